@@ -0,0 +1,310 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/audio_stream.h"
+#include "../library/file_mapping.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Half a minute of stereo audio at 44100Hz, streamed one tick (at 60 ticks per
+// second) at a time.
+#define SAMPLES_PER_SECOND 44100
+#define SAMPLES (SAMPLES_PER_SECOND * 30)
+#define SAMPLES_PER_TICK 735
+
+#define PI 3.14159265358979323846
+
+// IMA ADPCM blocks of 1024 bytes, as commonly written for stereo audio.
+#define BLOCK_ALIGN 1024
+#define SAMPLES_PER_BLOCK ((BLOCK_ALIGN - 8) / 8 * 8 + 1)
+#define BLOCKS ((SAMPLES + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK)
+
+static const int16_t ima_steps[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t ima_index_changes[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                             -1, -1, -1, -1, 2, 4, 6, 8};
+
+static int16_t source[SAMPLES * 2];
+static float audio[SAMPLES * 2];
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+static void put_uint16(FILE *const file, const uint16_t value) {
+  fputc(value & 255, file);
+  fputc(value >> 8, file);
+}
+
+static void put_uint32(FILE *const file, const uint32_t value) {
+  put_uint16(file, value & 65535);
+  put_uint16(file, value >> 16);
+}
+
+static void put_header(FILE *const file, const uint16_t format,
+                       const uint16_t block_align,
+                       const uint16_t bits_per_sample,
+                       const uint32_t data_size) {
+  const bool adpcm = format == 0x11;
+
+  fwrite("RIFF", 1, 4, file);
+  put_uint32(file, 4 + 8 + 20 + (adpcm ? 12 : 0) + 8 + data_size);
+  fwrite("WAVEfmt ", 1, 8, file);
+  put_uint32(file, 20);
+  put_uint16(file, format);
+  put_uint16(file, 2);
+  put_uint32(file, SAMPLES_PER_SECOND);
+  put_uint32(file, SAMPLES_PER_SECOND * 4);
+  put_uint16(file, block_align);
+  put_uint16(file, bits_per_sample);
+  put_uint16(file, 2);
+  put_uint16(file, adpcm ? SAMPLES_PER_BLOCK : 0);
+
+  // The fact chunk excludes the padding at the end of the final block.
+  if (adpcm) {
+    fwrite("fact", 1, 4, file);
+    put_uint32(file, 4);
+    put_uint32(file, SAMPLES);
+  }
+
+  fwrite("data", 1, 4, file);
+  put_uint32(file, data_size);
+}
+
+static uint8_t encode(const int16_t sample, int32_t *const predictor,
+                      int32_t *const index) {
+  int32_t step = ima_steps[*index];
+  int32_t difference = sample - *predictor;
+  int32_t change = step >> 3;
+  uint8_t code = 0;
+
+  if (difference < 0) {
+    code = 8;
+    difference = -difference;
+  }
+
+  if (difference >= step) {
+    code |= 4;
+    difference -= step;
+    change += step;
+  }
+
+  step >>= 1;
+
+  if (difference >= step) {
+    code |= 2;
+    difference -= step;
+    change += step;
+  }
+
+  step >>= 1;
+
+  if (difference >= step) {
+    code |= 1;
+    change += step;
+  }
+
+  *predictor += code & 8 ? -change : change;
+  *predictor = *predictor < -32768  ? -32768
+               : *predictor > 32767 ? 32767
+                                    : *predictor;
+  *index += ima_index_changes[code];
+  *index = *index < 0 ? 0 : *index > 88 ? 88 : *index;
+  return code;
+}
+
+static int16_t padded(const uint32_t sample, const int channel) {
+  return sample < SAMPLES ? source[sample * 2 + channel] : 0;
+}
+
+// Opens a file, exiting should it fail (for example, when not run from the
+// root of the repository).
+static FILE *open_file(const char *const path, const char *const mode) {
+  FILE *const file = fopen(path, mode);
+
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open %s.\n", path);
+    exit(EXIT_FAILURE);
+  }
+
+  return file;
+}
+
+static void close_file(FILE *const file, const char *const path) {
+  const bool failed = ferror(file) != 0;
+
+  if (fclose(file) != 0 || failed) {
+    fprintf(stderr, "Failed to write %s.\n", path);
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void write_files(void) {
+  FILE *file = open_file("dist/bench/int16.wav", "wb");
+  put_header(file, 1, 4, 16, SAMPLES * 4);
+
+  for (uint32_t sample = 0; sample < SAMPLES * 2; sample++) {
+    put_uint16(file, (uint16_t)source[sample]);
+  }
+
+  close_file(file, "dist/bench/int16.wav");
+
+  file = open_file("dist/bench/float.wav", "wb");
+  put_header(file, 3, 8, 32, SAMPLES * 8);
+
+  for (uint32_t sample = 0; sample < SAMPLES * 2; sample++) {
+    const float value = source[sample] / 32768.0f;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_uint32(file, bits);
+  }
+
+  close_file(file, "dist/bench/float.wav");
+
+  file = open_file("dist/bench/ima_adpcm.wav", "wb");
+  put_header(file, 0x11, BLOCK_ALIGN, 4, BLOCKS * BLOCK_ALIGN);
+  int32_t indices[2] = {0, 0};
+
+  for (uint32_t block = 0; block < BLOCKS; block++) {
+    const uint32_t first = block * SAMPLES_PER_BLOCK;
+    int32_t predictors[2];
+
+    for (int channel = 0; channel < 2; channel++) {
+      predictors[channel] = padded(first, channel);
+      put_uint16(file, (uint16_t)predictors[channel]);
+      fputc(indices[channel], file);
+      fputc(0, file);
+    }
+
+    for (uint32_t group = 0; group < (SAMPLES_PER_BLOCK - 1) / 8; group++) {
+      for (int channel = 0; channel < 2; channel++) {
+        for (int pair = 0; pair < 4; pair++) {
+          const uint32_t sample = first + 1 + group * 8 + pair * 2;
+          const uint8_t low = encode(padded(sample, channel),
+                                     &predictors[channel], &indices[channel]);
+          const uint8_t high = encode(padded(sample + 1, channel),
+                                      &predictors[channel], &indices[channel]);
+          fputc(low | (high << 4), file);
+        }
+      }
+    }
+  }
+
+  close_file(file, "dist/bench/ima_adpcm.wav");
+}
+
+static void measure(const char *const name, const char *const path,
+                    const bool memory) {
+  file_mapping file_mapping;
+  audio_stream audio_stream;
+  uint8_t *bytes = NULL;
+
+  if (memory) {
+    FILE *const file = open_file(path, "rb");
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    bytes = malloc(size);
+
+    if (bytes == NULL) {
+      fprintf(stderr, "Failed to allocate memory.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    if (fread(bytes, 1, size, file) != (size_t)size) {
+      fprintf(stderr, "Failed to read %s.\n", path);
+      exit(EXIT_FAILURE);
+    }
+
+    fclose(file);
+    file_mapping_open_memory(&file_mapping, bytes, size);
+  } else {
+    const char *const error = file_mapping_open(&file_mapping, path);
+
+    if (error != NULL) {
+      fprintf(stderr, "%s\n", error);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  const char *error = audio_stream_open(&audio_stream, &file_mapping,
+                                        SAMPLES_PER_SECOND, false);
+  memset(audio, 0, sizeof(audio));
+  bool ended = false;
+  uint32_t sample = 0;
+  const double start = now();
+
+  while (error == NULL && !ended) {
+    error = audio_stream_mix(&audio_stream, audio + sample * 2,
+                             SAMPLES_PER_TICK < SAMPLES - sample
+                                 ? SAMPLES_PER_TICK
+                                 : SAMPLES - sample,
+                             1.0f, &ended);
+    sample += SAMPLES_PER_TICK;
+  }
+
+  const double end = now();
+
+  if (error != NULL) {
+    fprintf(stderr, "%s\n", error);
+    exit(EXIT_FAILURE);
+  }
+
+  double signal = 0;
+  double noise = 0;
+
+  for (uint32_t index = 0; index < SAMPLES * 2; index++) {
+    const double expected = source[index] / 32768.0;
+    signal += expected * expected;
+    noise += (audio[index] - expected) * (audio[index] - expected);
+  }
+
+  printf("%-24s %8.3f ns/sample", name,
+         (end - start) * 1000000000.0 / SAMPLES);
+
+  if (noise > 0) {
+    printf(" %6.1f dB SNR", 10 * log10(signal / noise));
+  }
+
+  printf("\n");
+  file_mapping_close(&file_mapping);
+  free(bytes);
+}
+
+int main(void) {
+  // A few detuned partials, so that the ADPCM encoder has something like music
+  // to follow.
+  for (uint32_t sample = 0; sample < SAMPLES; sample++) {
+    const double time = (double)sample / SAMPLES_PER_SECOND;
+    const double left = sin(time * 2 * PI * 220) * 0.3 +
+                        sin(time * 2 * PI * 331) * 0.2 +
+                        sin(time * 2 * PI * 1763) * 0.1;
+    const double right = sin(time * 2 * PI * 165) * 0.3 +
+                         sin(time * 2 * PI * 442) * 0.2 +
+                         sin(time * 2 * PI * 2491) * 0.1;
+    source[sample * 2] = (int16_t)(left * 32767);
+    source[sample * 2 + 1] = (int16_t)(right * 32767);
+  }
+
+  write_files();
+  measure("int16 (memory)", "dist/bench/int16.wav", true);
+  measure("int16 (mapped file)", "dist/bench/int16.wav", false);
+  measure("float (mapped file)", "dist/bench/float.wav", false);
+  measure("IMA ADPCM (mapped file)", "dist/bench/ima_adpcm.wav", false);
+  return EXIT_SUCCESS;
+}
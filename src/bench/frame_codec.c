@@ -0,0 +1,215 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/frame_codec.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Each case is encoded, decoded and written this many times.
+#define ITERATIONS 20
+
+// Relative to the root of the repository, from which make runs benchmarks.
+#define PATH "dist/bench/frame_codec.bin"
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+static void *allocate(const size_t bytes) {
+  void *const memory = malloc(bytes);
+
+  if (memory == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  return memory;
+}
+
+static FILE *open_file(const char *const path, const char *const mode) {
+  FILE *const file = fopen(path, mode);
+
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open %s.\n", path);
+    exit(EXIT_FAILURE);
+  }
+
+  return file;
+}
+
+static void close_file(FILE *const file, const char *const path) {
+  const bool failed = ferror(file) != 0;
+
+  if (fclose(file) != 0 || failed) {
+    fprintf(stderr, "Failed to write %s.\n", path);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// As rendered by the example application: a checkerboard over gradients.
+static void example(uint8_t *const pixels, const int rows, const int columns,
+                    const int channels) {
+  for (int row = 0; row < rows; row++) {
+    for (int column = 0; column < columns; column++) {
+      uint8_t *const pixel = pixels + (row * columns + column) * channels;
+      pixel[0] = (uint8_t)(row * 0.9f / rows * 255.0f);
+      pixel[1] = (uint8_t)(row * 0.3f / rows * 255.0f);
+      pixel[2] = (row + column) % 2 ? 51 : 178;
+
+      if (channels == 4) {
+        pixel[3] = 63;
+      }
+    }
+  }
+}
+
+// Flat backdrops with a scattering of sprites, as in many 2D games.
+static void flat(uint8_t *const pixels, const int rows, const int columns,
+                 const int channels) {
+  uint32_t state = 1;
+
+  for (int row = 0; row < rows; row++) {
+    for (int column = 0; column < columns; column++) {
+      uint8_t *const pixel = pixels + (row * columns + column) * channels;
+      const int band = row * 8 / rows;
+      pixel[0] = 40 + band * 20;
+      pixel[1] = 90 + band * 10;
+      pixel[2] = 200 - band * 15;
+
+      if (channels == 4) {
+        pixel[3] = 255;
+      }
+    }
+  }
+
+  for (int sprite = 0; sprite < 200; sprite++) {
+    state = state * 1664525u + 1013904223u;
+    const int top = state % (rows - 32);
+    state = state * 1664525u + 1013904223u;
+    const int left = state % (columns - 32);
+
+    for (int row = 0; row < 32; row++) {
+      for (int column = 0; column < 32; column++) {
+        uint8_t *const pixel =
+            pixels + ((top + row) * columns + left + column) * channels;
+        pixel[0] = (uint8_t)(row * 8);
+        pixel[1] = (uint8_t)(column * 8);
+        pixel[2] = (uint8_t)((row ^ column) * 8);
+      }
+    }
+  }
+}
+
+// The worst case, with nothing to exploit.
+static void noise(uint8_t *const pixels, const int rows, const int columns,
+                  const int channels) {
+  uint32_t state = 12345;
+
+  for (int byte = 0; byte < rows * columns * channels; byte++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    pixels[byte] = state;
+  }
+}
+
+static int measure(const char *const name,
+                   void (*const generate)(uint8_t *const pixels,
+                                          const int rows, const int columns,
+                                          const int channels),
+                   const int rows, const int columns, const int channels) {
+  const size_t raw_bytes = (size_t)rows * columns * channels;
+  uint8_t *const pixels = allocate(raw_bytes);
+  uint8_t *const decoded = allocate(raw_bytes);
+  uint8_t *const encoded =
+      allocate(frame_codec_maximum_bytes(rows, columns, channels));
+
+  generate(pixels, rows, columns, channels);
+
+  size_t encoded_bytes = 0;
+  const double encode_start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    encoded_bytes =
+        frame_codec_encode(pixels, rows, columns, channels, encoded);
+  }
+
+  const double encode_seconds = (now() - encode_start) / ITERATIONS;
+  const double decode_start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    size_t consumed;
+    const char *const error = frame_codec_decode(
+        encoded, encoded_bytes, rows, columns, channels, decoded, &consumed);
+
+    if (error != NULL || consumed != encoded_bytes) {
+      fprintf(stderr, "%s: %s\n", name,
+              error == NULL ? "Decoding consumed the wrong number of bytes."
+                            : error);
+      return 1;
+    }
+  }
+
+  const double decode_seconds = (now() - decode_start) / ITERATIONS;
+
+  if (memcmp(pixels, decoded, raw_bytes) != 0) {
+    fprintf(stderr, "%s: Decoding did not reproduce the frame.\n", name);
+    return 1;
+  }
+
+  // Writes go through the page cache, so this shows the cost of the calls
+  // and copies rather than of the disk itself.
+  // Any short write sets the error indicator, which close_file checks.
+  FILE *const file = open_file(PATH, "wb");
+  const double raw_start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    fwrite(pixels, 1, raw_bytes, file);
+  }
+
+  fflush(file);
+  const double raw_seconds = (now() - raw_start) / ITERATIONS;
+  const double compressed_start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    const size_t bytes =
+        frame_codec_encode(pixels, rows, columns, channels, encoded);
+    fwrite(encoded, 1, bytes, file);
+  }
+
+  fflush(file);
+  const double compressed_seconds = (now() - compressed_start) / ITERATIONS;
+  close_file(file, PATH);
+
+  printf("%-8s %4dx%-4d %d channels %6.2f:1  encode %7.1f MB/s  "
+         "decode %7.1f MB/s  raw write %7.3f ms  encode and write %7.3f ms\n",
+         name, columns, rows, channels, (double)raw_bytes / encoded_bytes,
+         raw_bytes / encode_seconds / 1000000.0,
+         raw_bytes / decode_seconds / 1000000.0, raw_seconds * 1000.0,
+         compressed_seconds * 1000.0);
+
+  free(encoded);
+  free(decoded);
+  free(pixels);
+  return 0;
+}
+
+int main(void) {
+  int failures = 0;
+
+  for (int channels = 3; channels <= 4; channels++) {
+    failures += measure("example", example, 192, 256, channels);
+    failures += measure("flat", flat, 1080, 1920, channels);
+    failures += measure("noise", noise, 1080, 1920, channels);
+  }
+
+  remove(PATH);
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/framebuffer.h"
+#include "../library/viewport.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The size of the example's viewport.
+#define ROWS 270
+#define COLUMNS 480
+
+// Enough frames for timer resolution to be insignificant.
+#define FRAMES 200
+
+static float opacities[ROWS * COLUMNS];
+static float reds[ROWS * COLUMNS];
+static float greens[ROWS * COLUMNS];
+static float blues[ROWS * COLUMNS];
+static uint8_t scratch[ROWS * COLUMNS * 4];
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+static void opaque(volatile uint8_t *const sink) {
+  // Rows of a device-independent bitmap are padded to a multiple of 4 bytes.
+  const int bytes_per_row = (COLUMNS * 3 + 3) & ~3;
+  uint8_t *const pixels = malloc(ROWS * bytes_per_row);
+
+  if (pixels == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  const double start = now();
+
+  for (int frame = 0; frame < FRAMES; frame++) {
+    framebuffer_convert_opaque(ROWS, COLUMNS, reds, greens, blues,
+                               bytes_per_row - COLUMNS * 3, pixels);
+    *sink += pixels[frame];
+  }
+
+  const double nanoseconds = (now() - start) * 1000000000.0 / FRAMES;
+
+  printf("opaque %dx%d %10.0f ns/frame %6.2f ns/pixel\n", COLUMNS, ROWS,
+         nanoseconds, nanoseconds / (ROWS * COLUMNS));
+
+  free(pixels);
+}
+
+static void layered(const int width, const int height,
+                    volatile uint8_t *const sink) {
+  viewport viewport;
+  viewport_fit(&viewport, ROWS, COLUMNS, width, height);
+
+  uint8_t *const pixels =
+      malloc((size_t)viewport.scaled_width * viewport.scaled_height * 4);
+
+  if (pixels == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  const double start = now();
+
+  for (int frame = 0; frame < FRAMES; frame++) {
+    framebuffer_convert_layered(ROWS, COLUMNS, opacities, reds, greens, blues,
+                                scratch, &viewport, pixels);
+    *sink += pixels[frame];
+  }
+
+  const double nanoseconds = (now() - start) * 1000000000.0 / FRAMES;
+  const double scaled_pixels =
+      (double)viewport.scaled_width * viewport.scaled_height;
+
+  printf("layered %dx%d %10.0f ns/frame %6.2f ns/pixel\n", width, height,
+         nanoseconds, nanoseconds / scaled_pixels);
+
+  free(pixels);
+}
+
+int main(void) {
+  for (int index = 0; index < ROWS * COLUMNS; index++) {
+    opacities[index] = (float)(index % 256) / 255.0f;
+    reds[index] = (float)(index % 251) / 250.0f;
+    greens[index] = (float)(index % 241) / 240.0f;
+    blues[index] = (float)(index % 239) / 238.0f;
+  }
+
+  volatile uint8_t sink = 0;
+
+  opaque(&sink);
+  layered(COLUMNS, ROWS, &sink);
+  layered(1920, 1080, &sink);
+  layered(3840, 2160, &sink);
+
+  return 0;
+}
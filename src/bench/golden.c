@@ -0,0 +1,74 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/golden.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// golden_compare is timed on frames of this size.
+#define COMPARE_ROWS 1080
+#define COMPARE_COLUMNS 1920
+#define COMPARE_ITERATIONS 50
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+static void *allocate(const size_t bytes) {
+  void *const memory = malloc(bytes);
+
+  if (memory == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  return memory;
+}
+
+int main(void) {
+  const size_t bytes = (size_t)COMPARE_ROWS * COMPARE_COLUMNS * 4;
+  uint8_t *const expected = allocate(bytes);
+  uint8_t *const actual = allocate(bytes);
+
+  for (size_t byte = 0; byte < bytes; byte++) {
+    expected[byte] = byte * 7;
+  }
+
+  memcpy(actual, expected, bytes);
+
+  golden_region region;
+  double start = now();
+
+  for (int iteration = 0; iteration < COMPARE_ITERATIONS; iteration++) {
+    golden_compare(expected, actual, COMPARE_ROWS, COMPARE_COLUMNS, 4,
+                   &region);
+  }
+
+  const double identical_seconds = (now() - start) / COMPARE_ITERATIONS;
+
+  actual[(700 * COMPARE_COLUMNS + 900) * 4 + 2] ^= 1;
+  actual[(710 * COMPARE_COLUMNS + 905) * 4] ^= 1;
+  start = now();
+
+  for (int iteration = 0; iteration < COMPARE_ITERATIONS; iteration++) {
+    golden_compare(expected, actual, COMPARE_ROWS, COMPARE_COLUMNS, 4,
+                   &region);
+  }
+
+  const double differing_seconds = (now() - start) / COMPARE_ITERATIONS;
+
+  printf("golden_compare %dx%d identical %7.2f GB/s  two pixels differ "
+         "%7.2f GB/s\n",
+         COMPARE_COLUMNS, COMPARE_ROWS, bytes / identical_seconds / 1e9,
+         bytes / differing_seconds / 1e9);
+
+  free(actual);
+  free(expected);
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/capture.h"
+#include "../library/event_loop_core.h"
+#include "../library/input.h"
+#include "../library/run_event_loop_headless.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// As the example application.
+#define ROWS 192
+#define COLUMNS 256
+#define SAMPLES_PER_TICK 441
+#define TICKS 6000
+#define FRAMES 14400
+
+// A shorter run is captured, as every frame is written uncompressed.
+#define CAPTURED_TICKS 200
+#define CAPTURED_FRAMES 480
+
+static float opacities[ROWS * COLUMNS];
+static float reds[ROWS * COLUMNS];
+static float greens[ROWS * COLUMNS];
+static float blues[ROWS * COLUMNS];
+static int ticks;
+static int samples;
+
+static int64_t now(void *const state) {
+  (void)state;
+
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (int64_t)timespec.tv_sec * 1000000 + timespec.tv_nsec / 1000;
+}
+
+static void tick(const input *const input, float *const audio) {
+  (void)input;
+
+  const float pan = (float)sin(ticks * 0.1) * 0.5f + 0.5f;
+  ticks++;
+
+  for (int sample = 0; sample < SAMPLES_PER_TICK; sample++) {
+    const float unmixed = (float)sin(samples * 0.0313487528344671);
+    audio[sample * 2] = (1.0f - pan) * unmixed;
+    audio[sample * 2 + 1] = pan * unmixed;
+    samples++;
+  }
+}
+
+static void video(const input *const input,
+                  const float tick_progress_unit_interval) {
+  (void)input;
+
+  const float shade = tick_progress_unit_interval * 0.5f;
+
+  for (int row = 0; row < ROWS; row++) {
+    for (int column = 0; column < COLUMNS; column++) {
+      opacities[row * COLUMNS + column] = 0.25f;
+      reds[row * COLUMNS + column] = (row + column) % 2 ? 0.2f : 0.7f;
+      greens[row * COLUMNS + column] = (row * 0.3f) / ROWS + shade;
+      blues[row * COLUMNS + column] = (row * 0.9f) / ROWS * (1.0f - shade);
+    }
+  }
+}
+
+int main(void) {
+  const event_loop_timer timer = {.state = NULL, .now = now};
+  headless_statistics statistics;
+
+  const char *const error = run_event_loop_headless(
+      tick, ROWS, COLUMNS, opacities, reds, greens, blues, video,
+      SAMPLES_PER_TICK, TICKS, FRAMES, NULL, &timer, &statistics);
+
+  if (error != NULL) {
+    fprintf(stderr, "%s\n", error);
+    return 1;
+  }
+
+  printf("%6llu ticks  %10.0f ticks/s\n",
+         (unsigned long long)statistics.ticks, statistics.ticks_per_second);
+  printf("%6llu frames %10.0f frames/s\n",
+         (unsigned long long)statistics.frames, statistics.frames_per_second);
+  printf("total        %10.3f ms\n", statistics.total_microseconds / 1000.0);
+
+  capture capture;
+
+  const char *const open_error = capture_open(
+      &capture, "dist/bench/headless.y4m", CAPTURE_VIDEO_Y4M, ROWS, COLUMNS,
+      60, 16, "dist/bench/headless.wav", 44100, SAMPLES_PER_TICK,
+      CAPTURED_TICKS);
+
+  if (open_error != NULL) {
+    fprintf(stderr, "%s\n", open_error);
+    return 1;
+  }
+
+  const headless_output output = capture_interface(&capture);
+  const int64_t start = now(NULL);
+
+  const char *const captured_error = run_event_loop_headless(
+      tick, ROWS, COLUMNS, opacities, reds, greens, blues, video,
+      SAMPLES_PER_TICK, CAPTURED_TICKS, CAPTURED_FRAMES, &output, &timer,
+      &statistics);
+
+  capture_statistics capture_statistics;
+  capture_measure(&capture, &capture_statistics);
+  const char *const close_error = capture_close(&capture);
+  const int64_t end = now(NULL);
+
+  if (captured_error != NULL || close_error != NULL) {
+    fprintf(stderr, "%s\n",
+            captured_error != NULL ? captured_error : close_error);
+    return 1;
+  }
+
+  printf("captured %llu frames (%llu dropped), %llu ticks (%llu dropped) "
+         "to Y4M and WAV\n",
+         (unsigned long long)capture_statistics.captured_frames,
+         (unsigned long long)capture_statistics.dropped_frames,
+         (unsigned long long)capture_statistics.captured_ticks,
+         (unsigned long long)capture_statistics.dropped_ticks);
+  printf("run          %10.3f ms\n", statistics.total_microseconds / 1000.0);
+  printf("flushed      %10.3f ms\n", (end - start) / 1000.0);
+
+  return 0;
+}
@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/event_loop_core.h"
+#include "../library/headless_output.h"
+#include "../library/headless_pool.h"
+#include "../library/input.h"
+#include "../library/run_event_loop_headless.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// As the example application.
+#define ROWS 192
+#define COLUMNS 256
+#define SAMPLES_PER_TICK 441
+
+#define INSTANCES 32
+
+// Each instance is given a different budget, so that some finish early.
+#define MINIMUM_TICKS 600
+#define TICKS_PER_INSTANCE 10
+
+#define FNV_OFFSET_BASIS 14695981039346656037u
+#define FNV_PRIME 1099511628211u
+
+// The state of one instance of an application like the example, which would
+// otherwise be held in globals.
+typedef struct {
+  float opacities[ROWS * COLUMNS];
+  float reds[ROWS * COLUMNS];
+  float greens[ROWS * COLUMNS];
+  float blues[ROWS * COLUMNS];
+  int ticks;
+  int samples;
+  float pitch;
+
+  // A hash of the audio the instance has output, which is combined with its
+  // final viewport to check that it is unaffected by how many threads run
+  // alongside it.
+  uint64_t hash;
+} instance;
+
+static int64_t now(void *const state) {
+  (void)state;
+
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (int64_t)timespec.tv_sec * 1000000 + timespec.tv_nsec / 1000;
+}
+
+static void *allocate(const size_t bytes) {
+  void *const memory = malloc(bytes);
+
+  if (memory == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  return memory;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void *const data,
+                           const size_t bytes) {
+  for (size_t byte = 0; byte < bytes; byte++) {
+    hash = (hash ^ ((const uint8_t *)data)[byte]) * FNV_PRIME;
+  }
+
+  return hash;
+}
+
+static void tick(void *const state, const input *const input,
+                 float *const audio) {
+  (void)input;
+
+  instance *const instance = state;
+  const float pan = (float)sin(instance->ticks * 0.1) * 0.5f + 0.5f;
+  instance->ticks++;
+
+  for (int sample = 0; sample < SAMPLES_PER_TICK; sample++) {
+    const float unmixed = (float)sin(instance->samples * instance->pitch);
+    audio[sample * 2] = (1.0f - pan) * unmixed;
+    audio[sample * 2 + 1] = pan * unmixed;
+    instance->samples++;
+  }
+}
+
+static void video(void *const state, const input *const input,
+                  const float tick_progress_unit_interval) {
+  (void)input;
+
+  instance *const instance = state;
+  const float shade = tick_progress_unit_interval * 0.5f;
+  const float offset = (instance->ticks % 100) / 100.0f;
+
+  for (int row = 0; row < ROWS; row++) {
+    for (int column = 0; column < COLUMNS; column++) {
+      const int index = row * COLUMNS + column;
+      instance->opacities[index] = 0.25f;
+      instance->reds[index] = (row + column) % 2 ? 0.2f : 0.7f;
+      instance->greens[index] = (row * 0.3f) / ROWS + shade;
+      instance->blues[index] = (row * 0.9f) / ROWS * (1.0f - offset);
+    }
+  }
+}
+
+static const char *hash_audio(void *const state, const float *const samples,
+                              const int samples_per_tick) {
+  instance *const instance = state;
+  instance->hash = hash_bytes(instance->hash, samples,
+                              sizeof(float) * 2 * samples_per_tick);
+  return NULL;
+}
+
+// Runs every instance from the start on a number of threads, returning the
+// number of microseconds taken, or -1 on failure.
+static int64_t run(instance *const instances, const int threads,
+                   uint64_t *const hashes) {
+  headless_application *const applications =
+      allocate(sizeof(headless_application) * INSTANCES);
+  headless_output *const outputs =
+      allocate(sizeof(headless_output) * INSTANCES);
+  headless_job *const jobs = allocate(sizeof(headless_job) * INSTANCES);
+
+  for (int index = 0; index < INSTANCES; index++) {
+    instance *const instance = &instances[index];
+    instance->ticks = 0;
+    instance->samples = 0;
+    instance->pitch = 0.02f + index * 0.0005f;
+    instance->hash = FNV_OFFSET_BASIS;
+
+    const headless_application application = {
+        .state = instance,
+        .tick = tick,
+        .video = video,
+        .rows = ROWS,
+        .columns = COLUMNS,
+        .opacities = instance->opacities,
+        .reds = instance->reds,
+        .greens = instance->greens,
+        .blues = instance->blues,
+        .samples_per_tick = SAMPLES_PER_TICK,
+    };
+    const headless_output output = {
+        .state = instance,
+        .audio = hash_audio,
+        .video = NULL,
+    };
+    const headless_job job = {
+        .application = &applications[index],
+        .ticks = MINIMUM_TICKS + index * TICKS_PER_INSTANCE,
+        .frames = (MINIMUM_TICKS + index * TICKS_PER_INSTANCE) / 10,
+        .output = &outputs[index],
+        .error = NULL,
+    };
+
+    // The members are constant, so the structures are copied in whole.
+    memcpy(&applications[index], &application, sizeof(application));
+    memcpy(&outputs[index], &output, sizeof(output));
+    memcpy(&jobs[index], &job, sizeof(job));
+  }
+
+  const event_loop_timer timer = {.state = NULL, .now = now};
+  const int64_t start = now(NULL);
+  const char *const error =
+      run_headless_pool(jobs, INSTANCES, threads, &timer);
+  const int64_t microseconds = now(NULL) - start;
+  int failures = error == NULL ? 0 : 1;
+
+  if (error != NULL) {
+    fprintf(stderr, "%s\n", error);
+  }
+
+  for (int index = 0; index < INSTANCES; index++) {
+    if (jobs[index].error != NULL) {
+      fprintf(stderr, "Instance %d: %s\n", index, jobs[index].error);
+      failures++;
+    }
+
+    if (jobs[index].statistics.ticks != jobs[index].ticks) {
+      fprintf(stderr, "Instance %d: Ran the wrong number of ticks.\n", index);
+      failures++;
+    }
+
+    const size_t bytes = sizeof(float) * ROWS * COLUMNS;
+    uint64_t hash = instances[index].hash;
+    hash = hash_bytes(hash, instances[index].opacities, bytes);
+    hash = hash_bytes(hash, instances[index].reds, bytes);
+    hash = hash_bytes(hash, instances[index].greens, bytes);
+    hashes[index] = hash_bytes(hash, instances[index].blues, bytes);
+  }
+
+  free(jobs);
+  free(outputs);
+  free(applications);
+
+  return failures == 0 ? microseconds : -1;
+}
+
+int main(void) {
+  instance *const instances = allocate(sizeof(instance) * INSTANCES);
+  uint64_t expected[INSTANCES];
+  uint64_t actual[INSTANCES];
+  // Several threads are always run, even on a single processor, to check
+  // that instances remain independent when interleaved.
+  const int processors = headless_pool_processors();
+  const int maximum_threads = processors > 4 ? processors : 4;
+  int64_t single = -1;
+  int failures = 0;
+
+  for (int threads = 1; failures == 0; threads *= 2) {
+    const int limited =
+        threads < maximum_threads ? threads : maximum_threads;
+    const int64_t microseconds =
+        run(instances, limited, limited == 1 ? expected : actual);
+
+    if (microseconds < 0) {
+      failures++;
+      break;
+    }
+
+    if (limited == 1) {
+      single = microseconds;
+    } else if (memcmp(expected, actual, sizeof(expected)) != 0) {
+      fprintf(stderr, "%d threads: Instances produced different output to "
+                      "running them one at a time.\n",
+              limited);
+      failures++;
+    }
+
+    printf("%2d threads %2d processors %3d instances %9.3f ms  %6.2fx\n",
+           limited, processors, INSTANCES, microseconds / 1000.0,
+           microseconds > 0 ? (double)single / (double)microseconds : 0.0);
+
+    if (limited == maximum_threads) {
+      break;
+    }
+  }
+
+  free(instances);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,477 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../library/framebuffer.h"
+#include "../library/input.h"
+#include "../library/pcm.h"
+#include "../library/viewport.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TIME_STAMP_COUNTER 1
+#else
+#define HAS_TIME_STAMP_COUNTER 0
+#endif
+
+// Emits a JSON document describing the distribution of the time taken by each
+// of the host's per-frame and per-tick kernels, across a matrix of viewport
+// and window sizes and, for the framebuffer conversions, of the number of
+// threads the rows are split between.
+
+// The number of timed samples taken of each case.  Too few for a 99th
+// percentile to differ from the maximum, so only the 90th is reported.
+#define SAMPLES 25
+
+// Each sample repeats its case until at least this many nanoseconds have
+// passed, so that timer resolution is insignificant.
+#define MINIMUM_SAMPLE_NANOSECONDS 200000.0
+
+// The largest window, to which the largest scale factors are limited.
+#define MAXIMUM_WIDTH 3840
+#define MAXIMUM_HEIGHT 2160
+
+// One buffer of stereo audio at 48KHz and 60 ticks per second.
+#define AUDIO_SAMPLES 1600
+
+// The framebuffer conversions are split between 1, 2, 4... threads, up to the
+// number of processors (but at least 2, to check that splitting them gives
+// the same pixels, and at most this).
+#define MAXIMUM_THREADS 8
+
+static const int viewports[][2] = {
+    {192, 256}, // As the example application.
+    {270, 480},
+    {360, 640},
+    {540, 960},
+};
+
+#define VIEWPORTS ((int)(sizeof(viewports) / sizeof(viewports[0])))
+
+typedef struct {
+  int rows;
+  int columns;
+  const float *opacities;
+  const float *reds;
+  const float *greens;
+  const float *blues;
+  uint8_t *scratch;
+  viewport viewport;
+  uint8_t *pixels;
+  const float *audio;
+  int16_t *converted;
+  pcm_dither *pcm_dither;
+  const input *input;
+  bool *held;
+} bench_case;
+
+static volatile uint8_t sink;
+static bool first_result = true;
+
+// Workers which each run one band of rows of a kernel whenever the generation
+// changes, the calling thread running the first.
+static struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t started;
+  pthread_cond_t finished;
+  uint64_t generation;
+  int remaining;
+  void (*band)(const bench_case *const bench_case, const int first_row,
+               const int last_row);
+  const bench_case *bench_case;
+  int rows;
+  int bands;
+} pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .started = PTHREAD_COND_INITIALIZER,
+    .finished = PTHREAD_COND_INITIALIZER,
+};
+
+static int maximum_threads = 1;
+
+// The pixels written by each framebuffer conversion on a single thread, which
+// must be reproduced exactly however many threads it is split between.
+static uint8_t *expected_pixels;
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec * 1000000000.0 + (double)timespec.tv_nsec;
+}
+
+// Ticks of the time stamp counter, which runs at a constant rate on modern
+// processors rather than counting core clock cycles.
+static uint64_t tsc_ticks(void) {
+#if HAS_TIME_STAMP_COUNTER
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static int compare(const void *const a, const void *const b) {
+  const double left = *(const double *)a;
+  const double right = *(const double *)b;
+  return (left > right) - (left < right);
+}
+
+// Nearest-rank percentile of sorted samples.
+static double percentile(const double *const sorted, const int percent) {
+  int rank = (percent * SAMPLES + 99) / 100;
+  rank = rank < 1 ? 1 : rank;
+  return sorted[rank - 1];
+}
+
+static void run_band(const int band) {
+  const int first_row = pool.rows * band / pool.bands;
+  const int last_row = pool.rows * (band + 1) / pool.bands;
+  pool.band(pool.bench_case, first_row, last_row);
+}
+
+static void *worker(void *const argument) {
+  // Each worker runs the band after the calling thread's and those of the
+  // workers before it.
+  const int band = (int)(intptr_t)argument;
+  uint64_t generation = 0;
+
+  while (true) {
+    pthread_mutex_lock(&pool.mutex);
+
+    while (pool.generation == generation) {
+      pthread_cond_wait(&pool.started, &pool.mutex);
+    }
+
+    generation = pool.generation;
+    const bool participating = band < pool.bands;
+    pthread_mutex_unlock(&pool.mutex);
+
+    if (participating) {
+      run_band(band);
+      pthread_mutex_lock(&pool.mutex);
+
+      if (--pool.remaining == 0) {
+        pthread_cond_signal(&pool.finished);
+      }
+
+      pthread_mutex_unlock(&pool.mutex);
+    }
+  }
+
+  return NULL;
+}
+
+// Splits rows between threads, returning once every band has been run.
+static void split(void (*const band)(const bench_case *const bench_case,
+                                     const int first_row, const int last_row),
+                  const bench_case *const bench_case, const int rows,
+                  const int threads) {
+  if (threads == 1) {
+    band(bench_case, 0, rows);
+    return;
+  }
+
+  pthread_mutex_lock(&pool.mutex);
+  pool.band = band;
+  pool.bench_case = bench_case;
+  pool.rows = rows;
+  pool.bands = threads;
+  pool.remaining = threads - 1;
+  pool.generation++;
+  pthread_cond_broadcast(&pool.started);
+  pthread_mutex_unlock(&pool.mutex);
+
+  run_band(0);
+
+  pthread_mutex_lock(&pool.mutex);
+
+  while (pool.remaining > 0) {
+    pthread_cond_wait(&pool.finished, &pool.mutex);
+  }
+
+  pthread_mutex_unlock(&pool.mutex);
+}
+
+static void opaque_rows(const bench_case *const bench_case,
+                        const int first_row, const int last_row) {
+  const int columns = bench_case->columns;
+  const int bytes_per_row = (columns * 3 + 3) & ~3;
+  const int first_pixel = first_row * columns;
+  framebuffer_convert_opaque(last_row - first_row, columns,
+                             bench_case->reds + first_pixel,
+                             bench_case->greens + first_pixel,
+                             bench_case->blues + first_pixel,
+                             bytes_per_row - columns * 3,
+                             bench_case->pixels + first_row * bytes_per_row);
+}
+
+static void opaque(const bench_case *const bench_case, const int threads) {
+  split(opaque_rows, bench_case, bench_case->rows, threads);
+  sink += bench_case->pixels[0];
+}
+
+static void premultiply_rows(const bench_case *const bench_case,
+                             const int first_row, const int last_row) {
+  framebuffer_premultiply(bench_case->rows, bench_case->columns,
+                          bench_case->opacities, bench_case->reds,
+                          bench_case->greens, bench_case->blues, first_row,
+                          last_row, bench_case->scratch);
+}
+
+static void scale_rows(const bench_case *const bench_case,
+                       const int first_row, const int last_row) {
+  framebuffer_scale(bench_case->rows, bench_case->columns, bench_case->scratch,
+                    &bench_case->viewport, first_row, last_row,
+                    bench_case->pixels);
+}
+
+// As framebuffer_convert_layered, but with every row of the viewport
+// premultiplied before any are scaled.
+static void layered(const bench_case *const bench_case, const int threads) {
+  if (threads == 1) {
+    framebuffer_convert_layered(bench_case->rows, bench_case->columns,
+                                bench_case->opacities, bench_case->reds,
+                                bench_case->greens, bench_case->blues,
+                                bench_case->scratch, &bench_case->viewport,
+                                bench_case->pixels);
+  } else {
+    split(premultiply_rows, bench_case, bench_case->rows, threads);
+    split(scale_rows, bench_case, bench_case->viewport.scaled_height,
+          threads);
+  }
+
+  sink += bench_case->pixels[0];
+}
+
+static void convert_audio(const bench_case *const bench_case,
+                          const int threads) {
+  (void)threads;
+  pcm_convert_int16(bench_case->audio, bench_case->converted, AUDIO_SAMPLES,
+                    bench_case->pcm_dither);
+  sink += (uint8_t)bench_case->converted[0];
+}
+
+static void look_up_keys(const bench_case *const bench_case,
+                         const int threads) {
+  (void)threads;
+
+  for (int virtual_key_code = 0; virtual_key_code < 256; virtual_key_code++) {
+    bench_case->held[virtual_key_code] =
+        key_held(bench_case->input, virtual_key_code);
+  }
+
+  sink += bench_case->held[sink];
+}
+
+static void print_distribution(const char *const name, double *const samples) {
+  qsort(samples, SAMPLES, sizeof(double), compare);
+  printf("\"%s\": {\"minimum\": %.1f, \"median\": %.1f, \"p90\": %.1f, "
+         "\"maximum\": %.1f}",
+         name, samples[0], percentile(samples, 50), percentile(samples, 90),
+         samples[SAMPLES - 1]);
+}
+
+// Times a case on a number of threads, printing it as an element of the
+// results array.  bytes is the number of bytes written by each run of the
+// case.
+static void measure(const char *const kernel,
+                    void (*const run)(const bench_case *const bench_case,
+                                      const int threads),
+                    const bench_case *const bench_case, const int width,
+                    const int height, const int threads,
+                    const uint64_t bytes) {
+  double nanoseconds[SAMPLES];
+  double tick_counts[SAMPLES];
+
+  run(bench_case, threads);
+
+  const double single_start = now();
+  run(bench_case, threads);
+  const double single = now() - single_start;
+  const int repeats =
+      single >= MINIMUM_SAMPLE_NANOSECONDS
+          ? 1
+          : (int)(MINIMUM_SAMPLE_NANOSECONDS / (single > 1.0 ? single : 1.0)) +
+                1;
+
+  for (int sample = 0; sample < SAMPLES; sample++) {
+    const double start = now();
+    const uint64_t start_ticks = tsc_ticks();
+
+    for (int repeat = 0; repeat < repeats; repeat++) {
+      run(bench_case, threads);
+    }
+
+    tick_counts[sample] = (double)(tsc_ticks() - start_ticks) / repeats;
+    nanoseconds[sample] = (now() - start) / repeats;
+  }
+
+  printf("%s\n    {\"kernel\": \"%s\", \"rows\": %d, \"columns\": %d, "
+         "\"width\": %d, \"height\": %d, \"threads\": %d, \"bytes\": %llu, "
+         "\"samples\": %d, \"repeats\": %d,\n     ",
+         first_result ? "" : ",", kernel, bench_case->rows,
+         bench_case->columns, width, height, threads,
+         (unsigned long long)bytes, SAMPLES, repeats);
+  first_result = false;
+
+  print_distribution("nanoseconds", nanoseconds);
+  printf(",\n     ");
+
+  if (HAS_TIME_STAMP_COUNTER) {
+    print_distribution("tsc_ticks", tick_counts);
+    printf(",\n     \"bytes_per_tsc_tick\": %.3f}",
+           (double)bytes / percentile(tick_counts, 50));
+  } else {
+    printf("\"tsc_ticks\": null, \"bytes_per_tsc_tick\": null}");
+  }
+}
+
+static void *allocate(const size_t bytes) {
+  void *const memory = malloc(bytes);
+
+  if (memory == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  return memory;
+}
+
+// Times a framebuffer conversion on each number of threads, exiting should
+// splitting it between threads change the pixels written.
+static void measure_threads(const char *const kernel,
+                            void (*const run)(const bench_case *const
+                                                  bench_case,
+                                              const int threads),
+                            const bench_case *const bench_case,
+                            const int width, const int height,
+                            const uint64_t bytes) {
+  for (int threads = 1; threads <= maximum_threads; threads *= 2) {
+    memset(bench_case->pixels, 0, bytes);
+    measure(kernel, run, bench_case, width, height, threads, bytes);
+
+    if (threads == 1) {
+      memcpy(expected_pixels, bench_case->pixels, bytes);
+    } else if (memcmp(expected_pixels, bench_case->pixels, bytes) != 0) {
+      fprintf(stderr, "%s wrote different pixels when split between %d "
+                      "threads.\n",
+              kernel, threads);
+      exit(1);
+    }
+  }
+}
+
+static void measure_viewport(const int rows, const int columns) {
+  const int pixels = rows * columns;
+  float *const planes = allocate(sizeof(float) * pixels * 4);
+
+  for (int index = 0; index < pixels * 4; index++) {
+    planes[index] = (float)(index % 253) / 252.0f;
+  }
+
+  bench_case bench_case = {
+      .rows = rows,
+      .columns = columns,
+      .opacities = planes,
+      .reds = planes + pixels,
+      .greens = planes + pixels * 2,
+      .blues = planes + pixels * 3,
+      .scratch = allocate((size_t)pixels * 4),
+      .pixels = allocate((size_t)MAXIMUM_WIDTH * MAXIMUM_HEIGHT * 4),
+  };
+
+  const int bytes_per_row = (columns * 3 + 3) & ~3;
+  measure_threads("framebuffer_convert_opaque", opaque, &bench_case, columns,
+                  rows, (uint64_t)bytes_per_row * rows);
+
+  // Scale factor 1 measures premultiplication alone; beyond that, the cost of
+  // nearest-neighbor scaling dominates.
+  for (int scale = 1; columns * scale <= MAXIMUM_WIDTH &&
+                      rows * scale <= MAXIMUM_HEIGHT;
+       scale++) {
+    viewport_fit(&bench_case.viewport, rows, columns, columns * scale,
+                 rows * scale);
+    measure_threads("framebuffer_convert_layered", layered, &bench_case,
+                    columns * scale, rows * scale,
+                    (uint64_t)columns * scale * rows * scale * 4);
+  }
+
+  // Fitting a 4K window rarely lands on a whole scale factor.
+  viewport_fit(&bench_case.viewport, rows, columns, MAXIMUM_WIDTH,
+               MAXIMUM_HEIGHT);
+
+  if (bench_case.viewport.scaled_width % columns != 0 ||
+      bench_case.viewport.scaled_height % rows != 0) {
+    measure_threads("framebuffer_convert_layered", layered, &bench_case,
+                    bench_case.viewport.scaled_width,
+                    bench_case.viewport.scaled_height,
+                    (uint64_t)bench_case.viewport.scaled_width *
+                        bench_case.viewport.scaled_height * 4);
+  }
+
+  free(bench_case.pixels);
+  free(bench_case.scratch);
+  free(planes);
+}
+
+int main(void) {
+  const long online = sysconf(_SC_NPROCESSORS_ONLN);
+  const int processors = online < 1 ? 1 : (int)online;
+  maximum_threads = processors < 2                 ? 2
+                    : processors > MAXIMUM_THREADS ? MAXIMUM_THREADS
+                                                   : processors;
+  expected_pixels = allocate((size_t)MAXIMUM_WIDTH * MAXIMUM_HEIGHT * 4);
+
+  // The workers run until the process exits.
+  for (int band = 1; band < maximum_threads; band++) {
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, worker, (void *)(intptr_t)band) != 0) {
+      fprintf(stderr, "Failed to start a worker thread.\n");
+      return 1;
+    }
+  }
+
+  printf("{\"tick_counter\": \"%s\", \"processors\": %d, "
+         "\"results\": [",
+         HAS_TIME_STAMP_COUNTER ? "rdtsc" : "none", processors);
+
+  for (int index = 0; index < VIEWPORTS; index++) {
+    measure_viewport(viewports[index][0], viewports[index][1]);
+  }
+
+  float audio[AUDIO_SAMPLES];
+  int16_t converted[AUDIO_SAMPLES];
+  pcm_dither pcm_dither;
+  pcm_dither_initialize(&pcm_dither, 0);
+
+  for (int sample = 0; sample < AUDIO_SAMPLES; sample++) {
+    audio[sample] = (float)(sample % 200) / 100.0f - 1.0f;
+  }
+
+  bench_case audio_case = {.rows = 1,
+                           .columns = AUDIO_SAMPLES,
+                           .audio = audio,
+                           .converted = converted,
+                           .pcm_dither = NULL};
+  measure("pcm_convert_int16", convert_audio, &audio_case, 0, 0, 1,
+          sizeof(converted));
+  audio_case.pcm_dither = &pcm_dither;
+  measure("pcm_convert_int16_dithered", convert_audio, &audio_case, 0, 0, 1,
+          sizeof(converted));
+
+  const input input = {.held_keys = {0x12345678, 0x9abcdef0, 0, 1, 2, 3, 4, 5}};
+  bool held[256];
+  bench_case key_case = {.rows = 1, .columns = 256, .input = &input,
+                         .held = held};
+  measure("key_held", look_up_keys, &key_case, 0, 0, 1, sizeof(held));
+
+  printf("\n]}\n");
+
+  return 0;
+}
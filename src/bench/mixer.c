@@ -0,0 +1,98 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/mixer.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// One tick of audio at 44100Hz and 60 ticks per second, repeated enough times
+// for timer resolution to be insignificant.
+#define SAMPLES_PER_TICK 735
+#define TICKS 4000
+
+// Roughly a second of sound, mono and stereo.
+#define FRAMES 44100
+
+// The number of columns in the bar chart for the slowest case.
+#define CHART_WIDTH 40
+
+static float mono[FRAMES];
+static float stereo[FRAMES * 2];
+static float audio[SAMPLES_PER_TICK * 2];
+static mixer bench_mixer;
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+// Returns the nanoseconds taken to mix each tick with the given number of
+// voices, alternating between mono and stereo sounds.
+static double measure(const int voices, const float pitch,
+                      volatile float *const sink) {
+  mixer_initialize(&bench_mixer);
+
+  for (int voice = 0; voice < voices; voice++) {
+    const float pan = (float)voice / MIXER_CAPACITY * 2.0f - 1.0f;
+
+    if (voice % 2 == 0) {
+      mixer_play(&bench_mixer, mono, FRAMES, 1, 0.1f, pan, pitch, true);
+    } else {
+      mixer_play(&bench_mixer, stereo, FRAMES, 2, 0.1f, pan, pitch, true);
+    }
+  }
+
+  const double start = now();
+
+  for (int tick = 0; tick < TICKS; tick++) {
+    mixer_mix(&bench_mixer, audio, SAMPLES_PER_TICK);
+    *sink += audio[tick % (SAMPLES_PER_TICK * 2)];
+  }
+
+  return (now() - start) * 1000000000.0 / TICKS;
+}
+
+static void chart(const char *const name, const float pitch,
+                  volatile float *const sink) {
+  double nanoseconds[7];
+  double slowest = 0;
+
+  for (int power = 0; power < 7; power++) {
+    nanoseconds[power] = measure(1 << power, pitch, sink);
+    slowest = nanoseconds[power] > slowest ? nanoseconds[power] : slowest;
+  }
+
+  printf("%s\n", name);
+
+  for (int power = 0; power < 7; power++) {
+    const int columns = (int)ceil(nanoseconds[power] / slowest * CHART_WIDTH);
+
+    printf("%2d voices %10.0f ns/tick %7.2f ns/voice/sample ", 1 << power,
+           nanoseconds[power],
+           nanoseconds[power] / (1 << power) / SAMPLES_PER_TICK);
+
+    for (int column = 0; column < columns; column++) {
+      putchar('#');
+    }
+
+    putchar('\n');
+  }
+}
+
+int main(void) {
+  volatile float sink = 0;
+
+  for (int frame = 0; frame < FRAMES; frame++) {
+    mono[frame] = sinf((float)frame * 0.05f);
+    stereo[frame * 2] = sinf((float)frame * 0.03f);
+    stereo[frame * 2 + 1] = sinf((float)frame * 0.07f);
+  }
+
+  chart("Original pitch", 1.0f, &sink);
+  chart("Pitched (x1.2)", 1.2f, &sink);
+
+  return EXIT_SUCCESS;
+}
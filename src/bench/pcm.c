@@ -0,0 +1,72 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/pcm.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Roughly one slot of stereo audio at 48KHz and 60 ticks per second, repeated
+// enough times for timer resolution to be insignificant.
+#define SAMPLES 1600
+#define ITERATIONS 200000
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+static void report(const char *const name, const double start,
+                   const double end) {
+  printf("%-16s %8.3f ns/sample\n", name,
+         (end - start) * 1000000000.0 / ((double)SAMPLES * ITERATIONS));
+}
+
+int main(void) {
+  float input[SAMPLES];
+  float copied[SAMPLES];
+  int16_t converted[SAMPLES];
+  pcm_dither pcm_dither;
+  volatile int32_t sink = 0;
+
+  for (int sample = 0; sample < SAMPLES; sample++) {
+    input[sample] = sinf((float)sample * 0.05f) * 1.1f;
+  }
+
+  pcm_dither_initialize(&pcm_dither, 0);
+
+  double start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    memcpy(copied, input, sizeof(copied));
+    sink += (int32_t)copied[iteration % SAMPLES];
+  }
+
+  double end = now();
+  report("float (copy)", start, end);
+
+  start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    pcm_convert_int16(input, converted, SAMPLES, NULL);
+    sink += converted[iteration % SAMPLES];
+  }
+
+  end = now();
+  report("int16", start, end);
+
+  start = now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    pcm_convert_int16(input, converted, SAMPLES, &pcm_dither);
+    sink += converted[iteration % SAMPLES];
+  }
+
+  end = now();
+  report("int16 (dithered)", start, end);
+
+  return EXIT_SUCCESS;
+}
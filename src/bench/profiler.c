@@ -0,0 +1,151 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/profiler.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Each measurement is repeated this many times.
+#define ITERATIONS 10000000
+
+// The recording thread records this many spans while the trace is repeatedly
+// written out alongside it.
+#define CONCURRENT_SPANS 2000000
+
+static profiler_ring recording_ring = {.name = "recording", .thread = 1};
+static profiler_ring idle_ring = {.name = "idle", .thread = 2};
+static bool recording_finished;
+
+static void *record(void *const argument) {
+  (void)argument;
+
+  for (int span = 0; span < CONCURRENT_SPANS; span++) {
+    const int64_t start = profiler_now();
+    profiler_record(&recording_ring, span % PROFILER_PHASES, start,
+                    profiler_now());
+  }
+
+  __atomic_store_n(&recording_finished, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+// Counts the spans within a trace file.
+static uint64_t count_spans(const char *const path) {
+  FILE *const file = fopen(path, "rb");
+
+  if (file == NULL) {
+    return 0;
+  }
+
+  char line[256];
+  uint64_t spans = 0;
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (strstr(line, "\"ph\":\"X\"") != NULL) {
+      spans++;
+    }
+  }
+
+  fclose(file);
+  return spans;
+}
+
+static double seconds(const int64_t start, const int64_t end) {
+  return (double)(end - start) / (double)profiler_frequency();
+}
+
+int main(void) {
+  int64_t start = profiler_now();
+  int64_t sink = 0;
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    sink += profiler_now();
+  }
+
+  printf("profiler_now                 %7.2f ns/call (%lld per second)\n",
+         seconds(start, profiler_now()) * 1000000000.0 / ITERATIONS,
+         (long long)profiler_frequency());
+
+  // Written out each time the ring fills, so that nothing is dropped.
+  start = profiler_now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    profiler_record(&idle_ring, PROFILER_PHASE_TICK, sink, sink + iteration);
+
+    if (idle_ring.written - idle_ring.read == PROFILER_RING_CAPACITY) {
+      idle_ring.read = idle_ring.written;
+    }
+  }
+
+  printf("profiler_record              %7.2f ns/span\n",
+         seconds(start, profiler_now()) * 1000000000.0 / ITERATIONS);
+
+  start = profiler_now();
+
+  for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+    const int64_t span_start = profiler_now();
+    profiler_record(&idle_ring, PROFILER_PHASE_TICK, span_start,
+                    profiler_now());
+
+    if (idle_ring.written - idle_ring.read == PROFILER_RING_CAPACITY) {
+      idle_ring.read = idle_ring.written;
+    }
+  }
+
+  printf("PROFILER_BEGIN/PROFILER_END  %7.2f ns/span\n",
+         seconds(start, profiler_now()) * 1000000000.0 / ITERATIONS);
+
+  idle_ring.read = idle_ring.written;
+
+  // One thread records while this one writes out traces, as run_event_loop's
+  // threads do while the application asks for a trace.
+  pthread_t thread;
+
+  if (pthread_create(&thread, NULL, record, NULL) != 0) {
+    fprintf(stderr, "Failed to start the recording thread.\n");
+    return 1;
+  }
+
+  profiler_ring *const profiler_rings[] = {&recording_ring, &idle_ring};
+  uint64_t written_out = 0;
+  int traces = 0;
+  bool finished = false;
+  int64_t writing = 0;
+
+  while (!finished) {
+    finished = __atomic_load_n(&recording_finished, __ATOMIC_ACQUIRE);
+
+    const int64_t before = profiler_now();
+    const char *const error =
+        profiler_write_trace("dist/bench/trace.json", profiler_rings, 2);
+    writing += profiler_now() - before;
+
+    if (error != NULL) {
+      fprintf(stderr, "%s\n", error);
+      return 1;
+    }
+
+    written_out += count_spans("dist/bench/trace.json");
+    traces++;
+  }
+
+  pthread_join(thread, NULL);
+
+  const uint64_t dropped = recording_ring.dropped;
+
+  printf("profiler_write_trace         %7.2f ns/span over %d traces, "
+         "%llu written, %llu dropped\n",
+         seconds(0, writing) * 1000000000.0 / (double)written_out, traces,
+         (unsigned long long)written_out, (unsigned long long)dropped);
+
+  if (written_out + dropped != CONCURRENT_SPANS) {
+    fprintf(stderr, "Spans were lost while writing traces concurrently.\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,163 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "../library/resampler.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// One second of audio, given to the resampler a tick (at 60 ticks per second)
+// at a time, as the event loop would.
+#define SECONDS 1
+#define TICKS_PER_SECOND 60
+#define ITERATIONS 20
+#define PI 3.14159265358979323846
+
+static const char *const quality_names[] = {"low", "medium", "high"};
+
+static double now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (double)timespec.tv_sec + (double)timespec.tv_nsec / 1000000000.0;
+}
+
+static uint32_t resample(resampler *const resampler, const float *const input,
+                         const uint32_t input_rate, float *const output) {
+  const uint32_t samples_per_tick = input_rate / TICKS_PER_SECOND;
+  uint32_t produced = 0;
+
+  for (uint32_t tick = 0; tick < SECONDS * TICKS_PER_SECOND; tick++) {
+    produced += resampler_process(resampler,
+                                  input + 2 * tick * samples_per_tick,
+                                  samples_per_tick, output + 2 * produced);
+  }
+
+  return produced;
+}
+
+static void generate(float *const samples, const uint32_t rate,
+                     const double frequency) {
+  for (uint32_t sample = 0; sample < rate * SECONDS; sample++) {
+    const float value =
+        (float)(0.5 * sin(2.0 * PI * frequency * sample / rate));
+    samples[sample * 2] = value;
+    samples[sample * 2 + 1] = value;
+  }
+}
+
+// Fits a sine of a known frequency to the left channel by least squares,
+// returning the ratio in decibels between it and everything else.  The start
+// is skipped, while the filter fills with audio.
+static double signal_to_noise(const float *const samples, const uint32_t count,
+                              const uint32_t rate, const double frequency) {
+  double ss = 0.0, sc = 0.0, cc = 0.0, sy = 0.0, cy = 0.0;
+
+  for (uint32_t sample = 256; sample < count; sample++) {
+    const double angle = 2.0 * PI * frequency * sample / rate;
+    const double s = sin(angle), c = cos(angle), y = samples[sample * 2];
+    ss += s * s;
+    sc += s * c;
+    cc += c * c;
+    sy += s * y;
+    cy += c * y;
+  }
+
+  const double determinant = ss * cc - sc * sc;
+  const double a = (sy * cc - cy * sc) / determinant;
+  const double b = (cy * ss - sy * sc) / determinant;
+  double signal = 0.0, noise = 0.0;
+
+  for (uint32_t sample = 256; sample < count; sample++) {
+    const double angle = 2.0 * PI * frequency * sample / rate;
+    const double fitted = a * sin(angle) + b * cos(angle);
+    const double residual = samples[sample * 2] - fitted;
+    signal += fitted * fitted;
+    noise += residual * residual;
+  }
+
+  return 10.0 * log10(signal / noise);
+}
+
+// The level in decibels of everything which was produced, relative to the
+// input, for a tone which should have been removed entirely.
+static double rejection(const float *const samples, const uint32_t count) {
+  double power = 0.0;
+
+  for (uint32_t sample = 256; sample < count; sample++) {
+    power += (double)samples[sample * 2] * samples[sample * 2];
+  }
+
+  return -10.0 * log10(power / (count - 256) / 0.125);
+}
+
+int main(void) {
+  float *const input = malloc(sizeof(float) * 2 * 48000 * SECONDS);
+  float *const output = malloc(sizeof(float) * 2 * 48000 * SECONDS * 2);
+
+  if (input == NULL || output == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("%-8s %12s %12s %12s %14s\n", "quality", "ns/sample", "1KHz SNR",
+         "15KHz SNR", "20KHz reject");
+
+  for (int quality = RESAMPLER_QUALITY_LOW; quality <= RESAMPLER_QUALITY_HIGH;
+       quality++) {
+    resampler upsampler, downsampler;
+    const char *error = resampler_open(&upsampler, 44100, 48000, quality);
+
+    if (error == NULL) {
+      error = resampler_open(&downsampler, 48000, 32000, quality);
+
+      if (error != NULL) {
+        resampler_close(&upsampler);
+      }
+    }
+
+    if (error != NULL) {
+      fprintf(stderr, "%s\n", error);
+      return EXIT_FAILURE;
+    }
+
+    // Throughput, converting from 44100Hz (735 samples per tick) to 48000Hz.
+    generate(input, 44100, 1000.0);
+    uint32_t produced = 0;
+    const double start = now();
+
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+      resampler_reset(&upsampler);
+      produced = resample(&upsampler, input, 44100, output);
+    }
+
+    const double end = now();
+    const double nanoseconds =
+        (end - start) * 1000000000.0 / ((double)produced * ITERATIONS);
+
+    resampler_reset(&upsampler);
+    produced = resample(&upsampler, input, 44100, output);
+    const double low = signal_to_noise(output, produced, 48000, 1000.0);
+
+    generate(input, 44100, 15000.0);
+    resampler_reset(&upsampler);
+    produced = resample(&upsampler, input, 44100, output);
+    const double high = signal_to_noise(output, produced, 48000, 15000.0);
+
+    // A tone above 32000Hz's Nyquist frequency, converting from 48000Hz, would
+    // otherwise alias to 12000Hz.
+    generate(input, 48000, 20000.0);
+    produced = resample(&downsampler, input, 48000, output);
+    const double rejected = rejection(output, produced);
+
+    printf("%-8s %12.3f %9.1f dB %9.1f dB %11.1f dB\n", quality_names[quality],
+           nanoseconds, low, high, rejected);
+
+    resampler_close(&upsampler);
+    resampler_close(&downsampler);
+  }
+
+  free(input);
+  free(output);
+  return EXIT_SUCCESS;
+}
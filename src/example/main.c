@@ -15,8 +15,6 @@ static float greens[COLUMNS * ROWS];
 static float blues[COLUMNS * ROWS];
 
 #define SAMPLES_PER_TICK 441
-static float left[SAMPLES_PER_TICK];
-static float right[SAMPLES_PER_TICK];
 
 static int ticks;
 static int samples;
@@ -33,18 +31,15 @@ static float calculate_y(const int ticks) {
   return (sin(ticks * 0.12) * 0.1 + 0.5) * ROWS;
 }
 
-static void tick(const void *const context, const int pointer_state,
-                 const float pointer_row, const float pointer_column,
-                 bool (*const key_held)(const void *const context,
-                                        const WPARAM virtual_key_code)) {
+static void tick(const input *const input, float *const audio) {
   previous_x = next_x;
   next_x = calculate_x(ticks);
   previous_y = next_y;
-  next_y = calculate_y(ticks) + (key_held(context, 87) ? 50.0f : 0.0f) -
-           (key_held(context, 83) ? 50.0f : 0.0f);
-  tick_pointer_state = pointer_state;
-  tick_pointer_row = pointer_row;
-  tick_pointer_column = pointer_column;
+  next_y = calculate_y(ticks) + (key_held(input, 87) ? 50.0f : 0.0f) -
+           (key_held(input, 83) ? 50.0f : 0.0f);
+  tick_pointer_state = input->pointer_state;
+  tick_pointer_row = input->pointer_row;
+  tick_pointer_column = input->pointer_column;
   ticks++;
 
   for (int sample = 0; sample < SAMPLES_PER_TICK; sample++) {
@@ -55,8 +50,8 @@ static void tick(const void *const context, const int pointer_state,
         COLUMNS;
 
     const float unmixed = sin(samples * 0.0313487528344671);
-    left[sample] = max(0, -x) * unmixed;
-    right[sample] = max(0, x) * unmixed;
+    audio[sample * 2] = max(0, -x) * unmixed;
+    audio[sample * 2 + 1] = max(0, x) * unmixed;
     samples++;
   }
 }
@@ -124,10 +119,7 @@ static void video_pointer(const int state, const float row, const float column,
   blues[index] = blue;
 }
 
-static void video(const void *const context, const int pointer_state,
-                  const float pointer_row, const float pointer_column,
-                  bool (*const key_held)(const void *const context,
-                                         const WPARAM virtual_key_code),
+static void video(const input *const input,
                   const float tick_progress_unit_interval) {
   for (int row = 0; row < ROWS; row++) {
     for (int column = 0; column < COLUMNS; column++) {
@@ -152,7 +144,7 @@ static void video(const void *const context, const int pointer_state,
     for (int column = x - 2; column < x + 2; column++) {
       opacities[row * COLUMNS + column] = 1.0f;
       reds[row * COLUMNS + column] = 1;
-      greens[row * COLUMNS + column] = key_held(context, VK_SPACE) ? 1 : 0;
+      greens[row * COLUMNS + column] = key_held(input, VK_SPACE) ? 1 : 0;
       blues[row * COLUMNS + column] = 1;
     }
   }
@@ -161,8 +153,8 @@ static void video(const void *const context, const int pointer_state,
 
   video_pointer(tick_pointer_state, tick_pointer_row, tick_pointer_column, 1, 0,
                 0, 0, 1, 0, 0, 0, 1);
-  video_pointer(pointer_state, pointer_row, pointer_column, 0, 1, 1, 1, 0, 1, 1,
-                1, 0);
+  video_pointer(input->pointer_state, input->pointer_row, input->pointer_column,
+                0, 1, 1, 1, 0, 1, 1, 1, 0);
 
   video_calls++;
 }
@@ -179,6 +171,12 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine,
   next_y = calculate_y(1);
   ticks = 2;
 
+  const run_event_loop_options options = {
+      .maximum_ticks_per_batch = 4,
+      .audio_output = AUDIO_OUTPUT_WASAPI,
+      .audio_resampling = AUDIO_RESAMPLING_MEDIUM,
+  };
+
   const char *const error_message = run_event_loop(
       "Example Application", 100, tick, ROWS, COLUMNS,
       MessageBox(HWND_DESKTOP,
@@ -186,7 +184,7 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine,
                  MB_YESNO | MB_ICONQUESTION) == IDYES
           ? opacities
           : NULL,
-      reds, greens, blues, video, SAMPLES_PER_TICK, left, right, nShowCmd);
+      reds, greens, blues, video, SAMPLES_PER_TICK, &options, nShowCmd);
 
   if (error_message == NULL) {
     printf("Successfully completed.\n");
@@ -0,0 +1,131 @@
+#ifndef AUDIO_BACKEND_H
+
+#define AUDIO_BACKEND_H
+
+#include <stdint.h>
+
+/**
+ * Audio is given to the audio backend as 32-bit floating-point samples, exactly
+ * as generated by ticks.
+ */
+#define AUDIO_FORMAT_FLOAT 0
+
+/**
+ * Audio is converted to signed 16-bit integer samples before being given to the
+ * audio backend, which some drivers handle better than floating point, and
+ * which halves the memory the audio backend needs for it.
+ */
+#define AUDIO_FORMAT_INT16 1
+
+/**
+ * As AUDIO_FORMAT_INT16, but with triangular probability density function
+ * dither added before conversion, so that quiet audio fades out into a low
+ * noise floor rather than into distortion.
+ */
+#define AUDIO_FORMAT_INT16_DITHERED 2
+
+/**
+ * A destination for interleaved stereo audio, such as an audio device.  Audio
+ * is given to a backend one slot of an audio ring at a time; every slot is the
+ * same size, and slots are submitted, and finish playing, in the order of the
+ * ring.
+ *
+ * Backends are opened, paused, by functions specific to each; the following
+ * are common to all of them.
+ */
+typedef struct {
+  /**
+   * Passed to each of the following functions.
+   */
+  void *const state;
+
+  /**
+   * Makes one of the slots of an audio ring known to the backend before it is
+   * first submitted.  Called once for each slot before any are submitted.
+   * @param state The state of the backend.
+   * @param slot The index of the slot.
+   * @param samples The samples of the slot.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const prepare)(void *const state, const uint32_t slot,
+                               float *const samples);
+
+  /**
+   * Queues a slot to be played after every slot previously submitted.
+   * @param state The state of the backend.
+   * @param slot The index of the slot.
+   * @param samples The samples of the slot, which must not be modified until
+   *                the backend reports that the slot has finished playing.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const submit)(void *const state, const uint32_t slot,
+                              const float *const samples);
+
+  /**
+   * Retrieves the number of submitted slots which have finished playing since
+   * the backend was opened, wrapping at 2^32.
+   * @param state The state of the backend.
+   * @param completed Written to on success.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const get_completed)(void *const state,
+                                     uint32_t *const completed);
+
+  /**
+   * Determines the most slots which may be queued at once.
+   * @param state The state of the backend.
+   * @return The number of slots, which is at least 1.
+   */
+  uint32_t (*const get_capacity)(void *const state);
+
+  /**
+   * Retrieves the number of samples which have been played since the backend
+   * was opened, wrapping at 2^32.  Suitable for use as the get_position of a
+   * scheduler clock.
+   * @param state The state of the backend.
+   * @param position Written to on success.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const get_position)(void *const state,
+                                    uint32_t *const position);
+
+  /**
+   * Stops playback without discarding any queued slots.
+   * @param state The state of the backend.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const pause)(void *const state);
+
+  /**
+   * Starts or continues playback.
+   * @param state The state of the backend.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const resume)(void *const state);
+
+  /**
+   * Stops playback, discarding any queued slots, which are then reported as
+   * having finished playing.
+   * @param state The state of the backend.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const reset)(void *const state);
+
+  /**
+   * Closes the backend, releasing everything it holds.  Should the backend
+   * have been playing, it must first be reset.
+   * @param state The state of the backend.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const close)(void *const state);
+} audio_backend;
+
+#endif
@@ -0,0 +1,94 @@
+#include "audio_ring.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// All three counters only ever increase (wrapping), and each is written by one
+// thread alone.  The writer publishes a slot by releasing "written" after
+// filling it, and the reader returns a slot by releasing "read" only once it
+// has finished with it, so neither can observe the other's half-finished work.
+// "reading" lies between the two, counting slots taken but not yet returned.
+// The indices of the next slots are tracked separately, as the counters wrap
+// at 2^32 rather than at a multiple of the number of slots.
+
+void audio_ring_initialize(audio_ring *const audio_ring, float *const samples,
+                           const uint32_t slots,
+                           const uint32_t samples_per_slot) {
+  audio_ring->samples = samples;
+  audio_ring->slots = slots;
+  audio_ring->samples_per_slot = samples_per_slot;
+  audio_ring->written = 0;
+  audio_ring->reading = 0;
+  audio_ring->read = 0;
+  audio_ring->next_written_slot = 0;
+  audio_ring->next_reading_slot = 0;
+  audio_ring->high_watermark = 0;
+  audio_ring->low_watermark = slots;
+}
+
+float *audio_ring_slot(const audio_ring *const audio_ring,
+                       const uint32_t slot) {
+  return audio_ring->samples + slot * audio_ring->samples_per_slot;
+}
+
+float *audio_ring_begin_write(const audio_ring *const audio_ring) {
+  const uint32_t written = audio_ring->written;
+  const uint32_t read = __atomic_load_n(&audio_ring->read, __ATOMIC_ACQUIRE);
+
+  if (written - read == audio_ring->slots) {
+    return NULL;
+  }
+
+  return audio_ring_slot(audio_ring, audio_ring->next_written_slot);
+}
+
+void audio_ring_publish(audio_ring *const audio_ring) {
+  const uint32_t written = audio_ring->written + 1;
+  audio_ring->next_written_slot =
+      (audio_ring->next_written_slot + 1) % audio_ring->slots;
+
+  __atomic_store_n(&audio_ring->written, written, __ATOMIC_RELEASE);
+
+  const uint32_t waiting =
+      written - __atomic_load_n(&audio_ring->reading, __ATOMIC_ACQUIRE);
+
+  if (waiting > audio_ring->high_watermark) {
+    __atomic_store_n(&audio_ring->high_watermark, waiting, __ATOMIC_RELAXED);
+  }
+}
+
+bool audio_ring_begin_read(audio_ring *const audio_ring, uint32_t *const slot) {
+  const uint32_t reading = audio_ring->reading;
+  const uint32_t waiting =
+      __atomic_load_n(&audio_ring->written, __ATOMIC_ACQUIRE) - reading;
+
+  if (waiting < audio_ring->low_watermark) {
+    __atomic_store_n(&audio_ring->low_watermark, waiting, __ATOMIC_RELAXED);
+  }
+
+  if (waiting == 0) {
+    return false;
+  }
+
+  *slot = audio_ring->next_reading_slot;
+  audio_ring->next_reading_slot = (*slot + 1) % audio_ring->slots;
+  __atomic_store_n(&audio_ring->reading, reading + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+void audio_ring_release(audio_ring *const audio_ring) {
+  __atomic_store_n(&audio_ring->read, audio_ring->read + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t audio_ring_waiting(const audio_ring *const audio_ring) {
+  return __atomic_load_n(&audio_ring->written, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(&audio_ring->reading, __ATOMIC_ACQUIRE);
+}
+
+uint32_t audio_ring_high_watermark(const audio_ring *const audio_ring) {
+  return __atomic_load_n(&audio_ring->high_watermark, __ATOMIC_RELAXED);
+}
+
+uint32_t audio_ring_low_watermark(const audio_ring *const audio_ring) {
+  return __atomic_load_n(&audio_ring->low_watermark, __ATOMIC_RELAXED);
+}
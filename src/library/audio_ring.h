@@ -0,0 +1,109 @@
+#ifndef AUDIO_RING_H
+
+#define AUDIO_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A lock-free ring of fixed-size slots of interleaved stereo samples, safe for
+ * one thread to fill slots while another consumes them.  Slots are written to
+ * and read from in place, so that audio need never be copied between threads.
+ * All fields are owned by the ring and should only be accessed through the
+ * functions below.
+ */
+typedef struct {
+  float *samples;
+  uint32_t slots;
+  uint32_t samples_per_slot;
+  uint32_t written;
+  uint32_t reading;
+  uint32_t read;
+  uint32_t next_written_slot;
+  uint32_t next_reading_slot;
+  uint32_t high_watermark;
+  uint32_t low_watermark;
+} audio_ring;
+
+/**
+ * Prepares an empty ring.  Must not be called while either thread is using it.
+ * @param audio_ring The ring to prepare.
+ * @param samples The storage for the ring.  Must have space for slots
+ *                multiplied by samples_per_slot samples, and remain valid for
+ *                as long as the ring is used.
+ * @param slots The number of slots in the ring.  Behavior is undefined if less
+ *              than 1.
+ * @param samples_per_slot The number of samples in each slot, across both
+ *                         channels.  Behavior is undefined if less than 1.
+ */
+void audio_ring_initialize(audio_ring *const audio_ring, float *const samples,
+                           const uint32_t slots,
+                           const uint32_t samples_per_slot);
+
+/**
+ * Retrieves one of the slots of a ring.
+ * @param audio_ring The ring to retrieve a slot of.
+ * @param slot The index of the slot to retrieve.  Behavior is undefined if not
+ *             less than the number of slots in the ring.
+ * @return The samples of the slot.
+ */
+float *audio_ring_slot(const audio_ring *const audio_ring, const uint32_t slot);
+
+/**
+ * Retrieves the next slot to be filled by the writing thread.  Only one thread
+ * may write to a ring.
+ * @param audio_ring The ring to write to.
+ * @return The samples of the slot, to be filled and then published using
+ *         audio_ring_publish, or null when every slot is still in use.
+ */
+float *audio_ring_begin_write(const audio_ring *const audio_ring);
+
+/**
+ * Makes the slot most recently returned by audio_ring_begin_write available to
+ * the reading thread.
+ * @param audio_ring The ring to publish to.
+ */
+void audio_ring_publish(audio_ring *const audio_ring);
+
+/**
+ * Takes the earliest published slot which the reading thread has not yet
+ * taken.  Only one thread may read from a ring.
+ * @param audio_ring The ring to read from.
+ * @param slot Written to with the index of the slot taken, on success.
+ * @return True when a slot was taken, false when none were waiting.
+ */
+bool audio_ring_begin_read(audio_ring *const audio_ring, uint32_t *const slot);
+
+/**
+ * Returns the earliest slot taken by the reading thread to the writing thread
+ * once the reading thread has finished with it.
+ * @param audio_ring The ring to return a slot to.
+ */
+void audio_ring_release(audio_ring *const audio_ring);
+
+/**
+ * Determines how many published slots the reading thread has not yet taken.
+ * May be called from either thread.
+ * @param audio_ring The ring to query.
+ * @return The number of slots waiting to be taken.
+ */
+uint32_t audio_ring_waiting(const audio_ring *const audio_ring);
+
+/**
+ * Determines the most slots which have been waiting to be taken immediately
+ * after a slot was published.  May be called from either thread.
+ * @param audio_ring The ring to query.
+ * @return The high watermark, in slots.
+ */
+uint32_t audio_ring_high_watermark(const audio_ring *const audio_ring);
+
+/**
+ * Determines the fewest slots which have been waiting to be taken whenever the
+ * reading thread attempted to take one.  May be called from either thread.
+ * @param audio_ring The ring to query.
+ * @return The low watermark, in slots, or the number of slots in the ring
+ *         should the reading thread not yet have attempted to take one.
+ */
+uint32_t audio_ring_low_watermark(const audio_ring *const audio_ring);
+
+#endif
@@ -0,0 +1,454 @@
+#include "audio_stream.h"
+#include "file_mapping.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The format tags of the supported WAV files.
+#define FORMAT_INT16 1
+#define FORMAT_FLOAT 3
+#define FORMAT_IMA_ADPCM 0x11
+#define FORMAT_EXTENSIBLE 0xFFFE
+
+// Uncompressed audio is read in runs of at most this many samples per channel.
+#define MAXIMUM_RUN 4096
+
+// Indicates that no IMA ADPCM block has yet been decoded.
+#define NO_BLOCK UINT64_MAX
+
+static const int16_t ima_steps[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t ima_index_changes[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                             -1, -1, -1, -1, 2, 4, 6, 8};
+
+static uint16_t get_uint16(const uint8_t *const bytes) {
+  return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t get_uint32(const uint8_t *const bytes) {
+  return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+         ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static const char *read_format(audio_stream *const audio_stream,
+                               const uint8_t *const bytes,
+                               const uint32_t size,
+                               const uint32_t samples_per_second) {
+  uint16_t format = get_uint16(bytes);
+  const uint16_t channels = get_uint16(bytes + 2);
+  const uint16_t block_align = get_uint16(bytes + 12);
+  const uint16_t bits_per_sample = get_uint16(bytes + 14);
+
+  // Extensible formats name the actual format in the first two bytes of their
+  // sub-format GUID.
+  if (format == FORMAT_EXTENSIBLE) {
+    if (size < 40) {
+      return "The WAV file's format is not supported.";
+    }
+
+    format = get_uint16(bytes + 24);
+  }
+
+  if (channels != 1 && channels != 2) {
+    return "The WAV file's format is not supported.";
+  }
+
+  switch (format) {
+  case FORMAT_INT16:
+    if (bits_per_sample != 16 || block_align != 2 * channels) {
+      return "The WAV file's format is not supported.";
+    }
+
+    audio_stream->samples_per_block = 1;
+    break;
+
+  case FORMAT_FLOAT:
+    if (bits_per_sample != 32 || block_align != 4 * channels) {
+      return "The WAV file's format is not supported.";
+    }
+
+    audio_stream->samples_per_block = 1;
+    break;
+
+  case FORMAT_IMA_ADPCM: {
+    // Each block starts with a header of 4 bytes per channel, followed by
+    // groups of 4 bytes (8 samples) per channel.
+    const uint32_t header = 4 * channels;
+
+    if (bits_per_sample != 4 || block_align <= header ||
+        (block_align - header) % header != 0) {
+      return "The WAV file's format is not supported.";
+    }
+
+    audio_stream->samples_per_block =
+        (block_align - header) / header * 8 + 1;
+
+    if (audio_stream->samples_per_block > AUDIO_STREAM_MAXIMUM_BLOCK_SAMPLES) {
+      return "The WAV file's IMA ADPCM blocks are too large.";
+    }
+
+    break;
+  }
+
+  default:
+    return "The WAV file's format is not supported.";
+  }
+
+  if (get_uint32(bytes + 4) != samples_per_second) {
+    return "The WAV file's sample rate does not match that of the audio.";
+  }
+
+  audio_stream->format = format;
+  audio_stream->channels = channels;
+  audio_stream->block_align = block_align;
+  return NULL;
+}
+
+const char *audio_stream_open(audio_stream *const audio_stream,
+                              file_mapping *const file_mapping,
+                              const uint32_t samples_per_second,
+                              const bool looping) {
+  const uint64_t size = file_mapping_size(file_mapping);
+  const uint8_t *bytes;
+
+  if (size < 12 || file_mapping_read(file_mapping, 0, 12, &bytes) != NULL ||
+      memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0) {
+    return "The file is not a WAV file.";
+  }
+
+  bool found_format = false;
+  bool found_data = false;
+  bool found_fact = false;
+  uint32_t fact_samples = 0;
+  uint64_t offset = 12;
+
+  // Chunks may appear in any order, so every chunk header is read.
+  while (size - offset >= 8) {
+    const char *const header_error =
+        file_mapping_read(file_mapping, offset, 8, &bytes);
+
+    if (header_error != NULL) {
+      return header_error;
+    }
+
+    const uint32_t chunk_size = get_uint32(bytes + 4);
+    const uint64_t available = size - offset - 8;
+
+    if (memcmp(bytes, "fmt ", 4) == 0) {
+      const uint32_t format_size = chunk_size < 40 ? chunk_size : 40;
+
+      if (format_size < 16 || format_size > available) {
+        return "The WAV file's format chunk is truncated.";
+      }
+
+      const char *const read_error =
+          file_mapping_read(file_mapping, offset + 8, format_size, &bytes);
+
+      if (read_error != NULL) {
+        return read_error;
+      }
+
+      const char *const format_error =
+          read_format(audio_stream, bytes, format_size, samples_per_second);
+
+      if (format_error != NULL) {
+        return format_error;
+      }
+
+      found_format = true;
+    } else if (memcmp(bytes, "fact", 4) == 0 && chunk_size >= 4 &&
+               available >= 4) {
+      const char *const read_error =
+          file_mapping_read(file_mapping, offset + 8, 4, &bytes);
+
+      if (read_error != NULL) {
+        return read_error;
+      }
+
+      fact_samples = get_uint32(bytes);
+      found_fact = true;
+    } else if (memcmp(bytes, "data", 4) == 0) {
+      // Files which were not finished being written may claim more data than
+      // they contain.
+      audio_stream->data_offset = offset + 8;
+      audio_stream->data_size = chunk_size < available ? chunk_size : available;
+      found_data = true;
+    }
+
+    if (chunk_size >= available) {
+      break;
+    }
+
+    // Chunks are padded to an even number of bytes.
+    offset += 8 + (uint64_t)chunk_size + (chunk_size & 1);
+  }
+
+  if (!found_format) {
+    return "The WAV file has no format chunk.";
+  }
+
+  if (!found_data) {
+    return "The WAV file has no data chunk.";
+  }
+
+  if (audio_stream->format == FORMAT_IMA_ADPCM) {
+    // The final block may be partial.
+    const uint32_t header = 4 * audio_stream->channels;
+    const uint64_t remainder =
+        audio_stream->data_size % audio_stream->block_align;
+
+    audio_stream->samples =
+        audio_stream->data_size / audio_stream->block_align *
+            audio_stream->samples_per_block +
+        (remainder >= header ? (remainder - header) / header * 8 + 1 : 0);
+
+    // The fact chunk excludes the padding at the end of the final block.
+    if (found_fact && fact_samples < audio_stream->samples) {
+      audio_stream->samples = fact_samples;
+    }
+  } else {
+    audio_stream->samples =
+        audio_stream->data_size / audio_stream->block_align;
+  }
+
+  audio_stream->file_mapping = file_mapping;
+  audio_stream->position = 0;
+  audio_stream->decoded_block = NO_BLOCK;
+  audio_stream->decoded_samples = 0;
+  audio_stream->looping = looping;
+  return NULL;
+}
+
+static void add_int16(const uint8_t *const bytes, const uint16_t channels,
+                      float *const audio, const uint32_t samples,
+                      const float gain) {
+  const float scale = gain / 32768.0f;
+
+  if (channels == 1) {
+    for (uint32_t sample = 0; sample < samples; sample++) {
+      const float value =
+          (int16_t)get_uint16(bytes + sample * 2) * scale;
+      audio[sample * 2] += value;
+      audio[sample * 2 + 1] += value;
+    }
+  } else {
+    for (uint32_t sample = 0; sample < samples * 2; sample++) {
+      audio[sample] += (int16_t)get_uint16(bytes + sample * 2) * scale;
+    }
+  }
+}
+
+static void add_decoded(const int16_t *const decoded, const uint16_t channels,
+                        float *const audio, const uint32_t samples,
+                        const float gain) {
+  const float scale = gain / 32768.0f;
+
+  if (channels == 1) {
+    for (uint32_t sample = 0; sample < samples; sample++) {
+      const float value = decoded[sample] * scale;
+      audio[sample * 2] += value;
+      audio[sample * 2 + 1] += value;
+    }
+  } else {
+    for (uint32_t sample = 0; sample < samples * 2; sample++) {
+      audio[sample] += decoded[sample] * scale;
+    }
+  }
+}
+
+static void add_float(const uint8_t *const bytes, const uint16_t channels,
+                      float *const audio, const uint32_t samples,
+                      const float gain) {
+  if (channels == 1) {
+    for (uint32_t sample = 0; sample < samples; sample++) {
+      float value;
+      memcpy(&value, bytes + sample * 4, sizeof(value));
+      audio[sample * 2] += value * gain;
+      audio[sample * 2 + 1] += value * gain;
+    }
+  } else {
+    for (uint32_t sample = 0; sample < samples * 2; sample++) {
+      float value;
+      memcpy(&value, bytes + sample * 4, sizeof(value));
+      audio[sample] += value * gain;
+    }
+  }
+}
+
+static const char *decode_block(audio_stream *const audio_stream,
+                                const uint64_t block) {
+  const uint16_t channels = audio_stream->channels;
+  const uint64_t start = block * audio_stream->block_align;
+  const uint64_t remaining = audio_stream->data_size - start;
+  const uint32_t size = remaining < audio_stream->block_align
+                            ? (uint32_t)remaining
+                            : audio_stream->block_align;
+  const uint8_t *bytes;
+
+  const char *const error = file_mapping_read(
+      audio_stream->file_mapping, audio_stream->data_offset + start, size,
+      &bytes);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  int16_t *const decoded = audio_stream->decoded;
+  const uint32_t groups = (size - 4 * channels) / (4 * channels);
+
+  for (uint16_t channel = 0; channel < channels; channel++) {
+    const uint8_t *const header = bytes + channel * 4;
+    int32_t predictor = (int16_t)get_uint16(header);
+    int32_t index = header[2];
+
+    if (index > 88) {
+      return "The WAV file contains corrupt IMA ADPCM data.";
+    }
+
+    decoded[channel] = (int16_t)predictor;
+
+    // Each group holds 8 samples for one channel, and groups alternate
+    // between channels.
+    for (uint32_t group = 0; group < groups; group++) {
+      const uint8_t *const nibbles =
+          bytes + 4 * channels + (group * channels + channel) * 4;
+
+      for (int nibble = 0; nibble < 8; nibble++) {
+        const uint8_t code = (nibbles[nibble / 2] >> (nibble % 2 * 4)) & 15;
+        const int32_t step = ima_steps[index];
+        int32_t difference = step >> 3;
+
+        if (code & 4) {
+          difference += step;
+        }
+
+        if (code & 2) {
+          difference += step >> 1;
+        }
+
+        if (code & 1) {
+          difference += step >> 2;
+        }
+
+        predictor += code & 8 ? -difference : difference;
+        predictor = predictor < -32768  ? -32768
+                    : predictor > 32767 ? 32767
+                                        : predictor;
+        index += ima_index_changes[code];
+        index = index < 0 ? 0 : index > 88 ? 88 : index;
+        decoded[(1 + group * 8 + nibble) * channels + channel] =
+            (int16_t)predictor;
+      }
+    }
+  }
+
+  audio_stream->decoded_block = block;
+  audio_stream->decoded_samples = 1 + groups * 8;
+  return NULL;
+}
+
+// Adds as many of the next samples as can be decoded at once, returning how
+// many were added.
+static const char *mix_run(audio_stream *const audio_stream,
+                           float *const audio, const uint32_t samples,
+                           const float gain, uint32_t *const mixed) {
+  const uint16_t channels = audio_stream->channels;
+
+  if (audio_stream->format == FORMAT_IMA_ADPCM) {
+    const uint64_t block =
+        audio_stream->position / audio_stream->samples_per_block;
+    const uint32_t offset =
+        audio_stream->position % audio_stream->samples_per_block;
+
+    if (audio_stream->decoded_block != block) {
+      const char *const error = decode_block(audio_stream, block);
+
+      if (error != NULL) {
+        return error;
+      }
+    }
+
+    if (offset >= audio_stream->decoded_samples) {
+      return "The WAV file contains corrupt IMA ADPCM data.";
+    }
+
+    const uint32_t available = audio_stream->decoded_samples - offset;
+    *mixed = samples < available ? samples : available;
+    add_decoded(audio_stream->decoded + offset * channels, channels, audio,
+                *mixed, gain);
+  } else {
+    const uint8_t *bytes;
+    *mixed = samples < MAXIMUM_RUN ? samples : MAXIMUM_RUN;
+
+    const char *const error = file_mapping_read(
+        audio_stream->file_mapping,
+        audio_stream->data_offset +
+            audio_stream->position * audio_stream->block_align,
+        (size_t)*mixed * audio_stream->block_align, &bytes);
+
+    if (error != NULL) {
+      return error;
+    }
+
+    if (audio_stream->format == FORMAT_INT16) {
+      add_int16(bytes, channels, audio, *mixed, gain);
+    } else {
+      add_float(bytes, channels, audio, *mixed, gain);
+    }
+  }
+
+  audio_stream->position += *mixed;
+  return NULL;
+}
+
+const char *audio_stream_mix(audio_stream *const audio_stream,
+                             float *const audio, const uint32_t samples,
+                             const float gain, bool *const ended) {
+  uint32_t sample = 0;
+
+  while (sample < samples) {
+    if (audio_stream->position == audio_stream->samples) {
+      if (!audio_stream->looping || audio_stream->samples == 0) {
+        *ended = true;
+        return NULL;
+      }
+
+      audio_stream->position = 0;
+    }
+
+    const uint64_t remaining = audio_stream->samples - audio_stream->position;
+    const uint32_t requested = samples - sample < remaining
+                                   ? samples - sample
+                                   : (uint32_t)remaining;
+    uint32_t mixed;
+
+    const char *const error = mix_run(audio_stream, audio + sample * 2,
+                                      requested, gain, &mixed);
+
+    if (error != NULL) {
+      return error;
+    }
+
+    sample += mixed;
+  }
+
+  *ended = !audio_stream->looping &&
+           audio_stream->position == audio_stream->samples;
+  return NULL;
+}
+
+void audio_stream_seek(audio_stream *const audio_stream,
+                       const uint64_t sample) {
+  audio_stream->position =
+      sample < audio_stream->samples ? sample : audio_stream->samples;
+}
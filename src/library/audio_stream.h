@@ -0,0 +1,87 @@
+#ifndef AUDIO_STREAM_H
+
+#define AUDIO_STREAM_H
+
+#include "file_mapping.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The most samples per channel which may be packed into a single block of an
+ * IMA ADPCM stream.  Common encoders use far fewer (e.g. 1017 for 512-byte
+ * stereo blocks).
+ */
+#define AUDIO_STREAM_MAXIMUM_BLOCK_SAMPLES 8192
+
+/**
+ * A mono or stereo WAV file which is decoded incrementally as it plays, so
+ * that long tracks such as music need neither be decoded up front nor held in
+ * memory.  16-bit integer, 32-bit floating-point and IMA ADPCM (4 bits per
+ * sample) WAV files are supported.  All fields are owned by the audio stream
+ * and should only be accessed through the functions below.
+ */
+typedef struct {
+  file_mapping *file_mapping;
+  uint16_t format;
+  uint16_t channels;
+  uint16_t block_align;
+  uint32_t samples_per_block;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t samples;
+  uint64_t position;
+  uint64_t decoded_block;
+  uint32_t decoded_samples;
+  bool looping;
+  int16_t decoded[AUDIO_STREAM_MAXIMUM_BLOCK_SAMPLES * 2];
+} audio_stream;
+
+/**
+ * Opens an audio stream, reading its header.
+ * @param audio_stream The audio stream to open.
+ * @param file_mapping The already-opened file mapping of the WAV file to
+ *                     stream.  Must remain open for as long as the audio
+ *                     stream is in use, and must not be read from by anything
+ *                     else in the meantime.
+ * @param samples_per_second The sample rate of the audio into which the audio
+ *                           stream will be mixed, which the WAV file must
+ *                           match.
+ * @param looping When true, the audio stream repeats from its start once it
+ *                ends.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *audio_stream_open(audio_stream *const audio_stream,
+                              file_mapping *const file_mapping,
+                              const uint32_t samples_per_second,
+                              const bool looping);
+
+/**
+ * Decodes the next samples of an audio stream, adding them to audio (such as
+ * that of a tick, or that produced by a mixer).  Mono audio streams are added
+ * to both channels.
+ * @param audio_stream The audio stream to decode.
+ * @param audio The interleaved stereo samples to add to.
+ * @param samples The number of samples per channel to add.  Should the audio
+ *                stream end (without looping) part of the way through, the
+ *                remaining samples are left unchanged.
+ * @param gain The volume of the audio stream, where 1 is unchanged.  Behavior
+ *             is undefined if NaN or infinite.
+ * @param ended Written to with true should the audio stream have ended
+ *              (without looping), otherwise, false.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *audio_stream_mix(audio_stream *const audio_stream,
+                             float *const audio, const uint32_t samples,
+                             const float gain, bool *const ended);
+
+/**
+ * Moves the position from which an audio stream next decodes.
+ * @param audio_stream The audio stream to seek within.
+ * @param sample The number of samples per channel from the start of the audio
+ *               stream.  Positions beyond its end are clamped to its end.
+ */
+void audio_stream_seek(audio_stream *const audio_stream, const uint64_t sample);
+
+#endif
@@ -0,0 +1,539 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "capture.h"
+#include "frame_codec.h"
+#include "framebuffer.h"
+#include "headless_output.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+// Each file is written through a buffer this large, so that the disk sees few,
+// large, sequential writes.
+#define CAPTURE_FILE_BUFFER_BYTES 4194304
+
+#define WAV_HEADER_BYTES 44
+
+// The ring counters only ever increase (wrapping), and each is written by one
+// thread alone, as with audio_ring.  The semaphore is released once per slot
+// published, and once more when stopping, so that the writer thread wakes
+// exactly once for each.
+
+static void write_u16(uint8_t *const bytes, const uint16_t value) {
+  bytes[0] = value;
+  bytes[1] = value >> 8;
+}
+
+static void write_u32(uint8_t *const bytes, const uint32_t value) {
+  write_u16(bytes, value);
+  write_u16(bytes + 2, value >> 16);
+}
+
+static void wav_header(uint8_t *const header, const int samples_per_second,
+                       const uint32_t data_bytes) {
+  memcpy(header, "RIFF", 4);
+  write_u32(header + 4, WAV_HEADER_BYTES - 8 + data_bytes);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  write_u32(header + 16, 16);
+  write_u16(header + 20, 3);
+  write_u16(header + 22, 2);
+  write_u32(header + 24, samples_per_second);
+  write_u32(header + 28, samples_per_second * 8);
+  write_u16(header + 32, 8);
+  write_u16(header + 34, 32);
+  memcpy(header + 36, "data", 4);
+  write_u32(header + 40, data_bytes);
+}
+
+static void ring_initialize(capture_ring *const ring, float *const samples,
+                            const uint32_t slots,
+                            const uint32_t samples_per_slot) {
+  ring->samples = samples;
+  ring->slots = slots;
+  ring->samples_per_slot = samples_per_slot;
+  ring->written = 0;
+  ring->read = 0;
+  ring->next_written_slot = 0;
+  ring->next_read_slot = 0;
+}
+
+static float *ring_begin_write(const capture_ring *const ring) {
+  const uint32_t read = __atomic_load_n(&ring->read, __ATOMIC_ACQUIRE);
+
+  if (ring->written - read == ring->slots) {
+    return NULL;
+  }
+
+  return ring->samples + ring->next_written_slot * ring->samples_per_slot;
+}
+
+static void ring_publish(capture_ring *const ring) {
+  ring->next_written_slot = (ring->next_written_slot + 1) % ring->slots;
+  __atomic_store_n(&ring->written, ring->written + 1, __ATOMIC_RELEASE);
+}
+
+static const float *ring_begin_read(const capture_ring *const ring) {
+  const uint32_t written = __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE);
+
+  if (written == ring->read) {
+    return NULL;
+  }
+
+  return ring->samples + ring->next_read_slot * ring->samples_per_slot;
+}
+
+static void ring_release(capture_ring *const ring) {
+  ring->next_read_slot = (ring->next_read_slot + 1) % ring->slots;
+  __atomic_store_n(&ring->read, ring->read + 1, __ATOMIC_RELEASE);
+}
+
+static void signal_pending(capture *const capture) {
+#ifdef _WIN32
+  ReleaseSemaphore(capture->pending, 1, NULL);
+#else
+  sem_post(&capture->pending);
+#endif
+}
+
+static void await_pending(capture *const capture) {
+#ifdef _WIN32
+  WaitForSingleObject(capture->pending, INFINITE);
+#else
+  while (sem_wait(&capture->pending) != 0) {
+  }
+#endif
+}
+
+static void write_frame(capture *const capture, const float *const planes) {
+  const int pixels = capture->rows * capture->columns;
+  uint8_t *const bgr = capture->pixels;
+
+  framebuffer_convert_opaque(capture->rows, capture->columns, planes,
+                             planes + pixels, planes + pixels * 2, 0, bgr);
+
+  if (capture->video_format == CAPTURE_VIDEO_RAW) {
+    if (fwrite(bgr, 3, pixels, capture->video_file) != (size_t)pixels) {
+      capture->error = "Failed to write to the video capture file.";
+    }
+
+    return;
+  }
+
+  if (capture->video_format == CAPTURE_VIDEO_QOI) {
+    uint8_t *const encoded = bgr + pixels * 3;
+    const size_t bytes = frame_codec_encode(bgr, capture->rows,
+                                            capture->columns, 3, encoded);
+
+    if (fwrite(encoded, 1, bytes, capture->video_file) != bytes) {
+      capture->error = "Failed to write to the video capture file.";
+    }
+
+    return;
+  }
+
+  uint8_t *const luma = bgr + pixels * 3;
+  uint8_t *const blue_difference = luma + pixels;
+  uint8_t *const red_difference = blue_difference + pixels;
+
+  // Full-range BT.601, as used by JPEG, in 16-bit fixed point.  The offset of
+  // 128 is added before shifting so that nothing shifted is negative.
+  for (int index = 0; index < pixels; index++) {
+    const int32_t blue = bgr[index * 3];
+    const int32_t green = bgr[index * 3 + 1];
+    const int32_t red = bgr[index * 3 + 2];
+    const int32_t cb = (-11059 * red - 21709 * green + 32768 * blue +
+                        (128 << 16) + 32768) >>
+                       16;
+    const int32_t cr = (32768 * red - 27439 * green - 5329 * blue +
+                        (128 << 16) + 32768) >>
+                       16;
+
+    luma[index] = (19595 * red + 38470 * green + 7471 * blue + 32768) >> 16;
+    blue_difference[index] = cb > 255 ? 255 : cb;
+    red_difference[index] = cr > 255 ? 255 : cr;
+  }
+
+  if (fwrite("FRAME\n", 1, 6, capture->video_file) != 6 ||
+      fwrite(luma, 3, pixels, capture->video_file) != (size_t)pixels) {
+    capture->error = "Failed to write to the video capture file.";
+  }
+}
+
+static void write_tick(capture *const capture, const float *const audio) {
+  const size_t samples = capture->samples_per_tick * 2;
+
+  if (fwrite(audio, sizeof(float), samples, capture->audio_file) != samples) {
+    capture->error = "Failed to write to the audio capture file.";
+  } else {
+    capture->audio_bytes += samples * sizeof(float);
+  }
+}
+
+typedef void (*slot_writer)(capture *const capture,
+                            const float *const samples);
+
+// Writes (or, following an error, discards) the earliest slot of a ring.
+static bool write_next(capture *const capture, capture_ring *const ring,
+                       const slot_writer write) {
+  const float *const samples = ring_begin_read(ring);
+
+  if (samples == NULL) {
+    return false;
+  }
+
+  if (capture->error == NULL) {
+    write(capture, samples);
+  }
+
+  ring_release(ring);
+  return true;
+}
+
+static void run_writer(capture *const capture) {
+  while (true) {
+    await_pending(capture);
+
+    if (!write_next(capture, &capture->video_ring, write_frame) &&
+        !write_next(capture, &capture->audio_ring, write_tick) &&
+        __atomic_load_n(&capture->stopping, __ATOMIC_ACQUIRE)) {
+      return;
+    }
+  }
+}
+
+#ifdef _WIN32
+
+static DWORD WINAPI writer_thread(LPVOID lpParam) {
+  run_writer(lpParam);
+  return 0;
+}
+
+static const char *start_writer(capture *const capture,
+                                const LONG maximum_pending) {
+  capture->pending = CreateSemaphoreA(NULL, 0, maximum_pending, NULL);
+
+  if (capture->pending == NULL) {
+    return "Failed to create a semaphore for the capture writer thread.";
+  }
+
+  capture->thread = CreateThread(NULL, 0, writer_thread, capture, 0, NULL);
+
+  if (capture->thread == NULL) {
+    if (CloseHandle(capture->pending)) {
+      return "Failed to start the capture writer thread.";
+    } else {
+      return "Failed to start the capture writer thread.  Additionally "
+             "failed to close its semaphore.";
+    }
+  }
+
+  return NULL;
+}
+
+static const char *stop_writer(capture *const capture) {
+  const bool joined =
+      WaitForSingleObject(capture->thread, INFINITE) == WAIT_OBJECT_0;
+  const bool closed_thread = CloseHandle(capture->thread);
+  const bool closed_semaphore = CloseHandle(capture->pending);
+
+  if (!joined) {
+    return "Failed to wait for the capture writer thread to stop.";
+  } else if (!closed_thread || !closed_semaphore) {
+    return "Failed to close the capture writer thread.";
+  } else {
+    return NULL;
+  }
+}
+
+#else
+
+static void *writer_thread(void *const argument) {
+  run_writer(argument);
+  return NULL;
+}
+
+static const char *start_writer(capture *const capture,
+                                const long maximum_pending) {
+  (void)maximum_pending;
+
+  if (sem_init(&capture->pending, 0, 0) != 0) {
+    return "Failed to create a semaphore for the capture writer thread.";
+  }
+
+  if (pthread_create(&capture->thread, NULL, writer_thread, capture) != 0) {
+    if (sem_destroy(&capture->pending) == 0) {
+      return "Failed to start the capture writer thread.";
+    } else {
+      return "Failed to start the capture writer thread.  Additionally "
+             "failed to destroy its semaphore.";
+    }
+  }
+
+  return NULL;
+}
+
+static const char *stop_writer(capture *const capture) {
+  const bool joined = pthread_join(capture->thread, NULL) == 0;
+  const bool destroyed = sem_destroy(&capture->pending) == 0;
+
+  if (!joined) {
+    return "Failed to wait for the capture writer thread to stop.";
+  } else if (!destroyed) {
+    return "Failed to close the capture writer thread.";
+  } else {
+    return NULL;
+  }
+}
+
+#endif
+
+static FILE *open_file(const char *const path) {
+  if (path == NULL) {
+    return NULL;
+  }
+
+  FILE *const file = fopen(path, "wb");
+
+  if (file != NULL) {
+    setvbuf(file, NULL, _IOFBF, CAPTURE_FILE_BUFFER_BYTES);
+  }
+
+  return file;
+}
+
+// Closes whichever files are open, returning false should any fail to close.
+static bool close_files(capture *const capture) {
+  bool closed = true;
+
+  if (capture->video_file != NULL && fclose(capture->video_file) != 0) {
+    closed = false;
+  }
+
+  if (capture->audio_file != NULL && fclose(capture->audio_file) != 0) {
+    closed = false;
+  }
+
+  return closed;
+}
+
+static const char *abandon(capture *const capture, const char *const error,
+                           const char *const error_closing) {
+  const bool closed = close_files(capture);
+  free(capture->video_ring.samples);
+  return closed ? error : error_closing;
+}
+
+const char *capture_open(capture *const capture, const char *const video_path,
+                         const int video_format, const int rows,
+                         const int columns, const int frames_per_second,
+                         const int frame_slots, const char *const audio_path,
+                         const int samples_per_second,
+                         const int samples_per_tick, const int tick_slots) {
+  const size_t pixels = (size_t)rows * columns;
+  const size_t video_samples = video_path == NULL ? 0 : pixels * 3;
+  const size_t audio_samples = audio_path == NULL ? 0 : samples_per_tick * 2;
+  const size_t ring_samples =
+      video_samples * frame_slots + audio_samples * tick_slots;
+  const size_t ring_bytes = sizeof(float) * ring_samples;
+
+  // Room for a frame converted to 24-bit pixels, then to three planes of
+  // YCbCr or compressed.
+  const size_t encoded_bytes = frame_codec_maximum_bytes(rows, columns, 3);
+  const size_t pixel_bytes =
+      video_path == NULL
+          ? 0
+          : pixels * 3 + (encoded_bytes > pixels * 3 ? encoded_bytes
+                                                     : pixels * 3);
+
+  float *const samples = malloc(ring_bytes + pixel_bytes + 1);
+
+  if (samples == NULL) {
+    return "Failed to allocate memory for the capture.";
+  }
+
+  capture->rows = rows;
+  capture->columns = columns;
+  capture->video_format = video_format;
+  capture->samples_per_tick = samples_per_tick;
+  capture->video_file = NULL;
+  capture->audio_file = NULL;
+  ring_initialize(&capture->video_ring, samples, frame_slots, video_samples);
+  ring_initialize(&capture->audio_ring,
+                  samples + video_samples * frame_slots, tick_slots,
+                  audio_samples);
+  capture->pixels = (uint8_t *)samples + ring_bytes;
+  capture->statistics.captured_frames = 0;
+  capture->statistics.dropped_frames = 0;
+  capture->statistics.captured_ticks = 0;
+  capture->statistics.dropped_ticks = 0;
+  capture->audio_bytes = 0;
+  capture->stopping = false;
+  capture->error = NULL;
+
+  capture->video_file = open_file(video_path);
+
+  if (video_path != NULL && capture->video_file == NULL) {
+    free(samples);
+    return "Failed to open the video capture file.";
+  }
+
+  capture->audio_file = open_file(audio_path);
+
+  if (audio_path != NULL && capture->audio_file == NULL) {
+    return abandon(capture, "Failed to open the audio capture file.",
+                   "Failed to open the audio capture file.  Additionally "
+                   "failed to close the video capture file.");
+  }
+
+  if (capture->video_file != NULL && video_format == CAPTURE_VIDEO_Y4M &&
+      fprintf(capture->video_file,
+              "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n",
+              columns, rows, frames_per_second) < 0) {
+    return abandon(capture, "Failed to write to the video capture file.",
+                   "Failed to write to the video capture file.  "
+                   "Additionally failed to close the capture files.");
+  }
+
+  if (capture->audio_file != NULL) {
+    uint8_t header[WAV_HEADER_BYTES];
+    wav_header(header, samples_per_second, 0);
+
+    if (fwrite(header, 1, WAV_HEADER_BYTES, capture->audio_file) !=
+        WAV_HEADER_BYTES) {
+      return abandon(capture, "Failed to write to the audio capture file.",
+                     "Failed to write to the audio capture file.  "
+                     "Additionally failed to close the capture files.");
+    }
+  }
+
+  capture->samples_per_second = samples_per_second;
+
+  const char *const error =
+      start_writer(capture, (long)frame_slots + tick_slots + 1);
+
+  if (error != NULL) {
+    return abandon(capture, error,
+                   "Failed to start the capture writer thread.  "
+                   "Additionally failed to close the capture files.");
+  }
+
+  return NULL;
+}
+
+void capture_video(capture *const capture, const float *const reds,
+                   const float *const greens, const float *const blues) {
+  if (capture->video_file == NULL) {
+    return;
+  }
+
+  float *const slot = ring_begin_write(&capture->video_ring);
+
+  if (slot == NULL) {
+    capture->statistics.dropped_frames++;
+    return;
+  }
+
+  const size_t pixels = (size_t)capture->rows * capture->columns;
+  memcpy(slot, reds, sizeof(float) * pixels);
+  memcpy(slot + pixels, greens, sizeof(float) * pixels);
+  memcpy(slot + pixels * 2, blues, sizeof(float) * pixels);
+  ring_publish(&capture->video_ring);
+  capture->statistics.captured_frames++;
+  signal_pending(capture);
+}
+
+void capture_audio(capture *const capture, const float *const audio) {
+  if (capture->audio_file == NULL) {
+    return;
+  }
+
+  float *const slot = ring_begin_write(&capture->audio_ring);
+
+  if (slot == NULL) {
+    capture->statistics.dropped_ticks++;
+    return;
+  }
+
+  memcpy(slot, audio, sizeof(float) * 2 * capture->samples_per_tick);
+  ring_publish(&capture->audio_ring);
+  capture->statistics.captured_ticks++;
+  signal_pending(capture);
+}
+
+void capture_measure(const capture *const capture,
+                     capture_statistics *const statistics) {
+  *statistics = capture->statistics;
+}
+
+static const char *interface_audio(void *const state,
+                                   const float *const samples,
+                                   const int samples_per_tick) {
+  (void)samples_per_tick;
+  capture_audio(state, samples);
+  return NULL;
+}
+
+static const char *interface_video(void *const state, const int rows,
+                                   const int columns,
+                                   const float *const opacities,
+                                   const float *const reds,
+                                   const float *const greens,
+                                   const float *const blues) {
+  (void)rows;
+  (void)columns;
+  (void)opacities;
+  capture_video(state, reds, greens, blues);
+  return NULL;
+}
+
+headless_output capture_interface(capture *const capture) {
+  const headless_output headless_output = {
+      .state = capture, .audio = interface_audio, .video = interface_video};
+  return headless_output;
+}
+
+const char *capture_close(capture *const capture) {
+  __atomic_store_n(&capture->stopping, true, __ATOMIC_RELEASE);
+  signal_pending(capture);
+
+  const char *const stop_error = stop_writer(capture);
+  const char *error = capture->error == NULL ? stop_error : capture->error;
+
+  // The sizes within the WAV header were unknown until now.
+  if (capture->audio_file != NULL && error == NULL) {
+    uint8_t header[WAV_HEADER_BYTES];
+    const uint64_t maximum_bytes = UINT32_MAX - WAV_HEADER_BYTES;
+    wav_header(header, capture->samples_per_second,
+               capture->audio_bytes < maximum_bytes ? capture->audio_bytes
+                                                    : maximum_bytes);
+
+    if (fseek(capture->audio_file, 0, SEEK_SET) != 0 ||
+        fwrite(header, 1, WAV_HEADER_BYTES, capture->audio_file) !=
+            WAV_HEADER_BYTES) {
+      error = "Failed to write to the audio capture file.";
+    }
+  }
+
+  const bool closed = close_files(capture);
+  free(capture->video_ring.samples);
+
+  if (error == NULL) {
+    return closed ? NULL : "Failed to close the capture files.";
+  } else {
+    return closed ? error
+                  : "Failed to write the capture files.  Additionally failed "
+                    "to close them.";
+  }
+}
@@ -0,0 +1,193 @@
+#ifndef CAPTURE_H
+
+#define CAPTURE_H
+
+#include "headless_output.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+/**
+ * Video is written as a YUV4MPEG2 stream of full-range BT.601 4:4:4 YCbCr,
+ * which most video tools can read directly.
+ */
+#define CAPTURE_VIDEO_Y4M 0
+
+/**
+ * Video is written as headerless 24-bit pixels (blue, green then red bytes),
+ * row-major from the top left corner, one frame after another.  This is
+ * ffmpeg's "bgr24" raw video.
+ */
+#define CAPTURE_VIDEO_RAW 1
+
+/**
+ * Video is written as a losslessly compressed QOI image of 24-bit pixels per
+ * frame, one after another, compressed on the writer thread.  This is
+ * ffmpeg's "qoi_pipe", and is typically several times smaller than raw video
+ * for game framebuffers.  Use frame_codec_decode to read frames back.
+ */
+#define CAPTURE_VIDEO_QOI 2
+
+/**
+ * Counters describing how much of what was given to a capture was kept.
+ */
+typedef struct {
+  /**
+   * The number of frames copied for writing.
+   */
+  uint64_t captured_frames;
+
+  /**
+   * The number of frames discarded because the writer had fallen behind.
+   */
+  uint64_t dropped_frames;
+
+  /**
+   * The number of ticks of audio copied for writing.
+   */
+  uint64_t captured_ticks;
+
+  /**
+   * The number of ticks of audio discarded because the writer had fallen
+   * behind.  Each leaves a gap in the audio written.
+   */
+  uint64_t dropped_ticks;
+} capture_statistics;
+
+/**
+ * A lock-free ring of fixed-size slots, filled by the thread being captured
+ * and emptied by the writer thread.
+ */
+typedef struct {
+  float *samples;
+  uint32_t slots;
+  uint32_t samples_per_slot;
+  uint32_t written;
+  uint32_t read;
+  uint32_t next_written_slot;
+  uint32_t next_read_slot;
+} capture_ring;
+
+/**
+ * Copies frames of video and ticks of audio to preallocated rings, from which
+ * a background thread writes them to files, so that the thread being captured
+ * never waits on the disk.  All fields are owned by the capture and should
+ * only be accessed through the functions below.
+ */
+typedef struct {
+  int rows;
+  int columns;
+  int video_format;
+  int samples_per_tick;
+  int samples_per_second;
+  FILE *video_file;
+  FILE *audio_file;
+  capture_ring video_ring;
+  capture_ring audio_ring;
+  uint8_t *pixels;
+  capture_statistics statistics;
+  uint64_t audio_bytes;
+  bool stopping;
+  const char *error;
+#ifdef _WIN32
+  HANDLE thread;
+  HANDLE pending;
+#else
+  pthread_t thread;
+  sem_t pending;
+#endif
+} capture;
+
+/**
+ * Opens a capture and starts its writer thread.
+ * @param capture The capture to open.
+ * @param video_path When non-null, the null-terminated path to a file to which
+ *                   frames of video are written.  Otherwise, video given to the
+ *                   capture is ignored.
+ * @param video_format A CAPTURE_VIDEO_* constant.  Behavior is undefined if
+ *                     not a CAPTURE_VIDEO_* constant.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ * @param frames_per_second The frame rate written to the header of a Y4M
+ *                          stream.  Behavior is undefined if less than 1.
+ * @param frame_slots The most frames which may wait to be written before
+ *                    further frames are dropped.  Behavior is undefined if
+ *                    less than 1.
+ * @param audio_path When non-null, the null-terminated path to a 32-bit
+ *                   floating-point stereo WAV file to which audio is written.
+ *                   Otherwise, audio given to the capture is ignored.  Audio
+ *                   beyond the 4GiB a WAV file can describe is still written,
+ *                   but the header then gives the size as the maximum.
+ * @param samples_per_second The sample rate written to the header of the WAV
+ *                           file.  Behavior is undefined if less than 1.
+ * @param samples_per_tick The number of audio samples generated each tick, per
+ *                         channel.  Behavior is undefined if less than 1.
+ * @param tick_slots The most ticks of audio which may wait to be written
+ *                   before further ticks are dropped.  Behavior is undefined if
+ *                   less than 1.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *capture_open(capture *const capture, const char *const video_path,
+                         const int video_format, const int rows,
+                         const int columns, const int frames_per_second,
+                         const int frame_slots, const char *const audio_path,
+                         const int samples_per_second,
+                         const int samples_per_tick, const int tick_slots);
+
+/**
+ * Copies a frame of video to be written, or drops it if the writer has fallen
+ * too far behind.  Must only be called from one thread at a time.
+ * @param capture The capture to copy to.
+ * @param reds The intensity of the red channel of each pixel within the
+ *             viewport, row-major, starting from the top left corner.
+ * @param greens As reds, but for the green channel.
+ * @param blues As reds, but for the blue channel.
+ */
+void capture_video(capture *const capture, const float *const reds,
+                   const float *const greens, const float *const blues);
+
+/**
+ * Copies a tick of audio to be written, or drops it if the writer has fallen
+ * too far behind.  Must only be called from one thread at a time.
+ * @param capture The capture to copy to.
+ * @param audio The interleaved stereo audio written by the tick.
+ */
+void capture_audio(capture *const capture, const float *const audio);
+
+/**
+ * Reads the counters of a capture.  Must be called from the thread which
+ * gives it video and audio.
+ * @param capture The capture to read the counters of.
+ * @param statistics Written to with the counters.
+ */
+void capture_measure(const capture *const capture,
+                     capture_statistics *const statistics);
+
+/**
+ * Wraps a capture so that it may be given the output of a headless event loop.
+ * @param capture The capture to wrap.
+ * @return The wrapped capture.
+ */
+headless_output capture_interface(capture *const capture);
+
+/**
+ * Waits for everything copied so far to be written, stops the writer thread
+ * and closes the capture's files.
+ * @param capture The capture to close.
+ * @return In the event of an error (including one which occurred while
+ *         writing), a null-terminated UTF-8-encoded error message describing
+ *         the problem, otherwise, null.
+ */
+const char *capture_close(capture *const capture);
+
+#endif
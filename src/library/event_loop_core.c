@@ -0,0 +1,358 @@
+#include "event_loop_core.h"
+#include "audio_ring.h"
+#include "capture.h"
+#include "input.h"
+#include "input_event_queue.h"
+#include "input_recording.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The number of seconds of audio which must play without running dry before
+// the number of buffers in flight may shrink.
+#define ADAPTIVE_BUFFERS_STABLE_SECONDS 2
+
+void event_loop_core_initialize(
+    event_loop_core *const event_loop_core,
+    const event_loop_timer *const timer, const int ticks_per_second,
+    void (*const tick)(const input *const input, float *const audio),
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const int ticks_per_buffer,
+    const int minimum_buffers, const int maximum_buffers,
+    const int maximum_ticks_per_batch, const int catch_up_policy,
+    input_recording *const recording, capture *const capture,
+    event_loop_statistics *const statistics,
+    const uint32_t start_milliseconds) {
+  // We need a minimum of two buffers.
+  // We also need a minimum of enough buffers for 100msec in my experience.
+  const double default_ticks = ticks_per_second / 10.0 / ticks_per_buffer;
+  const int default_buffers =
+      ((int)ceil(default_ticks > 1 ? default_ticks : 1)) + 1;
+
+  const bool fixed_buffers = maximum_buffers == 0;
+  const int lowest_buffers = fixed_buffers ? default_buffers : minimum_buffers;
+  const int highest_buffers = fixed_buffers ? default_buffers : maximum_buffers;
+
+  event_loop_core->timer = timer;
+  event_loop_core->ticks_per_second = ticks_per_second;
+  event_loop_core->tick = tick;
+  event_loop_core->video = video;
+  event_loop_core->samples_per_tick = samples_per_tick;
+  event_loop_core->ticks_per_buffer = ticks_per_buffer;
+  event_loop_core->maximum_ticks_per_batch = maximum_ticks_per_batch;
+  event_loop_core->catch_up_policy = catch_up_policy;
+  event_loop_core->recording = recording;
+  event_loop_core->capture = capture;
+  event_loop_core->statistics = statistics;
+  event_loop_core->error = NULL;
+
+  // Adapting starts from the default and moves towards whatever proves stable.
+  event_loop_core->buffers = default_buffers < lowest_buffers ? lowest_buffers
+                             : default_buffers > highest_buffers
+                                 ? highest_buffers
+                                 : default_buffers;
+  event_loop_core->minimum_buffers = lowest_buffers;
+  event_loop_core->maximum_buffers = highest_buffers;
+  event_loop_core->submitted_buffers = 0;
+  event_loop_core->observed_underruns = 0;
+  event_loop_core->stable_since_buffers = 0;
+  event_loop_core->minimum_position = 0;
+  event_loop_core->input.pointer_state = POINTER_STATE_NONE;
+  event_loop_core->input.pointer_row = 0.0f;
+  event_loop_core->input.pointer_column = 0.0f;
+  memset(event_loop_core->input.held_keys, 0,
+         sizeof(event_loop_core->input.held_keys));
+  event_loop_core->input.events = NULL;
+  event_loop_core->input.number_of_events = 0;
+  event_loop_core->input_event_queue.first = 0;
+  event_loop_core->input_event_queue.count = 0;
+  event_loop_core->start_milliseconds = start_milliseconds;
+  event_loop_core->latency_pending_input = 0;
+  event_loop_core->latency_input = 0;
+  event_loop_core->latency_tick = 0;
+  event_loop_core->latency_video = 0;
+
+#ifdef PROFILER
+  event_loop_core->profiler = NULL;
+#endif
+}
+
+static int64_t now(const event_loop_core *const event_loop_core) {
+  return event_loop_core->timer->now(event_loop_core->timer->state);
+}
+
+static void run_tick(event_loop_core *const event_loop_core,
+                     const input *const input, float *const audio) {
+  // The latency probe follows one input at a time from arrival through to
+  // presentation; any which arrive meanwhile wait for the next probe.
+  if (event_loop_core->latency_pending_input != 0 &&
+      event_loop_core->latency_input == 0 && input->number_of_events > 0) {
+    event_loop_core->latency_input = event_loop_core->latency_pending_input;
+    event_loop_core->latency_pending_input = 0;
+    event_loop_core->latency_tick = now(event_loop_core);
+  }
+
+  PROFILER_BEGIN(tick);
+  event_loop_core->tick(input, audio);
+  PROFILER_END(event_loop_core->profiler, PROFILER_PHASE_TICK, tick);
+
+  if (event_loop_core->capture != NULL) {
+    capture_audio(event_loop_core->capture, audio);
+  }
+
+  if (event_loop_core->recording != NULL && event_loop_core->error == NULL) {
+    event_loop_core->error =
+        input_recording_write(event_loop_core->recording, input);
+  }
+}
+
+static void record_input_event(event_loop_core *const event_loop_core,
+                               const uint32_t milliseconds,
+                               input_event *const input_event) {
+  input_event->milliseconds =
+      milliseconds - event_loop_core->start_milliseconds;
+
+  if (event_loop_core->statistics != NULL &&
+      event_loop_core->latency_pending_input == 0) {
+    event_loop_core->latency_pending_input = now(event_loop_core);
+  }
+
+  if (!input_event_queue_push(&event_loop_core->input_event_queue,
+                              input_event) &&
+      event_loop_core->statistics != NULL) {
+    event_loop_core->statistics->dropped_input_events++;
+  }
+}
+
+void event_loop_core_prime(event_loop_core *const event_loop_core,
+                           audio_ring *const audio_ring) {
+  const int samples_per_tick = event_loop_core->samples_per_tick;
+
+  for (int buffer_index = 0; buffer_index < event_loop_core->buffers;
+       buffer_index++) {
+    float *const buffer = audio_ring_begin_write(audio_ring);
+
+    for (int tick_index = 0; tick_index < event_loop_core->ticks_per_buffer;
+         tick_index++) {
+      run_tick(event_loop_core, &event_loop_core->input,
+               buffer + tick_index * samples_per_tick * 2);
+    }
+
+    audio_ring_publish(audio_ring);
+    event_loop_core->submitted_buffers++;
+  }
+}
+
+void event_loop_core_key(event_loop_core *const event_loop_core,
+                         const uint32_t virtual_key_code, const bool held,
+                         const uint32_t milliseconds) {
+  if (virtual_key_code >= 256) {
+    return;
+  }
+
+  uint32_t *const held_keys =
+      event_loop_core->input.held_keys + (virtual_key_code >> 5);
+  const uint32_t mask = (uint32_t)1 << (virtual_key_code & 31);
+
+  // Auto-repeat raises further presses while a key is held; these are not
+  // changes in input.
+  if (((*held_keys & mask) != 0) == held) {
+    return;
+  }
+
+  if (held) {
+    *held_keys |= mask;
+  } else {
+    *held_keys &= ~mask;
+  }
+
+  input_event key_event = {
+      .type = held ? INPUT_EVENT_TYPE_KEY_DOWN : INPUT_EVENT_TYPE_KEY_UP,
+      .virtual_key_code = virtual_key_code,
+  };
+
+  record_input_event(event_loop_core, milliseconds, &key_event);
+}
+
+void event_loop_core_pointer(event_loop_core *const event_loop_core,
+                             const int pointer_state, const float pointer_row,
+                             const float pointer_column,
+                             const uint32_t milliseconds) {
+  event_loop_core->input.pointer_state = pointer_state;
+  event_loop_core->input.pointer_row = pointer_row;
+  event_loop_core->input.pointer_column = pointer_column;
+
+  input_event pointer_event = {
+      .type = INPUT_EVENT_TYPE_POINTER,
+      .pointer_state = pointer_state,
+      .pointer_row = pointer_row,
+      .pointer_column = pointer_column,
+  };
+
+  record_input_event(event_loop_core, milliseconds, &pointer_event);
+}
+
+const char *event_loop_core_refill(event_loop_core *const event_loop_core,
+                                   audio_ring *const audio_ring,
+                                   const uint32_t completed_buffers,
+                                   const uint32_t underruns,
+                                   const int minimum_slack, bool *const adapted,
+                                   int *const refills) {
+  const int samples_per_tick = event_loop_core->samples_per_tick;
+  const int ticks_per_buffer = event_loop_core->ticks_per_buffer;
+  const int samples_per_buffer = samples_per_tick * ticks_per_buffer;
+  const int catch_up_policy = event_loop_core->catch_up_policy;
+  const uint32_t new_underruns =
+      underruns - event_loop_core->observed_underruns;
+  const bool underran = new_underruns > 0;
+  event_loop_core->observed_underruns = underruns;
+
+  const int buffers = scheduler_adapt(
+      event_loop_core->buffers, event_loop_core->minimum_buffers,
+      event_loop_core->maximum_buffers, underran, minimum_slack,
+      completed_buffers - event_loop_core->stable_since_buffers,
+      (event_loop_core->ticks_per_second * ADAPTIVE_BUFFERS_STABLE_SECONDS +
+       ticks_per_buffer - 1) /
+          ticks_per_buffer);
+
+  // The current buffer is the one following the last to finish playing.  This
+  // is derived rather than advanced per refill, as the number of refills
+  // differs from the number of buffers which finished whenever the number in
+  // flight changes or ticks are slowed to catch up.
+  event_loop_core->minimum_position =
+      completed_buffers * (uint32_t)samples_per_buffer;
+
+  *adapted = underran || buffers != event_loop_core->buffers;
+
+  if (*adapted) {
+    event_loop_core->buffers = buffers;
+    event_loop_core->stable_since_buffers = completed_buffers;
+  }
+
+  // Having just shrunk, more may be in flight than are now wanted.
+  const int in_flight =
+      (int)(event_loop_core->submitted_buffers - completed_buffers);
+  const int due = buffers > in_flight ? buffers - in_flight : 0;
+
+  // Everything is planned a buffer at a time.
+  const int maximum_buffers_per_batch =
+      event_loop_core->maximum_ticks_per_batch < ticks_per_buffer
+          ? 1
+          : event_loop_core->maximum_ticks_per_batch / ticks_per_buffer;
+
+  int ticks;
+  scheduler_plan(due, maximum_buffers_per_batch, catch_up_policy, &ticks,
+                 refills);
+
+  // Input events which occurred since the previous tick are all delivered to
+  // the first tick of the batch.
+  input snapshot = event_loop_core->input;
+
+  if (ticks > 0) {
+    snapshot.events = event_loop_core->tick_input_events;
+    snapshot.number_of_events =
+        input_event_queue_drain(&event_loop_core->input_event_queue,
+                                event_loop_core->tick_input_events);
+  }
+
+  const float *latest_audio = NULL;
+
+  for (int refill = 0; refill < *refills; refill++) {
+    // The ring has a slot for every buffer which may be in flight, so one is
+    // always free here.
+    float *const buffer = audio_ring_begin_write(audio_ring);
+
+    for (int tick_index = 0; tick_index < ticks_per_buffer; tick_index++) {
+      float *const audio = buffer + tick_index * samples_per_tick * 2;
+
+      if (refill < ticks) {
+        run_tick(event_loop_core, &snapshot, audio);
+        snapshot.number_of_events = 0;
+        latest_audio = audio;
+
+        if (event_loop_core->error != NULL) {
+          return event_loop_core->error;
+        }
+      } else if (catch_up_policy == CATCH_UP_POLICY_EXTEND) {
+        memcpy(audio, latest_audio, sizeof(float) * 2 * samples_per_tick);
+      } else {
+        memset(audio, 0, sizeof(float) * 2 * samples_per_tick);
+      }
+    }
+
+    audio_ring_publish(audio_ring);
+    event_loop_core->submitted_buffers++;
+  }
+
+  event_loop_statistics *const statistics = event_loop_core->statistics;
+
+  if (statistics != NULL) {
+    if (ticks > 1) {
+      statistics->batches++;
+      statistics->batched_ticks += ticks * ticks_per_buffer;
+    }
+
+    statistics->discarded_ticks += (*refills - ticks) * ticks_per_buffer;
+    statistics->audio_ring_high_watermark =
+        audio_ring_high_watermark(audio_ring) * samples_per_buffer;
+    statistics->audio_ring_low_watermark =
+        audio_ring_low_watermark(audio_ring) * samples_per_buffer;
+    statistics->audio_underruns += new_underruns;
+    statistics->audio_buffers = buffers;
+    statistics->audio_latency_microseconds =
+        ((uint64_t)buffers * ticks_per_buffer * 1000000) /
+        event_loop_core->ticks_per_second;
+  }
+
+  return NULL;
+}
+
+float event_loop_core_progress(const event_loop_core *const event_loop_core,
+                               const uint32_t position) {
+  // Ticks are executed a buffer at a time, so progress is measured through the
+  // buffer rather than through any one tick within it.
+  return scheduler_progress(event_loop_core->minimum_position, position,
+                            event_loop_core->samples_per_tick *
+                                event_loop_core->ticks_per_buffer);
+}
+
+void event_loop_core_video(event_loop_core *const event_loop_core,
+                           const input *const input,
+                           const float tick_progress_unit_interval) {
+  if (event_loop_core->latency_tick != 0 &&
+      event_loop_core->latency_video == 0) {
+    event_loop_core->latency_video = now(event_loop_core);
+  }
+
+  event_loop_core->video(input, tick_progress_unit_interval);
+}
+
+void event_loop_core_presented(event_loop_core *const event_loop_core) {
+  if (event_loop_core->latency_video == 0) {
+    return;
+  }
+
+  event_loop_statistics *const statistics = event_loop_core->statistics;
+  const int64_t input = event_loop_core->latency_input;
+  const uint64_t input_to_present = now(event_loop_core) - input;
+
+  statistics->latency_samples++;
+  statistics->input_to_tick_microseconds +=
+      event_loop_core->latency_tick - input;
+  statistics->input_to_video_microseconds +=
+      event_loop_core->latency_video - input;
+  statistics->input_to_present_microseconds += input_to_present;
+
+  if (input_to_present > statistics->maximum_input_to_present_microseconds) {
+    statistics->maximum_input_to_present_microseconds = input_to_present;
+  }
+
+  event_loop_core->latency_input = 0;
+  event_loop_core->latency_tick = 0;
+  event_loop_core->latency_video = 0;
+}
@@ -0,0 +1,321 @@
+#ifndef EVENT_LOOP_CORE_H
+
+#define EVENT_LOOP_CORE_H
+
+#include "audio_ring.h"
+#include "capture.h"
+#include "input.h"
+#include "input_event_queue.h"
+#include "input_recording.h"
+#include "profiler.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Counters which are updated as an application event loop runs.
+ */
+typedef struct {
+  /**
+   * The number of times that more than one buffer of ticks was due at once and
+   * executed back-to-back.
+   */
+  uint64_t batches;
+
+  /**
+   * The total number of ticks executed as part of batches.
+   */
+  uint64_t batched_ticks;
+
+  /**
+   * The total number of ticks discarded because they exceeded the limit on
+   * ticks per batch.
+   */
+  uint64_t discarded_ticks;
+
+  /**
+   * The total number of input events dropped because more occurred between
+   * two ticks than INPUT_EVENT_QUEUE_CAPACITY.
+   */
+  uint64_t dropped_input_events;
+
+  /**
+   * The number of inputs which have been followed from their arrival through
+   * to the presentation of the first frame rendered after a tick consumed
+   * them.  Only one input is followed at a time.
+   */
+  uint64_t latency_samples;
+
+  /**
+   * The total time, in microseconds, between the arrival of each input
+   * followed and the tick which consumed it.
+   */
+  uint64_t input_to_tick_microseconds;
+
+  /**
+   * The total time, in microseconds, between the arrival of each input
+   * followed and the first subsequent video event.
+   */
+  uint64_t input_to_video_microseconds;
+
+  /**
+   * The total time, in microseconds, between the arrival of each input
+   * followed and the presentation of the frame rendered by the first
+   * subsequent video event.
+   */
+  uint64_t input_to_present_microseconds;
+
+  /**
+   * The longest time, in microseconds, between the arrival of any input
+   * followed and the presentation of the frame rendered by the first
+   * subsequent video event.
+   */
+  uint64_t maximum_input_to_present_microseconds;
+
+  /**
+   * The most audio, in samples per channel, which has been waiting for the
+   * audio thread to pass it on to the audio device.  Overwritten rather than
+   * accumulated.
+   */
+  uint64_t audio_ring_high_watermark;
+
+  /**
+   * The least audio, in samples per channel, which has been waiting for the
+   * audio thread to pass it on to the audio device whenever the audio thread
+   * looked for more.  Overwritten rather than accumulated.  Values near zero
+   * indicate that ticks are only just keeping up with the audio device.
+   */
+  uint64_t audio_ring_low_watermark;
+
+  /**
+   * The number of times the audio device has run out of audio to play,
+   * resulting in an audible gap.
+   */
+  uint64_t audio_underruns;
+
+  /**
+   * The number of buffers of audio, each of ticks_per_buffer ticks, currently
+   * queued for output.  Overwritten rather than accumulated.
+   */
+  uint64_t audio_buffers;
+
+  /**
+   * The latency of the audio output, in microseconds, implied by the number of
+   * buffers of audio currently queued for output.  Overwritten rather than
+   * accumulated.
+   */
+  uint64_t audio_latency_microseconds;
+} event_loop_statistics;
+
+/**
+ * The source of time with which an event loop core measures latency.
+ */
+typedef struct {
+  /**
+   * Passed to each of the following functions.
+   */
+  void *const state;
+
+  /**
+   * Reads a monotonic clock.
+   * @param state The state of the timer.
+   * @return The number of microseconds since an arbitrary point in time.
+   */
+  int64_t (*const now)(void *const state);
+} event_loop_timer;
+
+/**
+ * The parts of an application event loop which do not depend upon the
+ * operating system: tracking user input, executing ticks a buffer of audio at
+ * a time, adapting the number of buffers in flight, and measuring latency.  A
+ * platform-specific event loop drives it, forwarding user input, the progress
+ * of the audio output and requests to refresh the display.  Fields may be
+ * read, but should only be modified through the functions below.
+ */
+typedef struct {
+  const event_loop_timer *timer;
+  int ticks_per_second;
+  void (*tick)(const input *const input, float *const audio);
+  void (*video)(const input *const input,
+                const float tick_progress_unit_interval);
+  int samples_per_tick;
+  int ticks_per_buffer;
+  int maximum_ticks_per_batch;
+  int catch_up_policy;
+  input_recording *recording;
+  capture *capture;
+  event_loop_statistics *statistics;
+
+  /**
+   * The first error to have occurred while executing a tick, or null.
+   */
+  const char *error;
+
+  /**
+   * The number of buffers of audio which should currently be in flight.
+   */
+  int buffers;
+
+  /**
+   * The fewest buffers of audio which may be in flight.
+   */
+  int minimum_buffers;
+
+  /**
+   * The most buffers of audio which may be in flight, and so the number of
+   * slots the audio ring needs.
+   */
+  int maximum_buffers;
+
+  /**
+   * The number of buffers of audio which have been published to the audio
+   * ring, wrapping at 2^32.
+   */
+  uint32_t submitted_buffers;
+
+  uint32_t observed_underruns;
+  uint32_t stable_since_buffers;
+
+  /**
+   * The position at which the audio of the current buffer started playing,
+   * wrapping at 2^32.
+   */
+  uint32_t minimum_position;
+
+  /**
+   * The current state of user input.
+   */
+  input input;
+
+  input_event_queue input_event_queue;
+  input_event tick_input_events[INPUT_EVENT_QUEUE_CAPACITY];
+  uint32_t start_milliseconds;
+  int64_t latency_pending_input;
+  int64_t latency_input;
+  int64_t latency_tick;
+  int64_t latency_video;
+
+#ifdef PROFILER
+  /**
+   * When non-null, the ring to which the thread driving the event loop
+   * records its tick events.  Null after event_loop_core_initialize.
+   */
+  profiler_ring *profiler;
+#endif
+} event_loop_core;
+
+/**
+ * Prepares an event loop core.  Parameters not documented here are as given
+ * to run_event_loop.
+ * @param event_loop_core The event loop core to prepare.
+ * @param timer The timer with which to measure latency.  Must remain valid for
+ *              as long as the event loop core is in use.
+ * @param start_milliseconds The time at which the event loop started, in
+ *                           the same milliseconds as given with input
+ *                           events, wrapping at 2^32.
+ */
+void event_loop_core_initialize(
+    event_loop_core *const event_loop_core,
+    const event_loop_timer *const timer, const int ticks_per_second,
+    void (*const tick)(const input *const input, float *const audio),
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const int ticks_per_buffer,
+    const int minimum_buffers, const int maximum_buffers,
+    const int maximum_ticks_per_batch, const int catch_up_policy,
+    input_recording *const recording, capture *const capture,
+    event_loop_statistics *const statistics,
+    const uint32_t start_milliseconds);
+
+/**
+ * Fills the buffers of audio which are initially in flight by executing
+ * ticks, publishing each to an audio ring.  Any error is recorded in the
+ * event loop core's error field.
+ * @param event_loop_core The event loop core to prime.
+ * @param audio_ring The empty audio ring to fill, with maximum_buffers slots
+ *                   of samples_per_tick * ticks_per_buffer stereo samples.
+ */
+void event_loop_core_prime(event_loop_core *const event_loop_core,
+                           audio_ring *const audio_ring);
+
+/**
+ * Records a key being pressed or released.  Changes which do not change
+ * whether the key is held (such as auto-repeat) are ignored.
+ * @param event_loop_core The event loop core to inform.
+ * @param virtual_key_code The key.  Ignored unless less than 256.
+ * @param held True when the key was pressed, false when released.
+ * @param milliseconds The time at which the change occurred, wrapping at 2^32.
+ */
+void event_loop_core_key(event_loop_core *const event_loop_core,
+                         const uint32_t virtual_key_code, const bool held,
+                         const uint32_t milliseconds);
+
+/**
+ * Records a change in the state or location of the pointer.
+ * @param event_loop_core The event loop core to inform.
+ * @param pointer_state A POINTER_STATE_* constant.
+ * @param pointer_row The number of rows between the top of the viewport and
+ *                    the pointer.
+ * @param pointer_column The number of columns between the left of the viewport
+ *                       and the pointer.
+ * @param milliseconds The time at which the change occurred, wrapping at 2^32.
+ */
+void event_loop_core_pointer(event_loop_core *const event_loop_core,
+                             const int pointer_state, const float pointer_row,
+                             const float pointer_column,
+                             const uint32_t milliseconds);
+
+/**
+ * Replaces buffers of audio which have finished playing by executing ticks,
+ * publishing each to an audio ring, after first adapting the number of
+ * buffers in flight to recent underruns and slack.
+ * @param event_loop_core The event loop core to refill.
+ * @param audio_ring The audio ring to publish to.
+ * @param completed_buffers The number of buffers which have finished playing,
+ *                          wrapping at 2^32.
+ * @param underruns The number of times the audio output has run dry, wrapping
+ *                  at 2^32.
+ * @param minimum_slack The fewest buffers which have been queued or waiting in
+ *                      the audio ring whenever a buffer finished playing,
+ *                      since the number of buffers last changed.
+ * @param adapted Written to with true when the number of buffers in flight
+ *                has changed or an underrun has occurred, in which case
+ *                minimum slack should be measured afresh.
+ * @param refills Written to with the number of buffers published.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *event_loop_core_refill(event_loop_core *const event_loop_core,
+                                   audio_ring *const audio_ring,
+                                   const uint32_t completed_buffers,
+                                   const uint32_t underruns,
+                                   const int minimum_slack, bool *const adapted,
+                                   int *const refills);
+
+/**
+ * Calculates how far the audio output has progressed through the current
+ * buffer of ticks.
+ * @param event_loop_core The event loop core to query.
+ * @param position The number of samples which have been played since the
+ *                 audio output started, wrapping at 2^32.
+ * @return The progress through the current buffer as a unit interval.
+ */
+float event_loop_core_progress(const event_loop_core *const event_loop_core,
+                               const uint32_t position);
+
+/**
+ * Raises a video event.
+ * @param event_loop_core The event loop core to raise the video event of.
+ * @param input The state of user input to give to the video event.
+ * @param tick_progress_unit_interval The progress through the current tick.
+ */
+void event_loop_core_video(event_loop_core *const event_loop_core,
+                           const input *const input,
+                           const float tick_progress_unit_interval);
+
+/**
+ * Records that the frame rendered by the last video event has been presented.
+ * @param event_loop_core The event loop core to inform.
+ */
+void event_loop_core_presented(event_loop_core *const event_loop_core);
+
+#endif
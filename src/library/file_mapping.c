@@ -0,0 +1,262 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "file_mapping.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Views must start on a multiple of the allocation granularity on Windows,
+// which is also a multiple of the page size everywhere else.
+#define FILE_MAPPING_GRANULARITY 65536
+
+#ifdef _WIN32
+
+const char *file_mapping_open(file_mapping *const file_mapping,
+                              const char *const path) {
+  file_mapping->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if (file_mapping->file == INVALID_HANDLE_VALUE) {
+    return "Failed to open the file to map.";
+  }
+
+  LARGE_INTEGER size;
+
+  if (!GetFileSizeEx(file_mapping->file, &size)) {
+    if (CloseHandle(file_mapping->file)) {
+      return "Failed to determine the size of the file to map.";
+    } else {
+      return "Failed to determine the size of the file to map.  Additionally "
+             "failed to close the file.";
+    }
+  }
+
+  file_mapping->size = (uint64_t)size.QuadPart;
+
+  // Empty files cannot be mapped, but then, nothing can be read from them.
+  if (file_mapping->size == 0) {
+    file_mapping->mapping = NULL;
+  } else {
+    file_mapping->mapping = CreateFileMappingA(file_mapping->file, NULL,
+                                               PAGE_READONLY, 0, 0, NULL);
+
+    if (file_mapping->mapping == NULL) {
+      if (CloseHandle(file_mapping->file)) {
+        return "Failed to create a file mapping.";
+      } else {
+        return "Failed to create a file mapping.  Additionally failed to close "
+               "the file.";
+      }
+    }
+  }
+
+  file_mapping->memory = NULL;
+  file_mapping->view = NULL;
+  file_mapping->view_offset = 0;
+  file_mapping->view_size = 0;
+  return NULL;
+}
+
+const char *file_mapping_open_resource(file_mapping *const file_mapping,
+                                       const char *const name) {
+  const HRSRC resource = FindResourceA(NULL, name, RT_RCDATA);
+
+  if (resource == NULL) {
+    return "Failed to find the resource to map.";
+  }
+
+  // Resources are mapped along with the rest of the executable, and are never
+  // unloaded.
+  const HGLOBAL loaded = LoadResource(NULL, resource);
+
+  if (loaded == NULL) {
+    return "Failed to load the resource to map.";
+  }
+
+  const void *const bytes = LockResource(loaded);
+
+  if (bytes == NULL) {
+    return "Failed to lock the resource to map.";
+  }
+
+  file_mapping_open_memory(file_mapping, bytes,
+                           SizeofResource(NULL, resource));
+  return NULL;
+}
+
+static const char *map_view(file_mapping *const file_mapping,
+                            const uint64_t offset, const size_t size) {
+  const void *const view =
+      MapViewOfFile(file_mapping->mapping, FILE_MAP_READ,
+                    (DWORD)(offset >> 32), (DWORD)offset, size);
+
+  if (view == NULL) {
+    return "Failed to map a view of a file.";
+  }
+
+  file_mapping->view = view;
+  return NULL;
+}
+
+static const char *unmap_view(file_mapping *const file_mapping) {
+  return UnmapViewOfFile(file_mapping->view)
+             ? NULL
+             : "Failed to unmap a view of a file.";
+}
+
+static const char *close_file(file_mapping *const file_mapping) {
+  if (file_mapping->mapping != NULL && !CloseHandle(file_mapping->mapping)) {
+    return "Failed to close a file mapping.";
+  }
+
+  return CloseHandle(file_mapping->file) ? NULL : "Failed to close a file.";
+}
+
+#else
+
+const char *file_mapping_open(file_mapping *const file_mapping,
+                              const char *const path) {
+  file_mapping->file = open(path, O_RDONLY);
+
+  if (file_mapping->file == -1) {
+    return "Failed to open the file to map.";
+  }
+
+  struct stat status;
+
+  if (fstat(file_mapping->file, &status) != 0) {
+    if (close(file_mapping->file) == 0) {
+      return "Failed to determine the size of the file to map.";
+    } else {
+      return "Failed to determine the size of the file to map.  Additionally "
+             "failed to close the file.";
+    }
+  }
+
+  file_mapping->size = (uint64_t)status.st_size;
+  file_mapping->memory = NULL;
+  file_mapping->view = NULL;
+  file_mapping->view_offset = 0;
+  file_mapping->view_size = 0;
+  return NULL;
+}
+
+static const char *map_view(file_mapping *const file_mapping,
+                            const uint64_t offset, const size_t size) {
+  const void *const view = mmap(NULL, size, PROT_READ, MAP_PRIVATE,
+                                file_mapping->file, (off_t)offset);
+
+  if (view == MAP_FAILED) {
+    return "Failed to map a view of a file.";
+  }
+
+  file_mapping->view = view;
+  return NULL;
+}
+
+static const char *unmap_view(file_mapping *const file_mapping) {
+  return munmap((void *)file_mapping->view, file_mapping->view_size) == 0
+             ? NULL
+             : "Failed to unmap a view of a file.";
+}
+
+static const char *close_file(file_mapping *const file_mapping) {
+  return close(file_mapping->file) == 0 ? NULL : "Failed to close a file.";
+}
+
+#endif
+
+void file_mapping_open_memory(file_mapping *const file_mapping,
+                              const void *const bytes, const size_t size) {
+  file_mapping->memory = bytes;
+  file_mapping->size = size;
+  file_mapping->view = NULL;
+  file_mapping->view_offset = 0;
+  file_mapping->view_size = 0;
+}
+
+uint64_t file_mapping_size(const file_mapping *const file_mapping) {
+  return file_mapping->size;
+}
+
+const char *file_mapping_read(file_mapping *const file_mapping,
+                              const uint64_t offset, const size_t size,
+                              const uint8_t **const bytes) {
+  if (offset > file_mapping->size || size > file_mapping->size - offset) {
+    return "Attempted to read beyond the end of a mapped file.";
+  }
+
+  if (file_mapping->memory != NULL) {
+    *bytes = file_mapping->memory + offset;
+    return NULL;
+  }
+
+  if (file_mapping->view != NULL && offset >= file_mapping->view_offset &&
+      offset + size <= file_mapping->view_offset + file_mapping->view_size) {
+    *bytes = file_mapping->view + (offset - file_mapping->view_offset);
+    return NULL;
+  }
+
+  if (size == 0) {
+    *bytes = NULL;
+    return NULL;
+  }
+
+  if (file_mapping->view != NULL) {
+    const char *const error = unmap_view(file_mapping);
+
+    if (error != NULL) {
+      return error;
+    }
+
+    file_mapping->view = NULL;
+  }
+
+  // The window extends beyond the requested bytes so that sequential reads
+  // only occasionally need to remap it.
+  const uint64_t start = offset - offset % FILE_MAPPING_GRANULARITY;
+  const uint64_t end =
+      file_mapping->size - (offset + size) > FILE_MAPPING_WINDOW
+          ? offset + size + FILE_MAPPING_WINDOW
+          : file_mapping->size;
+
+  const char *const error =
+      map_view(file_mapping, start, (size_t)(end - start));
+
+  if (error != NULL) {
+    return error;
+  }
+
+  file_mapping->view_offset = start;
+  file_mapping->view_size = (size_t)(end - start);
+  *bytes = file_mapping->view + (offset - start);
+  return NULL;
+}
+
+const char *file_mapping_close(file_mapping *const file_mapping) {
+  if (file_mapping->memory != NULL) {
+    return NULL;
+  }
+
+  if (file_mapping->view != NULL) {
+    const char *const error = unmap_view(file_mapping);
+
+    if (error != NULL) {
+      return error;
+    }
+
+    file_mapping->view = NULL;
+  }
+
+  return close_file(file_mapping);
+}
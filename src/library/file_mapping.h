@@ -0,0 +1,106 @@
+#ifndef FILE_MAPPING_H
+
+#define FILE_MAPPING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * The number of bytes of a file mapped into memory at a time, beyond those
+ * requested by a read.
+ */
+#define FILE_MAPPING_WINDOW 262144
+
+/**
+ * Read-only access to a file through a window which is mapped into memory
+ * where needed, so that however large the file, only a small part of it is
+ * resident at any time.  Alternatively, bytes which are already in memory,
+ * such as those of an embedded resource, can be read through the same
+ * interface.  All fields are owned by the file mapping and should only be
+ * accessed through the functions below.
+ */
+typedef struct {
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int file;
+#endif
+  const uint8_t *memory;
+  uint64_t size;
+  const uint8_t *view;
+  uint64_t view_offset;
+  size_t view_size;
+} file_mapping;
+
+/**
+ * Opens a file mapping of a file on disk.
+ * @param file_mapping The file mapping to open.
+ * @param path The null-terminated path to the file to map.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *file_mapping_open(file_mapping *const file_mapping,
+                              const char *const path);
+
+/**
+ * Opens a file mapping of bytes which are already in memory.  This cannot
+ * fail.
+ * @param file_mapping The file mapping to open.
+ * @param bytes The bytes to read from in place.  Must remain valid and
+ *              unchanged for as long as the file mapping is open.
+ * @param size The number of bytes.
+ */
+void file_mapping_open_memory(file_mapping *const file_mapping,
+                              const void *const bytes, const size_t size);
+
+#ifdef _WIN32
+
+/**
+ * Opens a file mapping of an RCDATA resource embedded in the executable.
+ * @param file_mapping The file mapping to open.
+ * @param name The null-terminated name of the resource.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *file_mapping_open_resource(file_mapping *const file_mapping,
+                                       const char *const name);
+
+#endif
+
+/**
+ * Determines the size of a mapped file.
+ * @param file_mapping The file mapping to query.
+ * @return The number of bytes in the mapped file.
+ */
+uint64_t file_mapping_size(const file_mapping *const file_mapping);
+
+/**
+ * Makes a range of bytes of a mapped file available in memory.  This may unmap
+ * bytes previously read.
+ * @param file_mapping The file mapping to read from.
+ * @param offset The index of the first byte to read.
+ * @param size The number of bytes to read.
+ * @param bytes Written to with a pointer to the first byte read, which remains
+ *              valid until the next read from, or closure of, the file mapping.
+ * @return In the event of an error (including the range extending beyond the
+ *         end of the file), a null-terminated UTF-8-encoded error message
+ *         describing the problem, otherwise, null.
+ */
+const char *file_mapping_read(file_mapping *const file_mapping,
+                              const uint64_t offset, const size_t size,
+                              const uint8_t **const bytes);
+
+/**
+ * Closes a file mapping.
+ * @param file_mapping The file mapping to close.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *file_mapping_close(file_mapping *const file_mapping);
+
+#endif
@@ -0,0 +1,320 @@
+#include "frame_codec.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define QOI_HEADER_BYTES 14
+#define QOI_END_MARKER_BYTES 8
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK 0xc0
+
+// The longest run a single QOI_OP_RUN can describe.
+#define QOI_MAXIMUM_RUN 62
+
+// Runs are scanned this many bytes at a time, which is a whole number of both
+// 3- and 4-channel pixels.
+#define SCAN_BYTES 48
+
+// Pixels are handled internally as red, green, blue and opacity bytes packed
+// from least to most significant, so that they can be compared as a whole.
+static uint32_t read_pixel(const uint8_t *const pixel, const int channels) {
+  const uint32_t opacity = channels == 4 ? pixel[3] : 255;
+  return (uint32_t)pixel[2] | (uint32_t)pixel[1] << 8 |
+         (uint32_t)pixel[0] << 16 | opacity << 24;
+}
+
+static void write_pixel(uint8_t *const pixel, const int channels,
+                        const uint32_t value) {
+  pixel[0] = value >> 16;
+  pixel[1] = value >> 8;
+  pixel[2] = value;
+
+  if (channels == 4) {
+    pixel[3] = value >> 24;
+  }
+}
+
+static int hash(const uint32_t pixel) {
+  return ((pixel & 255) * 3 + (pixel >> 8 & 255) * 5 +
+          (pixel >> 16 & 255) * 7 + (pixel >> 24) * 11) %
+         64;
+}
+
+// Wraps the difference between two bytes to -128...127.
+static int wrap(const int difference) {
+  return ((difference + 128) & 255) - 128;
+}
+
+static void write_u32_big_endian(uint8_t *const bytes, const uint32_t value) {
+  bytes[0] = value >> 24;
+  bytes[1] = value >> 16;
+  bytes[2] = value >> 8;
+  bytes[3] = value;
+}
+
+static uint32_t read_u32_big_endian(const uint8_t *const bytes) {
+  return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 |
+         (uint32_t)bytes[2] << 8 | bytes[3];
+}
+
+// Counts the pixels from the start of pixels which equal the first of them,
+// up to remaining.
+static int run_length(const uint8_t *const pixels, const int remaining,
+                      const int channels) {
+  const uint32_t first = read_pixel(pixels, channels);
+  int length = 1;
+
+  // Most runs in busy areas are short, so a few pixels are checked before
+  // committing to building a pattern to scan with.
+  while (length < remaining && length < 8 &&
+         read_pixel(pixels + length * channels, channels) == first) {
+    length++;
+  }
+
+  if (length < 8) {
+    return length;
+  }
+
+#ifdef __SSE2__
+  uint8_t pattern_bytes[SCAN_BYTES];
+
+  for (int byte = 0; byte < SCAN_BYTES; byte++) {
+    pattern_bytes[byte] = pixels[byte % channels];
+  }
+
+  const __m128i pattern_0 = _mm_loadu_si128((const __m128i *)pattern_bytes);
+  const __m128i pattern_1 =
+      _mm_loadu_si128((const __m128i *)(pattern_bytes + 16));
+  const __m128i pattern_2 =
+      _mm_loadu_si128((const __m128i *)(pattern_bytes + 32));
+  const int pixels_per_scan = SCAN_BYTES / channels;
+
+  while (remaining - length >= pixels_per_scan) {
+    const uint8_t *const scan = pixels + length * channels;
+    const __m128i equal = _mm_and_si128(
+        _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)scan), pattern_0),
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(scan + 16)),
+                           pattern_1)),
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(scan + 32)),
+                       pattern_2));
+
+    if (_mm_movemask_epi8(equal) != 0xffff) {
+      break;
+    }
+
+    length += pixels_per_scan;
+  }
+#endif
+
+  while (length < remaining &&
+         read_pixel(pixels + length * channels, channels) == first) {
+    length++;
+  }
+
+  return length;
+}
+
+size_t frame_codec_maximum_bytes(const int rows, const int columns,
+                                 const int channels) {
+  return QOI_HEADER_BYTES + (size_t)rows * columns * (channels + 1) +
+         QOI_END_MARKER_BYTES;
+}
+
+size_t frame_codec_encode(const uint8_t *const pixels, const int rows,
+                          const int columns, const int channels,
+                          uint8_t *const encoded) {
+  const int total = rows * columns;
+  uint32_t index[64];
+  memset(index, 0, sizeof(index));
+
+  memcpy(encoded, "qoif", 4);
+  write_u32_big_endian(encoded + 4, columns);
+  write_u32_big_endian(encoded + 8, rows);
+  encoded[12] = channels;
+  encoded[13] = 0;
+
+  size_t output = QOI_HEADER_BYTES;
+  uint32_t previous = 255u << 24;
+  int pixel = 0;
+
+  while (pixel < total) {
+    const uint32_t current = read_pixel(pixels + pixel * channels, channels);
+
+    if (current == previous) {
+      int run = run_length(pixels + pixel * channels, total - pixel, channels);
+      pixel += run;
+
+      while (run > 0) {
+        const int part = run < QOI_MAXIMUM_RUN ? run : QOI_MAXIMUM_RUN;
+        encoded[output++] = QOI_OP_RUN | (part - 1);
+        run -= part;
+      }
+
+      continue;
+    }
+
+    const int position = hash(current);
+
+    if (index[position] == current) {
+      encoded[output++] = QOI_OP_INDEX | position;
+    } else {
+      index[position] = current;
+
+      if ((current >> 24) == (previous >> 24)) {
+        const int red = wrap((int)(current & 255) - (int)(previous & 255));
+        const int green =
+            wrap((int)(current >> 8 & 255) - (int)(previous >> 8 & 255));
+        const int blue =
+            wrap((int)(current >> 16 & 255) - (int)(previous >> 16 & 255));
+        const int red_green = red - green;
+        const int blue_green = blue - green;
+
+        if (red > -3 && red < 2 && green > -3 && green < 2 && blue > -3 &&
+            blue < 2) {
+          encoded[output++] =
+              QOI_OP_DIFF | (red + 2) << 4 | (green + 2) << 2 | (blue + 2);
+        } else if (red_green > -9 && red_green < 8 && green > -33 &&
+                   green < 32 && blue_green > -9 && blue_green < 8) {
+          encoded[output++] = QOI_OP_LUMA | (green + 32);
+          encoded[output++] = (red_green + 8) << 4 | (blue_green + 8);
+        } else {
+          encoded[output++] = QOI_OP_RGB;
+          encoded[output++] = current;
+          encoded[output++] = current >> 8;
+          encoded[output++] = current >> 16;
+        }
+      } else {
+        encoded[output++] = QOI_OP_RGBA;
+        encoded[output++] = current;
+        encoded[output++] = current >> 8;
+        encoded[output++] = current >> 16;
+        encoded[output++] = current >> 24;
+      }
+    }
+
+    previous = current;
+    pixel++;
+  }
+
+  memset(encoded + output, 0, QOI_END_MARKER_BYTES - 1);
+  encoded[output + QOI_END_MARKER_BYTES - 1] = 1;
+
+  return output + QOI_END_MARKER_BYTES;
+}
+
+const char *frame_codec_decode(const uint8_t *const encoded, const size_t bytes,
+                               const int rows, const int columns,
+                               const int channels, uint8_t *const pixels,
+                               size_t *const consumed) {
+  if (bytes < QOI_HEADER_BYTES + QOI_END_MARKER_BYTES ||
+      memcmp(encoded, "qoif", 4) != 0) {
+    return "The encoded frame is not a QOI image.";
+  }
+
+  if (read_u32_big_endian(encoded + 4) != (uint32_t)columns ||
+      read_u32_big_endian(encoded + 8) != (uint32_t)rows) {
+    return "The encoded frame is of an unexpected size.";
+  }
+
+  const int total = rows * columns;
+  uint32_t index[64];
+  memset(index, 0, sizeof(index));
+
+  size_t input = QOI_HEADER_BYTES;
+  uint32_t previous = 255u << 24;
+  int pixel = 0;
+
+  while (pixel < total) {
+    if (input >= bytes) {
+      return "The encoded frame is truncated.";
+    }
+
+    const int op = encoded[input++];
+    uint32_t current = previous;
+    int repeats = 1;
+
+    if (op == QOI_OP_RGB || op == QOI_OP_RGBA) {
+      const size_t length = op == QOI_OP_RGB ? 3 : 4;
+
+      if (bytes - input < length) {
+        return "The encoded frame is truncated.";
+      }
+
+      current = (uint32_t)encoded[input] | (uint32_t)encoded[input + 1] << 8 |
+                (uint32_t)encoded[input + 2] << 16 |
+                (op == QOI_OP_RGB ? previous & 0xff000000
+                                  : (uint32_t)encoded[input + 3] << 24);
+      input += length;
+    } else {
+      switch (op & QOI_MASK) {
+      case QOI_OP_INDEX:
+        current = index[op];
+        break;
+
+      case QOI_OP_DIFF: {
+        const uint32_t red = ((previous & 255) + (op >> 4 & 3) - 2) & 255;
+        const uint32_t green =
+            ((previous >> 8 & 255) + (op >> 2 & 3) - 2) & 255;
+        const uint32_t blue = ((previous >> 16 & 255) + (op & 3) - 2) & 255;
+        current = red | green << 8 | blue << 16 | (previous & 0xff000000);
+        break;
+      }
+
+      case QOI_OP_LUMA: {
+        if (input >= bytes) {
+          return "The encoded frame is truncated.";
+        }
+
+        const int next = encoded[input++];
+        const int green = (op & 63) - 32;
+        const uint32_t red =
+            ((previous & 255) + green - 8 + (next >> 4)) & 255;
+        const uint32_t green_byte = ((previous >> 8 & 255) + green) & 255;
+        const uint32_t blue =
+            ((previous >> 16 & 255) + green - 8 + (next & 15)) & 255;
+        current = red | green_byte << 8 | blue << 16 | (previous & 0xff000000);
+        break;
+      }
+
+      default:
+        repeats = (op & 63) + 1;
+        break;
+      }
+    }
+
+    if (repeats > total - pixel) {
+      return "The encoded frame describes too many pixels.";
+    }
+
+    index[hash(current)] = current;
+
+    for (int repeat = 0; repeat < repeats; repeat++) {
+      write_pixel(pixels + pixel * channels, channels, current);
+      pixel++;
+    }
+
+    previous = current;
+  }
+
+  if (bytes - input < QOI_END_MARKER_BYTES) {
+    return "The encoded frame is truncated.";
+  }
+
+  if (consumed != NULL) {
+    *consumed = input + QOI_END_MARKER_BYTES;
+  }
+
+  return NULL;
+}
@@ -0,0 +1,67 @@
+#ifndef FRAME_CODEC_H
+
+#define FRAME_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Determines the most bytes which encoding a frame could produce.
+ * @param rows The height of the frame in rows.  Behavior is undefined if less
+ *             than 1.
+ * @param columns The width of the frame in columns.  Behavior is undefined if
+ *                less than 1.
+ * @param channels 3 for blue, green and red bytes per pixel, or 4 to follow
+ *                 those with an opacity byte.  Behavior is undefined
+ *                 otherwise.
+ * @return The most bytes which frame_codec_encode could write.
+ */
+size_t frame_codec_maximum_bytes(const int rows, const int columns,
+                                 const int channels);
+
+/**
+ * Losslessly compresses a frame as a complete QOI image, which encodes each
+ * pixel as a run of the previous pixel, a reference to a recently seen pixel,
+ * a small difference from the previous pixel or, failing those, literally.
+ * Flat areas of color, common in game framebuffers, are scanned using SSE2
+ * where available.
+ * @param pixels The bytes of each pixel of the frame in turn (blue, green, red
+ *               and, when there are 4 channels, opacity), row-major, starting
+ *               from the top left corner, without padding between rows.
+ * @param rows The height of the frame in rows.  Behavior is undefined if less
+ *             than 1.
+ * @param columns The width of the frame in columns.  Behavior is undefined if
+ *                less than 1.
+ * @param channels 3 or 4, as described for pixels.  Behavior is undefined
+ *                 otherwise.
+ * @param encoded Written to with the QOI image.  Must have space for
+ *                frame_codec_maximum_bytes bytes.
+ * @return The number of bytes written to encoded.
+ */
+size_t frame_codec_encode(const uint8_t *const pixels, const int rows,
+                          const int columns, const int channels,
+                          uint8_t *const encoded);
+
+/**
+ * Decompresses a frame encoded by frame_codec_encode (or any other QOI image
+ * of the expected size).
+ * @param encoded The bytes of the QOI image, which may be followed by further
+ *                bytes.
+ * @param bytes The number of bytes available within encoded.
+ * @param rows The expected height of the frame in rows.
+ * @param columns The expected width of the frame in columns.
+ * @param channels 3 or 4, as given to frame_codec_encode.  Behavior is
+ *                 undefined otherwise.
+ * @param pixels Written to with the bytes of each pixel, as given to
+ *               frame_codec_encode.
+ * @param consumed When non-null, written to with the number of bytes of
+ *                 encoded which made up the QOI image on success.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *frame_codec_decode(const uint8_t *const encoded, const size_t bytes,
+                               const int rows, const int columns,
+                               const int channels, uint8_t *const pixels,
+                               size_t *const consumed);
+
+#endif
@@ -0,0 +1,113 @@
+#include "framebuffer.h"
+#include "viewport.h"
+#include <stdint.h>
+
+void framebuffer_convert_opaque(const int rows, const int columns,
+                                const float *const reds,
+                                const float *const greens,
+                                const float *const blues,
+                                const int skipped_bytes_per_row,
+                                uint8_t *const pixels) {
+  int input = 0;
+  int output = 0;
+
+  for (int row = 0; row < rows; row++) {
+    for (int column = 0; column < columns; column++) {
+      pixels[output++] = blues[input] * 255.0f;
+      pixels[output++] = greens[input] * 255.0f;
+      pixels[output++] = reds[input] * 255.0f;
+      input++;
+    }
+
+    output += skipped_bytes_per_row;
+  }
+}
+
+void framebuffer_premultiply(const int rows, const int columns,
+                             const float *const opacities,
+                             const float *const reds,
+                             const float *const greens,
+                             const float *const blues, const int first_row,
+                             const int last_row, uint8_t *const scratch) {
+  const int source_pixels = rows * columns;
+  uint8_t *const scratch_blues = scratch;
+  uint8_t *const scratch_greens = scratch_blues + source_pixels;
+  uint8_t *const scratch_reds = scratch_greens + source_pixels;
+  uint8_t *const scratch_opacities = scratch_reds + source_pixels;
+  const int last_index = last_row * columns;
+
+  for (int source_index = first_row * columns; source_index < last_index;
+       source_index++) {
+    const float opacity = opacities[source_index] * 255.0f;
+    scratch_blues[source_index] = blues[source_index] * opacity;
+    scratch_greens[source_index] = greens[source_index] * opacity;
+    scratch_reds[source_index] = reds[source_index] * opacity;
+    scratch_opacities[source_index] = opacity;
+  }
+}
+
+void framebuffer_scale(const int rows, const int columns,
+                       const uint8_t *const scratch,
+                       const viewport *const viewport, const int first_row,
+                       const int last_row, uint8_t *const pixels) {
+  const int scaled_width = viewport->scaled_width;
+  const int source_pixels = rows * columns;
+  const uint8_t *const scratch_blues = scratch;
+  const uint8_t *const scratch_greens = scratch_blues + source_pixels;
+  const uint8_t *const scratch_reds = scratch_greens + source_pixels;
+  const uint8_t *const scratch_opacities = scratch_reds + source_pixels;
+  const float y_per_row = viewport->rows_per_pixel;
+  const int rows_minus_one = rows - 1;
+  const float x_per_column = viewport->columns_per_pixel;
+  const int columns_minus_one = columns - 1;
+  int destination_index = first_row * scaled_width * 4;
+
+  for (int row = first_row; row < last_row; row++) {
+    int y = row * y_per_row;
+
+    if (y < 0) {
+      y = 0;
+    }
+
+    if (y > rows_minus_one) {
+      y = rows_minus_one;
+    }
+
+    const int y_index = y * columns;
+
+    for (int column = 0; column < scaled_width; column++) {
+      int x = column * x_per_column;
+
+      if (x < 0) {
+        x = 0;
+      }
+
+      if (x > columns_minus_one) {
+        x = columns_minus_one;
+      }
+
+      const int source_index = y_index + x;
+
+      pixels[destination_index++] = scratch_blues[source_index];
+      pixels[destination_index++] = scratch_greens[source_index];
+      pixels[destination_index++] = scratch_reds[source_index];
+      pixels[destination_index++] = scratch_opacities[source_index];
+    }
+  }
+}
+
+void framebuffer_convert_layered(const int rows, const int columns,
+                                 const float *const opacities,
+                                 const float *const reds,
+                                 const float *const greens,
+                                 const float *const blues,
+                                 uint8_t *const scratch,
+                                 const viewport *const viewport,
+                                 uint8_t *const pixels) {
+  // Each pixel of the viewport is converted once, however many times it is
+  // then repeated by scaling.
+  framebuffer_premultiply(rows, columns, opacities, reds, greens, blues, 0,
+                          rows, scratch);
+  framebuffer_scale(rows, columns, scratch, viewport, 0,
+                    viewport->scaled_height, pixels);
+}
@@ -0,0 +1,110 @@
+#ifndef FRAMEBUFFER_H
+
+#define FRAMEBUFFER_H
+
+#include "viewport.h"
+#include <stdint.h>
+
+/**
+ * Converts a viewport to 24-bit pixels, as expected by an opaque
+ * device-independent bitmap.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ * @param reds The intensity of the red channel of each pixel within the
+ *             viewport, row-major, starting from the top left corner.  Behavior
+ *             is undefined if any are NaN, less than 0 or greater than 1.
+ * @param greens As reds, but for the green channel.
+ * @param blues As reds, but for the blue channel.
+ * @param skipped_bytes_per_row The number of bytes of padding following each
+ *                              row of pixels, which are left unchanged.
+ * @param pixels Written to with the blue, green and red bytes of each pixel in
+ *               turn, row-major, starting from the top left corner.
+ */
+void framebuffer_convert_opaque(const int rows, const int columns,
+                                const float *const reds,
+                                const float *const greens,
+                                const float *const blues,
+                                const int skipped_bytes_per_row,
+                                uint8_t *const pixels);
+
+/**
+ * Converts a viewport to premultiplied 32-bit pixels, scaled using
+ * nearest-neighbor sampling, as expected by a layered window.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ * @param opacities The opacity of each pixel within the viewport, row-major,
+ *                  starting from the top left corner.  Behavior is undefined if
+ *                  any are NaN, less than 0 or greater than 1.
+ * @param reds As opacities, but for the intensity of the red channel.
+ * @param greens As opacities, but for the intensity of the green channel.
+ * @param blues As opacities, but for the intensity of the blue channel.
+ * @param scratch Overwritten.  Must have space for 4 bytes per pixel of the
+ *                viewport.
+ * @param viewport The size to which to scale the viewport.
+ * @param pixels Written to with the blue, green, red and opacity bytes of each
+ *               pixel of the scaled viewport in turn, row-major, starting from
+ *               the top left corner.
+ */
+void framebuffer_convert_layered(const int rows, const int columns,
+                                 const float *const opacities,
+                                 const float *const reds,
+                                 const float *const greens,
+                                 const float *const blues,
+                                 uint8_t *const scratch,
+                                 const viewport *const viewport,
+                                 uint8_t *const pixels);
+
+/**
+ * Performs the first half of framebuffer_convert_layered for a range of rows,
+ * so that it may be split between threads: premultiplies each pixel of those
+ * rows of the viewport into scratch.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ * @param opacities As given to framebuffer_convert_layered.
+ * @param reds As given to framebuffer_convert_layered.
+ * @param greens As given to framebuffer_convert_layered.
+ * @param blues As given to framebuffer_convert_layered.
+ * @param first_row The first row of the viewport to premultiply.
+ * @param last_row The row of the viewport after the last to premultiply.
+ *                 Behavior is undefined if less than first_row or greater than
+ *                 rows.
+ * @param scratch As given to framebuffer_convert_layered.  Only the parts
+ *                describing the given rows are written to.
+ */
+void framebuffer_premultiply(const int rows, const int columns,
+                             const float *const opacities,
+                             const float *const reds,
+                             const float *const greens,
+                             const float *const blues, const int first_row,
+                             const int last_row, uint8_t *const scratch);
+
+/**
+ * Performs the second half of framebuffer_convert_layered for a range of rows
+ * of the scaled viewport, so that it may be split between threads: samples
+ * the premultiplied viewport to fill those rows.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ * @param scratch Written by framebuffer_premultiply for every row of the
+ *                viewport.
+ * @param viewport As given to framebuffer_convert_layered.
+ * @param first_row The first row of the scaled viewport to fill.
+ * @param last_row The row of the scaled viewport after the last to fill.
+ *                 Behavior is undefined if less than first_row or greater than
+ *                 the height of the scaled viewport.
+ * @param pixels As given to framebuffer_convert_layered.  Only the given rows
+ *               are written to.
+ */
+void framebuffer_scale(const int rows, const int columns,
+                       const uint8_t *const scratch,
+                       const viewport *const viewport, const int first_row,
+                       const int last_row, uint8_t *const pixels);
+
+#endif
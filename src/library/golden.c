@@ -0,0 +1,489 @@
+#include "golden.h"
+#include "file_mapping.h"
+#include "frame_codec.h"
+#include "framebuffer.h"
+#include "input.h"
+#include "input_recording.h"
+#include "viewport.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Each tick is stored as a hash of its audio, so that divergent audio can be
+// located to the tick.  Each checkpoint follows the ticks before it, stored as
+// the number of ticks executed and the length of the frame which follows,
+// compressed as a QOI image.
+#define TICK_BYTES 8
+#define CHECKPOINT_HEADER_BYTES 8
+
+#define FNV_OFFSET_BASIS 14695981039346656037u
+#define FNV_PRIME 1099511628211u
+
+static const uint8_t magic[] = {'G', 'O', 'L', 'D', 2};
+
+typedef struct {
+  bool record;
+  FILE *file;
+  file_mapping file_mapping;
+  uint64_t offset;
+} golden_file;
+
+static void write_u32(uint8_t *const bytes, const uint32_t value) {
+  for (int byte = 0; byte < 4; byte++) {
+    bytes[byte] = value >> (byte * 8);
+  }
+}
+
+static void write_u64(uint8_t *const bytes, const uint64_t value) {
+  write_u32(bytes, value);
+  write_u32(bytes + 4, value >> 32);
+}
+
+static uint32_t read_u32(const uint8_t *const bytes) {
+  return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+         (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t read_u64(const uint8_t *const bytes) {
+  return read_u32(bytes) | (uint64_t)read_u32(bytes + 4) << 32;
+}
+
+// FNV-1a, over the bytes of the samples as they lie in memory.
+static uint64_t hash_audio(uint64_t hash, const float *const audio,
+                           const int samples) {
+  const uint8_t *const bytes = (const uint8_t *)audio;
+
+  for (size_t byte = 0; byte < sizeof(float) * samples; byte++) {
+    hash = (hash ^ bytes[byte]) * FNV_PRIME;
+  }
+
+  return hash;
+}
+
+static uint64_t compare_pixels(const uint8_t *const expected,
+                               const uint8_t *const actual, const int row,
+                               const int from, const int to,
+                               const int channels,
+                               golden_region *const region) {
+  uint64_t differing = 0;
+
+  for (int column = from; column < to; column++) {
+    if (memcmp(expected + column * channels, actual + column * channels,
+               channels) != 0) {
+      differing++;
+      region->top = row < region->top ? row : region->top;
+      region->bottom = row + 1 > region->bottom ? row + 1 : region->bottom;
+      region->left = column < region->left ? column : region->left;
+      region->right = column + 1 > region->right ? column + 1 : region->right;
+    }
+  }
+
+  return differing;
+}
+
+uint64_t golden_compare(const uint8_t *const expected,
+                        const uint8_t *const actual, const int rows,
+                        const int columns, const int channels,
+                        golden_region *const region) {
+  const int bytes_per_row = columns * channels;
+  uint64_t differing = 0;
+
+  region->top = rows;
+  region->left = columns;
+  region->bottom = 0;
+  region->right = 0;
+
+  for (int row = 0; row < rows; row++) {
+    const uint8_t *const expected_row = expected + (size_t)row * bytes_per_row;
+    const uint8_t *const actual_row = actual + (size_t)row * bytes_per_row;
+    int byte = 0;
+
+    // The pixels before this have already been compared.
+    int compared = 0;
+
+#ifdef __SSE2__
+    // Identical frames are the common case, so whole vectors are compared,
+    // only looking at individual pixels where a vector differs.
+    for (; byte + 16 <= bytes_per_row; byte += 16) {
+      const __m128i equal = _mm_cmpeq_epi8(
+          _mm_loadu_si128((const __m128i *)(expected_row + byte)),
+          _mm_loadu_si128((const __m128i *)(actual_row + byte)));
+
+      if (_mm_movemask_epi8(equal) == 0xffff) {
+        continue;
+      }
+
+      const int first = byte / channels;
+      const int from = first > compared ? first : compared;
+      const int to = (byte + 15) / channels + 1;
+
+      differing += compare_pixels(expected_row, actual_row, row, from, to,
+                                  channels, region);
+      compared = to;
+    }
+#endif
+
+    const int first = byte / channels;
+    differing += compare_pixels(expected_row, actual_row, row,
+                                first > compared ? first : compared, columns,
+                                channels, region);
+  }
+
+  if (differing == 0) {
+    region->top = 0;
+    region->left = 0;
+  }
+
+  return differing;
+}
+
+static const char *open_golden_file(golden_file *const golden_file,
+                                    const char *const path, const bool record) {
+  golden_file->record = record;
+  golden_file->offset = sizeof(magic);
+
+  if (record) {
+    golden_file->file = fopen(path, "wb");
+
+    if (golden_file->file == NULL) {
+      return "Failed to open the golden file for writing.";
+    }
+
+    if (fwrite(magic, 1, sizeof(magic), golden_file->file) != sizeof(magic)) {
+      if (fclose(golden_file->file) == 0) {
+        return "Failed to write to the golden file.";
+      } else {
+        return "Failed to write to the golden file.  Additionally failed to "
+               "close it.";
+      }
+    }
+
+    return NULL;
+  }
+
+  const char *const error =
+      file_mapping_open(&golden_file->file_mapping, path);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  const uint8_t *bytes;
+
+  if (file_mapping_size(&golden_file->file_mapping) < sizeof(magic) ||
+      file_mapping_read(&golden_file->file_mapping, 0, sizeof(magic),
+                        &bytes) != NULL ||
+      memcmp(bytes, magic, sizeof(magic)) != 0) {
+    if (file_mapping_close(&golden_file->file_mapping) == NULL) {
+      return "The golden file is not a golden file.";
+    } else {
+      return "The golden file is not a golden file.  Additionally failed to "
+             "close it.";
+    }
+  }
+
+  return NULL;
+}
+
+static const char *close_golden_file(golden_file *const golden_file) {
+  if (golden_file->record) {
+    return fclose(golden_file->file) == 0 ? NULL
+                                          : "Failed to close the golden file.";
+  } else {
+    return file_mapping_close(&golden_file->file_mapping);
+  }
+}
+
+// Records or compares against the hash of a tick's audio.
+static const char *tick_hash(golden_file *const golden_file,
+                             const uint64_t hash, bool *const matched) {
+  if (golden_file->record) {
+    uint8_t bytes[TICK_BYTES];
+    write_u64(bytes, hash);
+    *matched = true;
+    return fwrite(bytes, 1, sizeof(bytes), golden_file->file) == sizeof(bytes)
+               ? NULL
+               : "Failed to write to the golden file.";
+  }
+
+  if (file_mapping_size(&golden_file->file_mapping) - golden_file->offset <
+      TICK_BYTES) {
+    return "The golden file describes fewer checkpoints than given.";
+  }
+
+  const uint8_t *bytes;
+  const char *const error = file_mapping_read(
+      &golden_file->file_mapping, golden_file->offset, TICK_BYTES, &bytes);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  golden_file->offset += TICK_BYTES;
+  *matched = read_u64(bytes) == hash;
+  return NULL;
+}
+
+// Records or compares against a checkpoint.  work must have space for the
+// larger of the frame and the most its encoding could take.  audio_tick is the
+// first tick since the previous checkpoint whose audio differed, if any.
+static const char *
+checkpoint(golden_file *const golden_file, const uint32_t tick,
+           const bool audio_diverged, const uint32_t audio_tick,
+           const uint8_t *const frame, const int rows, const int columns,
+           const int channels, uint8_t *const work, bool *const diverged,
+           golden_divergence *const divergence) {
+  uint8_t header[CHECKPOINT_HEADER_BYTES];
+
+  if (golden_file->record) {
+    const size_t bytes =
+        frame_codec_encode(frame, rows, columns, channels, work);
+    write_u32(header, tick);
+    write_u32(header + 4, bytes);
+
+    if (fwrite(header, 1, sizeof(header), golden_file->file) !=
+            sizeof(header) ||
+        fwrite(work, 1, bytes, golden_file->file) != bytes) {
+      return "Failed to write to the golden file.";
+    }
+
+    return NULL;
+  }
+
+  const uint64_t remaining =
+      file_mapping_size(&golden_file->file_mapping) - golden_file->offset;
+  const uint8_t *bytes;
+
+  if (remaining < CHECKPOINT_HEADER_BYTES) {
+    return "The golden file describes fewer checkpoints than given.";
+  }
+
+  const char *error =
+      file_mapping_read(&golden_file->file_mapping, golden_file->offset,
+                        CHECKPOINT_HEADER_BYTES, &bytes);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  const uint32_t expected_tick = read_u32(bytes);
+  const uint32_t length = read_u32(bytes + 4);
+
+  if (expected_tick != tick) {
+    return "The golden file describes other checkpoints than given.";
+  }
+
+  if (remaining - CHECKPOINT_HEADER_BYTES < length) {
+    return "The golden file is truncated.";
+  }
+
+  error = file_mapping_read(&golden_file->file_mapping,
+                            golden_file->offset + CHECKPOINT_HEADER_BYTES,
+                            length, &bytes);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  error =
+      frame_codec_decode(bytes, length, rows, columns, channels, work, NULL);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  golden_file->offset += CHECKPOINT_HEADER_BYTES + length;
+
+  golden_region region;
+  const uint64_t differing_pixels =
+      golden_compare(work, frame, rows, columns, channels, &region);
+
+  if (differing_pixels > 0 || audio_diverged) {
+    *diverged = true;
+
+    if (divergence != NULL) {
+      divergence->tick = tick;
+      divergence->audio_diverged = audio_diverged;
+      divergence->audio_tick = audio_diverged ? audio_tick : 0;
+      divergence->video_diverged = differing_pixels > 0;
+      divergence->differing_pixels = differing_pixels;
+      divergence->region = region;
+    }
+  }
+
+  return NULL;
+}
+
+static const char *
+replay(input_recording *const recording, golden_file *const golden_file,
+       void (*const tick)(const input *const input, float *const audio),
+       const int rows, const int columns, const float *const opacities,
+       const float *const reds, const float *const greens,
+       const float *const blues,
+       void (*const video)(const input *const input,
+                           const float tick_progress_unit_interval),
+       const int samples_per_tick, const int width, const int height,
+       const uint32_t *const checkpoints, const int number_of_checkpoints,
+       bool *const diverged, golden_divergence *const divergence) {
+  viewport viewport;
+  int frame_rows = rows;
+  int frame_columns = columns;
+  int channels = 3;
+
+  if (opacities != NULL) {
+    viewport_fit(&viewport, rows, columns, width, height);
+    frame_rows = viewport.scaled_height;
+    frame_columns = viewport.scaled_width;
+    channels = 4;
+  }
+
+  const size_t audio_bytes = sizeof(float) * 2 * samples_per_tick;
+  const size_t frame_bytes = (size_t)frame_rows * frame_columns * channels;
+  const size_t scratch_bytes =
+      opacities == NULL ? 0 : (size_t)rows * columns * 4;
+  const size_t work_bytes =
+      frame_codec_maximum_bytes(frame_rows, frame_columns, channels);
+  float *const audio =
+      malloc(audio_bytes + frame_bytes + scratch_bytes + work_bytes);
+
+  if (audio == NULL) {
+    return "Failed to allocate memory.";
+  }
+
+  uint8_t *const frame = (uint8_t *)audio + audio_bytes;
+  uint8_t *const scratch = frame + frame_bytes;
+  uint8_t *const work = scratch + scratch_bytes;
+  input_event input_events[INPUT_EVENT_QUEUE_CAPACITY];
+  input snapshot = {
+      .pointer_state = POINTER_STATE_NONE,
+      .pointer_row = 0.0f,
+      .pointer_column = 0.0f,
+      .held_keys = {0, 0, 0, 0, 0, 0, 0, 0},
+      .events = NULL,
+      .number_of_events = 0,
+  };
+  bool audio_diverged = false;
+  uint32_t audio_tick = 0;
+  uint32_t executed = 0;
+  int next = 0;
+  const char *error = NULL;
+
+  while (error == NULL && !*diverged) {
+    if (next < number_of_checkpoints && checkpoints[next] == executed) {
+      // Video is only given events alongside the tick they belong to.
+      snapshot.events = NULL;
+      snapshot.number_of_events = 0;
+      video(&snapshot, 0.0f);
+
+      if (opacities == NULL) {
+        framebuffer_convert_opaque(rows, columns, reds, greens, blues, 0,
+                                   frame);
+      } else {
+        framebuffer_convert_layered(rows, columns, opacities, reds, greens,
+                                    blues, scratch, &viewport, frame);
+      }
+
+      error = checkpoint(golden_file, executed, audio_diverged, audio_tick,
+                         frame, frame_rows, frame_columns, channels, work,
+                         diverged, divergence);
+      next++;
+      continue;
+    }
+
+    if (next == number_of_checkpoints) {
+      break;
+    }
+
+    bool ended;
+    error = input_recording_read(recording, &snapshot, input_events, &ended);
+
+    if (error == NULL && ended) {
+      error = "The input recording ended before the last checkpoint.";
+    }
+
+    if (error == NULL) {
+      tick(&snapshot, audio);
+
+      bool matched;
+      error = tick_hash(golden_file,
+                        hash_audio(FNV_OFFSET_BASIS, audio,
+                                   samples_per_tick * 2),
+                        &matched);
+
+      // Replay continues to the checkpoint, so that the frame there is
+      // compared too.
+      if (error == NULL && !matched && !audio_diverged) {
+        audio_diverged = true;
+        audio_tick = executed;
+      }
+
+      executed++;
+    }
+  }
+
+  free(audio);
+  return error;
+}
+
+const char *run_golden(
+    const char *const recording_path, const char *const golden_path,
+    const bool record,
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows, const int columns, const float *const opacities,
+    const float *const reds, const float *const greens,
+    const float *const blues,
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const int width, const int height,
+    const uint32_t *const checkpoints, const int number_of_checkpoints,
+    bool *const diverged, golden_divergence *const divergence) {
+  input_recording recording;
+  golden_file golden_file;
+
+  *diverged = false;
+
+  const char *error = input_recording_open(&recording, recording_path, false);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  error = open_golden_file(&golden_file, golden_path, record);
+
+  if (error != NULL) {
+    if (input_recording_close(&recording) == NULL) {
+      return error;
+    } else {
+      return "Failed to open the golden file.  Additionally failed to close "
+             "the input recording.";
+    }
+  }
+
+  error = replay(&recording, &golden_file, tick, rows, columns, opacities,
+                 reds, greens, blues, video, samples_per_tick, width, height,
+                 checkpoints, number_of_checkpoints, diverged, divergence);
+
+  if (error == NULL && !record && !*diverged &&
+      golden_file.offset != file_mapping_size(&golden_file.file_mapping)) {
+    error = "The golden file describes more checkpoints than given.";
+  }
+
+  const char *const golden_error = close_golden_file(&golden_file);
+  const char *const recording_error = input_recording_close(&recording);
+
+  // Only one message can be returned; the first to occur is the most useful.
+  if (error != NULL) {
+    return error;
+  } else if (golden_error != NULL) {
+    return golden_error;
+  } else {
+    return recording_error;
+  }
+}
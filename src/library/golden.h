@@ -0,0 +1,136 @@
+#ifndef GOLDEN_H
+
+#define GOLDEN_H
+
+#include "input.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A rectangle of pixels within a frame.
+ */
+typedef struct {
+  /**
+   * The number of rows above the rectangle.
+   */
+  int top;
+
+  /**
+   * The number of columns left of the rectangle.
+   */
+  int left;
+
+  /**
+   * The number of rows above the bottom edge of the rectangle.
+   */
+  int bottom;
+
+  /**
+   * The number of columns left of the right edge of the rectangle.
+   */
+  int right;
+} golden_region;
+
+/**
+ * Describes where a run first diverged from its golden file.
+ */
+typedef struct {
+  /**
+   * The checkpoint at which divergence was detected, in ticks executed.
+   */
+  uint32_t tick;
+
+  /**
+   * True when the audio of any tick since the previous checkpoint differed.
+   */
+  bool audio_diverged;
+
+  /**
+   * The number of ticks executed before the first whose audio differed, so
+   * that its audio starts this many multiples of samples_per_tick samples into
+   * the replay.  0 when audio_diverged is false.
+   */
+  uint32_t audio_tick;
+
+  /**
+   * True when the frame at the checkpoint differed.
+   */
+  bool video_diverged;
+
+  /**
+   * The number of pixels of the frame which differed.  0 when video_diverged
+   * is false.
+   */
+  uint64_t differing_pixels;
+
+  /**
+   * The smallest rectangle containing every pixel of the frame which differed.
+   * Empty when video_diverged is false.
+   */
+  golden_region region;
+} golden_divergence;
+
+/**
+ * Compares two frames of pixels, using SSE2 where available.
+ * @param expected The bytes of each pixel of the expected frame, row-major,
+ *                 starting from the top left corner, without padding between
+ *                 rows.
+ * @param actual As expected, but for the frame to compare against it.
+ * @param rows The height of the frames in rows.
+ * @param columns The width of the frames in columns.
+ * @param channels The number of bytes per pixel.  Behavior is undefined if
+ *                 less than 1.
+ * @param region Written to with the smallest rectangle containing every pixel
+ *               which differs, or an empty rectangle when none do.
+ * @return The number of pixels which differ.
+ */
+uint64_t golden_compare(const uint8_t *const expected,
+                        const uint8_t *const actual, const int rows,
+                        const int columns, const int channels,
+                        golden_region *const region);
+
+/**
+ * Replays an input recording, as run_replay, but at each of a list of
+ * checkpoints renders a frame through the same conversion and scaling as a
+ * window of a given size, and either records it and a hash of the audio of
+ * each tick since the previous checkpoint to a golden file, or compares them
+ * against those previously recorded.  Replay stops at the first checkpoint at
+ * which either diverged.  Parameters not documented here are as given to
+ * run_event_loop.
+ * @param recording_path The null-terminated path to the input recording to
+ *                       replay.
+ * @param golden_path The null-terminated path to the golden file.
+ * @param record When true, the golden file is (re)written.  Otherwise, it is
+ *               compared against.
+ * @param width The width of the client area of the window to render for, in
+ *              pixels.  Only used when opacities is non-null, in which case
+ *              frames are scaled as a layered window would be.  Otherwise,
+ *              frames are compared at the size of the viewport, as given to
+ *              an opaque window.
+ * @param height As width, but for the height.
+ * @param checkpoints The number of ticks to have executed at each checkpoint,
+ *                    in ascending order.  0 renders a frame before the first
+ *                    tick.
+ * @param number_of_checkpoints The number of checkpoints.
+ * @param diverged Written to with true should the run have diverged from the
+ *                 golden file, otherwise false.
+ * @param divergence When non-null and the run diverged, written to with where.
+ * @return In the event of an error (including the recording ending before the
+ *         last checkpoint, or the golden file describing other checkpoints), a
+ *         null-terminated UTF-8-encoded error message describing the problem,
+ *         otherwise, null.
+ */
+const char *run_golden(
+    const char *const recording_path, const char *const golden_path,
+    const bool record,
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows, const int columns, const float *const opacities,
+    const float *const reds, const float *const greens,
+    const float *const blues,
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const int width, const int height,
+    const uint32_t *const checkpoints, const int number_of_checkpoints,
+    bool *const diverged, golden_divergence *const divergence);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef HEADLESS_OUTPUT_H
+
+#define HEADLESS_OUTPUT_H
+
+/**
+ * A destination for the audio and video produced by a headless event loop,
+ * such as a file.  Either function may be null, in which case whatever it
+ * would have been given is discarded.
+ */
+typedef struct {
+  /**
+   * Passed to each of the following functions.
+   */
+  void *const state;
+
+  /**
+   * Consumes the audio written by a tick.
+   * @param state The state of the output.
+   * @param samples The interleaved stereo audio written by the tick.
+   * @param samples_per_tick The number of samples within samples, per channel.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const audio)(void *const state, const float *const samples,
+                             const int samples_per_tick);
+
+  /**
+   * Consumes the viewport rendered by a video event.
+   * @param state The state of the output.
+   * @param rows The height of the viewport in rows.
+   * @param columns The width of the viewport in columns.
+   * @param opacities The opacity of each pixel within the viewport, or null
+   *                  when the viewport is fully opaque.
+   * @param reds The intensity of the red channel of each pixel.
+   * @param greens The intensity of the green channel of each pixel.
+   * @param blues The intensity of the blue channel of each pixel.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const video)(void *const state, const int rows,
+                             const int columns, const float *const opacities,
+                             const float *const reds, const float *const greens,
+                             const float *const blues);
+} headless_output;
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "headless_pool.h"
+#include "event_loop_core.h"
+#include "run_event_loop_headless.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+  headless_job *const jobs;
+  const int number_of_jobs;
+  const event_loop_timer *const timer;
+
+  // The index of the next job to start, claimed atomically.
+  int next;
+} pool;
+
+static void run_jobs(pool *const pool) {
+  while (true) {
+    const int index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+
+    if (index >= pool->number_of_jobs) {
+      return;
+    }
+
+    headless_job *const job = &pool->jobs[index];
+    job->error =
+        run_headless_application(job->application, job->ticks, job->frames,
+                                 job->output, pool->timer, &job->statistics);
+  }
+}
+
+#ifdef _WIN32
+
+typedef HANDLE worker;
+
+static DWORD WINAPI worker_thread(LPVOID lpParam) {
+  run_jobs(lpParam);
+  return 0;
+}
+
+int headless_pool_processors(void) {
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  return system_info.dwNumberOfProcessors < 1
+             ? 1
+             : (int)system_info.dwNumberOfProcessors;
+}
+
+static bool start_worker(worker *const worker, pool *const pool) {
+  *worker = CreateThread(NULL, 0, worker_thread, pool, 0, NULL);
+  return *worker != NULL;
+}
+
+static const char *stop_worker(const worker worker) {
+  const bool joined = WaitForSingleObject(worker, INFINITE) == WAIT_OBJECT_0;
+  const bool closed = CloseHandle(worker);
+
+  if (!joined) {
+    return "Failed to wait for a headless pool thread to stop.";
+  } else if (!closed) {
+    return "Failed to close a headless pool thread.";
+  } else {
+    return NULL;
+  }
+}
+
+#else
+
+typedef pthread_t worker;
+
+static void *worker_thread(void *const argument) {
+  run_jobs(argument);
+  return NULL;
+}
+
+int headless_pool_processors(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+  const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  return processors < 1 ? 1 : (int)processors;
+#else
+  return 1;
+#endif
+}
+
+static bool start_worker(worker *const worker, pool *const pool) {
+  return pthread_create(worker, NULL, worker_thread, pool) == 0;
+}
+
+static const char *stop_worker(const worker worker) {
+  return pthread_join(worker, NULL) == 0
+             ? NULL
+             : "Failed to wait for a headless pool thread to stop.";
+}
+
+#endif
+
+const char *run_headless_pool(headless_job *const jobs,
+                              const int number_of_jobs, const int threads,
+                              const event_loop_timer *const timer) {
+  pool pool = {
+      .jobs = jobs,
+      .number_of_jobs = number_of_jobs,
+      .timer = timer,
+      .next = 0,
+  };
+
+  const int requested = threads < 1 ? headless_pool_processors() : threads;
+
+  // There is no use in more threads than jobs, and the calling thread is one.
+  const int additional =
+      (requested < number_of_jobs ? requested : number_of_jobs) - 1;
+  worker *const workers =
+      additional > 0 ? malloc(sizeof(worker) * additional) : NULL;
+  const char *error = NULL;
+  int started = 0;
+
+  if (additional > 0 && workers == NULL) {
+    error = "Failed to allocate memory for the headless pool.";
+  } else {
+    while (started < additional) {
+      if (!start_worker(&workers[started], &pool)) {
+        error = "Failed to start a headless pool thread.";
+        break;
+      }
+
+      started++;
+    }
+  }
+
+  run_jobs(&pool);
+
+  for (int index = 0; index < started; index++) {
+    const char *const stop_error = stop_worker(workers[index]);
+
+    if (error == NULL) {
+      error = stop_error;
+    }
+  }
+
+  free(workers);
+  return error;
+}
@@ -0,0 +1,74 @@
+#ifndef HEADLESS_POOL_H
+
+#define HEADLESS_POOL_H
+
+#include "event_loop_core.h"
+#include "headless_output.h"
+#include "run_event_loop_headless.h"
+#include <stdint.h>
+
+/**
+ * A headless run of an instance of an application, executed by a pool.
+ */
+typedef struct {
+  /**
+   * The instance to run.  Must not be shared with any other job.
+   */
+  const headless_application *application;
+
+  /**
+   * The number of tick events to raise for this instance.
+   */
+  uint32_t ticks;
+
+  /**
+   * The number of video events to raise for this instance, spread evenly
+   * between its tick events.
+   */
+  uint32_t frames;
+
+  /**
+   * When non-null, given the audio and viewport of this instance, as by
+   * run_headless_application.  Must not be shared with any other job.
+   */
+  const headless_output *output;
+
+  /**
+   * Written to with measurements once the job has run.
+   */
+  headless_statistics statistics;
+
+  /**
+   * Written to with null once the job has run without error, otherwise, a
+   * null-terminated UTF-8-encoded error message describing the problem.
+   */
+  const char *error;
+} headless_job;
+
+/**
+ * Determines how many processors are available to run threads on.
+ * @return The number of processors available, or 1 when unknown.
+ */
+int headless_pool_processors(void);
+
+/**
+ * Runs a batch of headless jobs across a pool of threads, each taking the next
+ * job yet to start whenever it finishes one, blocking until every job has run.
+ * Jobs run to completion once started; one failing does not stop the others.
+ * @param jobs The jobs to run.
+ * @param number_of_jobs The number of jobs.
+ * @param threads The number of threads to run jobs on, including the calling
+ *                thread.  Values less than 1 use headless_pool_processors.
+ * @param timer When non-null, used by every thread to measure time, so must be
+ *              safe to call concurrently.  Otherwise, as
+ *              run_headless_application.
+ * @return In the event of an error starting or stopping the pool's threads, a
+ *         null-terminated UTF-8-encoded error message describing the problem,
+ *         otherwise, null.  Errors of the jobs themselves are written to the
+ *         jobs.  Every job still runs should threads fail to start.
+ */
+const char *run_headless_pool(headless_job *const jobs,
+                              const int number_of_jobs, const int threads,
+                              const event_loop_timer *const timer);
+
+#endif
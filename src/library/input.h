@@ -0,0 +1,148 @@
+#ifndef INPUT_H
+
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * There is no currently known pointer.  For example, the device may only have
+ * a touch screen, with no manipulation currently occurring.  The pointer
+ * coordinates are undefined.
+ */
+#define POINTER_STATE_NONE 0
+
+/**
+ * The location of the pointer is known, but the user is not currently
+ * indicating that they wish to select what it overlaps, if anything.  For
+ * example, the device may have a mouse for which the primary button is not
+ * pressed, some kind of pen input which is hovering over the display or a light
+ * gun which which is tracking position without the trigger being pulled.  The
+ * pointer coordinates are likely to fall in the range 0 ... rows/columns, but
+ * may fall outside that range.
+ */
+#define POINTER_STATE_HOVER 1
+
+/**
+ * The location of the pointer is known, and the user is currently indicating
+ * that they wish to select what it overlaps, if anything.  For example, the
+ * device may have a mouse for which the primary button is pressed, some kind of
+ * pen input which is currently making contact with the display or a light gun
+ * for which the trigger is being pulled.  The pointer coordinates are likely to
+ * fall in the range 0 ... rows/columns, but may fall outside that range.
+ */
+#define POINTER_STATE_SELECT 2
+
+/**
+ * A key which was not previously held was pressed.
+ */
+#define INPUT_EVENT_TYPE_KEY_DOWN 0
+
+/**
+ * A key which was previously held was released.
+ */
+#define INPUT_EVENT_TYPE_KEY_UP 1
+
+/**
+ * The state and/or location of the pointer changed.
+ */
+#define INPUT_EVENT_TYPE_POINTER 2
+
+/**
+ * The maximum number of input events which may be delivered to a single tick.
+ * Any further events which occur before the tick are dropped.
+ */
+#define INPUT_EVENT_QUEUE_CAPACITY 256
+
+/**
+ * A change in user input.
+ */
+typedef struct {
+  /**
+   * An INPUT_EVENT_TYPE_* constant describing the change.
+   */
+  int type;
+
+  /**
+   * The time at which the change occurred, in milliseconds since the event
+   * loop started, wrapping at 2^32.
+   */
+  uint32_t milliseconds;
+
+  /**
+   * The virtual key code of the key pressed or released, when the type is
+   * INPUT_EVENT_TYPE_KEY_DOWN or INPUT_EVENT_TYPE_KEY_UP.  Otherwise undefined.
+   */
+  int virtual_key_code;
+
+  /**
+   * The new POINTER_STATE_* constant describing the pointer, when the type is
+   * INPUT_EVENT_TYPE_POINTER.  Otherwise undefined.
+   */
+  int pointer_state;
+
+  /**
+   * The new location of the pointer in rows from the top edge of the viewport,
+   * when the type is INPUT_EVENT_TYPE_POINTER.  Otherwise undefined.
+   */
+  float pointer_row;
+
+  /**
+   * The new location of the pointer in columns from the left edge of the
+   * viewport, when the type is INPUT_EVENT_TYPE_POINTER.  Otherwise undefined.
+   */
+  float pointer_column;
+} input_event;
+
+/**
+ * The state of user input at a point in time.  This does not change for the
+ * duration of the event to which it is given.
+ */
+typedef struct {
+  /**
+   * A POINTER_STATE_* constant describing the pointer.
+   */
+  int pointer_state;
+
+  /**
+   * The location of the pointer in rows from the top edge of the viewport.
+   */
+  float pointer_row;
+
+  /**
+   * The location of the pointer in columns from the left edge of the viewport.
+   */
+  float pointer_column;
+
+  /**
+   * One bit per virtual key code, set when the corresponding key is held.
+   * Use key_held to query.
+   */
+  uint32_t held_keys[8];
+
+  /**
+   * The changes in user input which occurred since the previous tick, from
+   * earliest to latest.  Only given to tick events; empty otherwise.
+   */
+  const input_event *events;
+
+  /**
+   * The number of changes in user input within events.
+   */
+  int number_of_events;
+} input;
+
+/**
+ * Determines whether a key is currently held.
+ * @param input The input to query.
+ * @param virtual_key_code The virtual key code of the key to check.  Behavior
+ *                         is undefined if less than 0 or greater than 255.
+ * @return True when the key is held, otherwise, false.
+ */
+static inline bool key_held(const input *const input,
+                            const int virtual_key_code) {
+  return (input->held_keys[virtual_key_code >> 5] >> (virtual_key_code & 31)) &
+         1;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "input_event_queue.h"
+#include "input.h"
+#include <stdbool.h>
+#include <string.h>
+
+bool input_event_queue_push(input_event_queue *const input_event_queue,
+                            const input_event *const input_event) {
+  const int count = input_event_queue->count;
+
+  if (count == INPUT_EVENT_QUEUE_CAPACITY) {
+    return false;
+  }
+
+  input_event_queue->events[(input_event_queue->first + count) %
+                            INPUT_EVENT_QUEUE_CAPACITY] = *input_event;
+  input_event_queue->count = count + 1;
+  return true;
+}
+
+int input_event_queue_drain(input_event_queue *const input_event_queue,
+                            input_event *const input_events) {
+  const int first = input_event_queue->first;
+  const int count = input_event_queue->count;
+
+  // The contents may wrap around the end of the ring, in which case they are
+  // copied in two parts.
+  const int before_end = INPUT_EVENT_QUEUE_CAPACITY - first;
+  const int contiguous = count < before_end ? count : before_end;
+
+  memcpy(input_events, input_event_queue->events + first,
+         sizeof(input_event) * contiguous);
+  memcpy(input_events + contiguous, input_event_queue->events,
+         sizeof(input_event) * (count - contiguous));
+
+  input_event_queue->first = (first + count) % INPUT_EVENT_QUEUE_CAPACITY;
+  input_event_queue->count = 0;
+  return count;
+}
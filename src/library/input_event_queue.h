@@ -0,0 +1,38 @@
+#ifndef INPUT_EVENT_QUEUE_H
+
+#define INPUT_EVENT_QUEUE_H
+
+#include "input.h"
+#include <stdbool.h>
+
+/**
+ * A fixed-capacity first-in-first-out queue of input events.
+ */
+typedef struct {
+  input_event events[INPUT_EVENT_QUEUE_CAPACITY];
+  int first;
+  int count;
+} input_event_queue;
+
+/**
+ * Appends an input event to the end of a queue.
+ * @param input_event_queue The queue to append to.
+ * @param input_event The input event to append.
+ * @return True when the input event was appended, false when the queue was
+ *         full and it was dropped.
+ */
+bool input_event_queue_push(input_event_queue *const input_event_queue,
+                            const input_event *const input_event);
+
+/**
+ * Empties a queue.
+ * @param input_event_queue The queue to empty.
+ * @param input_events Written to with the contents of the queue, from earliest
+ *                     to latest.  Must have space for at least
+ *                     INPUT_EVENT_QUEUE_CAPACITY input events.
+ * @return The number of input events written.
+ */
+int input_event_queue_drain(input_event_queue *const input_event_queue,
+                            input_event *const input_events);
+
+#endif
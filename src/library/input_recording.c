@@ -0,0 +1,349 @@
+#include "input_recording.h"
+#include "input.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHANGED_POINTER_STATE 1
+#define CHANGED_POINTER_ROW 2
+#define CHANGED_POINTER_COLUMN 4
+#define CHANGED_HELD_KEYS 8
+#define HAS_EVENTS 16
+
+// A tick can never exceed: flags, pointer state, row, column, held keys mask,
+// held keys, event count and events (type, time, then the larger of a key code
+// or pointer state, row and column).
+#define MAXIMUM_BYTES_PER_TICK                                                 \
+  (1 + 1 + 4 + 4 + 1 + 8 * 4 + 5 + INPUT_EVENT_QUEUE_CAPACITY * (1 + 5 + 9))
+
+static const uint8_t magic[] = {'I', 'N', 'P', 'T', 1};
+
+static uint32_t float_bits(const float value) {
+  uint32_t output;
+  memcpy(&output, &value, sizeof(output));
+  return output;
+}
+
+static uint8_t *put_uint32(uint8_t *bytes, const uint32_t value) {
+  *bytes++ = value;
+  *bytes++ = value >> 8;
+  *bytes++ = value >> 16;
+  *bytes++ = value >> 24;
+  return bytes;
+}
+
+static uint8_t *put_float(uint8_t *const bytes, const float value) {
+  return put_uint32(bytes, float_bits(value));
+}
+
+static uint8_t *put_varint(uint8_t *bytes, uint32_t value) {
+  while (value >= 0x80) {
+    *bytes++ = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+
+  *bytes++ = value;
+  return bytes;
+}
+
+static bool get_uint8(FILE *const file, uint8_t *const value) {
+  const int character = getc(file);
+
+  if (character == EOF) {
+    return false;
+  }
+
+  *value = character;
+  return true;
+}
+
+static bool get_uint32(FILE *const file, uint32_t *const value) {
+  uint8_t bytes[4];
+
+  if (fread(bytes, 1, 4, file) != 4) {
+    return false;
+  }
+
+  *value = bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) |
+           ((uint32_t)bytes[3] << 24);
+  return true;
+}
+
+static bool get_float(FILE *const file, float *const value) {
+  uint32_t bits;
+
+  if (!get_uint32(file, &bits)) {
+    return false;
+  }
+
+  memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+static bool get_varint(FILE *const file, uint32_t *const value) {
+  uint32_t output = 0;
+
+  for (int shift = 0; shift < 35; shift += 7) {
+    uint8_t byte;
+
+    if (!get_uint8(file, &byte)) {
+      return false;
+    }
+
+    output |= (uint32_t)(byte & 0x7F) << shift;
+
+    if (!(byte & 0x80)) {
+      *value = output;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char *input_recording_open(input_recording *const input_recording,
+                                 const char *const path, const bool write) {
+  FILE *const file = fopen(path, write ? "wb" : "rb");
+
+  if (file == NULL) {
+    return "Failed to open the input recording.";
+  }
+
+  if (write) {
+    if (fwrite(magic, 1, sizeof(magic), file) != sizeof(magic)) {
+      if (fclose(file) == 0) {
+        return "Failed to write to the input recording.";
+      } else {
+        return "Failed to write to the input recording.  Additionally failed "
+               "to close the input recording.";
+      }
+    }
+  } else {
+    uint8_t read_magic[sizeof(magic)];
+
+    if (fread(read_magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(read_magic, magic, sizeof(magic)) != 0) {
+      if (fclose(file) == 0) {
+        return "The input recording is not in a supported format.";
+      } else {
+        return "The input recording is not in a supported format.  "
+               "Additionally failed to close the input recording.";
+      }
+    }
+  }
+
+  input_recording->file = file;
+  memset(&input_recording->previous, 0, sizeof(input));
+  input_recording->previous.pointer_state = POINTER_STATE_NONE;
+  input_recording->previous_milliseconds = 0;
+  return NULL;
+}
+
+const char *input_recording_write(input_recording *const input_recording,
+                                  const input *const input) {
+  uint8_t bytes[MAXIMUM_BYTES_PER_TICK];
+  uint8_t *const flags = bytes;
+  uint8_t *next = bytes + 1;
+
+  *flags = 0;
+
+  if (input->pointer_state != input_recording->previous.pointer_state) {
+    *flags |= CHANGED_POINTER_STATE;
+    *next++ = input->pointer_state;
+  }
+
+  if (float_bits(input->pointer_row) !=
+      float_bits(input_recording->previous.pointer_row)) {
+    *flags |= CHANGED_POINTER_ROW;
+    next = put_float(next, input->pointer_row);
+  }
+
+  if (float_bits(input->pointer_column) !=
+      float_bits(input_recording->previous.pointer_column)) {
+    *flags |= CHANGED_POINTER_COLUMN;
+    next = put_float(next, input->pointer_column);
+  }
+
+  uint8_t *const held_keys_mask = next;
+  *held_keys_mask = 0;
+  next++;
+
+  for (int index = 0; index < 8; index++) {
+    const uint32_t difference =
+        input->held_keys[index] ^ input_recording->previous.held_keys[index];
+
+    if (difference) {
+      *held_keys_mask |= 1 << index;
+      next = put_uint32(next, difference);
+    }
+  }
+
+  if (*held_keys_mask) {
+    *flags |= CHANGED_HELD_KEYS;
+  } else {
+    next--;
+  }
+
+  const int number_of_events = input->number_of_events;
+
+  if (number_of_events > 0) {
+    *flags |= HAS_EVENTS;
+    next = put_varint(next, number_of_events);
+
+    uint32_t previous_milliseconds = input_recording->previous_milliseconds;
+
+    for (int index = 0; index < number_of_events; index++) {
+      const input_event *const event = input->events + index;
+      *next++ = event->type;
+      next = put_varint(next, event->milliseconds - previous_milliseconds);
+      previous_milliseconds = event->milliseconds;
+
+      if (event->type == INPUT_EVENT_TYPE_POINTER) {
+        *next++ = event->pointer_state;
+        next = put_float(next, event->pointer_row);
+        next = put_float(next, event->pointer_column);
+      } else {
+        *next++ = event->virtual_key_code;
+      }
+    }
+
+    input_recording->previous_milliseconds = previous_milliseconds;
+  }
+
+  const size_t length = next - bytes;
+
+  if (fwrite(bytes, 1, length, input_recording->file) != length) {
+    return "Failed to write to the input recording.";
+  }
+
+  input_recording->previous = *input;
+  return NULL;
+}
+
+const char *input_recording_read(input_recording *const input_recording,
+                                 input *const input,
+                                 input_event *const input_events,
+                                 bool *const ended) {
+  FILE *const file = input_recording->file;
+  uint8_t flags;
+
+  if (!get_uint8(file, &flags)) {
+    if (ferror(file)) {
+      return "Failed to read from the input recording.";
+    } else {
+      *ended = true;
+      return NULL;
+    }
+  }
+
+  *ended = false;
+  *input = input_recording->previous;
+  input->events = input_events;
+  input->number_of_events = 0;
+
+  if (flags & CHANGED_POINTER_STATE) {
+    uint8_t pointer_state;
+
+    if (!get_uint8(file, &pointer_state)) {
+      return "The input recording is truncated.";
+    }
+
+    input->pointer_state = pointer_state;
+  }
+
+  if ((flags & CHANGED_POINTER_ROW) && !get_float(file, &input->pointer_row)) {
+    return "The input recording is truncated.";
+  }
+
+  if ((flags & CHANGED_POINTER_COLUMN) &&
+      !get_float(file, &input->pointer_column)) {
+    return "The input recording is truncated.";
+  }
+
+  if (flags & CHANGED_HELD_KEYS) {
+    uint8_t held_keys_mask;
+
+    if (!get_uint8(file, &held_keys_mask)) {
+      return "The input recording is truncated.";
+    }
+
+    for (int index = 0; index < 8; index++) {
+      if (held_keys_mask & (1 << index)) {
+        uint32_t difference;
+
+        if (!get_uint32(file, &difference)) {
+          return "The input recording is truncated.";
+        }
+
+        input->held_keys[index] ^= difference;
+      }
+    }
+  }
+
+  if (flags & HAS_EVENTS) {
+    uint32_t number_of_events;
+
+    if (!get_varint(file, &number_of_events)) {
+      return "The input recording is truncated.";
+    }
+
+    if (number_of_events > INPUT_EVENT_QUEUE_CAPACITY) {
+      return "The input recording is not in a supported format.";
+    }
+
+    uint32_t milliseconds = input_recording->previous_milliseconds;
+
+    for (uint32_t index = 0; index < number_of_events; index++) {
+      input_event *const event = input_events + index;
+      uint8_t type;
+      uint32_t elapsed;
+
+      if (!get_uint8(file, &type) || !get_varint(file, &elapsed)) {
+        return "The input recording is truncated.";
+      }
+
+      milliseconds += elapsed;
+      event->type = type;
+      event->milliseconds = milliseconds;
+
+      if (type == INPUT_EVENT_TYPE_POINTER) {
+        uint8_t pointer_state;
+
+        if (!get_uint8(file, &pointer_state) ||
+            !get_float(file, &event->pointer_row) ||
+            !get_float(file, &event->pointer_column)) {
+          return "The input recording is truncated.";
+        }
+
+        event->pointer_state = pointer_state;
+        event->virtual_key_code = 0;
+      } else {
+        uint8_t virtual_key_code;
+
+        if (!get_uint8(file, &virtual_key_code)) {
+          return "The input recording is truncated.";
+        }
+
+        event->virtual_key_code = virtual_key_code;
+        event->pointer_state = POINTER_STATE_NONE;
+        event->pointer_row = 0.0f;
+        event->pointer_column = 0.0f;
+      }
+    }
+
+    input_recording->previous_milliseconds = milliseconds;
+    input->number_of_events = number_of_events;
+  }
+
+  input_recording->previous = *input;
+  return NULL;
+}
+
+const char *input_recording_close(input_recording *const input_recording) {
+  if (fclose(input_recording->file) == 0) {
+    return NULL;
+  } else {
+    return "Failed to close the input recording.";
+  }
+}
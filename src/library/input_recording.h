@@ -0,0 +1,71 @@
+#ifndef INPUT_RECORDING_H
+
+#define INPUT_RECORDING_H
+
+#include "input.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * A file of the input given to each tick, in order.  Each tick is stored as
+ * the difference from the one before it, so long stretches of unchanging input
+ * take a single byte per tick.
+ */
+typedef struct {
+  FILE *file;
+  input previous;
+  uint32_t previous_milliseconds;
+} input_recording;
+
+/**
+ * Opens an input recording.
+ * @param input_recording Written to on success.
+ * @param path The null-terminated path to the file to open.
+ * @param write When true, the file is created (or truncated) and ticks may be
+ *              written to it.  When false, the file must already exist and
+ *              ticks may be read from it.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *input_recording_open(input_recording *const input_recording,
+                                 const char *const path, const bool write);
+
+/**
+ * Appends the input given to a tick to an input recording opened for writing.
+ * @param input_recording The input recording to append to.
+ * @param input The input given to the tick.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *input_recording_write(input_recording *const input_recording,
+                                  const input *const input);
+
+/**
+ * Reads the input given to the next tick from an input recording opened for
+ * reading.
+ * @param input_recording The input recording to read from.
+ * @param input Written to with the input given to the tick.  Its events refer
+ *              to input_events.
+ * @param input_events Written to with the input events given to the tick.
+ *                     Must have space for at least INPUT_EVENT_QUEUE_CAPACITY
+ *                     input events.
+ * @param ended Written to with true when there are no further ticks to read
+ *              (in which case input is not written to), otherwise false.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *input_recording_read(input_recording *const input_recording,
+                                 input *const input,
+                                 input_event *const input_events,
+                                 bool *const ended);
+
+/**
+ * Closes an input recording.
+ * @param input_recording The input recording to close.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *input_recording_close(input_recording *const input_recording);
+
+#endif
@@ -0,0 +1,355 @@
+#include "mixer.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// Positions within sounds are fixed-point, with 32 fractional bits.
+#define MIXER_ONE ((uint64_t)1 << 32)
+#define MIXER_FRACTION_SCALE (1.0f / 4294967296.0f)
+
+#define MIXER_QUARTER_PI 0.78539816339744830962f
+
+static float fraction(const uint64_t position) {
+  return (float)(uint32_t)position * MIXER_FRACTION_SCALE;
+}
+
+static void pan_gains(const float gain, const float pan,
+                      float *const left_gain, float *const right_gain) {
+  const float angle = (pan + 1.0f) * MIXER_QUARTER_PI;
+  *left_gain = gain * cosf(angle);
+  *right_gain = gain * sinf(angle);
+}
+
+// Returns the index of a voice, or -1 should the reference be stale.
+static int find_voice(const mixer *const mixer, const uint32_t voice) {
+  const uint32_t index = voice & 0xFFFF;
+
+  if (index >= MIXER_CAPACITY) {
+    return -1;
+  }
+
+  const mixer_voice *const mixer_voice = mixer->voices + index;
+
+  return mixer_voice->active && mixer_voice->generation == voice >> 16
+             ? (int)index
+             : -1;
+}
+
+// Mixes a single frame, including the last of a sound, which is interpolated
+// towards the first when looping or otherwise towards silence.
+static void mix_frame(const mixer_voice *const voice, float *const audio,
+                      const float left_gain, const float right_gain) {
+  const uint32_t index = (uint32_t)(voice->position >> 32);
+  const bool last = index + 1 >= voice->frames;
+  const uint32_t next = last ? 0 : index + 1;
+  const float progress = fraction(voice->position);
+
+  if (voice->channels == 1) {
+    const float from = voice->samples[index];
+    const float to = last && !voice->looping ? 0.0f : voice->samples[next];
+    const float sample = from + (to - from) * progress;
+    audio[0] += sample * left_gain;
+    audio[1] += sample * right_gain;
+  } else {
+    const float from_left = voice->samples[index * 2];
+    const float from_right = voice->samples[index * 2 + 1];
+    const float to_left =
+        last && !voice->looping ? 0.0f : voice->samples[next * 2];
+    const float to_right =
+        last && !voice->looping ? 0.0f : voice->samples[next * 2 + 1];
+    audio[0] += (from_left + (to_left - from_left) * progress) * left_gain;
+    audio[1] += (from_right + (to_right - from_right) * progress) * right_gain;
+  }
+}
+
+#ifdef __SSE__
+
+// Each of the following mixes as much of a run as it can in groups, returning
+// how many frames it mixed.
+
+static uint32_t mix_mono(mixer_voice *const voice, float *const audio,
+                         const uint32_t frames, const float left_gain,
+                         const float left_step, const float right_gain,
+                         const float right_step) {
+  const float *const samples = voice->samples + (voice->position >> 32);
+  __m128 left = _mm_set_ps(left_gain + left_step * 3, left_gain + left_step * 2,
+                           left_gain + left_step, left_gain);
+  __m128 right =
+      _mm_set_ps(right_gain + right_step * 3, right_gain + right_step * 2,
+                 right_gain + right_step, right_gain);
+  const __m128 left_increment = _mm_set1_ps(left_step * 4);
+  const __m128 right_increment = _mm_set1_ps(right_step * 4);
+  uint32_t frame = 0;
+
+  for (; frame + 4 <= frames; frame += 4) {
+    const __m128 sample = _mm_loadu_ps(samples + frame);
+    const __m128 left_samples = _mm_mul_ps(sample, left);
+    const __m128 right_samples = _mm_mul_ps(sample, right);
+    float *const output = audio + frame * 2;
+
+    _mm_storeu_ps(output,
+                  _mm_add_ps(_mm_loadu_ps(output),
+                             _mm_unpacklo_ps(left_samples, right_samples)));
+    _mm_storeu_ps(output + 4,
+                  _mm_add_ps(_mm_loadu_ps(output + 4),
+                             _mm_unpackhi_ps(left_samples, right_samples)));
+    left = _mm_add_ps(left, left_increment);
+    right = _mm_add_ps(right, right_increment);
+  }
+
+  voice->position += frame * MIXER_ONE;
+  return frame;
+}
+
+static uint32_t mix_stereo(mixer_voice *const voice, float *const audio,
+                           const uint32_t frames, const float left_gain,
+                           const float left_step, const float right_gain,
+                           const float right_step) {
+  const float *const samples = voice->samples + (voice->position >> 32) * 2;
+  __m128 gains = _mm_set_ps(right_gain + right_step, left_gain + left_step,
+                            right_gain, left_gain);
+  const __m128 increment = _mm_set_ps(right_step * 2, left_step * 2,
+                                      right_step * 2, left_step * 2);
+  uint32_t frame = 0;
+
+  for (; frame + 2 <= frames; frame += 2) {
+    float *const output = audio + frame * 2;
+
+    const __m128 sample = _mm_loadu_ps(samples + frame * 2);
+
+    _mm_storeu_ps(output,
+                  _mm_add_ps(_mm_loadu_ps(output), _mm_mul_ps(sample, gains)));
+    gains = _mm_add_ps(gains, increment);
+  }
+
+  voice->position += frame * MIXER_ONE;
+  return frame;
+}
+
+static uint32_t mix_mono_interpolated(mixer_voice *const voice,
+                                      float *const audio, const uint32_t frames,
+                                      const float left_gain,
+                                      const float left_step,
+                                      const float right_gain,
+                                      const float right_step) {
+  const float *const samples = voice->samples;
+  const uint64_t step = voice->step;
+  uint64_t position = voice->position;
+  __m128 left = _mm_set_ps(left_gain + left_step * 3, left_gain + left_step * 2,
+                           left_gain + left_step, left_gain);
+  __m128 right =
+      _mm_set_ps(right_gain + right_step * 3, right_gain + right_step * 2,
+                 right_gain + right_step, right_gain);
+  const __m128 left_increment = _mm_set1_ps(left_step * 4);
+  const __m128 right_increment = _mm_set1_ps(right_step * 4);
+  uint32_t frame = 0;
+
+  for (; frame + 4 <= frames; frame += 4) {
+    const uint64_t first = position;
+    const uint64_t second = first + step;
+    const uint64_t third = second + step;
+    const uint64_t fourth = third + step;
+    position = fourth + step;
+
+    // Samples are gathered individually, then interpolated together.
+    const __m128 from =
+        _mm_set_ps(samples[fourth >> 32], samples[third >> 32],
+                   samples[second >> 32], samples[first >> 32]);
+    const __m128 to =
+        _mm_set_ps(samples[(fourth >> 32) + 1], samples[(third >> 32) + 1],
+                   samples[(second >> 32) + 1], samples[(first >> 32) + 1]);
+    const __m128 progress =
+        _mm_mul_ps(_mm_set_ps((float)(uint32_t)fourth, (float)(uint32_t)third,
+                              (float)(uint32_t)second, (float)(uint32_t)first),
+                   _mm_set1_ps(MIXER_FRACTION_SCALE));
+    const __m128 sample =
+        _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), progress));
+    const __m128 left_samples = _mm_mul_ps(sample, left);
+    const __m128 right_samples = _mm_mul_ps(sample, right);
+    float *const output = audio + frame * 2;
+
+    _mm_storeu_ps(output,
+                  _mm_add_ps(_mm_loadu_ps(output),
+                             _mm_unpacklo_ps(left_samples, right_samples)));
+    _mm_storeu_ps(output + 4,
+                  _mm_add_ps(_mm_loadu_ps(output + 4),
+                             _mm_unpackhi_ps(left_samples, right_samples)));
+    left = _mm_add_ps(left, left_increment);
+    right = _mm_add_ps(right, right_increment);
+  }
+
+  voice->position = position;
+  return frame;
+}
+
+#endif
+
+// Mixes frames which are all followed by another frame of the sound.
+static void mix_run(mixer_voice *const voice, float *const audio,
+                    const uint32_t frames, const float left_gain,
+                    const float left_step, const float right_gain,
+                    const float right_step) {
+  uint32_t frame = 0;
+
+#ifdef __SSE__
+  // Sounds played at their original pitch need no interpolation.
+  if (voice->step == MIXER_ONE && (uint32_t)voice->position == 0) {
+    frame = voice->channels == 1
+                ? mix_mono(voice, audio, frames, left_gain, left_step,
+                           right_gain, right_step)
+                : mix_stereo(voice, audio, frames, left_gain, left_step,
+                             right_gain, right_step);
+  } else if (voice->channels == 1) {
+    frame = mix_mono_interpolated(voice, audio, frames, left_gain, left_step,
+                                  right_gain, right_step);
+  }
+#endif
+
+  for (; frame < frames; frame++) {
+    mix_frame(voice, audio + frame * 2, left_gain + left_step * frame,
+              right_gain + right_step * frame);
+    voice->position += voice->step;
+  }
+}
+
+static void mix_voice(mixer_voice *const voice, float *const audio,
+                      const uint32_t samples) {
+  const float left_step =
+      (voice->target_left_gain - voice->left_gain) / (float)samples;
+  const float right_step =
+      (voice->target_right_gain - voice->right_gain) / (float)samples;
+  const uint64_t end = (uint64_t)voice->frames << 32;
+  const uint64_t last = (uint64_t)(voice->frames - 1) << 32;
+  uint32_t sample = 0;
+
+  while (sample < samples) {
+    const float left_gain = voice->left_gain + left_step * sample;
+    const float right_gain = voice->right_gain + right_step * sample;
+
+    // The frames until the last of the sound can be mixed without checking
+    // for its end.
+    uint64_t run = voice->position < last ? (last - voice->position +
+                                             voice->step - 1) /
+                                                voice->step
+                                          : 0;
+    run = run < samples - sample ? run : samples - sample;
+
+    if (run > 0) {
+      mix_run(voice, audio + sample * 2, (uint32_t)run, left_gain, left_step,
+              right_gain, right_step);
+      sample += (uint32_t)run;
+    } else {
+      mix_frame(voice, audio + sample * 2, left_gain, right_gain);
+      voice->position += voice->step;
+      sample++;
+    }
+
+    // When the step exceeds a frame, the last frame of a run can step past
+    // the end of the sound as well as the last frame.
+    if (voice->position >= end) {
+      if (voice->looping) {
+        voice->position %= end;
+      } else {
+        voice->active = false;
+        return;
+      }
+    }
+  }
+
+  voice->left_gain = voice->target_left_gain;
+  voice->right_gain = voice->target_right_gain;
+
+  // Having now faded out.
+  if (voice->stopping) {
+    voice->active = false;
+  }
+}
+
+void mixer_initialize(mixer *const mixer) {
+  for (int index = 0; index < MIXER_CAPACITY; index++) {
+    mixer->voices[index].generation = 0;
+    mixer->voices[index].active = false;
+  }
+}
+
+uint32_t mixer_play(mixer *const mixer, const float *const samples,
+                    const uint32_t frames, const uint32_t channels,
+                    const float gain, const float pan, const float pitch,
+                    const bool looping) {
+  for (uint32_t index = 0; index < MIXER_CAPACITY; index++) {
+    mixer_voice *const voice = mixer->voices + index;
+
+    if (!voice->active) {
+      // Generation 0 is skipped so that no reference is ever MIXER_NO_VOICE.
+      voice->generation++;
+
+      if (voice->generation == 0) {
+        voice->generation = 1;
+      }
+
+      voice->samples = samples;
+      voice->frames = frames;
+      voice->channels = channels;
+      voice->position = 0;
+      voice->step = (uint64_t)((double)pitch * MIXER_ONE);
+      pan_gains(gain, pan, &voice->left_gain, &voice->right_gain);
+      voice->target_left_gain = voice->left_gain;
+      voice->target_right_gain = voice->right_gain;
+      voice->looping = looping;
+      voice->stopping = false;
+      voice->active = true;
+      return ((uint32_t)voice->generation << 16) | index;
+    }
+  }
+
+  return MIXER_NO_VOICE;
+}
+
+void mixer_adjust(mixer *const mixer, const uint32_t voice, const float gain,
+                  const float pan, const float pitch) {
+  const int index = find_voice(mixer, voice);
+
+  if (index != -1 && !mixer->voices[index].stopping) {
+    mixer_voice *const mixer_voice = mixer->voices + index;
+    pan_gains(gain, pan, &mixer_voice->target_left_gain,
+              &mixer_voice->target_right_gain);
+    mixer_voice->step = (uint64_t)((double)pitch * MIXER_ONE);
+  }
+}
+
+void mixer_stop(mixer *const mixer, const uint32_t voice) {
+  const int index = find_voice(mixer, voice);
+
+  if (index != -1) {
+    mixer_voice *const mixer_voice = mixer->voices + index;
+    mixer_voice->target_left_gain = 0.0f;
+    mixer_voice->target_right_gain = 0.0f;
+    mixer_voice->stopping = true;
+  }
+}
+
+bool mixer_playing(const mixer *const mixer, const uint32_t voice) {
+  return find_voice(mixer, voice) != -1;
+}
+
+void mixer_mix(mixer *const mixer, float *const audio, const uint32_t samples) {
+  memset(audio, 0, sizeof(float) * 2 * samples);
+
+  if (samples == 0) {
+    return;
+  }
+
+  for (int index = 0; index < MIXER_CAPACITY; index++) {
+    mixer_voice *const voice = mixer->voices + index;
+
+    if (voice->active) {
+      mix_voice(voice, audio, samples);
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef MIXER_H
+
+#define MIXER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The most voices which may play at once through a mixer.
+ */
+#define MIXER_CAPACITY 64
+
+/**
+ * Never refers to a voice; returned by mixer_play when every voice is in use.
+ */
+#define MIXER_NO_VOICE 0
+
+/**
+ * A single sound playing through a mixer.  All fields are owned by the mixer
+ * and should only be accessed through the functions below.
+ */
+typedef struct {
+  const float *samples;
+  uint32_t frames;
+  uint32_t channels;
+  uint64_t position;
+  uint64_t step;
+  float left_gain;
+  float right_gain;
+  float target_left_gain;
+  float target_right_gain;
+  uint16_t generation;
+  bool looping;
+  bool stopping;
+  bool active;
+} mixer_voice;
+
+/**
+ * A fixed pool of voices which are mixed together into interleaved stereo
+ * audio, such as that written by a tick.  Nothing is allocated while playing.
+ * All fields are owned by the mixer and should only be accessed through the
+ * functions below.
+ */
+typedef struct {
+  mixer_voice voices[MIXER_CAPACITY];
+} mixer;
+
+/**
+ * Prepares a mixer with no voices playing.
+ * @param mixer The mixer to prepare.
+ */
+void mixer_initialize(mixer *const mixer);
+
+/**
+ * Starts playing a sound.
+ * @param mixer The mixer to play through.
+ * @param samples The samples of the sound, which are read from in place, so
+ *                must remain valid and unchanged for as long as it plays.
+ *                When stereo, these are interleaved (left then right).
+ *                Behavior is undefined if any are NaN, less than -1 or
+ *                greater than 1.
+ * @param frames The number of samples per channel in the sound.  Behavior is
+ *               undefined if less than 1.
+ * @param channels 1 for mono, or 2 for stereo.  Behavior is undefined
+ *                 otherwise.
+ * @param gain The volume of the sound, where 1 is unchanged.  Behavior is
+ *             undefined if NaN, infinite or negative.
+ * @param pan The position of the sound between the left (-1) and right (1)
+ *            channels, using a constant-power law.  Behavior is undefined if
+ *            NaN, less than -1 or greater than 1.
+ * @param pitch The rate at which to play the sound, where 1 is unchanged and 2
+ *              is an octave higher.  Samples between those of the sound are
+ *              linearly interpolated.  Behavior is undefined if NaN, infinite,
+ *              zero or negative.
+ * @param looping When true, the sound repeats until stopped.  Otherwise, it
+ *                stops by itself once its last sample has played.
+ * @return A reference to the voice playing the sound, which becomes stale once
+ *         the sound stops, or MIXER_NO_VOICE should every voice be in use.
+ */
+uint32_t mixer_play(mixer *const mixer, const float *const samples,
+                    const uint32_t frames, const uint32_t channels,
+                    const float gain, const float pan, const float pitch,
+                    const bool looping);
+
+/**
+ * Changes the gain, pan and pitch of a voice.  Gain and pan are ramped to their
+ * new values over the next mix, to avoid audible steps.  Has no effect on a
+ * stale reference.
+ * @param mixer The mixer which is playing the voice.
+ * @param voice A reference returned by mixer_play.
+ * @param gain As given to mixer_play.
+ * @param pan As given to mixer_play.
+ * @param pitch As given to mixer_play.
+ */
+void mixer_adjust(mixer *const mixer, const uint32_t voice, const float gain,
+                  const float pan, const float pitch);
+
+/**
+ * Stops a voice, fading it out over the next mix.  Has no effect on a stale
+ * reference.
+ * @param mixer The mixer which is playing the voice.
+ * @param voice A reference returned by mixer_play.
+ */
+void mixer_stop(mixer *const mixer, const uint32_t voice);
+
+/**
+ * Determines whether a voice is still playing.
+ * @param mixer The mixer which was given the voice.
+ * @param voice A reference returned by mixer_play.
+ * @return True when the voice is still playing (including while fading out
+ *         after being stopped), otherwise, false.
+ */
+bool mixer_playing(const mixer *const mixer, const uint32_t voice);
+
+/**
+ * Mixes every playing voice together, advancing them.  Uses SSE where
+ * available.
+ * @param mixer The mixer to mix.
+ * @param audio Overwritten with the mixed interleaved stereo audio.
+ * @param samples The number of samples per channel to mix.
+ */
+void mixer_mix(mixer *const mixer, float *const audio, const uint32_t samples);
+
+#endif
@@ -0,0 +1,154 @@
+#include "null_audio_backend.h"
+#include "audio_backend.h"
+#include "pcm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *prepare(void *const state, const uint32_t slot,
+                           float *const samples) {
+  (void)(state);
+  (void)(slot);
+  (void)(samples);
+  return NULL;
+}
+
+static const char *submit(void *const state, const uint32_t slot,
+                          const float *const samples) {
+  null_audio_backend *const backend = (null_audio_backend *)state;
+  (void)(slot);
+
+  if (backend->file != NULL) {
+    const void *written = samples;
+    size_t bytes_per_sample = sizeof(float);
+
+    if (backend->format != AUDIO_FORMAT_FLOAT) {
+      pcm_convert_int16(samples, backend->converted,
+                        backend->samples_per_slot * 2,
+                        backend->format == AUDIO_FORMAT_INT16_DITHERED
+                            ? &backend->pcm_dither
+                            : NULL);
+      written = backend->converted;
+      bytes_per_sample = sizeof(int16_t);
+    }
+
+    if (fwrite(written, bytes_per_sample * 2, backend->samples_per_slot,
+               backend->file) != backend->samples_per_slot) {
+      return "Failed to write audio to the file.";
+    }
+  }
+
+  backend->submitted_samples += backend->samples_per_slot;
+  return NULL;
+}
+
+static const char *get_completed(void *const state,
+                                 uint32_t *const completed) {
+  const null_audio_backend *const backend = (const null_audio_backend *)state;
+  *completed = (uint32_t)(backend->played_samples / backend->samples_per_slot);
+  return NULL;
+}
+
+static uint32_t get_capacity(void *const state) {
+  return ((const null_audio_backend *)state)->capacity;
+}
+
+static const char *get_position(void *const state, uint32_t *const position) {
+  *position = (uint32_t)((const null_audio_backend *)state)->played_samples;
+  return NULL;
+}
+
+static const char *pause_backend(void *const state) {
+  ((null_audio_backend *)state)->playing = false;
+  return NULL;
+}
+
+static const char *resume_backend(void *const state) {
+  ((null_audio_backend *)state)->playing = true;
+  return NULL;
+}
+
+static const char *reset_backend(void *const state) {
+  null_audio_backend *const backend = (null_audio_backend *)state;
+  backend->playing = false;
+  backend->played_samples = backend->submitted_samples;
+  return NULL;
+}
+
+static const char *close_backend(void *const state) {
+  null_audio_backend *const backend = (null_audio_backend *)state;
+
+  free(backend->converted);
+
+  if (backend->file != NULL && fclose(backend->file) != 0) {
+    return "Failed to close the file to which audio was written.";
+  }
+
+  return NULL;
+}
+
+const char *
+null_audio_backend_open(null_audio_backend *const null_audio_backend,
+                        const char *const path, const uint32_t samples_per_slot,
+                        const uint32_t capacity, const int format) {
+  null_audio_backend->file = NULL;
+  null_audio_backend->converted = NULL;
+  null_audio_backend->format = format;
+  pcm_dither_initialize(&null_audio_backend->pcm_dither, 0);
+  null_audio_backend->samples_per_slot = samples_per_slot;
+  null_audio_backend->capacity = capacity;
+  null_audio_backend->submitted_samples = 0;
+  null_audio_backend->played_samples = 0;
+  null_audio_backend->playing = false;
+
+  if (path != NULL) {
+    if (format != AUDIO_FORMAT_FLOAT) {
+      null_audio_backend->converted =
+          malloc(sizeof(int16_t) * 2 * samples_per_slot);
+
+      if (null_audio_backend->converted == NULL) {
+        return "Failed to allocate memory for converted audio.";
+      }
+    }
+
+    null_audio_backend->file = fopen(path, "wb");
+
+    if (null_audio_backend->file == NULL) {
+      free(null_audio_backend->converted);
+      return "Failed to open the file to which to write audio.";
+    }
+  }
+
+  return NULL;
+}
+
+audio_backend
+null_audio_backend_interface(null_audio_backend *const null_audio_backend) {
+  const audio_backend output = {
+      .state = null_audio_backend,
+      .prepare = prepare,
+      .submit = submit,
+      .get_completed = get_completed,
+      .get_capacity = get_capacity,
+      .get_position = get_position,
+      .pause = pause_backend,
+      .resume = resume_backend,
+      .reset = reset_backend,
+      .close = close_backend,
+  };
+
+  return output;
+}
+
+void null_audio_backend_advance(null_audio_backend *const null_audio_backend,
+                                const uint32_t samples) {
+  if (null_audio_backend->playing) {
+    const uint64_t remaining = null_audio_backend->submitted_samples -
+                               null_audio_backend->played_samples;
+
+    null_audio_backend->played_samples +=
+        samples < remaining ? samples : remaining;
+  }
+}
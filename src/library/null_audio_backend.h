@@ -0,0 +1,70 @@
+#ifndef NULL_AUDIO_BACKEND_H
+
+#define NULL_AUDIO_BACKEND_H
+
+#include "audio_backend.h"
+#include "pcm.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * An audio backend without an audio device, which only "plays" audio when told
+ * to, so that the scheduling of audio can be exercised anywhere, far faster
+ * than real time and with reproducible results.  Submitted audio is discarded,
+ * or optionally appended to a file as raw interleaved samples in the chosen
+ * format.  All fields are owned by the backend and should only be accessed
+ * through the functions below.
+ */
+typedef struct {
+  FILE *file;
+  int16_t *converted;
+  int format;
+  pcm_dither pcm_dither;
+  uint32_t samples_per_slot;
+  uint32_t capacity;
+  uint64_t submitted_samples;
+  uint64_t played_samples;
+  bool playing;
+} null_audio_backend;
+
+/**
+ * Opens a null audio backend.
+ * @param null_audio_backend The backend to open.
+ * @param path The null-terminated path to a file to which to write submitted
+ *             audio, which is created or truncated, or null to discard it.
+ * @param samples_per_slot The number of samples per channel in each slot.
+ *                         Behavior is undefined if less than 1.
+ * @param capacity The most slots which may be queued at once.  Behavior is
+ *                 undefined if less than 1.
+ * @param format The format in which to write audio to the file.  Behavior is
+ *               undefined if not an AUDIO_FORMAT_* constant.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *
+null_audio_backend_open(null_audio_backend *const null_audio_backend,
+                        const char *const path, const uint32_t samples_per_slot,
+                        const uint32_t capacity, const int format);
+
+/**
+ * Wraps a null audio backend so that it may be used as an audio backend.
+ * @param null_audio_backend The null audio backend to wrap.  Must remain valid
+ *                           for as long as the returned audio backend is in
+ *                           use.
+ * @return An audio backend which plays to the given null audio backend.
+ */
+audio_backend
+null_audio_backend_interface(null_audio_backend *const null_audio_backend);
+
+/**
+ * Plays audio from a null audio backend, as an audio device would over time.
+ * Has no effect while paused, and stops early should every submitted sample
+ * have been played.
+ * @param null_audio_backend The backend to advance.
+ * @param samples The number of samples per channel to play.
+ */
+void null_audio_backend_advance(null_audio_backend *const null_audio_backend,
+                                const uint32_t samples);
+
+#endif
@@ -0,0 +1,132 @@
+#include "pcm.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Samples are scaled symmetrically, so that a full-scale sine does not clip on
+// its positive peak.  Values are clamped in floating point before conversion
+// to integer, which would otherwise overflow for large or infinite inputs.
+#define PCM_INT16_SCALE 32767.0f
+#define PCM_INT16_MINIMUM -32768.0f
+#define PCM_INT16_MAXIMUM 32767.0f
+
+// The top 24 bits of each generator's state form a uniform value in [0, 1);
+// the difference between two such values has a triangular distribution within
+// (-1, 1).
+#define PCM_DITHER_SCALE (1.0f / 16777216.0f)
+
+static uint32_t step_lane(const uint32_t state) {
+  uint32_t output = state;
+  output ^= output << 13;
+  output ^= output >> 17;
+  output ^= output << 5;
+  return output;
+}
+
+void pcm_dither_initialize(pcm_dither *const pcm_dither, const uint32_t seed) {
+  for (int lane = 0; lane < 4; lane++) {
+    // Each lane is scrambled from the seed so that they are not correlated;
+    // xorshift generators must never be zero.
+    uint32_t state = seed + 0x9E3779B9u * (uint32_t)(lane + 1);
+    state ^= state >> 16;
+    state *= 0x85EBCA6Bu;
+    state ^= state >> 13;
+    state *= 0xC2B2AE35u;
+    state ^= state >> 16;
+    pcm_dither->lanes[lane] = state == 0 ? 1 : state;
+  }
+}
+
+// Converts up to four samples.  Every lane of the dither is stepped regardless,
+// matching the SIMD path below.
+static void convert_group(const float *const input, int16_t *const output,
+                          const uint32_t samples,
+                          pcm_dither *const pcm_dither) {
+  float dither[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+  if (pcm_dither != NULL) {
+    for (int lane = 0; lane < 4; lane++) {
+      const uint32_t first = step_lane(pcm_dither->lanes[lane]);
+      const uint32_t second = step_lane(first);
+      pcm_dither->lanes[lane] = second;
+      dither[lane] = (float)(int32_t)(first >> 8) * PCM_DITHER_SCALE -
+                     (float)(int32_t)(second >> 8) * PCM_DITHER_SCALE;
+    }
+  }
+
+  for (uint32_t sample = 0; sample < samples; sample++) {
+    float value = input[sample] * PCM_INT16_SCALE + dither[sample];
+    value = value < PCM_INT16_MINIMUM ? PCM_INT16_MINIMUM : value;
+    value = value > PCM_INT16_MAXIMUM ? PCM_INT16_MAXIMUM : value;
+    output[sample] = (int16_t)lrintf(value);
+  }
+}
+
+#ifdef __SSE2__
+
+static __m128i step_lanes(const __m128i state) {
+  __m128i output = state;
+  output = _mm_xor_si128(output, _mm_slli_epi32(output, 13));
+  output = _mm_xor_si128(output, _mm_srli_epi32(output, 17));
+  output = _mm_xor_si128(output, _mm_slli_epi32(output, 5));
+  return output;
+}
+
+static __m128 uniform(const __m128i state) {
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(state, 8)),
+                    _mm_set1_ps(PCM_DITHER_SCALE));
+}
+
+static __m128i convert_four(const float *const input, const __m128 dither) {
+  __m128 value = _mm_add_ps(
+      _mm_mul_ps(_mm_loadu_ps(input), _mm_set1_ps(PCM_INT16_SCALE)), dither);
+  value = _mm_max_ps(value, _mm_set1_ps(PCM_INT16_MINIMUM));
+  value = _mm_min_ps(value, _mm_set1_ps(PCM_INT16_MAXIMUM));
+  return _mm_cvtps_epi32(value);
+}
+
+#endif
+
+void pcm_convert_int16(const float *const input, int16_t *const output,
+                       const uint32_t samples, pcm_dither *const pcm_dither) {
+  uint32_t sample = 0;
+
+#ifdef __SSE2__
+  __m128i lanes = pcm_dither == NULL
+                      ? _mm_setzero_si128()
+                      : _mm_loadu_si128((const __m128i *)pcm_dither->lanes);
+
+  for (; sample + 8 <= samples; sample += 8) {
+    __m128 first_dither = _mm_setzero_ps();
+    __m128 second_dither = _mm_setzero_ps();
+
+    if (pcm_dither != NULL) {
+      const __m128i first = step_lanes(lanes);
+      const __m128i second = step_lanes(first);
+      const __m128i third = step_lanes(second);
+      lanes = step_lanes(third);
+      first_dither = _mm_sub_ps(uniform(first), uniform(second));
+      second_dither = _mm_sub_ps(uniform(third), uniform(lanes));
+    }
+
+    // Packing saturates, though the values are already within range.
+    _mm_storeu_si128(
+        (__m128i *)(output + sample),
+        _mm_packs_epi32(convert_four(input + sample, first_dither),
+                        convert_four(input + sample + 4, second_dither)));
+  }
+
+  if (pcm_dither != NULL) {
+    _mm_storeu_si128((__m128i *)pcm_dither->lanes, lanes);
+  }
+#endif
+
+  for (; sample < samples; sample += 4) {
+    convert_group(input + sample, output + sample,
+                  samples - sample < 4 ? samples - sample : 4, pcm_dither);
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef PCM_H
+
+#define PCM_H
+
+#include <stdint.h>
+
+/**
+ * The state of a source of triangular probability density function (TPDF)
+ * dither.  Four independent xorshift generators are stepped together so that
+ * four samples can be dithered at once.  All fields are owned by the dither
+ * and should only be accessed through the functions below.
+ */
+typedef struct {
+  uint32_t lanes[4];
+} pcm_dither;
+
+/**
+ * Prepares a source of dither.
+ * @param pcm_dither The source of dither to prepare.
+ * @param seed Determines the sequence of dither produced.  Any value is valid.
+ */
+void pcm_dither_initialize(pcm_dither *const pcm_dither, const uint32_t seed);
+
+/**
+ * Converts floating-point (signed unit interval) samples to signed 16-bit
+ * integers, saturating those outside of the signed unit interval and rounding
+ * to the nearest integer.  Uses SSE2 where available.
+ * @param input The samples to convert.
+ * @param output Written to with the converted samples.  May not overlap with
+ *               input.
+ * @param samples The number of samples to convert.
+ * @param pcm_dither When non-null, TPDF dither of up to one least significant
+ *                   bit either way is added to each sample before rounding,
+ *                   and the source of dither is advanced.  The same dither is
+ *                   added whether or not SSE2 is used.
+ */
+void pcm_convert_int16(const float *const input, int16_t *const output,
+                       const uint32_t samples, pcm_dither *const pcm_dither);
+
+#endif
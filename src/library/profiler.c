@@ -0,0 +1,131 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "profiler.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static const char *const phase_names[PROFILER_PHASES] = {
+    "tick",     "audio refill", "audio submit",  "video",   "conversion",
+    "scaling",  "present",      "vertical sync", "dispatch",
+};
+
+#ifdef _WIN32
+
+int64_t profiler_now(void) {
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return counter.QuadPart;
+}
+
+int64_t profiler_frequency(void) {
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  return frequency.QuadPart;
+}
+
+#else
+
+int64_t profiler_now(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_MONOTONIC, &timespec);
+  return (int64_t)timespec.tv_sec * 1000000000 + timespec.tv_nsec;
+}
+
+int64_t profiler_frequency(void) { return 1000000000; }
+
+#endif
+
+void profiler_record(profiler_ring *const profiler_ring, const int phase,
+                     const int64_t start, const int64_t end) {
+  if (profiler_ring == NULL) {
+    return;
+  }
+
+  // Only this thread writes to written, so it can be read plainly.
+  const uint32_t written = profiler_ring->written;
+
+  if (written - __atomic_load_n(&profiler_ring->read, __ATOMIC_ACQUIRE) >=
+      PROFILER_RING_CAPACITY) {
+    __atomic_add_fetch(&profiler_ring->dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  profiler_span *const span =
+      &profiler_ring->spans[written % PROFILER_RING_CAPACITY];
+  span->phase = phase;
+  span->start = start;
+  span->end = end;
+  __atomic_store_n(&profiler_ring->written, written + 1, __ATOMIC_RELEASE);
+}
+
+// Converts a time from profiler_now to the microseconds of a trace.
+static double microseconds(const int64_t time, const int64_t frequency) {
+  return (double)(time / frequency) * 1000000.0 +
+         (double)(time % frequency) * 1000000.0 / (double)frequency;
+}
+
+const char *profiler_write_trace(const char *const path,
+                                 profiler_ring *const *const profiler_rings,
+                                 const int number_of_profiler_rings) {
+  FILE *const file = fopen(path, "wb");
+
+  if (file == NULL) {
+    return "Failed to open the trace file for writing.";
+  }
+
+  const int64_t frequency = profiler_frequency();
+  const char *separator = "";
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+  for (int index = 0; index < number_of_profiler_rings; index++) {
+    profiler_ring *const profiler_ring = profiler_rings[index];
+
+    fprintf(file,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\",\"dropped_spans\":%llu}}",
+            separator, profiler_ring->thread, profiler_ring->name,
+            (unsigned long long)__atomic_load_n(&profiler_ring->dropped,
+                                                __ATOMIC_RELAXED));
+    separator = ",";
+
+    const uint32_t written =
+        __atomic_load_n(&profiler_ring->written, __ATOMIC_ACQUIRE);
+    uint32_t read = profiler_ring->read;
+
+    while (read != written) {
+      const profiler_span *const span =
+          &profiler_ring->spans[read % PROFILER_RING_CAPACITY];
+      const double start = microseconds(span->start, frequency);
+
+      fprintf(file,
+              ",\n{\"name\":\"%s\",\"cat\":\"event_loop\",\"ph\":\"X\","
+              "\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+              phase_names[span->phase], profiler_ring->thread, start,
+              microseconds(span->end, frequency) - start);
+      read++;
+    }
+
+    __atomic_store_n(&profiler_ring->read, read, __ATOMIC_RELEASE);
+  }
+
+  fprintf(file, "\n]}\n");
+
+  const bool failed = ferror(file) != 0;
+
+  if (fclose(file) != 0 || failed) {
+    return "Failed to write the trace file.";
+  }
+
+  return NULL;
+}
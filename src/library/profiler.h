@@ -0,0 +1,173 @@
+#ifndef PROFILER_H
+
+#define PROFILER_H
+
+#include <stdint.h>
+
+/**
+ * The number of spans each profiler ring can hold before the oldest must be
+ * written out to make space.  A power of two.
+ */
+#define PROFILER_RING_CAPACITY 65536
+
+/**
+ * A tick event.
+ */
+#define PROFILER_PHASE_TICK 0
+
+/**
+ * Replacing the audio buffers which have finished playing, including the tick
+ * events which produce them.
+ */
+#define PROFILER_PHASE_AUDIO_REFILL 1
+
+/**
+ * Passing buffers of audio on to the audio device, on the audio thread.
+ */
+#define PROFILER_PHASE_AUDIO_SUBMIT 2
+
+/**
+ * A video event.
+ */
+#define PROFILER_PHASE_VIDEO 3
+
+/**
+ * Converting the viewport to pixels for an opaque window.
+ */
+#define PROFILER_PHASE_CONVERSION 4
+
+/**
+ * Converting and scaling the viewport to pixels for a layered window.
+ */
+#define PROFILER_PHASE_SCALING 5
+
+/**
+ * Handing pixels to GDI to be presented.
+ */
+#define PROFILER_PHASE_PRESENT 6
+
+/**
+ * Waiting for vertical sync, on the vertical sync thread.
+ */
+#define PROFILER_PHASE_VERTICAL_SYNC 7
+
+/**
+ * Dispatching a window message, including anything done in response to it.
+ */
+#define PROFILER_PHASE_DISPATCH 8
+
+/**
+ * The number of phases.
+ */
+#define PROFILER_PHASES 9
+
+/**
+ * A phase which has completed.
+ */
+typedef struct {
+  /**
+   * The PROFILER_PHASE_* which completed.
+   */
+  int phase;
+
+  /**
+   * The profiler_now at which the phase started.
+   */
+  int64_t start;
+
+  /**
+   * The profiler_now at which the phase ended.
+   */
+  int64_t end;
+} profiler_span;
+
+/**
+ * A lock-free ring of spans recorded by a single thread and written out by any
+ * other (one at a time).  Zero-initialize all but name and thread, then use
+ * only through the functions below.
+ */
+typedef struct {
+  /**
+   * The null-terminated name of the thread which records to the ring.
+   */
+  const char *name;
+
+  /**
+   * Identifies the thread which records to the ring within traces.
+   */
+  int thread;
+
+  /**
+   * The number of spans which have been recorded.  Wraps.
+   */
+  uint32_t written;
+
+  /**
+   * The number of spans which have been written out.  Wraps.
+   */
+  uint32_t read;
+
+  /**
+   * The number of spans discarded because the ring was full.
+   */
+  uint64_t dropped;
+
+  /**
+   * The spans recorded but not yet written out.
+   */
+  profiler_span spans[PROFILER_RING_CAPACITY];
+} profiler_ring;
+
+/**
+ * Reads a high-resolution monotonic clock: QueryPerformanceCounter on Win32,
+ * otherwise CLOCK_MONOTONIC.
+ * @return The current time, in units of 1 / profiler_frequency seconds.
+ */
+int64_t profiler_now(void);
+
+/**
+ * Determines the resolution of profiler_now.
+ * @return The number of units of profiler_now per second.
+ */
+int64_t profiler_frequency(void);
+
+/**
+ * Records a span to a profiler ring, discarding it should the ring be full.
+ * Must only be called from the thread which the ring belongs to.
+ * @param profiler_ring The ring to record to.  Nothing is recorded when null.
+ * @param phase The PROFILER_PHASE_* which completed.
+ * @param start The profiler_now at which the phase started.
+ * @param end The profiler_now at which the phase ended.
+ */
+void profiler_record(profiler_ring *const profiler_ring, const int phase,
+                     const int64_t start, const int64_t end);
+
+/**
+ * Writes every span recorded to a set of profiler rings since they were last
+ * written out to a file in Chrome's trace event format, to be opened by
+ * about:tracing or Perfetto, emptying the rings.  May be called while the
+ * rings are being recorded to.
+ * @param path The null-terminated path to the file to (re)write.
+ * @param profiler_rings The rings to write out.
+ * @param number_of_profiler_rings The number of rings.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *profiler_write_trace(const char *const path,
+                                 profiler_ring *const *const profiler_rings,
+                                 const int number_of_profiler_rings);
+
+// Timing is compiled in only when PROFILER is defined, so that it costs
+// nothing otherwise.  PROFILER_BEGIN names a span; PROFILER_END records it.
+#ifdef PROFILER
+#define PROFILER_BEGIN(name)                                                   \
+  const int64_t profiler_start_##name = profiler_now()
+#define PROFILER_END(profiler_ring, phase, name)                               \
+  profiler_record((profiler_ring), (phase), profiler_start_##name,             \
+                  profiler_now())
+#else
+#define PROFILER_BEGIN(name)
+#define PROFILER_END(profiler_ring, phase, name)
+#endif
+
+#endif
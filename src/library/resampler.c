@@ -0,0 +1,275 @@
+#include "resampler.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// Input is copied into the history in chunks of this many samples per channel,
+// bounding the memory the history needs regardless of the size of each block.
+#define RESAMPLER_CHUNK_SAMPLES 256
+
+// The most taps used by any quality.
+#define RESAMPLER_MAXIMUM_TAPS 64
+
+#define RESAMPLER_PI 3.14159265358979323846
+
+typedef struct {
+  const uint32_t taps;
+  const double passband;
+} resampler_quality;
+
+static const resampler_quality resampler_qualities[] = {
+    {16, 0.80},
+    {32, 0.88},
+    {64, 0.93},
+};
+
+static uint32_t greatest_common_divisor(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    const uint32_t remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+
+  return a;
+}
+
+// The zeroth-order modified Bessel function of the first kind, from its power
+// series.
+static double bessel_i0(const double x) {
+  double sum = 1.0;
+  double term = 1.0;
+
+  for (int k = 1; k < 64; k++) {
+    const double factor = x / (2.0 * k);
+    term *= factor * factor;
+    sum += term;
+
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+
+  return sum;
+}
+
+static double sinc(const double x) {
+  return x == 0.0 ? 1.0 : sin(RESAMPLER_PI * x) / (RESAMPLER_PI * x);
+}
+
+// Dot product of a phase's coefficients with the samples beneath it.  Each
+// coefficient is stored twice, once per channel, so that the interleaved
+// samples can be multiplied without first being separated.
+static void filter(const float *const coefficients, const float *const samples,
+                   const uint32_t taps, float *const output) {
+#if defined(__AVX__)
+  __m256 sum = _mm256_setzero_ps();
+
+  for (uint32_t index = 0; index < taps * 2; index += 8) {
+    sum = _mm256_add_ps(sum,
+                        _mm256_mul_ps(_mm256_loadu_ps(coefficients + index),
+                                      _mm256_loadu_ps(samples + index)));
+  }
+
+  __m128 half =
+      _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  _mm_storel_pi((__m64 *)output, half);
+#elif defined(__SSE__)
+  __m128 first = _mm_setzero_ps();
+  __m128 second = _mm_setzero_ps();
+
+  for (uint32_t index = 0; index < taps * 2; index += 8) {
+    first = _mm_add_ps(first, _mm_mul_ps(_mm_loadu_ps(coefficients + index),
+                                         _mm_loadu_ps(samples + index)));
+    second =
+        _mm_add_ps(second, _mm_mul_ps(_mm_loadu_ps(coefficients + index + 4),
+                                      _mm_loadu_ps(samples + index + 4)));
+  }
+
+  __m128 half = _mm_add_ps(first, second);
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  _mm_storel_pi((__m64 *)output, half);
+#else
+  float left = 0.0f;
+  float right = 0.0f;
+
+  for (uint32_t index = 0; index < taps * 2; index += 2) {
+    left += coefficients[index] * samples[index];
+    right += coefficients[index + 1] * samples[index + 1];
+  }
+
+  output[0] = left;
+  output[1] = right;
+#endif
+}
+
+const char *resampler_open(resampler *const resampler,
+                           const uint32_t input_samples_per_second,
+                           const uint32_t output_samples_per_second,
+                           const int quality) {
+  const uint32_t divisor = greatest_common_divisor(input_samples_per_second,
+                                                   output_samples_per_second);
+  const uint32_t phases = output_samples_per_second / divisor;
+  const uint32_t step = input_samples_per_second / divisor;
+
+  if (phases > RESAMPLER_MAXIMUM_PHASES) {
+    return "The ratio between the sample rates is not supported.";
+  }
+
+  const uint32_t taps = resampler_qualities[quality].taps;
+  const double passband = resampler_qualities[quality].passband;
+
+  resampler->phases = phases;
+  resampler->advance = step / phases;
+  resampler->step = step % phases;
+  resampler->taps = taps;
+
+  resampler->coefficients = malloc(sizeof(float) * 2 * taps * phases);
+
+  if (resampler->coefficients == NULL) {
+    return "Failed to allocate memory for resampling coefficients.";
+  }
+
+  resampler->history =
+      malloc(sizeof(float) * 2 * (taps - 1 + RESAMPLER_CHUNK_SAMPLES));
+
+  if (resampler->history == NULL) {
+    free(resampler->coefficients);
+    return "Failed to allocate memory for resampling history.";
+  }
+
+  // Frequencies are relative to the input's Nyquist frequency.  The stopband
+  // starts as far above the lower Nyquist frequency as the passband ends below
+  // it, so anything which aliases lands above the passband.
+  const double scale = phases < step ? (double)phases / (double)step : 1.0;
+  const double cutoff = scale;
+  const double transition = 2.0 * (1.0 - passband) * scale;
+
+  // Kaiser's empirical formulae for the attenuation achievable with this many
+  // taps over this transition, and the window which achieves it.
+  const double attenuation =
+      2.285 * (taps - 1) * RESAMPLER_PI * transition + 8.0;
+  const double beta = attenuation > 50.0
+                          ? 0.1102 * (attenuation - 8.7)
+                          : 0.5842 * pow(attenuation - 21.0, 0.4) +
+                                0.07886 * (attenuation - 21.0);
+  const double half_width = taps / 2.0;
+  const double window_scale = 1.0 / bessel_i0(beta);
+
+  for (uint32_t phase = 0; phase < phases; phase++) {
+    float *const coefficients = resampler->coefficients + 2 * taps * phase;
+    double sum = 0.0;
+    double values[RESAMPLER_MAXIMUM_TAPS];
+
+    for (uint32_t tap = 0; tap < taps; tap++) {
+      // The distance from this tap to the point in time being produced.
+      const double x =
+          (double)tap + 1.0 - half_width - (double)phase / (double)phases;
+      const double ratio = x / half_width;
+      const double window =
+          ratio <= -1.0 || ratio >= 1.0
+              ? 0.0
+              : bessel_i0(beta * sqrt(1.0 - ratio * ratio)) * window_scale;
+      values[tap] = cutoff * sinc(cutoff * x) * window;
+      sum += values[tap];
+    }
+
+    // Each phase is normalized so that silence and DC pass through unchanged.
+    for (uint32_t tap = 0; tap < taps; tap++) {
+      coefficients[tap * 2] = (float)(values[tap] / sum);
+      coefficients[tap * 2 + 1] = coefficients[tap * 2];
+    }
+  }
+
+  resampler_reset(resampler);
+  return NULL;
+}
+
+uint32_t resampler_maximum_output(const resampler *const resampler,
+                                  const uint32_t input_samples) {
+  const uint64_t step =
+      (uint64_t)resampler->advance * resampler->phases + resampler->step;
+
+  return (uint32_t)(((uint64_t)input_samples * resampler->phases) / step + 1);
+}
+
+uint32_t resampler_process(resampler *const resampler, const float *const input,
+                           const uint32_t input_samples, float *const output) {
+  const uint32_t taps = resampler->taps;
+  const uint32_t phases = resampler->phases;
+  const uint32_t advance = resampler->advance;
+  const uint32_t step = resampler->step;
+  const float *const coefficients = resampler->coefficients;
+  float *const history = resampler->history;
+  uint32_t history_samples = resampler->history_samples;
+  uint32_t position = resampler->position;
+  uint32_t phase = resampler->phase;
+  uint32_t consumed = 0;
+  uint32_t produced = 0;
+
+  while (consumed < input_samples) {
+    const uint32_t remaining = input_samples - consumed;
+    const uint32_t chunk = remaining < RESAMPLER_CHUNK_SAMPLES
+                               ? remaining
+                               : RESAMPLER_CHUNK_SAMPLES;
+
+    memcpy(history + 2 * history_samples, input + 2 * consumed,
+           sizeof(float) * 2 * chunk);
+    history_samples += chunk;
+    consumed += chunk;
+
+    // The position is that of the newest sample beneath the filter.
+    while (position < history_samples) {
+      filter(coefficients + 2 * taps * phase,
+             history + 2 * (position - (taps - 1)), taps,
+             output + 2 * produced);
+      produced++;
+
+      position += advance;
+      phase += step;
+
+      if (phase >= phases) {
+        phase -= phases;
+        position++;
+      }
+    }
+
+    // Only the samples which the filter will pass over again are kept.  When
+    // downsampling, the filter may already be past the end of the history.
+    const uint32_t passed = position - (taps - 1);
+    const uint32_t discarded =
+        passed < history_samples ? passed : history_samples;
+
+    memmove(history, history + 2 * discarded,
+            sizeof(float) * 2 * (history_samples - discarded));
+    history_samples -= discarded;
+    position -= discarded;
+  }
+
+  resampler->history_samples = history_samples;
+  resampler->position = position;
+  resampler->phase = phase;
+  return produced;
+}
+
+void resampler_reset(resampler *const resampler) {
+  const uint32_t history_samples = resampler->taps - 1;
+
+  memset(resampler->history, 0, sizeof(float) * 2 * history_samples);
+  resampler->history_samples = history_samples;
+  resampler->position = history_samples;
+  resampler->phase = 0;
+}
+
+void resampler_close(resampler *const resampler) {
+  free(resampler->coefficients);
+  free(resampler->history);
+}
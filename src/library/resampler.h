@@ -0,0 +1,110 @@
+#ifndef RESAMPLER_H
+
+#define RESAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * The lowest quality of resampling: 16 taps per channel per output sample,
+ * with the passband ending at 80% of the lower Nyquist frequency.
+ */
+#define RESAMPLER_QUALITY_LOW 0
+
+/**
+ * A compromise between quality and performance: 32 taps per channel per output
+ * sample, with the passband ending at 88% of the lower Nyquist frequency.
+ */
+#define RESAMPLER_QUALITY_MEDIUM 1
+
+/**
+ * The highest quality of resampling: 64 taps per channel per output sample,
+ * with the passband ending at 93% of the lower Nyquist frequency.
+ */
+#define RESAMPLER_QUALITY_HIGH 2
+
+/**
+ * The most filter phases a resampler may need, which limits the ratios between
+ * sample rates which can be converted.  Ratios between common sample rates need
+ * far fewer (e.g. 160 for 44100Hz to 48000Hz).
+ */
+#define RESAMPLER_MAXIMUM_PHASES 4096
+
+/**
+ * Converts interleaved stereo audio between two sample rates using a polyphase
+ * Kaiser-windowed sinc filter.  Audio is converted as a continuous stream, so
+ * it may be given in blocks of any size.  All fields are owned by the resampler
+ * and should only be accessed through the functions below.
+ */
+typedef struct {
+  uint32_t phases;
+  uint32_t advance;
+  uint32_t step;
+  uint32_t taps;
+  float *coefficients;
+  float *history;
+  uint32_t history_samples;
+  uint32_t position;
+  uint32_t phase;
+} resampler;
+
+/**
+ * Opens a resampler.
+ * @param resampler The resampler to open.
+ * @param input_samples_per_second The sample rate of the audio given to the
+ *                                 resampler.  Behavior is undefined if less
+ *                                 than 1.
+ * @param output_samples_per_second The sample rate of the audio produced by the
+ *                                  resampler.  Behavior is undefined if less
+ *                                  than 1.
+ * @param quality The trade-off between quality and performance.  Behavior is
+ *                undefined if not a RESAMPLER_QUALITY_* constant.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *resampler_open(resampler *const resampler,
+                           const uint32_t input_samples_per_second,
+                           const uint32_t output_samples_per_second,
+                           const int quality);
+
+/**
+ * Determines the most samples per channel a resampler could produce from a
+ * block of input.
+ * @param resampler The resampler to query.
+ * @param input_samples The number of samples per channel in the block.
+ * @return The most samples per channel which could be produced.
+ */
+uint32_t resampler_maximum_output(const resampler *const resampler,
+                                  const uint32_t input_samples);
+
+/**
+ * Converts a block of audio, continuing on from the previous block.  Output is
+ * delayed by half as many samples as the filter has taps, at the input's
+ * sample rate.  Uses SSE, or AVX, where available.
+ * @param resampler The resampler to use.
+ * @param input The interleaved stereo samples to convert.
+ * @param input_samples The number of samples per channel in input.
+ * @param output Written to with interleaved stereo samples.  Must have space
+ *               for at least as many samples per channel as
+ *               resampler_maximum_output reports for input_samples.  May not
+ *               overlap with input.
+ * @return The number of samples per channel written to output.  Given blocks
+ *         which each convert to a whole number of output samples, exactly that
+ *         number.
+ */
+uint32_t resampler_process(resampler *const resampler, const float *const input,
+                           const uint32_t input_samples, float *const output);
+
+/**
+ * Forgets all previously given audio, as though the resampler had just been
+ * opened.
+ * @param resampler The resampler to reset.
+ */
+void resampler_reset(resampler *const resampler);
+
+/**
+ * Closes a resampler, releasing everything it holds.
+ * @param resampler The resampler to close.
+ */
+void resampler_close(resampler *const resampler);
+
+#endif
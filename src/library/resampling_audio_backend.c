@@ -0,0 +1,174 @@
+#include "resampling_audio_backend.h"
+#include "audio_backend.h"
+#include "resampler.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static float *output_slot(const resampling_audio_backend *const backend,
+                          const uint32_t slot) {
+  return backend->slots + 2 * backend->output_samples_per_slot * slot;
+}
+
+static const char *prepare(void *const state, const uint32_t slot,
+                           float *const samples) {
+  const resampling_audio_backend *const backend =
+      (const resampling_audio_backend *)state;
+  (void)(samples);
+
+  return backend->output->prepare(backend->output->state, slot,
+                                  output_slot(backend, slot));
+}
+
+static const char *submit(void *const state, const uint32_t slot,
+                          const float *const samples) {
+  resampling_audio_backend *const backend = (resampling_audio_backend *)state;
+  float *const resampled = output_slot(backend, slot);
+
+  // Every slot converts to a whole number of output samples, so nothing is
+  // carried over between slots other than the resampler's history.
+  resampler_process(&backend->resampler, samples,
+                    backend->input_samples_per_slot, resampled);
+
+  return backend->output->submit(backend->output->state, slot, resampled);
+}
+
+static const char *get_completed(void *const state,
+                                 uint32_t *const completed) {
+  const audio_backend *const output =
+      ((const resampling_audio_backend *)state)->output;
+
+  return output->get_completed(output->state, completed);
+}
+
+static uint32_t get_capacity(void *const state) {
+  const audio_backend *const output =
+      ((const resampling_audio_backend *)state)->output;
+
+  return output->get_capacity(output->state);
+}
+
+static const char *get_position(void *const state, uint32_t *const position) {
+  resampling_audio_backend *const backend = (resampling_audio_backend *)state;
+  uint32_t output_position;
+
+  const char *const error =
+      backend->output->get_position(backend->output->state, &output_position);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  // The output's position wraps long before the input's would, so it is
+  // accumulated before being scaled.
+  backend->played_samples += output_position - backend->output_position;
+  backend->output_position = output_position;
+
+  *position = (uint32_t)((backend->played_samples *
+                          backend->input_samples_per_slot) /
+                         backend->output_samples_per_slot);
+  return NULL;
+}
+
+static const char *pause_backend(void *const state) {
+  const audio_backend *const output =
+      ((const resampling_audio_backend *)state)->output;
+
+  return output->pause(output->state);
+}
+
+static const char *resume_backend(void *const state) {
+  const audio_backend *const output =
+      ((const resampling_audio_backend *)state)->output;
+
+  return output->resume(output->state);
+}
+
+static const char *reset_backend(void *const state) {
+  resampling_audio_backend *const backend = (resampling_audio_backend *)state;
+
+  const char *const error = backend->output->reset(backend->output->state);
+
+  if (error != NULL) {
+    return error;
+  }
+
+  // Whatever is submitted next does not follow on from what was discarded.
+  resampler_reset(&backend->resampler);
+  return NULL;
+}
+
+static const char *close_backend(void *const state) {
+  resampling_audio_backend *const backend = (resampling_audio_backend *)state;
+
+  const char *const error = backend->output->close(backend->output->state);
+
+  // Should the output fail to close, it may still be reading from the slots,
+  // which are leaked rather than freed from beneath it.
+  if (error != NULL) {
+    return error;
+  }
+
+  free(backend->slots);
+  resampler_close(&backend->resampler);
+  return NULL;
+}
+
+const char *resampling_audio_backend_open(
+    resampling_audio_backend *const resampling_audio_backend,
+    const audio_backend *const output, const uint32_t slots,
+    const uint32_t input_samples_per_slot,
+    const uint32_t output_samples_per_slot, const int quality) {
+  resampling_audio_backend->output = output;
+  resampling_audio_backend->input_samples_per_slot = input_samples_per_slot;
+  resampling_audio_backend->output_samples_per_slot = output_samples_per_slot;
+  resampling_audio_backend->output_position = 0;
+  resampling_audio_backend->played_samples = 0;
+
+  const char *const resampler_error =
+      resampler_open(&resampling_audio_backend->resampler,
+                     input_samples_per_slot, output_samples_per_slot, quality);
+
+  if (resampler_error != NULL) {
+    if (output->close(output->state) == NULL) {
+      return resampler_error;
+    } else {
+      return "Failed to open a resampler.  Additionally failed to close the "
+             "audio output.";
+    }
+  }
+
+  resampling_audio_backend->slots =
+      malloc(sizeof(float) * 2 * output_samples_per_slot * slots);
+
+  if (resampling_audio_backend->slots == NULL) {
+    resampler_close(&resampling_audio_backend->resampler);
+
+    if (output->close(output->state) == NULL) {
+      return "Failed to allocate memory for resampled audio.";
+    } else {
+      return "Failed to allocate memory for resampled audio.  Additionally "
+             "failed to close the audio output.";
+    }
+  }
+
+  return NULL;
+}
+
+audio_backend resampling_audio_backend_interface(
+    resampling_audio_backend *const resampling_audio_backend) {
+  const audio_backend output = {
+      .state = resampling_audio_backend,
+      .prepare = prepare,
+      .submit = submit,
+      .get_completed = get_completed,
+      .get_capacity = get_capacity,
+      .get_position = get_position,
+      .pause = pause_backend,
+      .resume = resume_backend,
+      .reset = reset_backend,
+      .close = close_backend,
+  };
+
+  return output;
+}
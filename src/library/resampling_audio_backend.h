@@ -0,0 +1,65 @@
+#ifndef RESAMPLING_AUDIO_BACKEND_H
+
+#define RESAMPLING_AUDIO_BACKEND_H
+
+#include "audio_backend.h"
+#include "resampler.h"
+#include <stdint.h>
+
+/**
+ * An audio backend which resamples each slot before passing it on to another
+ * audio backend, so that audio can be given to an audio device at its own
+ * sample rate rather than being resampled by something which cannot be
+ * controlled.  All fields are owned by the backend and should only be accessed
+ * through the functions below.
+ */
+typedef struct {
+  const audio_backend *output;
+  resampler resampler;
+  float *slots;
+  uint32_t input_samples_per_slot;
+  uint32_t output_samples_per_slot;
+  uint32_t output_position;
+  uint64_t played_samples;
+} resampling_audio_backend;
+
+/**
+ * Opens a resampling audio backend.
+ * @param resampling_audio_backend The backend to open.
+ * @param output The already-opened audio backend to which to pass resampled
+ *               audio.  Must remain valid for as long as the resampling audio
+ *               backend is open, which closes it when itself closed, or
+ *               should it fail to open.
+ * @param slots The number of slots in the audio ring which will be played.
+ *              Behavior is undefined if less than 1.
+ * @param input_samples_per_slot The number of samples per channel in each slot
+ *                               given to the resampling audio backend.
+ *                               Behavior is undefined if less than 1.
+ * @param output_samples_per_slot The number of samples per channel in each
+ *                                slot given to the output, which determines
+ *                                the ratio between the sample rates.
+ *                                Behavior is undefined if less than 1.
+ * @param quality The trade-off between quality and performance.  Behavior is
+ *                undefined if not a RESAMPLER_QUALITY_* constant.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *resampling_audio_backend_open(
+    resampling_audio_backend *const resampling_audio_backend,
+    const audio_backend *const output, const uint32_t slots,
+    const uint32_t input_samples_per_slot,
+    const uint32_t output_samples_per_slot, const int quality);
+
+/**
+ * Wraps a resampling audio backend so that it may be used as an audio backend.
+ * Positions are reported at the input's sample rate.
+ * @param resampling_audio_backend The resampling audio backend to wrap.  Must
+ *                                 remain valid for as long as the returned
+ *                                 audio backend is in use.
+ * @return An audio backend which plays through the given resampling audio
+ *         backend.
+ */
+audio_backend resampling_audio_backend_interface(
+    resampling_audio_backend *const resampling_audio_backend);
+
+#endif
@@ -1,10 +1,24 @@
 #include "run_event_loop.h"
+#include "audio_backend.h"
+#include "audio_ring.h"
+#include "event_loop_core.h"
+#include "framebuffer.h"
+#include "input_recording.h"
+#include "profiler.h"
+#include "resampler.h"
+#include "resampling_audio_backend.h"
+#include "scheduler.h"
+#include "viewport.h"
+#include "wasapi_audio_backend.h"
+#include "wave_out_audio_backend.h"
 #include <dwmapi.h>
+#include <limits.h>
 #include <math.h>
 #include <mmreg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <windows.h>
 #include <windowsx.h>
 #include <winuser.h>
@@ -14,22 +28,62 @@
 #define VSYNC_CONTEXT_STATE_STOPPING 2
 #define VSYNC_CONTEXT_STATE_STOPPED 3
 
+#define AUDIO_CONTEXT_STATE_STARTING 0
+#define AUDIO_CONTEXT_STATE_RUNNING 1
+#define AUDIO_CONTEXT_STATE_STOPPING 2
+#define AUDIO_CONTEXT_STATE_STOPPED 3
+
+// Posted by the audio thread whenever buffers finish playing, so that the main
+// thread can tick to replace them, or when the audio thread stops due to an
+// error.
+#define WM_AUDIO_DUE (WM_APP + 1)
+
 #define OPAQUE_WS WS_OVERLAPPEDWINDOW
 #define TRANSPARENT_WS (WS_POPUP | WS_THICKFRAME)
 
+#ifdef PROFILER
+
+// Where whatever remains in the profiler rings is written when the window
+// closes.
+#ifndef PROFILER_TRACE_PATH
+#define PROFILER_TRACE_PATH "trace.json"
+#endif
+
+// Only one window's event loop runs per process, so each of its threads
+// records to a ring of its own here rather than allocating one per window.
+static profiler_ring main_profiler = {.name = "main", .thread = 1};
+static profiler_ring audio_profiler = {.name = "audio", .thread = 2};
+static profiler_ring vsync_profiler = {.name = "vertical sync", .thread = 3};
+
+#endif
+
 typedef struct {
   const HWND hwnd;
+  const scheduler_clock clock;
   int state;
   const char *error;
   CRITICAL_SECTION critical_section;
 } vsync_context;
 
 typedef struct {
-  const int ticks_per_second;
-  void (*const tick)(const void *const context, const int pointer_state,
-                     const float pointer_row, const float pointer_column,
-                     bool (*const key_held)(const void *const context,
-                                            const WPARAM virtual_key_code));
+  HWND hwnd;
+  const audio_backend audio_backend;
+  const HANDLE event;
+  const int samples_per_tick;
+  audio_ring audio_ring;
+  uint32_t completed_buffers;
+  int queueable_buffers;
+  int capacity;
+  uint32_t underruns;
+  int minimum_slack;
+  int queued_buffers;
+  int state;
+  const char *error;
+  CRITICAL_SECTION critical_section;
+} audio_context;
+
+typedef struct {
+  event_loop_core core;
   const int rows;
   const int columns;
   const int skipped_bytes_per_row;
@@ -37,84 +91,210 @@ typedef struct {
   const float *const reds;
   const float *const greens;
   const float *const blues;
-  void (*const video)(const void *const context, const int pointer_state,
-                      const float pointer_row, const float pointer_column,
-                      bool (*const key_held)(const void *const context,
-                                             const WPARAM virtual_key_code),
-                      const float tick_progress_unit_interval);
-  const int samples_per_tick;
-  const float *const left;
-  const float *const right;
   const char *error;
   void *const scratch;
-  HWAVEOUT hwaveout;
-  int next_buffer;
-  const int buffers;
-  DWORD minimum_position;
-  WPARAM *held_virtual_key_codes;
-  int number_of_held_virtual_key_codes;
+  wave_out_audio_backend wave_out_audio_backend;
+  wasapi_audio_backend wasapi_audio_backend;
+  resampling_audio_backend resampling_audio_backend;
+  const audio_backend output_audio_backend;
+  const audio_backend audio_backend;
+  bool audio_open;
+  const scheduler_clock clock;
+  audio_context audio_context;
   int position_x;
   int position_y;
-  int scaled_width;
-  int scaled_height;
-  int x_offset;
-  int y_offset;
-  int inverse_x_offset;
-  int inverse_y_offset;
-  int pointer_state;
-  float pointer_row;
-  float pointer_column;
+  viewport viewport;
+  RECT insets;
+  int maximum_track_width;
+  int maximum_track_height;
+  bool tracking_mouse;
+  const bool raw_pointer;
+  bool pointer_history_synchronized;
+  MOUSEMOVEPOINT latest_pointer_sample;
+  const bool resample_pointer_before_video;
   bool audio_paused;
 } context;
 
-static bool key_held(const void *const _context,
-                     const WPARAM virtual_key_code) {
-  const context *const our_context = (context *)_context;
-  const int number_of_held_virtual_key_codes =
-      our_context->number_of_held_virtual_key_codes;
-  const WPARAM *const held_virtual_key_codes =
-      our_context->held_virtual_key_codes;
-
-  for (int index = 0; index < number_of_held_virtual_key_codes; index++) {
-    if (virtual_key_code == held_virtual_key_codes[index]) {
-      return true;
-    }
+static const char *get_audio_position(void *const state,
+                                      uint32_t *const position) {
+  const audio_backend *const audio_backend =
+      &((const context *)state)->audio_backend;
+
+  return audio_backend->get_position(audio_backend->state, position);
+}
+
+static const char *wait_for_vertical_sync(void *const state) {
+  (void)(state);
+
+  if (DwmFlush() == S_OK) {
+    return NULL;
+  } else {
+    return "Failed to wait for vertical sync.";
   }
+}
 
-  return false;
+// Where possible, one buffer is held back in the ring rather than queued with
+// the audio backend, so that the audio thread can replace a buffer as soon as
+// it finishes playing rather than waiting for the next tick.
+static int queueable_buffers(const int buffers) {
+  return buffers > 2 ? buffers - 1 : buffers;
 }
 
-static const char *video(const context *const context) {
-  const HWAVEOUT hwaveout = context->hwaveout;
+static audio_backend select_output_audio_backend(context *const context,
+                                                 const int audio_output) {
+  if (audio_output == AUDIO_OUTPUT_WAVE_OUT) {
+    return wave_out_audio_backend_interface(&context->wave_out_audio_backend);
+  } else {
+    return wasapi_audio_backend_interface(&context->wasapi_audio_backend);
+  }
+}
 
-  if (hwaveout == NULL) {
-    context->video(context, context->pointer_state, context->pointer_row,
-                   context->pointer_column, key_held, 0.0f);
+static audio_backend select_audio_backend(context *const context,
+                                          const int audio_output,
+                                          const bool resampling) {
+  if (resampling) {
+    return resampling_audio_backend_interface(
+        &context->resampling_audio_backend);
   } else {
+    return select_output_audio_backend(context, audio_output);
+  }
+}
 
-    MMTIME mmtime = {.wType = TIME_SAMPLES};
+static int select_resampler_quality(const int audio_resampling) {
+  switch (audio_resampling) {
+  case AUDIO_RESAMPLING_LOW:
+    return RESAMPLER_QUALITY_LOW;
 
-    if (waveOutGetPosition(hwaveout, &mmtime, sizeof(mmtime)) !=
-        MMSYSERR_NOERROR) {
-      return "Failed to get wave out position.";
-    }
+  case AUDIO_RESAMPLING_MEDIUM:
+    return RESAMPLER_QUALITY_MEDIUM;
+
+  default:
+    return RESAMPLER_QUALITY_HIGH;
+  }
+}
+
+static int64_t now(void *const state) {
+  const int64_t performance_frequency = *(const int64_t *)state;
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
 
-    if (mmtime.wType != TIME_SAMPLES) {
-      return "Wave out position does not support sample time.";
+  // Split to avoid overflowing once the counter grows large.
+  return counter.QuadPart / performance_frequency * 1000000 +
+         counter.QuadPart % performance_frequency * 1000000 /
+             performance_frequency;
+}
+
+// Window geometry only changes with the style of the window, the DPI of the
+// monitor it is on or the system's metrics, so it is cached rather than
+// recalculated for every message which needs it.
+static const char *refresh_geometry(context *const context) {
+  RECT insets = {0, 0, 0, 0};
+
+  if (!AdjustWindowRect(&insets,
+                        context->opacities == NULL ? OPAQUE_WS : TRANSPARENT_WS,
+                        FALSE)) {
+    return "Failed to calculate the dimensions of the window.";
+  }
+
+  const int cxmaxtrack = GetSystemMetrics(SM_CXMAXTRACK);
+
+  if (cxmaxtrack == 0) {
+    return "Failed to retrieve the maximum width of a window.";
+  }
+
+  const int cymaxtrack = GetSystemMetrics(SM_CYMAXTRACK);
+
+  if (cymaxtrack == 0) {
+    return "Failed to retrieve the maximum height of a window.";
+  }
+
+  context->insets = insets;
+  context->maximum_track_width = cxmaxtrack;
+  context->maximum_track_height = cymaxtrack;
+
+  return NULL;
+}
+
+static const char *sample_pointer_history(const HWND hwnd,
+                                          context *const context) {
+  POINT cursor;
+
+  if (!GetCursorPos(&cursor)) {
+    return "Failed to get the position of the cursor.";
+  }
+
+  MOUSEMOVEPOINT latest = {
+      .x = cursor.x & 0xFFFF,
+      .y = cursor.y & 0xFFFF,
+      .time = 0,
+      .dwExtraInfo = 0,
+  };
+
+  MOUSEMOVEPOINT points[64];
+
+  const int count =
+      GetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &latest, points, 64,
+                           GMMP_USE_DISPLAY_POINTS);
+
+  // This fails when the cursor's location did not come from the mouse (for
+  // example, it was moved programmatically), in which case there is no
+  // history to be had.
+  if (count < 1) {
+    return NULL;
+  }
+
+  // Points are returned from latest to earliest; find those which are newer
+  // than the latest point already recorded.
+  int newer = 0;
+
+  if (context->pointer_history_synchronized) {
+    const MOUSEMOVEPOINT *const previous = &context->latest_pointer_sample;
+
+    while (newer < count && (points[newer].time != previous->time ||
+                             points[newer].x != previous->x ||
+                             points[newer].y != previous->y)) {
+      newer++;
     }
+  }
 
-    const int samples_per_tick = context->samples_per_tick;
+  context->latest_pointer_sample = points[0];
+  context->pointer_history_synchronized = true;
 
-    const DWORD minimum_position = context->minimum_position;
+  if (newer == 0) {
+    return NULL;
+  }
+
+  POINT origin = {0, 0};
+
+  if (!ClientToScreen(hwnd, &origin)) {
+    return "Failed to locate the window.";
+  }
+
+  if (context->opacities != NULL) {
+    origin.x += context->insets.left;
+    origin.y += context->insets.top;
+  }
+
+  for (int index = newer - 1; index >= 0; index--) {
+    // Display points are 16-bit, so those left of or above the primary monitor
+    // wrap around.
+    int x = points[index].x;
+    int y = points[index].y;
 
-    const DWORD position = mmtime.u.sample;
-    const DWORD elapsed = position < minimum_position
-                              ? position + ((4294967295 - minimum_position) + 1)
-                              : position - minimum_position;
+    if (x > 32767) {
+      x -= 65536;
+    }
+
+    if (y > 32767) {
+      y -= 65536;
+    }
 
-    context->video(context, context->pointer_state, context->pointer_row,
-                   context->pointer_column, key_held,
-                   max(0.0f, min(1.0f, elapsed / (float)samples_per_tick)));
+    float row;
+    float column;
+    viewport_locate(&context->viewport, x - origin.x, y - origin.y, &row,
+                    &column);
+    event_loop_core_pointer(&context->core, context->core.input.pointer_state,
+                            row, column, points[index].time);
   }
 
   return NULL;
@@ -127,24 +307,48 @@ static LRESULT handle_mouse_event(const HWND hwnd, const UINT uMsg,
   int y = GET_Y_LPARAM(lParam);
 
   if (context->opacities != NULL) {
-    RECT insets = {0, 0, 0, 0};
+    x -= context->insets.left;
+    y -= context->insets.top;
+  }
 
-    if (AdjustWindowRect(&insets, TRANSPARENT_WS, FALSE)) {
-      x -= insets.left;
-      y -= insets.top;
-    } else {
-      context->error = "Failed to calculate the dimensions of the window.";
+  const int pointer_state =
+      wParam & MK_LBUTTON ? POINTER_STATE_SELECT : POINTER_STATE_HOVER;
+
+  if (context->raw_pointer && uMsg == WM_MOUSEMOVE &&
+      pointer_state == context->core.input.pointer_state) {
+    // Moves are recorded from the pointer's history instead, which includes
+    // those coalesced away before this message was raised.
+    const char *const error = sample_pointer_history(hwnd, context);
+
+    if (error != NULL) {
+      context->error = error;
       return DefWindowProc(hwnd, uMsg, wParam, lParam);
     }
+  } else {
+    float row;
+    float column;
+    viewport_locate(&context->viewport, x, y, &row, &column);
+    event_loop_core_pointer(&context->core, pointer_state, row, column,
+                            GetMessageTime());
+
+    if (context->raw_pointer) {
+      // Anything in the pointer's history up to this point has been superseded
+      // by the above.
+      context->pointer_history_synchronized = false;
+      const char *const error = sample_pointer_history(hwnd, context);
+
+      if (error != NULL) {
+        context->error = error;
+        return DefWindowProc(hwnd, uMsg, wParam, lParam);
+      }
+    }
   }
 
-  context->pointer_state =
-      wParam & MK_LBUTTON ? POINTER_STATE_SELECT : POINTER_STATE_HOVER;
-  context->pointer_row = ((float)((y - context->y_offset) * context->rows)) /
-                         ((float)context->scaled_height);
-  context->pointer_column =
-      ((float)((x - context->x_offset) * context->columns)) /
-      ((float)context->scaled_width);
+  // Tracking persists until the pointer leaves, so there is no need to request
+  // it again for every movement.
+  if (context->tracking_mouse) {
+    return 0;
+  }
 
   TRACKMOUSEEVENT event_track = {
       .cbSize = sizeof(TRACKMOUSEEVENT),
@@ -154,6 +358,7 @@ static LRESULT handle_mouse_event(const HWND hwnd, const UINT uMsg,
   };
 
   if (TrackMouseEvent(&event_track)) {
+    context->tracking_mouse = true;
     return 0;
   } else {
     context->error = "Failed to track the mouse.";
@@ -161,32 +366,83 @@ static LRESULT handle_mouse_event(const HWND hwnd, const UINT uMsg,
   }
 }
 
-static const char *refresh_layered(const HWND hwnd,
-                                   const context *const context) {
-  const char *const error = video(context);
+static const char *resample_pointer(const HWND hwnd,
+                                    const context *const context,
+                                    input *const input) {
+  POINT cursor;
+
+  if (!GetCursorPos(&cursor)) {
+    return "Failed to get the position of the cursor.";
+  }
+
+  if (!ScreenToClient(hwnd, &cursor)) {
+    return "Failed to locate the window.";
+  }
+
+  if (context->opacities != NULL) {
+    cursor.x -= context->insets.left;
+    cursor.y -= context->insets.top;
+  }
+
+  viewport_locate(&context->viewport, cursor.x, cursor.y, &input->pointer_row,
+                  &input->pointer_column);
+
+  return NULL;
+}
+
+static const char *video(const HWND hwnd, context *const context) {
+  input snapshot = context->core.input;
+
+  // The pointer may well have moved since the last message about it was
+  // handled, so it is sampled again as late as possible.
+  if (context->resample_pointer_before_video &&
+      snapshot.pointer_state != POINTER_STATE_NONE) {
+    const char *const error = resample_pointer(hwnd, context, &snapshot);
+
+    if (error != NULL) {
+      return error;
+    }
+  }
+
+  float tick_progress_unit_interval = 0.0f;
+
+  if (context->audio_open) {
+    uint32_t position;
+
+    const char *const error =
+        context->clock.get_position(context->clock.state, &position);
+
+    if (error != NULL) {
+      return error;
+    }
+
+    tick_progress_unit_interval =
+        event_loop_core_progress(&context->core, position);
+  }
+
+  PROFILER_BEGIN(video);
+  event_loop_core_video(&context->core, &snapshot, tick_progress_unit_interval);
+  PROFILER_END(&main_profiler, PROFILER_PHASE_VIDEO, video);
+
+  if (context->core.capture != NULL) {
+    capture_video(context->core.capture, context->reds, context->greens,
+                  context->blues);
+  }
+
+  return NULL;
+}
+
+static const char *refresh_layered(const HWND hwnd, context *const context) {
+  const char *const error = video(hwnd, context);
 
   if (error != NULL) {
     return error;
   }
 
-  const int rows = context->rows;
-  const int y_offset = context->y_offset;
-  const int scaled_height = context->scaled_height;
+  const int scaled_height = context->viewport.scaled_height;
   const int position_y = context->position_y;
-  const int columns = context->columns;
-  const int x_offset = context->x_offset;
-  const int scaled_width = context->scaled_width;
+  const int scaled_width = context->viewport.scaled_width;
   const int position_x = context->position_x;
-  const float *const blues = context->blues;
-  const float *const greens = context->greens;
-  const float *const reds = context->reds;
-  const float *const opacities = context->opacities;
-  uint8_t *const scratch = context->scratch;
-  const int pixels = rows * columns;
-  uint8_t *const scratch_blues = scratch;
-  uint8_t *const scratch_greens = scratch_blues + pixels;
-  uint8_t *const scratch_reds = scratch_greens + pixels;
-  uint8_t *const scratch_opacities = scratch_reds + pixels;
 
   BITMAPINFO bitmapinfo = {
       .bmiHeader =
@@ -289,55 +545,13 @@ static const char *refresh_layered(const HWND hwnd,
     }
   }
 
-  for (int source_index = 0; source_index < pixels; source_index++) {
-    const float opacity = opacities[source_index] * 255.0f;
-    scratch_blues[source_index] = blues[source_index] * opacity;
-    scratch_greens[source_index] = greens[source_index] * opacity;
-    scratch_reds[source_index] = reds[source_index] * opacity;
-    scratch_opacities[source_index] = opacity;
-  }
-
-  const float y_per_row = ((float)rows) / ((float)scaled_height);
-  const int rows_minus_one = rows - 1;
-  const float x_per_column = ((float)columns) / ((float)scaled_width);
-  const int columns_minus_one = columns - 1;
-  int destination_index = 0;
-
-  for (int row = 0; row < scaled_height; row++) {
-    int y = row * y_per_row;
-
-    if (y < 0) {
-      y = 0;
-    }
-
-    if (y > rows_minus_one) {
-      y = rows_minus_one;
-    }
-
-    const int y_index = y * columns;
+  PROFILER_BEGIN(scaling);
+  framebuffer_convert_layered(context->rows, context->columns,
+                              context->opacities, context->reds,
+                              context->greens, context->blues, context->scratch,
+                              &context->viewport, pixel_bytes);
+  PROFILER_END(&main_profiler, PROFILER_PHASE_SCALING, scaling);
 
-    for (int column = 0; column < scaled_width; column++) {
-      int x = column * x_per_column;
-
-      if (x < 0) {
-        x = 0;
-      }
-
-      if (x > columns_minus_one) {
-        x = columns_minus_one;
-      }
-
-      const int source_index = y_index + x;
-
-      pixel_bytes[destination_index++] = scratch_blues[source_index];
-      pixel_bytes[destination_index++] = scratch_greens[source_index];
-      pixel_bytes[destination_index++] = scratch_reds[source_index];
-      pixel_bytes[destination_index++] = scratch_opacities[source_index];
-    }
-  }
-
-  (void)(x_offset);
-  (void)(y_offset);
   POINT ptPos = {position_x, position_y};
   SIZE sizeWnd = {scaled_width, scaled_height};
   POINT ptSrc = {0, 0};
@@ -347,8 +561,13 @@ static const char *refresh_layered(const HWND hwnd,
   blend.SourceConstantAlpha = 255;
   blend.AlphaFormat = AC_SRC_ALPHA;
 
-  if (UpdateLayeredWindow(hwnd, screen_hdc, &ptPos, &sizeWnd, hdcMem, &ptSrc, 0,
-                          &blend, ULW_ALPHA) == 0) {
+  PROFILER_BEGIN(present);
+  const BOOL updated =
+      UpdateLayeredWindow(hwnd, screen_hdc, &ptPos, &sizeWnd, hdcMem, &ptSrc, 0,
+                          &blend, ULW_ALPHA);
+  PROFILER_END(&main_profiler, PROFILER_PHASE_PRESENT, present);
+
+  if (updated == 0) {
     if (SelectObject(hdcMem, hOld) == NULL) {
       if (DeleteObject(hdcMem)) {
         if (DeleteObject(hBitmap)) {
@@ -436,6 +655,8 @@ static const char *refresh_layered(const HWND hwnd,
     }
   }
 
+  event_loop_core_presented(&context->core);
+
   if (SelectObject(hdcMem, hOld) == NULL) {
     if (DeleteObject(hdcMem)) {
       if (DeleteObject(hBitmap)) {
@@ -517,8 +738,11 @@ static const char *refresh_layered(const HWND hwnd,
 static LRESULT repaint(const HWND hwnd, const UINT uMsg, const WPARAM wParam,
                        const LPARAM lParam, context *const context) {
   if (context->audio_paused) {
-    if (waveOutRestart(context->hwaveout) != MMSYSERR_NOERROR) {
-      context->error = "Failed to restart wave out.";
+    const char *const error =
+        context->audio_backend.resume(context->audio_backend.state);
+
+    if (error != NULL) {
+      context->error = error;
       return DefWindowProc(hwnd, uMsg, wParam, lParam);
     } else {
       context->audio_paused = false;
@@ -558,68 +782,60 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
   }
 
   switch (uMsg) {
-  case MM_WOM_DONE: {
-    const int samples_per_tick = our_context->samples_per_tick;
-    const int next_buffer = our_context->next_buffer;
-    const int buffers = our_context->buffers;
-    HWAVEOUT hwaveout = our_context->hwaveout;
-
-    float *const start_of_buffers =
-        (float *)(((uint8_t *)our_context->scratch) +
-                  our_context->rows *
-                      (our_context->opacities == NULL
-                           ? (our_context->columns * 3 +
-                              our_context->skipped_bytes_per_row)
-                           : (our_context->columns * 4)));
-    float *buffer = start_of_buffers + samples_per_tick * 2 * next_buffer;
-    const float *left = our_context->left;
-    const float *right = our_context->right;
-
-    WAVEHDR *wavehdr =
-        ((WAVEHDR *)(start_of_buffers + samples_per_tick * 2 * buffers)) +
-        next_buffer;
-
-    if (waveOutUnprepareHeader(hwaveout, wavehdr, sizeof(WAVEHDR)) !=
-        MMSYSERR_NOERROR) {
-      our_context->error = "Failed to unprepare wave out.";
+  case WM_AUDIO_DUE: {
+    audio_context *const audio_context = &our_context->audio_context;
+
+    EnterCriticalSection(&audio_context->critical_section);
+    our_context->error = audio_context->error;
+    LeaveCriticalSection(&audio_context->critical_section);
+
+    if (our_context->error != NULL) {
       return DefWindowProc(hwnd, uMsg, wParam, lParam);
     }
 
-    our_context->tick(our_context, our_context->pointer_state,
-                      our_context->pointer_row, our_context->pointer_column,
-                      key_held);
+    // Should the main thread stall, several of these messages will queue up.
+    // Every buffer which has finished playing is due, so all of them are
+    // replaced now, and the messages which follow find nothing left to do.
+    const uint32_t completed_buffers = __atomic_load_n(
+        &audio_context->completed_buffers, __ATOMIC_ACQUIRE);
 
-    for (int index = 0; index < samples_per_tick; index++) {
-      *buffer = *left;
-      buffer++;
-      left++;
+    // Every movement of the pointer up to now is delivered to the ticks about
+    // to be executed.
+    if (our_context->raw_pointer &&
+        our_context->core.input.pointer_state != POINTER_STATE_NONE) {
+      our_context->error = sample_pointer_history(hwnd, our_context);
 
-      *buffer = *right;
-      buffer++;
-      right++;
+      if (our_context->error != NULL) {
+        return DefWindowProc(hwnd, uMsg, wParam, lParam);
+      }
     }
 
-    if (waveOutPrepareHeader(hwaveout, wavehdr, sizeof(WAVEHDR)) !=
-        MMSYSERR_NOERROR) {
-      our_context->error = "Failed to prepare wave out.";
-      return DefWindowProc(hwnd, uMsg, wParam, lParam);
-    }
+    bool adapted;
+    int refills;
+
+    PROFILER_BEGIN(audio_refill);
+    our_context->error = event_loop_core_refill(
+        &our_context->core, &audio_context->audio_ring, completed_buffers,
+        __atomic_load_n(&audio_context->underruns, __ATOMIC_RELAXED),
+        __atomic_load_n(&audio_context->minimum_slack, __ATOMIC_RELAXED),
+        &adapted, &refills);
+    PROFILER_END(&main_profiler, PROFILER_PHASE_AUDIO_REFILL, audio_refill);
 
-    if (waveOutWrite(hwaveout, wavehdr, sizeof(WAVEHDR)) != MMSYSERR_NOERROR) {
-      our_context->error = "Failed to write wave out.";
+    if (our_context->error != NULL) {
       return DefWindowProc(hwnd, uMsg, wParam, lParam);
     }
 
-    our_context->next_buffer = (next_buffer + 1) % buffers;
-
-    const DWORD previous_minimum_position = our_context->minimum_position;
-    const DWORD distance_to_end = (4294967295 - previous_minimum_position) + 1;
+    if (adapted) {
+      __atomic_store_n(&audio_context->minimum_slack, INT_MAX,
+                       __ATOMIC_RELAXED);
+      __atomic_store_n(&audio_context->queueable_buffers,
+                       queueable_buffers(our_context->core.buffers),
+                       __ATOMIC_RELAXED);
+    }
 
-    if (distance_to_end <= (DWORD)samples_per_tick) {
-      our_context->minimum_position = samples_per_tick - distance_to_end;
-    } else {
-      our_context->minimum_position =
-          previous_minimum_position + samples_per_tick;
+    if (refills > 0 && !SetEvent(audio_context->event)) {
+      our_context->error = "Failed to notify the audio thread.";
+      return DefWindowProc(hwnd, uMsg, wParam, lParam);
     }
 
     return 0;
@@ -627,8 +843,11 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
 
   case WM_PAINT: {
     if (our_context->audio_paused) {
-      if (waveOutRestart(our_context->hwaveout) != MMSYSERR_NOERROR) {
-        our_context->error = "Failed to restart wave out.";
+      const char *const error =
+          our_context->audio_backend.resume(our_context->audio_backend.state);
+
+      if (error != NULL) {
+        our_context->error = error;
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
       } else {
         our_context->audio_paused = false;
@@ -644,7 +863,7 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
       }
 
-      our_context->error = video(our_context);
+      our_context->error = video(hwnd, our_context);
 
       if (our_context->error != NULL) {
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
@@ -652,25 +871,13 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
 
       const int rows = our_context->rows;
       const int columns = our_context->columns;
-      const int skipped_bytes_per_row = our_context->skipped_bytes_per_row;
-      const float *const reds = our_context->reds;
-      const float *const greens = our_context->greens;
-      const float *const blues = our_context->blues;
       uint8_t *const pixels = our_context->scratch;
 
-      int input = 0;
-      int output = 0;
-
-      for (int row = 0; row < rows; row++) {
-        for (int column = 0; column < columns; column++) {
-          pixels[output++] = blues[input] * 255.0f;
-          pixels[output++] = greens[input] * 255.0f;
-          pixels[output++] = reds[input] * 255.0f;
-          input++;
-        }
-
-        output += skipped_bytes_per_row;
-      }
+      PROFILER_BEGIN(conversion);
+      framebuffer_convert_opaque(rows, columns, our_context->reds,
+                                 our_context->greens, our_context->blues,
+                                 our_context->skipped_bytes_per_row, pixels);
+      PROFILER_END(&main_profiler, PROFILER_PHASE_CONVERSION, conversion);
 
       BITMAPINFO bitmapinfo = {.bmiHeader = {
                                    sizeof(BITMAPINFO),
@@ -698,13 +905,14 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
       }
 
-      const int x_offset = our_context->x_offset;
-      const int scaled_width = our_context->scaled_width;
-      const int inverse_x_offset = our_context->inverse_x_offset;
+      const viewport *const viewport = &our_context->viewport;
+      const int x_offset = viewport->x_offset;
+      const int scaled_width = viewport->scaled_width;
+      const int inverse_x_offset = viewport->inverse_x_offset;
       const int destination_width = x_offset + scaled_width + inverse_x_offset;
-      const int y_offset = our_context->y_offset;
-      const int scaled_height = our_context->scaled_height;
-      const int inverse_y_offset = our_context->inverse_y_offset;
+      const int y_offset = viewport->y_offset;
+      const int scaled_height = viewport->scaled_height;
+      const int inverse_y_offset = viewport->inverse_y_offset;
       const int destination_height =
           y_offset + scaled_height + inverse_y_offset;
 
@@ -744,14 +952,20 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
         }
       }
 
-      if (StretchDIBits(hdc, x_offset, y_offset, scaled_width, scaled_height, 0,
-                        0, columns, rows, pixels, &bitmapinfo, DIB_RGB_COLORS,
-                        SRCCOPY) == 0) {
+      PROFILER_BEGIN(present);
+      const int stretched = StretchDIBits(
+          hdc, x_offset, y_offset, scaled_width, scaled_height, 0, 0, columns,
+          rows, pixels, &bitmapinfo, DIB_RGB_COLORS, SRCCOPY);
+      PROFILER_END(&main_profiler, PROFILER_PHASE_PRESENT, present);
+
+      if (stretched == 0) {
         EndPaint(hwnd, &paint);
         our_context->error = "Failed to paint the framebuffer.";
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
       }
 
+      event_loop_core_presented(&our_context->core);
+
       EndPaint(hwnd, &paint);
       return 0;
     } else {
@@ -766,33 +980,12 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
     int height = windowpos->cy;
 
     if (our_context->opacities == NULL) {
-      RECT insets = {0, 0, 0, 0};
-
-      if (AdjustWindowRect(&insets, OPAQUE_WS, FALSE)) {
-        width += insets.left;
-        height += insets.top;
-      } else {
-        our_context->error =
-            "Failed to calculate the dimensions of the window.";
-        return DefWindowProc(hwnd, uMsg, wParam, lParam);
-      }
+      width += our_context->insets.left;
+      height += our_context->insets.top;
     }
 
-    const int columns = our_context->columns;
-    const int rows = our_context->rows;
-    const double x_scale = (double)width / columns;
-    const double y_scale = (double)height / rows;
-    const double scale = x_scale < y_scale ? x_scale : y_scale;
-    const int scaled_width = columns * scale;
-    our_context->scaled_width = scaled_width;
-    const int scaled_height = rows * scale;
-    our_context->scaled_height = scaled_height;
-    const int x_offset = (width - scaled_width) / 2;
-    our_context->x_offset = x_offset;
-    const int y_offset = (height - scaled_height) / 2;
-    our_context->y_offset = y_offset;
-    our_context->inverse_x_offset = width - scaled_width - x_offset;
-    our_context->inverse_y_offset = height - scaled_height - y_offset;
+    viewport_fit(&our_context->viewport, our_context->rows,
+                 our_context->columns, width, height);
 
     our_context->position_x = windowpos->x;
     our_context->position_y = windowpos->y;
@@ -806,196 +999,121 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
   case WM_GETMINMAXINFO: {
     LPMINMAXINFO lpMMI = (LPMINMAXINFO)lParam;
 
-    RECT insets = {0, 0, 0, 0};
+    const RECT insets = our_context->insets;
 
-    if (AdjustWindowRect(&insets,
-                         our_context->opacities == NULL ? OPAQUE_WS
-                                                        : TRANSPARENT_WS,
-                         FALSE)) {
-      lpMMI->ptMinTrackSize.x =
-          our_context->columns + insets.right - insets.left;
-      lpMMI->ptMinTrackSize.y = our_context->rows + insets.bottom - insets.top;
+    lpMMI->ptMinTrackSize.x = our_context->columns + insets.right - insets.left;
+    lpMMI->ptMinTrackSize.y = our_context->rows + insets.bottom - insets.top;
 
-      const int cxmaxtrack = GetSystemMetrics(SM_CXMAXTRACK);
+    const int cxmaxtrack = our_context->maximum_track_width;
+    const int cymaxtrack = our_context->maximum_track_height;
 
-      if (cxmaxtrack == 0) {
-        our_context->error =
-            "Failed to retrieve the maximum width of a window.";
-        return DefWindowProc(hwnd, uMsg, wParam, lParam);
-      }
+    float maximum_x_scale =
+        (float)(cxmaxtrack + insets.left - insets.right) / our_context->columns;
+    float maximum_y_scale =
+        (float)(cymaxtrack + insets.top - insets.bottom) / our_context->rows;
+    float maximum_scale = min(maximum_x_scale, maximum_y_scale);
 
-      const int cymaxtrack = GetSystemMetrics(SM_CYMAXTRACK);
+    lpMMI->ptMaxTrackSize.x =
+        maximum_scale * our_context->columns + insets.right - insets.left;
+    lpMMI->ptMaxTrackSize.y =
+        maximum_scale * our_context->rows + insets.bottom - insets.top;
 
-      if (cymaxtrack == 0) {
-        our_context->error =
-            "Failed to retrieve the maximum height of a window.";
-        return DefWindowProc(hwnd, uMsg, wParam, lParam);
-      }
-
-      float maximum_x_scale = (float)(cxmaxtrack + insets.left - insets.right) /
-                              our_context->columns;
-      float maximum_y_scale =
-          (float)(cymaxtrack + insets.top - insets.bottom) / our_context->rows;
-      float maximum_scale = min(maximum_x_scale, maximum_y_scale);
-
-      lpMMI->ptMaxTrackSize.x =
-          maximum_scale * our_context->columns + insets.right - insets.left;
-      lpMMI->ptMaxTrackSize.y =
-          maximum_scale * our_context->rows + insets.bottom - insets.top;
-
-      return 0;
-    } else {
-      our_context->error = "Failed to calculate the dimensions of the window.";
-      return DefWindowProc(hwnd, uMsg, wParam, lParam);
-    }
+    return 0;
   }
 
+  case WM_DPICHANGED:
+  case WM_DISPLAYCHANGE:
+  case WM_SETTINGCHANGE:
+  case WM_STYLECHANGED:
+    our_context->error = refresh_geometry(our_context);
+    return DefWindowProc(hwnd, uMsg, wParam, lParam);
+
   case WM_SIZING: {
     PRECT outer = (PRECT)lParam;
 
-    RECT insets = {0, 0, 0, 0};
+    const RECT insets = our_context->insets;
 
-    if (AdjustWindowRect(&insets,
-                         our_context->opacities == NULL ? OPAQUE_WS
-                                                        : TRANSPARENT_WS,
-                         FALSE)) {
-      RECT inner = {outer->left - insets.left, outer->top - insets.top,
-                    outer->right - insets.right, outer->bottom - insets.bottom};
+    RECT inner = {outer->left - insets.left, outer->top - insets.top,
+                  outer->right - insets.right, outer->bottom - insets.bottom};
 
-      int inner_width = inner.right - inner.left;
-      int inner_height = inner.bottom - inner.top;
+    int inner_width = inner.right - inner.left;
+    int inner_height = inner.bottom - inner.top;
 
-      switch (wParam) {
-      case WMSZ_TOP:
-      case WMSZ_BOTTOM: {
-        int scaled_inner_width =
-            inner_height * our_context->columns / our_context->rows;
+    switch (wParam) {
+    case WMSZ_TOP:
+    case WMSZ_BOTTOM: {
+      int scaled_inner_width =
+          inner_height * our_context->columns / our_context->rows;
 
-        int width_change = scaled_inner_width - inner_width;
+      int width_change = scaled_inner_width - inner_width;
 
-        outer->left -= width_change / 2;
-        outer->right += width_change / 2;
-        break;
-      }
+      outer->left -= width_change / 2;
+      outer->right += width_change / 2;
+      break;
+    }
 
-      case WMSZ_LEFT:
-      case WMSZ_RIGHT: {
-        int scaled_inner_height =
-            inner_width * our_context->rows / our_context->columns;
+    case WMSZ_LEFT:
+    case WMSZ_RIGHT: {
+      int scaled_inner_height =
+          inner_width * our_context->rows / our_context->columns;
 
-        int height_change = scaled_inner_height - inner_height;
+      int height_change = scaled_inner_height - inner_height;
 
-        outer->bottom += height_change;
-        break;
-      }
+      outer->bottom += height_change;
+      break;
+    }
 
-      case WMSZ_BOTTOMLEFT:
-      case WMSZ_BOTTOMRIGHT:
-      case WMSZ_TOPLEFT:
-      case WMSZ_TOPRIGHT: {
-        float x_scale_factor = (float)inner_width / our_context->columns;
-        float y_scale_factor = (float)inner_height / our_context->rows;
+    case WMSZ_BOTTOMLEFT:
+    case WMSZ_BOTTOMRIGHT:
+    case WMSZ_TOPLEFT:
+    case WMSZ_TOPRIGHT: {
+      float x_scale_factor = (float)inner_width / our_context->columns;
+      float y_scale_factor = (float)inner_height / our_context->rows;
 
-        float scale_factor = max(x_scale_factor, y_scale_factor);
+      float scale_factor = max(x_scale_factor, y_scale_factor);
 
-        int scaled_inner_width = scale_factor * our_context->columns;
-        int scaled_inner_height = scale_factor * our_context->rows;
+      int scaled_inner_width = scale_factor * our_context->columns;
+      int scaled_inner_height = scale_factor * our_context->rows;
 
-        int width_change = scaled_inner_width - inner_width;
-        int height_change = scaled_inner_height - inner_height;
+      int width_change = scaled_inner_width - inner_width;
+      int height_change = scaled_inner_height - inner_height;
 
-        switch (wParam) {
-        case WMSZ_BOTTOMLEFT:
-          outer->bottom += height_change;
-          outer->left -= width_change;
-          break;
-
-        case WMSZ_BOTTOMRIGHT:
-          outer->bottom += height_change;
-          outer->right += width_change;
-          break;
+      switch (wParam) {
+      case WMSZ_BOTTOMLEFT:
+        outer->bottom += height_change;
+        outer->left -= width_change;
+        break;
 
-        case WMSZ_TOPLEFT:
-          outer->top -= height_change;
-          outer->left -= width_change;
-          break;
+      case WMSZ_BOTTOMRIGHT:
+        outer->bottom += height_change;
+        outer->right += width_change;
+        break;
 
-        case WMSZ_TOPRIGHT:
-          outer->top -= height_change;
-          outer->right += width_change;
-          break;
-        }
+      case WMSZ_TOPLEFT:
+        outer->top -= height_change;
+        outer->left -= width_change;
+        break;
 
+      case WMSZ_TOPRIGHT:
+        outer->top -= height_change;
+        outer->right += width_change;
         break;
       }
-      }
 
-      return 0;
-    } else {
-      our_context->error = "Failed to calculate the dimensions of the window.";
-      return DefWindowProc(hwnd, uMsg, wParam, lParam);
+      break;
     }
-  }
-
-  case WM_KEYDOWN: {
-    const int number_of_held_virtual_key_codes =
-        our_context->number_of_held_virtual_key_codes;
-    WPARAM *held_virtual_key_codes = our_context->held_virtual_key_codes;
-
-    for (int index = 0; index < number_of_held_virtual_key_codes; index++) {
-      if (held_virtual_key_codes[index] == wParam) {
-        return 0;
-      }
-    }
-
-    if (number_of_held_virtual_key_codes) {
-      held_virtual_key_codes =
-          realloc(held_virtual_key_codes,
-                  sizeof(WPARAM) * (number_of_held_virtual_key_codes + 1));
-      held_virtual_key_codes[number_of_held_virtual_key_codes] = wParam;
-      our_context->held_virtual_key_codes = held_virtual_key_codes;
-      our_context->number_of_held_virtual_key_codes =
-          number_of_held_virtual_key_codes + 1;
-    } else {
-      held_virtual_key_codes = malloc(sizeof(WPARAM));
-      held_virtual_key_codes[0] = wParam;
-      our_context->held_virtual_key_codes = held_virtual_key_codes;
-      our_context->number_of_held_virtual_key_codes = 1;
     }
 
     return 0;
   }
 
-  case WM_KEYUP: {
-    const int number_of_held_virtual_key_codes =
-        our_context->number_of_held_virtual_key_codes;
-    WPARAM *held_virtual_key_codes = our_context->held_virtual_key_codes;
-
-    for (int index = 0; index < number_of_held_virtual_key_codes; index++) {
-      if (held_virtual_key_codes[index] == wParam) {
-        if (number_of_held_virtual_key_codes == 1) {
-          free(held_virtual_key_codes);
-          our_context->held_virtual_key_codes = NULL;
-          our_context->number_of_held_virtual_key_codes = 0;
-        } else {
-          memmove(held_virtual_key_codes + index,
-                  held_virtual_key_codes + index + 1,
-                  sizeof(WPARAM) *
-                      (number_of_held_virtual_key_codes - index - 1));
-          held_virtual_key_codes =
-              realloc(held_virtual_key_codes,
-                      sizeof(WPARAM) * (number_of_held_virtual_key_codes - 1));
-          our_context->held_virtual_key_codes = held_virtual_key_codes;
-          our_context->number_of_held_virtual_key_codes =
-              number_of_held_virtual_key_codes - 1;
-        }
-
-        break;
-      }
-    }
+  case WM_KEYDOWN:
+    event_loop_core_key(&our_context->core, wParam, true, GetMessageTime());
+    return 0;
 
+  case WM_KEYUP:
+    event_loop_core_key(&our_context->core, wParam, false, GetMessageTime());
     return 0;
-  }
 
   case WM_LBUTTONDOWN:
     SetCapture(hwnd);
@@ -1013,7 +1131,12 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
     }
 
   case WM_MOUSELEAVE: {
-    our_context->pointer_state = POINTER_STATE_NONE;
+    our_context->tracking_mouse = false;
+
+    event_loop_core_pointer(&our_context->core, POINTER_STATE_NONE,
+                            our_context->core.input.pointer_row,
+                            our_context->core.input.pointer_column,
+                            GetMessageTime());
     return 0;
   }
 
@@ -1022,10 +1145,13 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
     if ((wParam == HTCAPTION || wParam == HTMAXBUTTON ||
          wParam == HTMINBUTTON || wParam == HTCLOSE) &&
         !our_context->audio_paused) {
-      if (waveOutPause(our_context->hwaveout) == MMSYSERR_NOERROR) {
+      const char *const error =
+          our_context->audio_backend.pause(our_context->audio_backend.state);
+
+      if (error == NULL) {
         our_context->audio_paused = true;
       } else {
-        our_context->error = "Failed to pause wave out.";
+        our_context->error = error;
       }
     }
 
@@ -1033,6 +1159,25 @@ static LRESULT CALLBACK window_procedure(const HWND hwnd, const UINT uMsg,
   }
 
   case WM_DESTROY:
+#ifdef PROFILER
+    // NOTE: Should this fail, there is nowhere left to report it.
+    run_event_loop_write_trace(PROFILER_TRACE_PATH);
+#endif
+
+    // The process exits below, so anything still queued for the capture's
+    // writer thread would otherwise be lost, and its WAV file left without
+    // sizes.
+    if (our_context->core.capture != NULL) {
+      // NOTE: Should this fail, there is nowhere left to report it.
+      capture_close(our_context->core.capture);
+    }
+
+    // Likewise, run_event_loop never regains control to close the recording.
+    if (our_context->core.recording != NULL) {
+      // NOTE: Should this fail, there is nowhere left to report it.
+      input_recording_close(our_context->core.recording);
+    }
+
     exit(0);
 
   default:
@@ -1052,7 +1197,13 @@ DWORD WINAPI vsync_thread(LPVOID lpParam) {
     while (context->state == VSYNC_CONTEXT_STATE_RUNNING) {
       LeaveCriticalSection(&context->critical_section);
 
-      if (DwmFlush() == S_OK) {
+      PROFILER_BEGIN(vertical_sync);
+      const char *const error =
+          context->clock.wait_for_refresh(context->clock.state);
+      PROFILER_END(&vsync_profiler, PROFILER_PHASE_VERTICAL_SYNC,
+                   vertical_sync);
+
+      if (error == NULL) {
         if (SendMessage(hwnd, WM_APP, 0, 0)) {
           // NOTE: As far as is known, this can only happen if the window
           //       unexpectedly closes, in which case, the main thread will
@@ -1068,7 +1219,7 @@ DWORD WINAPI vsync_thread(LPVOID lpParam) {
         }
       } else {
         EnterCriticalSection(&context->critical_section);
-        context->error = "Failed to wait for vertical sync.";
+        context->error = error;
         break;
       }
     }
@@ -1079,32 +1230,209 @@ DWORD WINAPI vsync_thread(LPVOID lpParam) {
   return 0;
 }
 
-const char *run_event_loop(
+static const char *service_audio(audio_context *const context) {
+  PROFILER_BEGIN(audio_submit);
+  const audio_backend *const audio_backend = &context->audio_backend;
+  uint32_t completed_buffers;
+
+  const char *const completed_error = audio_backend->get_completed(
+      audio_backend->state, &completed_buffers);
+
+  if (completed_error != NULL) {
+    return completed_error;
+  }
+
+  const uint32_t newly_completed_buffers =
+      completed_buffers - context->completed_buffers;
+
+  for (uint32_t index = 0; index < newly_completed_buffers; index++) {
+    audio_ring_release(&context->audio_ring);
+  }
+
+  context->queued_buffers -= (int)newly_completed_buffers;
+
+  const bool completed = newly_completed_buffers > 0;
+
+  if (completed) {
+    __atomic_store_n(&context->completed_buffers, completed_buffers,
+                     __ATOMIC_RELEASE);
+
+    // Should nothing remain queued, the audio output has run dry and there
+    // will be an audible gap before the next buffer.
+    if (context->queued_buffers == 0) {
+      __atomic_add_fetch(&context->underruns, 1, __ATOMIC_RELAXED);
+    }
+
+    const int slack = context->queued_buffers +
+                      (int)audio_ring_waiting(&context->audio_ring);
+
+    int minimum_slack =
+        __atomic_load_n(&context->minimum_slack, __ATOMIC_RELAXED);
+
+    // The main thread may reset this concurrently.
+    while (slack < minimum_slack &&
+           !__atomic_compare_exchange_n(&context->minimum_slack,
+                                        &minimum_slack, slack, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+  }
+
+  const int requested_buffers =
+      __atomic_load_n(&context->queueable_buffers, __ATOMIC_RELAXED);
+
+  // Should the audio backend be unable to queue as many as requested, the rest
+  // wait in the ring instead.
+  const int queueable_buffers = requested_buffers < context->capacity
+                                    ? requested_buffers
+                                    : context->capacity;
+
+  uint32_t slot;
+
+  while (context->queued_buffers < queueable_buffers &&
+         audio_ring_begin_read(&context->audio_ring, &slot)) {
+    const char *const submit_error = audio_backend->submit(
+        audio_backend->state, slot,
+        audio_ring_slot(&context->audio_ring, slot));
+
+    if (submit_error != NULL) {
+      return submit_error;
+    }
+
+    context->queued_buffers++;
+  }
+
+  PROFILER_END(&audio_profiler, PROFILER_PHASE_AUDIO_SUBMIT, audio_submit);
+
+  if (completed && !PostMessage(context->hwnd, WM_AUDIO_DUE, 0, 0)) {
+    return "Failed to notify the window that audio is due.";
+  }
+
+  return NULL;
+}
+
+DWORD WINAPI audio_thread(LPVOID lpParam) {
+  audio_context *const context = (audio_context *)lpParam;
+
+  EnterCriticalSection(&context->critical_section);
+
+  if (context->state == AUDIO_CONTEXT_STATE_STARTING) {
+    context->state = AUDIO_CONTEXT_STATE_RUNNING;
+
+    while (context->state == AUDIO_CONTEXT_STATE_RUNNING) {
+      LeaveCriticalSection(&context->critical_section);
+
+      // The audio backend signals this whenever it may be ready for more
+      // audio, and the main thread does so whenever it adds to the ring.
+      const char *const error =
+          WaitForSingleObject(context->event, INFINITE) == WAIT_OBJECT_0
+              ? service_audio(context)
+              : "Failed to wait for the audio output.";
+
+      EnterCriticalSection(&context->critical_section);
+
+      if (error != NULL) {
+        context->error = error;
+
+        // NOTE: Should this fail, the main thread will not learn of the error
+        //       until it next stops this thread.
+        PostMessage(context->hwnd, WM_AUDIO_DUE, 0, 0);
+        break;
+      }
+    }
+  }
+
+  context->state = AUDIO_CONTEXT_STATE_STOPPED;
+  LeaveCriticalSection(&context->critical_section);
+  return 0;
+}
+
+static void stop_audio_thread(audio_context *const context) {
+  EnterCriticalSection(&context->critical_section);
+
+  if (context->state != AUDIO_CONTEXT_STATE_STOPPED) {
+    context->state = AUDIO_CONTEXT_STATE_STOPPING;
+
+    // NOTE: Should this fail, the thread will instead wake when the next
+    //       buffer finishes playing.
+    SetEvent(context->event);
+
+    while (context->state != AUDIO_CONTEXT_STATE_STOPPED) {
+      LeaveCriticalSection(&context->critical_section);
+
+      Sleep(10);
+
+      EnterCriticalSection(&context->critical_section);
+    }
+  }
+
+  LeaveCriticalSection(&context->critical_section);
+  DeleteCriticalSection(&context->critical_section);
+}
+
+static const char *run_window(
     const char *const title, const int ticks_per_second,
-    void (*const tick)(const void *const context, const int pointer_state,
-                       const float pointer_row, const float pointer_column,
-                       bool (*const key_held)(const void *const context,
-                                              const WPARAM virtual_key_code)),
-    const int rows, const int columns, const float *const opacities,
-    const float *const reds, const float *const greens,
-    const float *const blues,
-    void (*const video)(const void *const context, const int pointer_state,
-                        const float pointer_row, const float pointer_column,
-                        bool (*const key_held)(const void *const context,
-                                               const WPARAM virtual_key_code),
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows,
+    const int columns, const float *const opacities, const float *const reds,
+    const float *const greens, const float *const blues,
+    void (*const video)(const input *const input,
                         const float tick_progress_unit_interval),
-    const int samples_per_tick, const float *const left,
-    const float *const right, const int nCmdShow) {
-  // We need a minimum of two buffers.
-  // We also need a minimum of enough buffers for 100msec in my experience.
-  int buffers = ((int)ceil(max(1, 1.0 / 10 / (1.0 / ticks_per_second)))) + 1;
+    const int samples_per_tick, const run_event_loop_options *const options,
+    input_recording *const recording, const HANDLE audio_event,
+    const int nCmdShow) {
+  const int ticks_per_buffer = options->ticks_per_buffer;
+  const int audio_output = options->audio_output;
+  const int audio_format = options->audio_format;
+  const int audio_resampling = options->audio_resampling;
+  capture *const capture = options->capture;
+
+  LARGE_INTEGER performance_frequency;
+  QueryPerformanceFrequency(&performance_frequency);
+
+  const event_loop_timer timer = {
+      .state = &performance_frequency.QuadPart,
+      .now = now,
+  };
+
+  event_loop_core core;
+  event_loop_core_initialize(
+      &core, &timer, ticks_per_second, tick, video, samples_per_tick,
+      ticks_per_buffer, options->minimum_buffers, options->maximum_buffers,
+      options->maximum_ticks_per_batch, options->catch_up_policy, recording,
+      capture, options->statistics, GetTickCount());
+
+#ifdef PROFILER
+  core.profiler = &main_profiler;
+#endif
+
+  const int buffers = core.buffers;
+
+  // Each slot of the audio ring, and so each buffer given to the audio
+  // backend, holds the audio of several consecutive ticks.
+  const int samples_per_buffer = samples_per_tick * ticks_per_buffer;
+
+  // Enough slots are allocated up-front for the most which may be in flight,
+  // so that adapting never allocates.
+  const int audio_slots = core.maximum_buffers;
+
+  // Audio is only resampled where a whole number of the audio endpoint's
+  // samples make up each tick, so that every slot remains the same size.
+  // Otherwise, including when the rate cannot be determined, it is left to
+  // Windows.
+  uint32_t mix_rate = 0;
+  const bool resampling =
+      audio_resampling != AUDIO_RESAMPLING_MIXER &&
+      wasapi_audio_backend_mix_rate(&mix_rate) == NULL &&
+      mix_rate != (uint32_t)(samples_per_tick * ticks_per_second) &&
+      mix_rate % ticks_per_second == 0;
+  const int output_samples_per_tick =
+      resampling ? (int)mix_rate / ticks_per_second : samples_per_tick;
 
   const int bytes_per_row =
       opacities == NULL ? (int)GDI_WIDTHBYTES(columns * 24) : columns * 4;
 
   context context = {
-      .ticks_per_second = ticks_per_second,
-      .tick = tick,
+      .core = core,
       .rows = rows,
       .columns = columns,
       .skipped_bytes_per_row =
@@ -1113,46 +1441,62 @@ const char *run_event_loop(
       .reds = reds,
       .greens = greens,
       .blues = blues,
-      .video = video,
-      .samples_per_tick = samples_per_tick,
-      .left = left,
-      .right = right,
       .error = NULL,
       .scratch = malloc(sizeof(uint8_t) * rows * bytes_per_row +
-                        sizeof(float) * 2 * buffers * samples_per_tick +
-                        sizeof(WAVEHDR) * buffers),
-      .hwaveout = NULL,
-      .next_buffer = 0,
-      .buffers = buffers,
-      .minimum_position = 0,
-      .held_virtual_key_codes = NULL,
-      .number_of_held_virtual_key_codes = 0,
+                        sizeof(float) * 2 * audio_slots * samples_per_buffer),
+      .output_audio_backend =
+          select_output_audio_backend(&context, audio_output),
+      .audio_backend =
+          select_audio_backend(&context, audio_output, resampling),
+      .audio_open = false,
+      .clock =
+          {
+              .state = &context,
+              .get_position = get_audio_position,
+              .wait_for_refresh = wait_for_vertical_sync,
+          },
+      .audio_context =
+          {
+              .hwnd = NULL,
+              .audio_backend =
+                  select_audio_backend(&context, audio_output, resampling),
+              .event = audio_event,
+              .samples_per_tick = samples_per_tick,
+              .completed_buffers = 0,
+              .queueable_buffers = queueable_buffers(buffers),
+              .capacity = 0,
+              .underruns = 0,
+              .minimum_slack = INT_MAX,
+              .queued_buffers = 0,
+              .state = AUDIO_CONTEXT_STATE_STARTING,
+              .error = NULL,
+          },
       .position_x = 0,
       .position_y = 0,
-      .scaled_width = columns,
-      .scaled_height = rows,
-      .x_offset = 0,
-      .y_offset = 0,
-      .inverse_x_offset = 0,
-      .inverse_y_offset = 0,
-      .pointer_state = POINTER_STATE_NONE,
-      .pointer_row = 0.0f,
-      .pointer_column = 0.0f,
+      .insets = {0, 0, 0, 0},
+      .maximum_track_width = 0,
+      .maximum_track_height = 0,
+      .tracking_mouse = false,
+      .raw_pointer = options->raw_pointer,
+      .pointer_history_synchronized = false,
+      .resample_pointer_before_video = options->resample_pointer_before_video,
   };
 
+  viewport_initialize(&context.viewport, rows, columns);
+
   if (context.scratch == NULL) {
     return "Failed to allocate scratch memory.";
   }
 
-  RECT insets = {0, 0, 0, 0};
+  const char *const geometry_error = refresh_geometry(&context);
 
-  if (!AdjustWindowRect(&insets, opacities == NULL ? OPAQUE_WS : TRANSPARENT_WS,
-                        FALSE)) {
+  if (geometry_error != NULL) {
     free(context.scratch);
-
-    return "Failed to calculate the dimensions of the window.";
+    return geometry_error;
   }
 
+  const RECT insets = context.insets;
+
   HINSTANCE instance = GetModuleHandle(NULL);
 
   if (instance == NULL) {
@@ -1240,137 +1584,107 @@ const char *run_event_loop(
     refresh_layered(hwnd, &context);
   }
 
-  const WAVEFORMATEX wave_format = {
-      WAVE_FORMAT_IEEE_FLOAT,
-      2,
-      samples_per_tick * ticks_per_second,
-      2 * sizeof(float) * samples_per_tick * ticks_per_second,
-      2 * sizeof(float),
-      sizeof(float) * 8,
-      0,
-  };
+  const char *open_error =
+      audio_output == AUDIO_OUTPUT_WAVE_OUT
+          ? wave_out_audio_backend_open(
+                &context.wave_out_audio_backend, audio_event,
+                output_samples_per_tick * ticks_per_second, audio_slots,
+                output_samples_per_tick * ticks_per_buffer, audio_format)
+          : wasapi_audio_backend_open(
+                &context.wasapi_audio_backend, audio_event,
+                output_samples_per_tick * ticks_per_second, audio_slots,
+                output_samples_per_tick * ticks_per_buffer, audio_format,
+                audio_output == AUDIO_OUTPUT_WASAPI_LOW_LATENCY);
+
+  // Should this fail, it closes the audio output itself.
+  if (open_error == NULL && resampling) {
+    open_error = resampling_audio_backend_open(
+        &context.resampling_audio_backend, &context.output_audio_backend,
+        audio_slots, samples_per_buffer,
+        output_samples_per_tick * ticks_per_buffer,
+        select_resampler_quality(audio_resampling));
+  }
 
-  if (waveOutOpen(&context.hwaveout, WAVE_MAPPER, &wave_format, (DWORD_PTR)hwnd,
-                  (DWORD_PTR)&context, CALLBACK_WINDOW) != MMSYSERR_NOERROR) {
+  if (open_error != NULL) {
     if (DestroyWindow(hwnd) || GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
       free(context.scratch);
 
       if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-        return "Failed to open wave out.";
+        return open_error;
       } else {
-        return "Failed to open wave out.  Additionally failed to unregister "
-               "the window class.";
+        return "Failed to open the audio output.  Additionally failed to "
+               "unregister the window class.";
       }
     } else {
       free(context.scratch);
 
       if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-        return "Failed to open wave out.  Additionally failed to destroy the "
-               "window.";
+        return "Failed to open the audio output.  Additionally failed to "
+               "destroy the window.";
       } else {
-        return "Failed to open wave out.  Additionally failed to destroy the "
-               "window and unregister the window class.";
+        return "Failed to open the audio output.  Additionally failed to "
+               "destroy the window and unregister the window class.";
       }
     }
   }
 
-  if (waveOutPause(context.hwaveout) != MMSYSERR_NOERROR) {
-    if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
-      if (DestroyWindow(hwnd) ||
-          GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
-        free(context.scratch);
+  context.audio_open = true;
+  context.audio_context.capacity =
+      (int)context.audio_backend.get_capacity(context.audio_backend.state);
 
-        if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to pause wave out.";
-        } else {
-          return "Failed to pause wave out.  Additionally failed to unregister "
-                 "the window class.";
-        }
-      } else {
-        free(context.scratch);
+  float *const start_of_buffers =
+      (float *)(((uint8_t *)context.scratch) + rows * bytes_per_row);
 
-        if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to pause wave out.  Additionally failed to destroy "
-                 "the window.";
-        } else {
-          return "Failed to pause wave out.  Additionally failed to destroy "
-                 "the window and unregister the window class.";
-        }
-      }
-    } else {
-      if (DestroyWindow(hwnd) ||
-          GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
-        free(context.scratch);
+  audio_ring *const audio_ring = &context.audio_context.audio_ring;
+  audio_ring_initialize(audio_ring, start_of_buffers, audio_slots,
+                        samples_per_buffer * 2);
 
-        if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to pause wave out.  Additionally failed to close wave "
-                 "out.";
-        } else {
-          return "Failed to pause wave out.  Additionally failed to close wave "
-                 "out and unregister the window class.";
-        }
-      } else {
-        free(context.scratch);
+  // Every slot is prepared, but only those which may initially be queued are
+  // submitted; the rest of those initially in flight wait in the ring.
+  const int initially_queued_buffers =
+      queueable_buffers(buffers) < context.audio_context.capacity
+          ? queueable_buffers(buffers)
+          : context.audio_context.capacity;
 
-        if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to pause wave out.  Additionally failed to close wave "
-                 "out and destroy the window.";
-        } else {
-          return "Failed to pause wave out.  Additionally failed to close wave "
-                 "out, destroy the window and unregister the window class.";
-        }
-      }
-    }
-  }
+  event_loop_core_prime(&context.core, audio_ring);
+  context.error = context.core.error;
 
-  float *buffer =
-      (float *)(((uint8_t *)context.scratch) + rows * bytes_per_row);
-  WAVEHDR *const first_wavehdr =
-      (WAVEHDR *)(buffer + buffers * samples_per_tick * 2);
-  WAVEHDR *wavehdr = first_wavehdr;
-
-  for (int buffer_index = 0; buffer_index < buffers; buffer_index++) {
-    tick(&context, POINTER_STATE_NONE, 0, 0, key_held);
-
-    wavehdr->lpData = (LPSTR)buffer;
-    wavehdr->dwBufferLength = samples_per_tick * 2 * sizeof(float);
-    wavehdr->dwBytesRecorded = 0;
-    wavehdr->dwUser = 0;
-    wavehdr->dwFlags = WHDR_DONE;
-    wavehdr->dwLoops = 0;
-    wavehdr->lpNext = NULL;
-    wavehdr->reserved = 0;
-
-    for (int index = 0; index < samples_per_tick; index++) {
-      *buffer = left[index];
-      buffer++;
-      *buffer = right[index];
-      buffer++;
+  for (int buffer_index = 0; buffer_index < audio_slots; buffer_index++) {
+    float *const buffer = audio_ring_slot(audio_ring, buffer_index);
+
+    const char *audio_error = context.audio_backend.prepare(
+        context.audio_backend.state, buffer_index, buffer);
+
+    if (audio_error == NULL && buffer_index < initially_queued_buffers) {
+      uint32_t slot;
+      audio_ring_begin_read(audio_ring, &slot);
+      audio_error =
+          context.audio_backend.submit(context.audio_backend.state, slot,
+                                       buffer);
     }
 
-    if (waveOutPrepareHeader(context.hwaveout, wavehdr, sizeof(WAVEHDR)) !=
-        MMSYSERR_NOERROR) {
-      if (waveOutReset(context.hwaveout) == MMSYSERR_NOERROR) {
-        if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+    if (audio_error != NULL) {
+      if (context.audio_backend.reset(context.audio_backend.state) == NULL) {
+        if (context.audio_backend.close(context.audio_backend.state) == NULL) {
           if (DestroyWindow(hwnd) ||
               GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.";
+              return audio_error;
             } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "unregister the window class.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to unregister the window class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "destroy the window.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to destroy the window.";
             } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "destroy the window and unregister the window class.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to destroy the window and unregister the window class.";
             }
           }
         } else {
@@ -1379,202 +1693,110 @@ const char *run_event_loop(
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "close wave out.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to close the audio output.";
             } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "close wave out and unregister the window class.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to close the audio output and unregister the window "
+                     "class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "close wave out and destroy the window.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to close the audio output and destroy the window.";
             } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "close wave out, destroy the window and unregister the "
-                     "window class.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to close the audio output, destroy the window and "
+                     "unregister the window class.";
             }
           }
         }
       } else {
-        // In the event this fails, we can't unprepare wave outs safely.
+        // In the event this fails, the audio output cannot be closed cleanly.
         // The process is probably about to close in any case.
 
-        if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
-          if (DestroyWindow(hwnd) ||
-              GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out.";
-            } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out and unregister the window class.";
-            }
-          } else {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out and destroy the window.";
-            } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out, destroy the window and unregister the "
-                     "window class.";
-            }
-          }
-        } else {
+        if (context.audio_backend.close(context.audio_backend.state) == NULL) {
           if (DestroyWindow(hwnd) ||
               GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out and close wave out.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output.";
             } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out, close wave out and unregister the window "
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output and unregister the window "
                      "class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out, close wave out and destroy the window.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output and destroy the window.";
             } else {
-              return "Failed to prepare wave out.  Additionally failed to "
-                     "reset wave out, close wave out, destroy the window and "
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output, destroy the window and "
                      "unregister the window class.";
             }
           }
-        }
-      }
-    }
-
-    if (waveOutWrite(context.hwaveout, wavehdr, sizeof(WAVEHDR)) !=
-        MMSYSERR_NOERROR) {
-      if (waveOutReset(context.hwaveout) == MMSYSERR_NOERROR) {
-        if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+        } else {
           if (DestroyWindow(hwnd) ||
               GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.";
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output and close the audio output.";
             } else {
-              return "Failed to write wave out.  Additionally failed to "
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output, close the audio output and "
                      "unregister the window class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to "
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output, close the audio output and "
                      "destroy the window.";
             } else {
-              return "Failed to write wave out.  Additionally failed to "
+              return "Failed to start the audio output.  Additionally failed "
+                     "to reset the audio output, close the audio output, "
                      "destroy the window and unregister the window class.";
             }
           }
-        } else {
-          if (DestroyWindow(hwnd) ||
-              GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to close "
-                     "wave out.";
-            } else {
-              return "Failed to write wave out.  Additionally failed to close "
-                     "wave out and unregister the window class.";
-            }
-          } else {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to close "
-                     "wave out and destroy the window.";
-            } else {
-              return "Failed to write wave out.  Additionally failed to close "
-                     "wave out, destroy the window and unregister the window "
-                     "class.";
-            }
-          }
-        }
-      } else {
-        // In the event this fails, we can't unprepare wave outs safely.
-        // The process is probably about to close in any case.
-
-        if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
-          if (DestroyWindow(hwnd) ||
-              GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out.";
-            } else {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out and unregister the window class.";
-            }
-          } else {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out and destroy the window.";
-            } else {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out, destroy the window and unregister the window "
-                     "class.";
-            }
-          }
-        } else {
-          if (DestroyWindow(hwnd) ||
-              GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out and close wave out.";
-            } else {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out, close wave out and unregister the window "
-                     "class.";
-            }
-          } else {
-            free(context.scratch);
-
-            if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out, close wave out and destroy the window.";
-            } else {
-              return "Failed to write wave out.  Additionally failed to reset "
-                     "wave out, close wave out, destroy the window and "
-                     "unregister the window class.";
-            }
-          }
         }
       }
     }
-
-    wavehdr++;
   }
 
-  vsync_context vc = {
-      .hwnd = hwnd, .state = VSYNC_CONTEXT_STATE_STARTING, .error = NULL};
+  context.audio_context.hwnd = hwnd;
+  context.audio_context.queued_buffers = initially_queued_buffers;
+
+  vsync_context vc = {.hwnd = hwnd,
+                      .clock = context.clock,
+                      .state = VSYNC_CONTEXT_STATE_STARTING,
+                      .error = NULL};
 
   InitializeCriticalSection(&vc.critical_section);
 
   CreateThread(NULL, 0, vsync_thread, &vc, 0, NULL);
 
+  InitializeCriticalSection(&context.audio_context.critical_section);
+
+  CreateThread(NULL, 0, audio_thread, &context.audio_context, 0, NULL);
+
   ShowWindow(hwnd, nCmdShow);
 
-  if (waveOutRestart(context.hwaveout) != MMSYSERR_NOERROR) {
+  const char *const resume_error =
+      context.audio_backend.resume(context.audio_backend.state);
+
+  if (resume_error != NULL) {
+    stop_audio_thread(&context.audio_context);
+
     EnterCriticalSection(&vc.critical_section);
 
     if (vc.state != VSYNC_CONTEXT_STATE_STOPPED) {
@@ -1593,27 +1815,27 @@ const char *run_event_loop(
     DeleteCriticalSection(&vc.critical_section);
 
     if (vc.error == NULL) {
-      if (waveOutReset(context.hwaveout) == MMSYSERR_NOERROR) {
-        if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+      if (context.audio_backend.reset(context.audio_backend.state) == NULL) {
+        if (context.audio_backend.close(context.audio_backend.state) == NULL) {
           if (DestroyWindow(hwnd) ||
               GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.";
+              return resume_error;
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "unregister the window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to unregister the window class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "destroy the window.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to destroy the window.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "destroy the window and unregister the window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to destroy the window and unregister the window class.";
             }
           }
         } else {
@@ -1622,51 +1844,53 @@ const char *run_event_loop(
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "close wave out.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to close the audio output.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "close wave out and unregister the window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to close the audio output and unregister the window "
+                     "class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "close wave out and destroy the window.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to close the audio output and destroy the window.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "close wave out, destroy the window and unregister the "
-                     "window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to close the audio output, destroy the window and "
+                     "unregister the window class.";
             }
           }
         }
       } else {
-        // In the event this fails, we can't unprepare wave outs safely.
+        // In the event this fails, the audio output cannot be closed cleanly.
         // The process is probably about to close in any case.
 
-        if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+        if (context.audio_backend.close(context.audio_backend.state) == NULL) {
           if (DestroyWindow(hwnd) ||
               GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out and unregister the window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output and unregister the window "
+                     "class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out and destroy the window.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output and destroy the window.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out, destroy the window and unregister the "
-                     "window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output, destroy the window and "
+                     "unregister the window class.";
             }
           }
         } else {
@@ -1675,51 +1899,54 @@ const char *run_event_loop(
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out and close wave out.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output and close the audio output.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out, close wave out and unregister the window "
-                     "class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output, close the audio output and "
+                     "unregister the window class.";
             }
           } else {
             free(context.scratch);
 
             if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out, close wave out and destroy the window.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output, close the audio output and "
+                     "destroy the window.";
             } else {
-              return "Failed to restart wave out.  Additionally failed to "
-                     "reset wave out, close wave out, destroy the window and "
-                     "unregister the window class.";
+              return "Failed to resume the audio output.  Additionally failed "
+                     "to reset the audio output, close the audio output, "
+                     "destroy the window and unregister the window class.";
             }
           }
         }
       }
-    } else if (waveOutReset(context.hwaveout) == MMSYSERR_NOERROR) {
-      if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+    } else if (context.audio_backend.reset(context.audio_backend.state) ==
+               NULL) {
+      if (context.audio_backend.close(context.audio_backend.state) == NULL) {
         if (DestroyWindow(hwnd) ||
             GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  An error additionally "
+            return "Failed to resume the audio output.  An error additionally "
                    "occurred in the vsync thread.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread and while unregistering the window "
-                   "class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread and while unregistering the "
+                   "window class.";
           }
         } else {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread and while destroying the window.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread and while destroying the "
+                   "window.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while destroying the window and "
-                   "unregistering the window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while destroying the window "
+                   "and unregistering the window class.";
           }
         }
       } else {
@@ -1728,55 +1955,59 @@ const char *run_event_loop(
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread and while closing wave out.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread and while closing the audio "
+                   "output.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while closing wave out and "
-                   "unregistering the window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while closing the audio "
+                   "output and unregistering the window class.";
           }
         } else {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while closing wave out and destroying "
-                   "the window.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while closing the audio "
+                   "output and destroying the window.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while closing wave out, destroying "
-                   "the window and unregistering the window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while closing the audio "
+                   "output, destroying the window and unregistering the window "
+                   "class.";
           }
         }
       }
     } else {
-      // In the event this fails, we can't unprepare wave outs safely.
+      // In the event this fails, the audio output cannot be closed cleanly.
       // The process is probably about to close in any case.
 
-      if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+      if (context.audio_backend.close(context.audio_backend.state) == NULL) {
         if (DestroyWindow(hwnd) ||
             GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread and while resetting wave out.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread and while resetting the audio "
+                   "output.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while restting wave out and "
-                   "unregistering the window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while restting the audio "
+                   "output and unregistering the window class.";
           }
         } else {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while resetting wave out and "
-                   "destroying the window.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while resetting the audio "
+                   "output and destroying the window.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while resetting wave out, destroying "
-                   "the window and unregistering the window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while resetting the audio "
+                   "output, destroying the window and unregistering the window "
+                   "class.";
           }
         }
       } else {
@@ -1785,26 +2016,28 @@ const char *run_event_loop(
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while resetting wave out and closing "
-                   "wave out.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while resetting the audio "
+                   "output and closing the audio output.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while restting wave out, closing wave "
-                   "out and unregistering the window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while restting the audio "
+                   "output, closing the audio output and unregistering the "
+                   "window class.";
           }
         } else {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while retting wave out, closing wave "
-                   "out and destroying the window.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while retting the audio "
+                   "output, closing the audio output and destroying the "
+                   "window.";
           } else {
-            return "Failed to restart wave out.  Errors additionally occurred "
-                   "in the vsync thread, while resetting wave out, closing "
-                   "wave out, destroing the window and unregistering the "
-                   "window class.";
+            return "Failed to resume the audio output.  Errors additionally "
+                   "occurred in the vsync thread, while resetting the audio "
+                   "output, closing the audio output, destroing the window and "
+                   "unregistering the window class.";
           }
         }
       }
@@ -1816,7 +2049,9 @@ const char *run_event_loop(
 
     while (GetMessage(&msg, hwnd, 0, 0)) {
       TranslateMessage(&msg);
+      PROFILER_BEGIN(dispatch);
       DispatchMessage(&msg);
+      PROFILER_END(&main_profiler, PROFILER_PHASE_DISPATCH, dispatch);
 
       if (context.error != NULL) {
         break;
@@ -1824,8 +2059,15 @@ const char *run_event_loop(
     }
   }
 
-  if (waveOutReset(context.hwaveout) != MMSYSERR_NOERROR) {
-    // In the event this fails, we can't unprepare wave outs safely.
+  // The audio thread must not refill the buffers which resetting the audio
+  // output marks as done.
+  stop_audio_thread(&context.audio_context);
+
+  const char *const reset_error =
+      context.audio_backend.reset(context.audio_backend.state);
+
+  if (reset_error != NULL) {
+    // In the event this fails, the audio output cannot be closed cleanly.
     // The process is probably about to close in any case.
 
     EnterCriticalSection(&vc.critical_section);
@@ -1846,26 +2088,26 @@ const char *run_event_loop(
     DeleteCriticalSection(&vc.critical_section);
 
     if (vc.error == NULL) {
-      if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+      if (context.audio_backend.close(context.audio_backend.state) == NULL) {
         if (DestroyWindow(hwnd) ||
             GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to reset wave out.";
+            return reset_error;
           } else {
-            return "Failed to reset wave out.  Additionally failed to "
+            return "Failed to reset the audio output.  Additionally failed to "
                    "unregister the window class.";
           }
         } else {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to reset wave out.  Additionally failed to destroy "
-                   "the window.";
+            return "Failed to reset the audio output.  Additionally failed to "
+                   "destroy the window.";
           } else {
-            return "Failed to reset wave out.  Additionally failed to destroy "
-                   "the window and unregister the window class.";
+            return "Failed to reset the audio output.  Additionally failed to "
+                   "destroy the window and unregister the window class.";
           }
         }
       } else {
@@ -1874,47 +2116,50 @@ const char *run_event_loop(
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to reset wave out.  Additionally failed to close "
-                   "wave out.";
+            return "Failed to reset the audio output.  Additionally failed to "
+                   "close the audio output.";
           } else {
-            return "Failed to reset wave out.  Additionally failed to close "
-                   "wave out and unregister the window class.";
+            return "Failed to reset the audio output.  Additionally failed to "
+                   "close the audio output and unregister the window class.";
           }
         } else {
           free(context.scratch);
 
           if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-            return "Failed to reset wave out.  Additionally failed to close "
-                   "wave out and destroy the window.";
+            return "Failed to reset the audio output.  Additionally failed to "
+                   "close the audio output and destroy the window.";
           } else {
-            return "Failed to reset wave out.  Additionally failed to close "
-                   "wave out, destroy the window and unregister the window "
-                   "class.";
+            return "Failed to reset the audio output.  Additionally failed to "
+                   "close the audio output, destroy the window and unregister "
+                   "the window class.";
           }
         }
       }
-    } else if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+    } else if (context.audio_backend.close(context.audio_backend.state) ==
+               NULL) {
       if (DestroyWindow(hwnd) ||
           GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
         free(context.scratch);
 
         if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to reset wave out.  An error additionally occurred in "
-                 "the vsync thread.";
+          return "Failed to reset the audio output.  An error additionally "
+                 "occurred in the vsync thread.";
         } else {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread and while unregistering the window class.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread and while unregistering the "
+                 "window class.";
         }
       } else {
         free(context.scratch);
 
         if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread and while destroying the window.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread and while destroying the "
+                 "window.";
         } else {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread, while destroying the window and "
-                 "unregistering the window class.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread, while destroying the window "
+                 "and unregistering the window class.";
         }
       }
     } else {
@@ -1923,24 +2168,26 @@ const char *run_event_loop(
         free(context.scratch);
 
         if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread and while closing wave out.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread and while closing the audio "
+                 "output.";
         } else {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread, while cling wave out and unregistering the "
-                 "window class.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread, while cling the audio output "
+                 "and unregistering the window class.";
         }
       } else {
         free(context.scratch);
 
         if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread, while closing wave out and destroying the "
-                 "window.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread, while closing the audio output "
+                 "and destroying the window.";
         } else {
-          return "Failed to reset wave out.  Errors additionally occurred in "
-                 "the vsync thread, while closing wave out, destroying the "
-                 "window and unregistering the window class.";
+          return "Failed to reset the audio output.  Errors additionally "
+                 "occurred in the vsync thread, while closing the audio "
+                 "output, destroying the window and unregistering the window "
+                 "class.";
         }
       }
     }
@@ -1970,7 +2217,7 @@ const char *run_event_loop(
   DeleteCriticalSection(&vc.critical_section);
 
   if (vc.error != NULL) {
-    if (waveOutClose(context.hwaveout) == MMSYSERR_NOERROR) {
+    if (context.audio_backend.close(context.audio_backend.state) == NULL) {
       return vc.error;
     } else {
       if (DestroyWindow(hwnd) ||
@@ -1979,45 +2226,48 @@ const char *run_event_loop(
 
         if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
           return "An error occurred in the vsync thread.  Additionally failed "
-                 "to close wave out.";
+                 "to close the audio output.";
         } else {
           return "An error occurred in the vsync thread.  Additionally failed "
-                 "to close wave out and unregister the window class.";
+                 "to close the audio output and unregister the window class.";
         }
       } else {
         free(context.scratch);
 
         if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
           return "An error occurred in the vsync thread.  Additionally failed "
-                 "to close wave out and destroy the window.";
+                 "to close the audio output and destroy the window.";
         } else {
           return "An error occurred in the vsync thread.  Additionally failed "
-                 "to close wave out, destroy the window and unregister the "
-                 "window class.";
+                 "to close the audio output, destroy the window and unregister "
+                 "the window class.";
         }
       }
     }
   }
 
-  if (waveOutClose(context.hwaveout) != MMSYSERR_NOERROR) {
+  const char *const close_error =
+      context.audio_backend.close(context.audio_backend.state);
+
+  if (close_error != NULL) {
     if (DestroyWindow(hwnd) || GetLastError() == ERROR_INVALID_WINDOW_HANDLE) {
       free(context.scratch);
 
       if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-        return "Failed to close wave out.";
+        return close_error;
       } else {
-        return "Failed to close wave out.  Additionally failed to unregister "
-               "the window class.";
+        return "Failed to close the audio output.  Additionally failed to "
+               "unregister the window class.";
       }
     } else {
       free(context.scratch);
 
       if (UnregisterClass(wc.lpszClassName, wc.hInstance)) {
-        return "Failed to close wave out.  Additionally failed to destroy the "
-               "window.";
+        return "Failed to close the audio output.  Additionally failed to "
+               "destroy the window.";
       } else {
-        return "Failed to close wave out.  Additionally failed to destroy the "
-               "window and unregister the window class.";
+        return "Failed to close the audio output.  Additionally failed to "
+               "destroy the window and unregister the window class.";
       }
     }
   }
@@ -2041,3 +2291,83 @@ const char *run_event_loop(
 
   return context.error;
 }
+
+#ifdef PROFILER
+
+const char *run_event_loop_write_trace(const char *const path) {
+  profiler_ring *const profiler_rings[] = {&main_profiler, &audio_profiler,
+                                           &vsync_profiler};
+
+  return profiler_write_trace(path, profiler_rings, 3);
+}
+
+#endif
+
+const char *run_event_loop(
+    const char *const title, const int ticks_per_second,
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows,
+    const int columns, const float *const opacities, const float *const reds,
+    const float *const greens, const float *const blues,
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const run_event_loop_options *const options,
+    const int nCmdShow) {
+  run_event_loop_options resolved = {0};
+
+  if (options != NULL) {
+    resolved = *options;
+  }
+
+  if (resolved.ticks_per_buffer == 0) {
+    resolved.ticks_per_buffer = 1;
+  }
+
+  if (resolved.minimum_buffers == 0) {
+    resolved.minimum_buffers = 2;
+  }
+
+  if (resolved.maximum_ticks_per_batch == 0) {
+    resolved.maximum_ticks_per_batch = INT_MAX;
+  }
+
+  // The audio backend signals this whenever it may be ready for more audio.
+  const HANDLE audio_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+  if (audio_event == NULL) {
+    return "Failed to create an event for the audio output.";
+  }
+
+  const char *error;
+
+  if (resolved.recording_path == NULL) {
+    error = run_window(title, ticks_per_second, tick, rows, columns, opacities,
+                       reds, greens, blues, video, samples_per_tick, &resolved,
+                       NULL, audio_event, nCmdShow);
+  } else {
+    input_recording recording;
+
+    error = input_recording_open(&recording, resolved.recording_path, true);
+
+    if (error == NULL) {
+      error = run_window(title, ticks_per_second, tick, rows, columns,
+                         opacities, reds, greens, blues, video,
+                         samples_per_tick, &resolved, &recording, audio_event,
+                         nCmdShow);
+
+      const char *const close_error = input_recording_close(&recording);
+
+      // Only one message can be returned; should both fail, the reason the
+      // event loop stopped is the more useful of the two.
+      if (error == NULL) {
+        error = close_error;
+      }
+    }
+  }
+
+  if (!CloseHandle(audio_event) && error == NULL) {
+    return "Failed to close the event for the audio output.";
+  }
+
+  return error;
+}
@@ -2,43 +2,181 @@
 
 #define RUN_EVENT_LOOP_H
 
+#include "audio_backend.h"
+#include "capture.h"
+#include "event_loop_core.h"
+#include "input.h"
+#include "profiler.h"
+#include "scheduler.h"
 #include <stdbool.h>
-#include <windows.h>
+#include <stdint.h>
 
 /**
- * There is no currently known pointer.  For example, the device may only have
- * a touch screen, with no manipulation currently occurring.  The pointer
- * coordinates are undefined.
+ * Audio is played through wave out, and so the legacy mixer.  Available
+ * everywhere, but adds tens of milliseconds of latency.
  */
-#define POINTER_STATE_NONE 0
+#define AUDIO_OUTPUT_WAVE_OUT 0
 
 /**
- * The location of the pointer is known, but the user is not currently
- * indicating that they wish to select what it overlaps, if anything.  For
- * example, the device may have a mouse for which the primary button is not
- * pressed, some kind of pen input which is hovering over the display or a light
- * gun which which is tracking position without the trigger being pulled.  The
- * pointer coordinates are likely to fall in the range 0 ... rows/columns, but
- * may fall outside that range.
+ * Audio is played through shared-mode WASAPI, which wakes the audio thread each
+ * time the audio engine processes audio.
  */
-#define POINTER_STATE_HOVER 1
+#define AUDIO_OUTPUT_WASAPI 1
 
 /**
- * The location of the pointer is known, and the user is currently indicating
- * that they wish to select what it overlaps, if anything.  For example, the
- * device may have a mouse for which the primary button is pressed, some kind of
- * pen input which is currently making contact with the display or a light gun
- * for which the trigger is being pulled.  The pointer coordinates are likely to
- * fall in the range 0 ... rows/columns, but may fall outside that range.
+ * As AUDIO_OUTPUT_WASAPI, but the audio engine is additionally asked to process
+ * audio in the smallest periods the audio endpoint supports.  Falls back to
+ * AUDIO_OUTPUT_WASAPI where this is unsupported.  This may limit how many ticks
+ * of audio can be queued with the audio engine; any beyond that wait in a ring
+ * until there is room.
  */
-#define POINTER_STATE_SELECT 2
+#define AUDIO_OUTPUT_WASAPI_LOW_LATENCY 2
+
+/**
+ * Audio is given to the audio output at the rate at which it is generated, and
+ * Windows resamples it to the rate of the audio endpoint as needed, with
+ * whatever latency and quality it sees fit.
+ */
+#define AUDIO_RESAMPLING_MIXER 0
+
+/**
+ * Where the audio endpoint's rate differs from the rate at which audio is
+ * generated, and a whole number of its samples make up each tick, audio is
+ * resampled to it using RESAMPLER_QUALITY_LOW before being given to the audio
+ * output.  Otherwise, as AUDIO_RESAMPLING_MIXER.
+ */
+#define AUDIO_RESAMPLING_LOW 1
+
+/**
+ * As AUDIO_RESAMPLING_LOW, but using RESAMPLER_QUALITY_MEDIUM.
+ */
+#define AUDIO_RESAMPLING_MEDIUM 2
+
+/**
+ * As AUDIO_RESAMPLING_LOW, but using RESAMPLER_QUALITY_HIGH.
+ */
+#define AUDIO_RESAMPLING_HIGH 3
+
+/**
+ * Settings of run_event_loop which most applications can leave alone.  Every
+ * field is optional; any left zeroed (e.g. by omitting it from a designated
+ * initializer) takes the default described.
+ */
+typedef struct {
+  /**
+   * The number of consecutive ticks whose audio is given to the audio device
+   * as a single buffer.  Values greater than 1 reduce the number of calls into
+   * the audio device at high tick rates, at the cost of ticks then being
+   * executed in groups of this many, and of video being given progress through
+   * the current group rather than the current tick.  Defaults to 1.  Behavior
+   * is undefined if negative.
+   */
+  int ticks_per_buffer;
+
+  /**
+   * The fewest buffers of audio which may be queued for output.  Ignored when
+   * maximum_buffers is 0.  Defaults to 2.  Behavior is undefined if otherwise
+   * less than 2.
+   */
+  int minimum_buffers;
+
+  /**
+   * The most buffers of audio which may be queued for output.  Within these
+   * bounds, the number queued grows whenever the audio device runs dry and
+   * shrinks once one has consistently gone unused, seeking the lowest stable
+   * latency.  When 0, a fixed number giving roughly 100msec of latency is
+   * queued instead.  Behavior is undefined if otherwise less than
+   * minimum_buffers.
+   */
+  int maximum_buffers;
+
+  /**
+   * The maximum number of ticks which may be executed back-to-back when the
+   * event loop has fallen behind (e.g. following a slow video event).  Rounded
+   * down to a whole number of buffers, but never fewer than one.  When 0, there
+   * is no limit.  Behavior is undefined if negative.
+   */
+  int maximum_ticks_per_batch;
+
+  /**
+   * What to do with ticks which are due beyond the limit on ticks per batch.
+   * Defaults to CATCH_UP_POLICY_DROP.  Behavior is undefined if not a
+   * CATCH_UP_POLICY_* constant.
+   */
+  int catch_up_policy;
+
+  /**
+   * How audio is to be played.  Defaults to AUDIO_OUTPUT_WAVE_OUT.  Behavior
+   * is undefined if not an AUDIO_OUTPUT_* constant.
+   */
+  int audio_output;
+
+  /**
+   * The format in which audio is to be played.  Ticks always generate
+   * floating-point audio, which is converted as needed.  Defaults to
+   * AUDIO_FORMAT_FLOAT.  Behavior is undefined if not an AUDIO_FORMAT_*
+   * constant.
+   */
+  int audio_format;
+
+  /**
+   * Whether, and at what quality, audio is to be resampled to the rate of the
+   * audio endpoint before being given to the audio output.  Defaults to
+   * AUDIO_RESAMPLING_MIXER.  Behavior is undefined if not an
+   * AUDIO_RESAMPLING_* constant.
+   */
+  int audio_resampling;
+
+  /**
+   * When true, every movement of the mouse between ticks is delivered as an
+   * input event, rather than only those which survive the coalescing of
+   * WM_MOUSEMOVE.
+   */
+  bool raw_pointer;
+
+  /**
+   * When true, the location of the pointer is sampled again immediately
+   * before each video event rather than taken from the last message about it,
+   * reducing latency.
+   */
+  bool resample_pointer_before_video;
+
+  /**
+   * When non-null, the null-terminated path to a file to which the input given
+   * to each tick is recorded, so that it may later be replayed using
+   * run_replay.  It is closed when the window is closed.
+   */
+  const char *recording_path;
+
+  /**
+   * When non-null, the audio of each tick and each frame of video once
+   * rendered are copied to this open capture, to be written to disk in the
+   * background.  It is closed when the window is closed, as the process then
+   * exits.
+   */
+  capture *capture;
+
+  /**
+   * When non-null, counters within are updated as the event loop runs.  They
+   * are not reset first.
+   */
+  event_loop_statistics *statistics;
+} run_event_loop_options;
 
 /**
  * Runs an application event loop, blocking until the window is closed by the
  * user or an error occurs.
  * @param title The null-terminated UTF-8-encoded title of the application.
  * @param ticks_per_second The number of tick events raised each second.
- * @param tick Called each time a tick event occurs.
+ * @param tick Called each time a tick event occurs, with the state of user
+ *             input at that time and the audio to play until the next tick,
+ *             to be written to.  This is interleaved stereo (left then right),
+ *             samples_per_tick pairs from sooner to later, and is part of the
+ *             very buffer which is passed to the audio device, so its
+ *             previous contents are undefined and it must be completely
+ *             overwritten.
+ *             Behavior is undefined if any are NaN, less than -1 or greater
+ *             than 1.
  * @param rows The height of the viewport in rows.  Behavior is undefined if
  *             less than 1.
  * @param columns The width of the viewport in columns.  Behavior is undefined
@@ -62,35 +200,42 @@
  *              viewport, row-major, starting from the top left corner.
  *              Behavior is undefined if any are NaN, less than 0 or greater
  *              than 1.
- * @param video Called each time the viewport needs to be refreshed.  May be
- *              called prior to the first tick event.
- * @param samples_per_tick The number of audio samples generated each tick.
- *                         Behavior is undefined if less than 1.
- * @param left The left channel of the audio output, from sooner to later.
- *             Behavior is undefined if any are NaN, less than -1 or greater
- *             than 1.  Will not be output prior to the first tick.
- * @param right The right channel of the audio output, from sooner to later.
- *              Behavior is undefined if any are NaN, less than -1 or greater
- *              than 1.  Will not be output prior to the first tick.
+ * @param video Called each time the viewport needs to be refreshed, with the
+ *              state of user input at that time and the progress through the
+ *              current tick.  May be called prior to the first tick event.
+ * @param samples_per_tick The number of audio samples generated each tick, per
+ *                         channel.  Behavior is undefined if less than 1.
+ * @param options The remaining settings.  When NULL, every one takes its
+ *                default.
  * @param nCmdShow As received by WinMain.
  * @return In the event of an error, a null-terminated UTF-8-encoded error
  *         message describing the problem, otherwise, null.
  */
 const char *run_event_loop(
     const char *const title, const int ticks_per_second,
-    void (*const tick)(const void *const context, const int pointer_state,
-                       const float pointer_row, const float pointer_column,
-                       bool (*const key_held)(const void *const context,
-                                              const WPARAM virtual_key_code)),
-    const int rows, const int columns, const float *const opacities,
-    const float *const reds, const float *const greens,
-    const float *const blues,
-    void (*const video)(const void *const context, const int pointer_state,
-                        const float pointer_row, const float pointer_column,
-                        bool (*const key_held)(const void *const context,
-                                               const WPARAM virtual_key_code),
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows,
+    const int columns, const float *const opacities, const float *const reds,
+    const float *const greens, const float *const blues,
+    void (*const video)(const input *const input,
                         const float tick_progress_unit_interval),
-    const int samples_per_tick, const float *const left,
-    const float *const right, const int nCmdShow);
+    const int samples_per_tick, const run_event_loop_options *const options,
+    const int nCmdShow);
+
+#ifdef PROFILER
+
+/**
+ * Writes every span the threads of run_event_loop have recorded since the
+ * trace was last written to a file in Chrome's trace event format, emptying
+ * their profiler rings.  Whatever remains is also written to
+ * PROFILER_TRACE_PATH ("trace.json" unless defined otherwise) when the window
+ * closes.  Only available when PROFILER is defined.
+ * @param path The null-terminated path to the file to (re)write.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *run_event_loop_write_trace(const char *const path);
+
+#endif
 
 #endif
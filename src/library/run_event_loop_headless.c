@@ -0,0 +1,160 @@
+#include "run_event_loop_headless.h"
+#include "event_loop_core.h"
+#include "input.h"
+#include "profiler.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static int64_t wall_time(void *const state) {
+  (void)state;
+
+  const int64_t now = profiler_now();
+  const int64_t frequency = profiler_frequency();
+
+  // Split to avoid overflowing.
+  return now / frequency * 1000000 + now % frequency * 1000000 / frequency;
+}
+
+// The callbacks given to run_event_loop_headless, which take no state.
+typedef struct {
+  void (*const tick)(const input *const input, float *const audio);
+  void (*const video)(const input *const input,
+                      const float tick_progress_unit_interval);
+} stateless_callbacks;
+
+static void stateless_tick(void *const state, const input *const input,
+                           float *const audio) {
+  ((const stateless_callbacks *)state)->tick(input, audio);
+}
+
+static void stateless_video(void *const state, const input *const input,
+                            const float tick_progress_unit_interval) {
+  ((const stateless_callbacks *)state)
+      ->video(input, tick_progress_unit_interval);
+}
+
+static double per_second(const uint64_t events, const int64_t microseconds) {
+  if (events == 0 || microseconds <= 0) {
+    return 0;
+  }
+
+  return (double)events * 1000000.0 / (double)microseconds;
+}
+
+const char *run_headless_application(
+    const headless_application *const application, const uint32_t ticks,
+    const uint32_t frames, const headless_output *const output,
+    const event_loop_timer *const timer,
+    headless_statistics *const statistics) {
+  const event_loop_timer fallback_timer = {.state = NULL,
+                                           .now = wall_time};
+  const event_loop_timer *const timing =
+      timer == NULL ? &fallback_timer : timer;
+  const input still = {
+      .pointer_state = POINTER_STATE_NONE,
+      .pointer_row = 0.0f,
+      .pointer_column = 0.0f,
+      .held_keys = {0, 0, 0, 0, 0, 0, 0, 0},
+      .events = NULL,
+      .number_of_events = 0,
+  };
+  headless_statistics measured = {
+      .ticks = 0,
+      .frames = 0,
+      .tick_microseconds = 0,
+      .video_microseconds = 0,
+      .total_microseconds = 0,
+      .ticks_per_second = 0,
+      .frames_per_second = 0,
+  };
+  const char *error = NULL;
+
+  float *const audio =
+      malloc(sizeof(float) * 2 * application->samples_per_tick);
+
+  if (audio == NULL) {
+    error = "Failed to allocate memory for audio.";
+  } else {
+    const int64_t start = timing->now(timing->state);
+
+    // Frame n falls n / frames of the way through the ticks, so runs once the
+    // ticks before that point have executed, part way through the next.
+    for (uint32_t frame = 0; frame <= frames && error == NULL; frame++) {
+      const uint64_t position = (uint64_t)frame * ticks;
+      const uint64_t due =
+          frame == frames ? ticks : frames == 0 ? 0 : position / frames;
+
+      while (measured.ticks < due && error == NULL) {
+        const int64_t before = timing->now(timing->state);
+        application->tick(application->state, &still, audio);
+        measured.tick_microseconds += timing->now(timing->state) - before;
+        measured.ticks++;
+
+        if (output != NULL && output->audio != NULL) {
+          error = output->audio(output->state, audio,
+                                application->samples_per_tick);
+        }
+      }
+
+      if (frame == frames || error != NULL) {
+        break;
+      }
+
+      const float progress = (float)(position % frames) / (float)frames;
+      const int64_t before = timing->now(timing->state);
+      application->video(application->state, &still, progress);
+      measured.video_microseconds += timing->now(timing->state) - before;
+      measured.frames++;
+
+      if (output != NULL && output->video != NULL) {
+        error = output->video(output->state, application->rows,
+                              application->columns, application->opacities,
+                              application->reds, application->greens,
+                              application->blues);
+      }
+    }
+
+    measured.total_microseconds = timing->now(timing->state) - start;
+    free(audio);
+  }
+
+  measured.ticks_per_second =
+      per_second(measured.ticks, measured.tick_microseconds);
+  measured.frames_per_second =
+      per_second(measured.frames, measured.video_microseconds);
+
+  if (statistics != NULL) {
+    *statistics = measured;
+  }
+
+  return error;
+}
+
+const char *run_event_loop_headless(
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows, const int columns, const float *const opacities,
+    const float *const reds, const float *const greens,
+    const float *const blues,
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const uint32_t ticks, const uint32_t frames,
+    const headless_output *const output, const event_loop_timer *const timer,
+    headless_statistics *const statistics) {
+  stateless_callbacks callbacks = {.tick = tick, .video = video};
+  const headless_application application = {
+      .state = &callbacks,
+      .tick = stateless_tick,
+      .video = stateless_video,
+      .rows = rows,
+      .columns = columns,
+      .opacities = opacities,
+      .reds = reds,
+      .greens = greens,
+      .blues = blues,
+      .samples_per_tick = samples_per_tick,
+  };
+
+  return run_headless_application(&application, ticks, frames, output, timer,
+                                  statistics);
+}
@@ -0,0 +1,169 @@
+#ifndef RUN_EVENT_LOOP_HEADLESS_H
+
+#define RUN_EVENT_LOOP_HEADLESS_H
+
+#include "event_loop_core.h"
+#include "headless_output.h"
+#include "input.h"
+#include <stdint.h>
+
+/**
+ * Measurements taken while running a headless event loop.
+ */
+typedef struct {
+  /**
+   * The number of tick events raised.
+   */
+  uint64_t ticks;
+
+  /**
+   * The number of video events raised.
+   */
+  uint64_t frames;
+
+  /**
+   * The number of microseconds spent within tick events.
+   */
+  int64_t tick_microseconds;
+
+  /**
+   * The number of microseconds spent within video events.
+   */
+  int64_t video_microseconds;
+
+  /**
+   * The number of microseconds taken overall, including any output.
+   */
+  int64_t total_microseconds;
+
+  /**
+   * The number of tick events which could be raised each second, were no time
+   * spent on anything else.  0 when none were raised or no time was measured.
+   */
+  double ticks_per_second;
+
+  /**
+   * As ticks_per_second, but for video events.
+   */
+  double frames_per_second;
+} headless_statistics;
+
+/**
+ * An application run by a headless event loop.  Unlike the callbacks given to
+ * run_event_loop, those here are given state, so that any number of instances
+ * of an application may run within a process (and on any number of threads)
+ * without sharing anything.
+ */
+typedef struct {
+  /**
+   * Passed to tick and video, typically the state of this instance.
+   */
+  void *const state;
+
+  /**
+   * Executes a tick, as given to run_event_loop.
+   * @param state The state of the application.
+   * @param input A snapshot of user input.
+   * @param audio Written to with interleaved stereo audio.
+   */
+  void (*const tick)(void *const state, const input *const input,
+                     float *const audio);
+
+  /**
+   * Renders the viewport, as given to run_event_loop.
+   * @param state The state of the application.
+   * @param input A snapshot of user input.
+   * @param tick_progress_unit_interval The progress through the current tick.
+   */
+  void (*const video)(void *const state, const input *const input,
+                      const float tick_progress_unit_interval);
+
+  /**
+   * The height of the viewport in rows.
+   */
+  const int rows;
+
+  /**
+   * The width of the viewport in columns.
+   */
+  const int columns;
+
+  /**
+   * The opacity of each pixel of the viewport, or null when opaque.
+   */
+  const float *const opacities;
+
+  /**
+   * The red intensity of each pixel of the viewport.
+   */
+  const float *const reds;
+
+  /**
+   * The green intensity of each pixel of the viewport.
+   */
+  const float *const greens;
+
+  /**
+   * The blue intensity of each pixel of the viewport.
+   */
+  const float *const blues;
+
+  /**
+   * The number of stereo samples each tick writes to audio.
+   */
+  const int samples_per_tick;
+} headless_application;
+
+/**
+ * Runs an application event loop as quickly as possible, without a window,
+ * audio output or pacing in real time, then reports how quickly its tick and
+ * video events executed.  Input never changes; the pointer is absent and no
+ * keys are held.  Parameters not documented here are as given to
+ * run_event_loop.
+ * @param ticks The number of tick events to raise.
+ * @param frames The number of video events to raise, spread evenly between the
+ *               tick events, with the progress through the current tick each
+ *               would have seen in real time.
+ * @param output When non-null, given the audio of each tick event and the
+ *               viewport after each video event.  Otherwise, both are
+ *               discarded.
+ * @param timer When non-null, used to measure time.  Otherwise, a monotonic
+ *              wall clock is read using profiler_now.
+ * @param statistics When non-null, written to with measurements, even in the
+ *                   event of an error.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *run_event_loop_headless(
+    void (*const tick)(const input *const input, float *const audio),
+    const int rows, const int columns, const float *const opacities,
+    const float *const reds, const float *const greens,
+    const float *const blues,
+    void (*const video)(const input *const input,
+                        const float tick_progress_unit_interval),
+    const int samples_per_tick, const uint32_t ticks, const uint32_t frames,
+    const headless_output *const output, const event_loop_timer *const timer,
+    headless_statistics *const statistics);
+
+/**
+ * As run_event_loop_headless, but for an application which is given state.
+ * Nothing is shared between calls, so this may run concurrently on any
+ * number of threads, given distinct applications, outputs and timers (or
+ * timers which are themselves safe to share).
+ * @param application The application to run.
+ * @param ticks The number of tick events to raise.
+ * @param frames The number of video events to raise, as given to
+ *               run_event_loop_headless.
+ * @param output As given to run_event_loop_headless.
+ * @param timer As given to run_event_loop_headless.
+ * @param statistics As given to run_event_loop_headless.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *run_headless_application(
+    const headless_application *const application, const uint32_t ticks,
+    const uint32_t frames, const headless_output *const output,
+    const event_loop_timer *const timer,
+    headless_statistics *const statistics);
+
+#endif
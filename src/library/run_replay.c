@@ -0,0 +1,64 @@
+#include "run_replay.h"
+#include "input.h"
+#include "input_recording.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const char *run_replay(const char *const path,
+                       void (*const tick)(const input *const input,
+                                          float *const audio),
+                       const int samples_per_tick, uint64_t *const ticks) {
+  input_recording recording;
+  input_event input_events[INPUT_EVENT_QUEUE_CAPACITY];
+  uint64_t executed = 0;
+
+  if (ticks != NULL) {
+    *ticks = 0;
+  }
+
+  float *const audio = malloc(sizeof(float) * 2 * samples_per_tick);
+
+  if (audio == NULL) {
+    return "Failed to allocate memory for audio.";
+  }
+
+  const char *error = input_recording_open(&recording, path, false);
+
+  if (error != NULL) {
+    free(audio);
+    return error;
+  }
+
+  while (true) {
+    input snapshot;
+    bool ended;
+
+    error = input_recording_read(&recording, &snapshot, input_events, &ended);
+
+    if (error != NULL || ended) {
+      break;
+    }
+
+    tick(&snapshot, audio);
+    executed++;
+  }
+
+  free(audio);
+
+  if (ticks != NULL) {
+    *ticks = executed;
+  }
+
+  const char *const close_error = input_recording_close(&recording);
+
+  if (error == NULL) {
+    return close_error;
+  } else if (close_error == NULL) {
+    return error;
+  } else {
+    return "Failed to read from the input recording.  Additionally failed to "
+           "close the input recording.";
+  }
+}
@@ -0,0 +1,27 @@
+#ifndef RUN_REPLAY_H
+
+#define RUN_REPLAY_H
+
+#include "input.h"
+#include <stdint.h>
+
+/**
+ * Replays an input recording, executing a tick for each tick within as quickly
+ * as possible, without a window, audio output or pacing in real time.
+ * @param path The null-terminated path to the input recording to replay.
+ * @param tick Called for each tick within the input recording, with the input
+ *             which was given to it when recorded and a buffer for its audio,
+ *             which is discarded.
+ * @param samples_per_tick The number of audio samples generated each tick, per
+ *                         channel.  Behavior is undefined if less than 1.
+ * @param ticks When non-null, written to with the number of ticks executed,
+ *              even in the event of an error.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *run_replay(const char *const path,
+                       void (*const tick)(const input *const input,
+                                          float *const audio),
+                       const int samples_per_tick, uint64_t *const ticks);
+
+#endif
@@ -0,0 +1,44 @@
+#include "scheduler.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+float scheduler_progress(const uint32_t minimum_position,
+                         const uint32_t position, const int samples_per_tick) {
+  // Unsigned arithmetic wraps, so this holds even when the position has wrapped
+  // back around past zero but the minimum position has not yet.
+  const uint32_t elapsed = position - minimum_position;
+  const float progress = elapsed / (float)samples_per_tick;
+  return progress > 1.0f ? 1.0f : progress;
+}
+
+void scheduler_plan(const int due, const int maximum_ticks_per_batch,
+                    const int catch_up_policy, int *const ticks,
+                    int *const refills) {
+  if (due > maximum_ticks_per_batch) {
+    *ticks = maximum_ticks_per_batch;
+    *refills = catch_up_policy == CATCH_UP_POLICY_SLOW
+                   ? maximum_ticks_per_batch
+                   : due;
+  } else {
+    *ticks = due;
+    *refills = due;
+  }
+}
+
+int scheduler_adapt(const int buffers, const int minimum_buffers,
+                    const int maximum_buffers, const bool underran,
+                    const int minimum_slack, const uint32_t stable_buffers,
+                    const uint32_t buffers_before_shrinking) {
+  if (underran) {
+    return buffers < maximum_buffers ? buffers + 1 : buffers;
+  }
+
+  // Shrinking by one still leaves at least one tick of audio queued at the
+  // worst moment observed.
+  if (buffers > minimum_buffers && minimum_slack >= 2 &&
+      stable_buffers >= buffers_before_shrinking) {
+    return buffers - 1;
+  }
+
+  return buffers;
+}
@@ -0,0 +1,117 @@
+#ifndef SCHEDULER_H
+
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * When more ticks are due than may be executed in a single batch, the audio
+ * buffers of the ticks beyond the limit are filled with silence.  Those ticks
+ * are discarded; the simulation jumps forward in time to catch up.
+ */
+#define CATCH_UP_POLICY_DROP 0
+
+/**
+ * When more ticks are due than may be executed in a single batch, the ticks
+ * beyond the limit are deferred until later in the event loop.  Time in the
+ * simulation slows down; audio may stutter until it has caught up.
+ */
+#define CATCH_UP_POLICY_SLOW 1
+
+/**
+ * When more ticks are due than may be executed in a single batch, the audio
+ * buffers of the ticks beyond the limit are filled with a repeat of the audio
+ * generated by the last tick executed.  Those ticks are discarded, but the
+ * audio output does not fall silent.
+ */
+#define CATCH_UP_POLICY_EXTEND 2
+
+/**
+ * The sources of time which drive the scheduling of tick and video events.
+ */
+typedef struct {
+  /**
+   * Passed to each of the following functions.
+   */
+  void *const state;
+
+  /**
+   * Retrieves the number of samples which have been played since the audio
+   * output started, wrapping at 2^32.
+   * @param state The state of the clock.
+   * @param position Written to on success.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const get_position)(void *const state,
+                                    uint32_t *const position);
+
+  /**
+   * Blocks until the display has next been refreshed.
+   * @param state The state of the clock.
+   * @return In the event of an error, a null-terminated UTF-8-encoded error
+   *         message describing the problem, otherwise, null.
+   */
+  const char *(*const wait_for_refresh)(void *const state);
+} scheduler_clock;
+
+/**
+ * Calculates how far the audio output has progressed through the current tick.
+ * @param minimum_position The position at which the current tick's audio
+ *                         started playing, wrapping at 2^32.
+ * @param position The current position, wrapping at 2^32.
+ * @param samples_per_tick The number of audio samples generated each tick.
+ *                         Behavior is undefined if less than 1.
+ * @return The progress through the current tick as a unit interval.
+ */
+float scheduler_progress(const uint32_t minimum_position,
+                         const uint32_t position, const int samples_per_tick);
+
+/**
+ * Decides how a number of due ticks are to be handled.
+ * @param due The number of ticks which are due.  Behavior is undefined if less
+ *            than 0.
+ * @param maximum_ticks_per_batch The maximum number of ticks which may be
+ *                                executed back-to-back.  Behavior is undefined
+ *                                if less than 1.
+ * @param catch_up_policy What to do with ticks which are due beyond the limit
+ *                        on ticks per batch.  Behavior is undefined if not a
+ *                        CATCH_UP_POLICY_* constant.
+ * @param ticks Written to with the number of ticks to execute.
+ * @param refills Written to with the number of audio buffers to refill, which
+ *                is at least the number of ticks to execute.  Any beyond that
+ *                are to be refilled according to the catch up policy.
+ */
+void scheduler_plan(const int due, const int maximum_ticks_per_batch,
+                    const int catch_up_policy, int *const ticks,
+                    int *const refills);
+
+/**
+ * Decides how many ticks of audio should be in flight, growing the count as
+ * soon as the audio output runs dry and shrinking it once it has proven to
+ * have had a tick to spare for long enough.  The window of observation should
+ * restart whenever the audio output runs dry or the count changes.
+ * @param buffers The number of ticks of audio currently in flight.
+ * @param minimum_buffers The fewest ticks of audio which may be in flight.
+ *                        Behavior is undefined if less than 2.
+ * @param maximum_buffers The most ticks of audio which may be in flight.
+ *                        Behavior is undefined if less than minimum_buffers.
+ * @param underran True when the audio output has run dry during the window.
+ * @param minimum_slack The fewest ticks of audio which remained in flight
+ *                      whenever a tick of audio finished playing during the
+ *                      window.
+ * @param stable_buffers The number of ticks of audio which have finished
+ *                       playing during the window.
+ * @param buffers_before_shrinking The number of ticks of audio which must
+ *                                 finish playing during a window before the
+ *                                 count may shrink.
+ * @return The number of ticks of audio which should be in flight, between
+ *         minimum_buffers and maximum_buffers.
+ */
+int scheduler_adapt(const int buffers, const int minimum_buffers,
+                    const int maximum_buffers, const bool underran,
+                    const int minimum_slack, const uint32_t stable_buffers,
+                    const uint32_t buffers_before_shrinking);
+
+#endif
@@ -0,0 +1,39 @@
+#include "viewport.h"
+
+void viewport_initialize(viewport *const viewport, const int rows,
+                         const int columns) {
+  viewport->scaled_width = columns;
+  viewport->scaled_height = rows;
+  viewport->x_offset = 0;
+  viewport->y_offset = 0;
+  viewport->inverse_x_offset = 0;
+  viewport->inverse_y_offset = 0;
+  viewport->rows_per_pixel = 1.0f;
+  viewport->columns_per_pixel = 1.0f;
+}
+
+void viewport_fit(viewport *const viewport, const int rows, const int columns,
+                  const int width, const int height) {
+  const double x_scale = (double)width / columns;
+  const double y_scale = (double)height / rows;
+  const double scale = x_scale < y_scale ? x_scale : y_scale;
+  const int scaled_width = columns * scale;
+  const int scaled_height = rows * scale;
+  const int x_offset = (width - scaled_width) / 2;
+  const int y_offset = (height - scaled_height) / 2;
+
+  viewport->scaled_width = scaled_width;
+  viewport->scaled_height = scaled_height;
+  viewport->x_offset = x_offset;
+  viewport->y_offset = y_offset;
+  viewport->inverse_x_offset = width - scaled_width - x_offset;
+  viewport->inverse_y_offset = height - scaled_height - y_offset;
+  viewport->rows_per_pixel = (float)rows / (float)scaled_height;
+  viewport->columns_per_pixel = (float)columns / (float)scaled_width;
+}
+
+void viewport_locate(const viewport *const viewport, const int x, const int y,
+                     float *const row, float *const column) {
+  *row = (float)(y - viewport->y_offset) * viewport->rows_per_pixel;
+  *column = (float)(x - viewport->x_offset) * viewport->columns_per_pixel;
+}
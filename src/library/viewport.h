@@ -0,0 +1,92 @@
+#ifndef VIEWPORT_H
+
+#define VIEWPORT_H
+
+/**
+ * The placement of a viewport within a larger area (such as the client area of
+ * a window), scaled as large as fits while keeping its aspect ratio, centered,
+ * and bordered where the aspect ratios differ.  Fields may be read, but should
+ * only be modified through the functions below.
+ */
+typedef struct {
+  /**
+   * The width of the scaled viewport, in pixels.
+   */
+  int scaled_width;
+
+  /**
+   * The height of the scaled viewport, in pixels.
+   */
+  int scaled_height;
+
+  /**
+   * The width of the border left of the scaled viewport, in pixels.
+   */
+  int x_offset;
+
+  /**
+   * The height of the border above the scaled viewport, in pixels.
+   */
+  int y_offset;
+
+  /**
+   * The width of the border right of the scaled viewport, in pixels.
+   */
+  int inverse_x_offset;
+
+  /**
+   * The height of the border below the scaled viewport, in pixels.
+   */
+  int inverse_y_offset;
+
+  /**
+   * The number of rows of the viewport covered by each pixel.
+   */
+  float rows_per_pixel;
+
+  /**
+   * The number of columns of the viewport covered by each pixel.
+   */
+  float columns_per_pixel;
+} viewport;
+
+/**
+ * Places a viewport at its original size, without borders.
+ * @param viewport The viewport to place.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ */
+void viewport_initialize(viewport *const viewport, const int rows,
+                         const int columns);
+
+/**
+ * Places a viewport within an area, as large as fits.
+ * @param viewport The viewport to place.
+ * @param rows The height of the viewport in rows.  Behavior is undefined if
+ *             less than 1.
+ * @param columns The width of the viewport in columns.  Behavior is undefined
+ *                if less than 1.
+ * @param width The width of the area, in pixels.  Behavior is undefined if
+ *              less than 1.
+ * @param height The height of the area, in pixels.  Behavior is undefined if
+ *               less than 1.
+ */
+void viewport_fit(viewport *const viewport, const int rows, const int columns,
+                  const int width, const int height);
+
+/**
+ * Converts a location within the area to a location within the viewport.
+ * @param viewport The placed viewport.
+ * @param x The number of pixels from the left edge of the area.
+ * @param y The number of pixels from the top edge of the area.
+ * @param row Written to with the number of rows from the top of the viewport.
+ *            May be outside of the viewport.
+ * @param column Written to with the number of columns from the left of the
+ *               viewport.  May be outside of the viewport.
+ */
+void viewport_locate(const viewport *const viewport, const int x, const int y,
+                     float *const row, float *const column);
+
+#endif
@@ -0,0 +1,31 @@
+#include "virtual_clock.h"
+#include "scheduler.h"
+#include <stddef.h>
+#include <stdint.h>
+
+static const char *get_position(void *const state, uint32_t *const position) {
+  *position = ((const virtual_clock *)state)->position;
+  return NULL;
+}
+
+static const char *wait_for_refresh(void *const state) {
+  virtual_clock *const our_virtual_clock = (virtual_clock *)state;
+  our_virtual_clock->position += our_virtual_clock->samples_per_refresh;
+  our_virtual_clock->refreshes++;
+  return NULL;
+}
+
+scheduler_clock virtual_clock_interface(virtual_clock *const virtual_clock) {
+  const scheduler_clock output = {
+      .state = virtual_clock,
+      .get_position = get_position,
+      .wait_for_refresh = wait_for_refresh,
+  };
+
+  return output;
+}
+
+void virtual_clock_advance(virtual_clock *const virtual_clock,
+                           const uint32_t samples) {
+  virtual_clock->position += samples;
+}
@@ -0,0 +1,48 @@
+#ifndef VIRTUAL_CLOCK_H
+
+#define VIRTUAL_CLOCK_H
+
+#include "scheduler.h"
+#include <stdint.h>
+
+/**
+ * A simulated source of time which only advances when told to, allowing the
+ * scheduling of tick and video events to run far faster than real time and
+ * with reproducible results.
+ */
+typedef struct {
+  /**
+   * The number of samples which have been "played", wrapping at 2^32.
+   */
+  uint32_t position;
+
+  /**
+   * The number of samples by which the position advances each time a display
+   * refresh is awaited.  May be altered between refreshes to simulate jitter.
+   */
+  uint32_t samples_per_refresh;
+
+  /**
+   * The number of display refreshes which have been awaited.
+   */
+  uint64_t refreshes;
+} virtual_clock;
+
+/**
+ * Wraps a virtual clock so that it may be used to drive a scheduler.
+ * @param virtual_clock The virtual clock to wrap.  Must remain valid for as
+ *                      long as the returned scheduler clock is in use.
+ * @return A scheduler clock which reads and advances the given virtual clock.
+ */
+scheduler_clock virtual_clock_interface(virtual_clock *const virtual_clock);
+
+/**
+ * Advances a virtual clock without awaiting a display refresh, for example, to
+ * simulate a stall.
+ * @param virtual_clock The virtual clock to advance.
+ * @param samples The number of samples by which to advance the position.
+ */
+void virtual_clock_advance(virtual_clock *const virtual_clock,
+                           const uint32_t samples);
+
+#endif
@@ -0,0 +1,485 @@
+#define COBJMACROS
+
+#include "wasapi_audio_backend.h"
+#include "audio_backend.h"
+#include "pcm.h"
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+#include <mmreg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <windows.h>
+
+// These are defined here rather than linked from libuuid, as not every
+// toolchain's libuuid includes all of them.
+static const CLSID clsid_mmdeviceenumerator = {
+    0xBCDE0395, 0xE52F, 0x467C,
+    {0x8E, 0x3D, 0xC4, 0x57, 0x92, 0x91, 0x69, 0x2E}};
+static const IID iid_immdeviceenumerator = {
+    0xA95664D2, 0x9614, 0x4F35,
+    {0xA7, 0x46, 0xDE, 0x8D, 0xB6, 0x36, 0x17, 0xE6}};
+static const IID iid_iaudioclient = {
+    0x1CB9AD4C, 0xDBFA, 0x4C32,
+    {0xB1, 0x78, 0xC2, 0xF5, 0x68, 0xA7, 0x03, 0xB2}};
+static const IID iid_iaudioclient3 = {
+    0x7ED4EE07, 0x8E67, 0x4CD4,
+    {0x8C, 0x1A, 0x2B, 0x7A, 0x59, 0x87, 0xAD, 0x42}};
+static const IID iid_iaudiorenderclient = {
+    0xF294ACFC, 0x3146, 0x4483,
+    {0xA7, 0xBF, 0xAD, 0xDC, 0xA7, 0xC2, 0x60, 0xE2}};
+static const IID iid_iaudioclock = {
+    0xCD63314F, 0x3FBA, 0x4A1B,
+    {0x81, 0x2C, 0xEF, 0x96, 0x35, 0x87, 0x28, 0xE7}};
+static const GUID ksdataformat_subtype_pcm = {
+    0x00000001, 0x0000, 0x0010,
+    {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
+static const GUID ksdataformat_subtype_ieee_float = {
+    0x00000003, 0x0000, 0x0010,
+    {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
+
+static void release(wasapi_audio_backend *const backend) {
+  if (backend->iaudioclock != NULL) {
+    IAudioClock_Release(backend->iaudioclock);
+  }
+
+  if (backend->iaudiorenderclient != NULL) {
+    IAudioRenderClient_Release(backend->iaudiorenderclient);
+  }
+
+  if (backend->iaudioclient != NULL) {
+    IAudioClient_Release(backend->iaudioclient);
+  }
+
+  if (backend->immdevice != NULL) {
+    IMMDevice_Release(backend->immdevice);
+  }
+
+  if (backend->immdeviceenumerator != NULL) {
+    IMMDeviceEnumerator_Release(backend->immdeviceenumerator);
+  }
+
+  if (backend->uninitialize_com) {
+    CoUninitialize();
+  }
+}
+
+// Determines whether audio in a format can be given to the audio engine
+// without conversion, which is required of streams opened through
+// IAudioClient3.
+static bool is_mix_format(const WAVEFORMATEX *const mix_format,
+                          const WAVEFORMATEX *const format) {
+  if (mix_format->nChannels != format->nChannels ||
+      mix_format->nSamplesPerSec != format->nSamplesPerSec ||
+      mix_format->wBitsPerSample != format->wBitsPerSample) {
+    return false;
+  }
+
+  if (mix_format->wFormatTag != WAVE_FORMAT_EXTENSIBLE) {
+    return mix_format->wFormatTag == format->wFormatTag;
+  }
+
+  if ((size_t)mix_format->cbSize <
+      sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX)) {
+    return false;
+  }
+
+  const WAVEFORMATEXTENSIBLE *const extensible =
+      (const WAVEFORMATEXTENSIBLE *)mix_format;
+
+  return extensible->Samples.wValidBitsPerSample == format->wBitsPerSample &&
+         IsEqualGUID(&extensible->SubFormat,
+                     format->wFormatTag == WAVE_FORMAT_IEEE_FLOAT
+                         ? &ksdataformat_subtype_ieee_float
+                         : &ksdataformat_subtype_pcm);
+}
+
+// Attempts to open a stream which the audio engine processes in its smallest
+// periods.  This is only possible when the audio is already in the audio
+// engine's mix format, and is only useful when the resulting buffer holds at
+// least a slot.  Should this fail for any reason, the audio client is replaced
+// with a fresh one, as it may have been left partially initialized.
+static bool initialize_low_latency(wasapi_audio_backend *const backend,
+                                   const WAVEFORMATEX *const format) {
+  IAudioClient3 *iaudioclient3;
+
+  if (FAILED(IAudioClient_QueryInterface(backend->iaudioclient,
+                                         &iid_iaudioclient3,
+                                         (void **)&iaudioclient3))) {
+    return false;
+  }
+
+  WAVEFORMATEX *mix_format = NULL;
+  UINT32 default_period, fundamental_period, minimum_period, maximum_period;
+  UINT32 buffer_samples;
+
+  const bool initialized =
+      SUCCEEDED(IAudioClient_GetMixFormat(backend->iaudioclient,
+                                          &mix_format)) &&
+      is_mix_format(mix_format, format) &&
+      SUCCEEDED(IAudioClient3_GetSharedModeEnginePeriod(
+          iaudioclient3, mix_format, &default_period, &fundamental_period,
+          &minimum_period, &maximum_period)) &&
+      SUCCEEDED(IAudioClient3_InitializeSharedAudioStream(
+          iaudioclient3, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, minimum_period,
+          mix_format, NULL)) &&
+      SUCCEEDED(IAudioClient_GetBufferSize(backend->iaudioclient,
+                                           &buffer_samples)) &&
+      buffer_samples >= backend->samples_per_slot;
+
+  CoTaskMemFree(mix_format);
+  IAudioClient3_Release(iaudioclient3);
+
+  if (!initialized) {
+    IAudioClient_Release(backend->iaudioclient);
+    backend->iaudioclient = NULL;
+
+    if (FAILED(IMMDevice_Activate(backend->immdevice, &iid_iaudioclient,
+                                  CLSCTX_ALL, NULL,
+                                  (void **)&backend->iaudioclient))) {
+      backend->iaudioclient = NULL;
+    }
+  }
+
+  return initialized;
+}
+
+static const char *prepare(void *const state, const uint32_t slot,
+                           float *const samples) {
+  (void)(state);
+  (void)(slot);
+  (void)(samples);
+  return NULL;
+}
+
+static const char *submit(void *const state, const uint32_t slot,
+                          const float *const samples) {
+  wasapi_audio_backend *const backend = (wasapi_audio_backend *)state;
+  BYTE *data;
+  (void)(slot);
+
+  // Shared mode only accepts audio into the audio engine's own buffer, so the
+  // slot is copied (or converted) rather than played in place.
+  if (FAILED(IAudioRenderClient_GetBuffer(backend->iaudiorenderclient,
+                                          backend->samples_per_slot, &data))) {
+    return "Failed to get a WASAPI buffer.";
+  }
+
+  if (backend->format == AUDIO_FORMAT_FLOAT) {
+    memcpy(data, samples, sizeof(float) * 2 * backend->samples_per_slot);
+  } else {
+    pcm_convert_int16(samples, (int16_t *)data, backend->samples_per_slot * 2,
+                      backend->format == AUDIO_FORMAT_INT16_DITHERED
+                          ? &backend->pcm_dither
+                          : NULL);
+  }
+
+  if (FAILED(IAudioRenderClient_ReleaseBuffer(backend->iaudiorenderclient,
+                                              backend->samples_per_slot, 0))) {
+    return "Failed to release a WASAPI buffer.";
+  }
+
+  backend->submitted_samples += backend->samples_per_slot;
+  return NULL;
+}
+
+static const char *get_completed(void *const state,
+                                 uint32_t *const completed) {
+  const wasapi_audio_backend *const backend =
+      (const wasapi_audio_backend *)state;
+  UINT32 padding;
+
+  if (FAILED(IAudioClient_GetCurrentPadding(backend->iaudioclient,
+                                            &padding))) {
+    return "Failed to get the WASAPI padding.";
+  }
+
+  // Every slot is the same size, so those which have finished playing can be
+  // inferred from how much of what was submitted is still waiting.
+  *completed = (uint32_t)((backend->submitted_samples - padding) /
+                          backend->samples_per_slot);
+  return NULL;
+}
+
+static uint32_t get_capacity(void *const state) {
+  return ((const wasapi_audio_backend *)state)->capacity;
+}
+
+static const char *get_position(void *const state, uint32_t *const position) {
+  const wasapi_audio_backend *const backend =
+      (const wasapi_audio_backend *)state;
+  UINT64 clock_position;
+
+  if (FAILED(IAudioClock_GetPosition(backend->iaudioclock, &clock_position,
+                                     NULL))) {
+    return "Failed to get the WASAPI position.";
+  }
+
+  // Split to avoid overflowing during long sessions.
+  const uint64_t frequency = backend->frequency;
+  const uint64_t samples_per_second = backend->samples_per_second;
+
+  *position = (uint32_t)((clock_position / frequency) * samples_per_second +
+                         ((clock_position % frequency) * samples_per_second) /
+                             frequency);
+  return NULL;
+}
+
+static const char *pause_backend(void *const state) {
+  if (FAILED(IAudioClient_Stop(
+          ((const wasapi_audio_backend *)state)->iaudioclient))) {
+    return "Failed to stop the WASAPI audio client.";
+  }
+
+  return NULL;
+}
+
+static const char *resume_backend(void *const state) {
+  if (FAILED(IAudioClient_Start(
+          ((const wasapi_audio_backend *)state)->iaudioclient))) {
+    return "Failed to start the WASAPI audio client.";
+  }
+
+  return NULL;
+}
+
+static const char *reset_backend(void *const state) {
+  wasapi_audio_backend *const backend = (wasapi_audio_backend *)state;
+
+  if (FAILED(IAudioClient_Stop(backend->iaudioclient))) {
+    return "Failed to stop the WASAPI audio client.";
+  }
+
+  if (FAILED(IAudioClient_Reset(backend->iaudioclient))) {
+    return "Failed to reset the WASAPI audio client.";
+  }
+
+  return NULL;
+}
+
+static const char *close_backend(void *const state) {
+  release((wasapi_audio_backend *)state);
+  return NULL;
+}
+
+const char *
+wasapi_audio_backend_open(wasapi_audio_backend *const wasapi_audio_backend,
+                          const HANDLE event, const int samples_per_second,
+                          const uint32_t slots, const uint32_t samples_per_slot,
+                          const int format, const bool low_latency) {
+  wasapi_audio_backend->immdeviceenumerator = NULL;
+  wasapi_audio_backend->immdevice = NULL;
+  wasapi_audio_backend->iaudioclient = NULL;
+  wasapi_audio_backend->iaudiorenderclient = NULL;
+  wasapi_audio_backend->iaudioclock = NULL;
+  wasapi_audio_backend->format = format;
+  pcm_dither_initialize(&wasapi_audio_backend->pcm_dither, 0);
+  wasapi_audio_backend->samples_per_second = samples_per_second;
+  wasapi_audio_backend->samples_per_slot = samples_per_slot;
+  wasapi_audio_backend->submitted_samples = 0;
+
+  // The application may have already joined an apartment of its own, which is
+  // fine; WASAPI's objects may be used from any thread.  Otherwise, this joins
+  // the multithreaded apartment, which the audio thread then implicitly shares.
+  const HRESULT coinitialize_result =
+      CoInitializeEx(NULL, COINIT_MULTITHREADED);
+
+  if (FAILED(coinitialize_result) &&
+      coinitialize_result != RPC_E_CHANGED_MODE) {
+    return "Failed to initialize COM.";
+  }
+
+  wasapi_audio_backend->uninitialize_com = SUCCEEDED(coinitialize_result);
+
+  if (FAILED(CoCreateInstance(&clsid_mmdeviceenumerator, NULL, CLSCTX_ALL,
+                              &iid_immdeviceenumerator,
+                              (void **)&wasapi_audio_backend
+                                  ->immdeviceenumerator))) {
+    wasapi_audio_backend->immdeviceenumerator = NULL;
+    release(wasapi_audio_backend);
+    return "Failed to create a WASAPI device enumerator.";
+  }
+
+  if (FAILED(IMMDeviceEnumerator_GetDefaultAudioEndpoint(
+          wasapi_audio_backend->immdeviceenumerator, eRender, eConsole,
+          &wasapi_audio_backend->immdevice))) {
+    wasapi_audio_backend->immdevice = NULL;
+    release(wasapi_audio_backend);
+    return "Failed to get the default WASAPI audio endpoint.";
+  }
+
+  if (FAILED(IMMDevice_Activate(wasapi_audio_backend->immdevice,
+                                &iid_iaudioclient, CLSCTX_ALL, NULL,
+                                (void **)&wasapi_audio_backend
+                                    ->iaudioclient))) {
+    wasapi_audio_backend->iaudioclient = NULL;
+    release(wasapi_audio_backend);
+    return "Failed to activate a WASAPI audio client.";
+  }
+
+  const int bytes_per_sample =
+      format == AUDIO_FORMAT_FLOAT ? sizeof(float) : sizeof(int16_t);
+
+  const WAVEFORMATEX wave_format = {
+      format == AUDIO_FORMAT_FLOAT ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM,
+      2,
+      samples_per_second,
+      2 * bytes_per_sample * samples_per_second,
+      2 * bytes_per_sample,
+      bytes_per_sample * 8,
+      0,
+  };
+
+  if (!(low_latency &&
+        initialize_low_latency(wasapi_audio_backend, &wave_format))) {
+    if (wasapi_audio_backend->iaudioclient == NULL) {
+      release(wasapi_audio_backend);
+      return "Failed to activate a WASAPI audio client.";
+    }
+
+    // Enough is requested to hold every slot; the audio engine converts to
+    // its own rate and format as needed.
+    const REFERENCE_TIME duration =
+        (((REFERENCE_TIME)slots * samples_per_slot * 10000000) +
+         samples_per_second - 1) /
+        samples_per_second;
+
+    if (FAILED(IAudioClient_Initialize(
+            wasapi_audio_backend->iaudioclient, AUDCLNT_SHAREMODE_SHARED,
+            AUDCLNT_STREAMFLAGS_EVENTCALLBACK |
+                AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+                AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
+            duration, 0, &wave_format, NULL))) {
+      release(wasapi_audio_backend);
+      return "Failed to initialize the WASAPI audio client.";
+    }
+  }
+
+  UINT32 buffer_samples;
+
+  if (FAILED(IAudioClient_GetBufferSize(wasapi_audio_backend->iaudioclient,
+                                        &buffer_samples))) {
+    release(wasapi_audio_backend);
+    return "Failed to get the WASAPI buffer size.";
+  }
+
+  wasapi_audio_backend->capacity = buffer_samples / samples_per_slot;
+
+  if (wasapi_audio_backend->capacity == 0) {
+    release(wasapi_audio_backend);
+    return "The WASAPI buffer is too small to hold a single tick of audio.";
+  }
+
+  if (FAILED(IAudioClient_SetEventHandle(wasapi_audio_backend->iaudioclient,
+                                         event))) {
+    release(wasapi_audio_backend);
+    return "Failed to set the WASAPI event.";
+  }
+
+  if (FAILED(IAudioClient_GetService(wasapi_audio_backend->iaudioclient,
+                                     &iid_iaudiorenderclient,
+                                     (void **)&wasapi_audio_backend
+                                         ->iaudiorenderclient))) {
+    wasapi_audio_backend->iaudiorenderclient = NULL;
+    release(wasapi_audio_backend);
+    return "Failed to get the WASAPI render client.";
+  }
+
+  if (FAILED(IAudioClient_GetService(wasapi_audio_backend->iaudioclient,
+                                     &iid_iaudioclock,
+                                     (void **)&wasapi_audio_backend
+                                         ->iaudioclock))) {
+    wasapi_audio_backend->iaudioclock = NULL;
+    release(wasapi_audio_backend);
+    return "Failed to get the WASAPI clock.";
+  }
+
+  UINT64 frequency;
+
+  if (FAILED(IAudioClock_GetFrequency(wasapi_audio_backend->iaudioclock,
+                                      &frequency)) ||
+      frequency == 0) {
+    release(wasapi_audio_backend);
+    return "Failed to get the WASAPI clock frequency.";
+  }
+
+  wasapi_audio_backend->frequency = frequency;
+  return NULL;
+}
+
+const char *wasapi_audio_backend_mix_rate(uint32_t *const samples_per_second) {
+  // A backend is used only for its references, so that they can be released
+  // in the same way.
+  wasapi_audio_backend backend = {
+      .immdeviceenumerator = NULL,
+      .immdevice = NULL,
+      .iaudioclient = NULL,
+      .iaudiorenderclient = NULL,
+      .iaudioclock = NULL,
+  };
+
+  const HRESULT coinitialize_result =
+      CoInitializeEx(NULL, COINIT_MULTITHREADED);
+
+  if (FAILED(coinitialize_result) &&
+      coinitialize_result != RPC_E_CHANGED_MODE) {
+    return "Failed to initialize COM.";
+  }
+
+  backend.uninitialize_com = SUCCEEDED(coinitialize_result);
+
+  if (FAILED(CoCreateInstance(&clsid_mmdeviceenumerator, NULL, CLSCTX_ALL,
+                              &iid_immdeviceenumerator,
+                              (void **)&backend.immdeviceenumerator))) {
+    backend.immdeviceenumerator = NULL;
+    release(&backend);
+    return "Failed to create a WASAPI device enumerator.";
+  }
+
+  if (FAILED(IMMDeviceEnumerator_GetDefaultAudioEndpoint(
+          backend.immdeviceenumerator, eRender, eConsole,
+          &backend.immdevice))) {
+    backend.immdevice = NULL;
+    release(&backend);
+    return "Failed to get the default WASAPI audio endpoint.";
+  }
+
+  if (FAILED(IMMDevice_Activate(backend.immdevice, &iid_iaudioclient,
+                                CLSCTX_ALL, NULL,
+                                (void **)&backend.iaudioclient))) {
+    backend.iaudioclient = NULL;
+    release(&backend);
+    return "Failed to activate a WASAPI audio client.";
+  }
+
+  WAVEFORMATEX *mix_format;
+
+  if (FAILED(IAudioClient_GetMixFormat(backend.iaudioclient, &mix_format))) {
+    release(&backend);
+    return "Failed to get the WASAPI mix format.";
+  }
+
+  *samples_per_second = mix_format->nSamplesPerSec;
+  CoTaskMemFree(mix_format);
+  release(&backend);
+  return NULL;
+}
+
+audio_backend wasapi_audio_backend_interface(
+    wasapi_audio_backend *const wasapi_audio_backend) {
+  const audio_backend output = {
+      .state = wasapi_audio_backend,
+      .prepare = prepare,
+      .submit = submit,
+      .get_completed = get_completed,
+      .get_capacity = get_capacity,
+      .get_position = get_position,
+      .pause = pause_backend,
+      .resume = resume_backend,
+      .reset = reset_backend,
+      .close = close_backend,
+  };
+
+  return output;
+}
@@ -0,0 +1,83 @@
+#ifndef WASAPI_AUDIO_BACKEND_H
+
+#define WASAPI_AUDIO_BACKEND_H
+
+#include "audio_backend.h"
+#include "pcm.h"
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <windows.h>
+
+/**
+ * An audio backend which plays through shared-mode WASAPI, bypassing the legacy
+ * mixer, and is woken by the audio engine each time it processes audio rather
+ * than only when a whole slot finishes playing.  All fields are owned by the
+ * backend and should only be accessed through the functions below.
+ */
+typedef struct {
+  bool uninitialize_com;
+  IMMDeviceEnumerator *immdeviceenumerator;
+  IMMDevice *immdevice;
+  IAudioClient *iaudioclient;
+  IAudioRenderClient *iaudiorenderclient;
+  IAudioClock *iaudioclock;
+  int format;
+  pcm_dither pcm_dither;
+  uint64_t frequency;
+  uint32_t samples_per_second;
+  uint32_t samples_per_slot;
+  uint32_t capacity;
+  uint64_t submitted_samples;
+} wasapi_audio_backend;
+
+/**
+ * Opens the default audio endpoint, paused.
+ * @param wasapi_audio_backend The backend to open.
+ * @param event Signaled whenever the audio engine is ready for more audio.
+ * @param samples_per_second The number of samples per channel per second.
+ *                           Converted to the rate of the endpoint as needed.
+ * @param slots The most slots which the backend should be able to queue at
+ *              once.  Behavior is undefined if less than 1.
+ * @param samples_per_slot The number of samples per channel in each slot.
+ *                         Behavior is undefined if less than 1.
+ * @param format The format in which to play audio.  Behavior is undefined if
+ *               not an AUDIO_FORMAT_* constant.
+ * @param low_latency When true, and supported by the endpoint, the audio engine
+ *                    is asked to process audio in its smallest periods.  This
+ *                    may limit how many slots can be queued at once.  Only
+ *                    possible when the format and rate match the audio
+ *                    engine's mix format, and the resulting buffer holds at
+ *                    least a slot; otherwise, ignored.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *
+wasapi_audio_backend_open(wasapi_audio_backend *const wasapi_audio_backend,
+                          const HANDLE event, const int samples_per_second,
+                          const uint32_t slots, const uint32_t samples_per_slot,
+                          const int format, const bool low_latency);
+
+/**
+ * Determines the sample rate at which the audio engine mixes audio for the
+ * default audio endpoint.  Audio at any other rate is resampled by the audio
+ * engine.
+ * @param samples_per_second Written to with the number of samples per channel
+ *                           per second on success.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *wasapi_audio_backend_mix_rate(uint32_t *const samples_per_second);
+
+/**
+ * Wraps a WASAPI audio backend so that it may be used as an audio backend.
+ * @param wasapi_audio_backend The WASAPI audio backend to wrap.  Must remain
+ *                             valid for as long as the returned audio backend
+ *                             is in use.
+ * @return An audio backend which plays through the given WASAPI audio backend.
+ */
+audio_backend wasapi_audio_backend_interface(
+    wasapi_audio_backend *const wasapi_audio_backend);
+
+#endif
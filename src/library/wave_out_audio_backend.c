@@ -0,0 +1,229 @@
+#include "wave_out_audio_backend.h"
+#include "audio_backend.h"
+#include "pcm.h"
+#include <mmreg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <windows.h>
+
+static const char *prepare(void *const state, const uint32_t slot,
+                           float *const samples) {
+  wave_out_audio_backend *const backend = (wave_out_audio_backend *)state;
+
+  WAVEHDR *const wavehdr = backend->wavehdrs + slot;
+
+  // Converted audio is played from a buffer of its own, in place of the slot.
+  if (backend->format == AUDIO_FORMAT_FLOAT) {
+    wavehdr->lpData = (LPSTR)samples;
+    wavehdr->dwBufferLength = backend->samples_per_slot * 2 * sizeof(float);
+  } else {
+    wavehdr->lpData =
+        (LPSTR)(backend->converted + slot * backend->samples_per_slot * 2);
+    wavehdr->dwBufferLength = backend->samples_per_slot * 2 * sizeof(int16_t);
+  }
+
+  wavehdr->dwBytesRecorded = 0;
+  wavehdr->dwUser = 0;
+  wavehdr->dwFlags = WHDR_DONE;
+  wavehdr->dwLoops = 0;
+  wavehdr->lpNext = NULL;
+  wavehdr->reserved = 0;
+
+  if (waveOutPrepareHeader(backend->hwaveout, wavehdr, sizeof(WAVEHDR)) !=
+      MMSYSERR_NOERROR) {
+    return "Failed to prepare wave out.";
+  }
+
+  backend->prepared++;
+  return NULL;
+}
+
+static const char *submit(void *const state, const uint32_t slot,
+                          const float *const samples) {
+  wave_out_audio_backend *const backend = (wave_out_audio_backend *)state;
+  WAVEHDR *const wavehdr = backend->wavehdrs + slot;
+
+  if (backend->format != AUDIO_FORMAT_FLOAT) {
+    pcm_convert_int16(samples, (int16_t *)wavehdr->lpData,
+                      backend->samples_per_slot * 2,
+                      backend->format == AUDIO_FORMAT_INT16_DITHERED
+                          ? &backend->pcm_dither
+                          : NULL);
+  }
+
+  // Headers stay prepared from when the backend was started until it is
+  // closed, as they always describe the same memory; only the flag which
+  // reports completion needs clearing before each reuse.
+  wavehdr->dwFlags &= ~WHDR_DONE;
+
+  if (waveOutWrite(backend->hwaveout, wavehdr, sizeof(WAVEHDR)) !=
+      MMSYSERR_NOERROR) {
+    return "Failed to write wave out.";
+  }
+
+  backend->queued++;
+  return NULL;
+}
+
+static const char *get_completed(void *const state,
+                                 uint32_t *const completed) {
+  wave_out_audio_backend *const backend = (wave_out_audio_backend *)state;
+
+  // Buffers finish playing in the order in which they were written.
+  while (backend->queued > 0 &&
+         (backend->wavehdrs[backend->next_completed_slot].dwFlags &
+          WHDR_DONE)) {
+    backend->next_completed_slot =
+        (backend->next_completed_slot + 1) % backend->slots;
+    backend->queued--;
+    backend->completed++;
+  }
+
+  *completed = backend->completed;
+  return NULL;
+}
+
+static uint32_t get_capacity(void *const state) {
+  return ((const wave_out_audio_backend *)state)->slots;
+}
+
+static const char *get_position(void *const state, uint32_t *const position) {
+  MMTIME mmtime = {.wType = TIME_SAMPLES};
+
+  if (waveOutGetPosition(((const wave_out_audio_backend *)state)->hwaveout,
+                         &mmtime, sizeof(mmtime)) != MMSYSERR_NOERROR) {
+    return "Failed to get wave out position.";
+  }
+
+  if (mmtime.wType != TIME_SAMPLES) {
+    return "Wave out position does not support sample time.";
+  }
+
+  *position = mmtime.u.sample;
+  return NULL;
+}
+
+static const char *pause_backend(void *const state) {
+  if (waveOutPause(((const wave_out_audio_backend *)state)->hwaveout) !=
+      MMSYSERR_NOERROR) {
+    return "Failed to pause wave out.";
+  }
+
+  return NULL;
+}
+
+static const char *resume_backend(void *const state) {
+  if (waveOutRestart(((const wave_out_audio_backend *)state)->hwaveout) !=
+      MMSYSERR_NOERROR) {
+    return "Failed to restart wave out.";
+  }
+
+  return NULL;
+}
+
+static const char *reset_backend(void *const state) {
+  if (waveOutReset(((const wave_out_audio_backend *)state)->hwaveout) !=
+      MMSYSERR_NOERROR) {
+    return "Failed to reset wave out.";
+  }
+
+  return NULL;
+}
+
+static const char *close_backend(void *const state) {
+  wave_out_audio_backend *const backend = (wave_out_audio_backend *)state;
+
+  // Slots are prepared in order, so those which were are the first.
+  for (uint32_t slot = 0; slot < backend->prepared; slot++) {
+    if (waveOutUnprepareHeader(backend->hwaveout, backend->wavehdrs + slot,
+                               sizeof(WAVEHDR)) != MMSYSERR_NOERROR) {
+      return "Failed to unprepare wave out.";
+    }
+  }
+
+  // Should this fail, wave out may still be using the headers, so they are
+  // leaked rather than freed.
+  if (waveOutClose(backend->hwaveout) != MMSYSERR_NOERROR) {
+    return "Failed to close wave out.";
+  }
+
+  free(backend->wavehdrs);
+  return NULL;
+}
+
+const char *wave_out_audio_backend_open(
+    wave_out_audio_backend *const wave_out_audio_backend, const HANDLE event,
+    const int samples_per_second, const uint32_t slots,
+    const uint32_t samples_per_slot, const int format) {
+  const int bytes_per_sample =
+      format == AUDIO_FORMAT_FLOAT ? sizeof(float) : sizeof(int16_t);
+
+  // Converted audio needs buffers of its own, which follow the headers.
+  wave_out_audio_backend->wavehdrs =
+      malloc(sizeof(WAVEHDR) * slots +
+             (format == AUDIO_FORMAT_FLOAT
+                  ? 0
+                  : sizeof(int16_t) * 2 * samples_per_slot * slots));
+
+  if (wave_out_audio_backend->wavehdrs == NULL) {
+    return "Failed to allocate memory for wave out headers.";
+  }
+
+  wave_out_audio_backend->converted =
+      (int16_t *)(wave_out_audio_backend->wavehdrs + slots);
+  wave_out_audio_backend->format = format;
+  pcm_dither_initialize(&wave_out_audio_backend->pcm_dither, 0);
+  wave_out_audio_backend->slots = slots;
+  wave_out_audio_backend->samples_per_slot = samples_per_slot;
+  wave_out_audio_backend->prepared = 0;
+  wave_out_audio_backend->queued = 0;
+  wave_out_audio_backend->completed = 0;
+  wave_out_audio_backend->next_completed_slot = 0;
+
+  const WAVEFORMATEX wave_format = {
+      format == AUDIO_FORMAT_FLOAT ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM,
+      2,
+      samples_per_second,
+      2 * bytes_per_sample * samples_per_second,
+      2 * bytes_per_sample,
+      bytes_per_sample * 8,
+      0,
+  };
+
+  if (waveOutOpen(&wave_out_audio_backend->hwaveout, WAVE_MAPPER, &wave_format,
+                  (DWORD_PTR)event, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+    free(wave_out_audio_backend->wavehdrs);
+    return "Failed to open wave out.";
+  }
+
+  if (waveOutPause(wave_out_audio_backend->hwaveout) != MMSYSERR_NOERROR) {
+    if (waveOutClose(wave_out_audio_backend->hwaveout) == MMSYSERR_NOERROR) {
+      free(wave_out_audio_backend->wavehdrs);
+      return "Failed to pause wave out.";
+    } else {
+      return "Failed to pause wave out.  Additionally failed to close wave "
+             "out.";
+    }
+  }
+
+  return NULL;
+}
+
+audio_backend wave_out_audio_backend_interface(
+    wave_out_audio_backend *const wave_out_audio_backend) {
+  const audio_backend output = {
+      .state = wave_out_audio_backend,
+      .prepare = prepare,
+      .submit = submit,
+      .get_completed = get_completed,
+      .get_capacity = get_capacity,
+      .get_position = get_position,
+      .pause = pause_backend,
+      .resume = resume_backend,
+      .reset = reset_backend,
+      .close = close_backend,
+  };
+
+  return output;
+}
@@ -0,0 +1,59 @@
+#ifndef WAVE_OUT_AUDIO_BACKEND_H
+
+#define WAVE_OUT_AUDIO_BACKEND_H
+
+#include "audio_backend.h"
+#include "pcm.h"
+#include <stdint.h>
+#include <windows.h>
+
+/**
+ * An audio backend which plays through wave out, and so the legacy mixer.  All
+ * fields are owned by the backend and should only be accessed through the
+ * functions below.
+ */
+typedef struct {
+  HWAVEOUT hwaveout;
+  WAVEHDR *wavehdrs;
+  int16_t *converted;
+  int format;
+  pcm_dither pcm_dither;
+  uint32_t slots;
+  uint32_t samples_per_slot;
+  uint32_t prepared;
+  uint32_t queued;
+  uint32_t completed;
+  uint32_t next_completed_slot;
+} wave_out_audio_backend;
+
+/**
+ * Opens the default wave out device, paused.
+ * @param wave_out_audio_backend The backend to open.
+ * @param event Signaled whenever a slot finishes playing.
+ * @param samples_per_second The number of samples per channel per second.
+ * @param slots The number of slots in the audio ring which will be played.
+ *              Behavior is undefined if less than 1.
+ * @param samples_per_slot The number of samples per channel in each slot.
+ *                         Behavior is undefined if less than 1.
+ * @param format The format in which to play audio.  Behavior is undefined if
+ *               not an AUDIO_FORMAT_* constant.
+ * @return In the event of an error, a null-terminated UTF-8-encoded error
+ *         message describing the problem, otherwise, null.
+ */
+const char *wave_out_audio_backend_open(
+    wave_out_audio_backend *const wave_out_audio_backend, const HANDLE event,
+    const int samples_per_second, const uint32_t slots,
+    const uint32_t samples_per_slot, const int format);
+
+/**
+ * Wraps a wave out audio backend so that it may be used as an audio backend.
+ * @param wave_out_audio_backend The wave out audio backend to wrap.  Must
+ *                               remain valid for as long as the returned audio
+ *                               backend is in use.
+ * @return An audio backend which plays through the given wave out audio
+ *         backend.
+ */
+audio_backend wave_out_audio_backend_interface(
+    wave_out_audio_backend *const wave_out_audio_backend);
+
+#endif
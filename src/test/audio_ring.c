@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../library/audio_ring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Not a power of two, so that the counters wrapping at 2^32 do not line up
+// with the slots.
+#define SLOTS 5
+#define SAMPLES_PER_SLOT 64
+
+// Exactly representable as floats.
+#define SLOTS_STREAMED 2000000
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+static float samples[SLOTS * SAMPLES_PER_SLOT];
+static audio_ring ring;
+
+// Starts the ring's counters part way through a stream so that they wrap past
+// 2^32 within it.  The counters are otherwise only reachable through the
+// ring's functions.
+static void initialize(const uint32_t counters) {
+  audio_ring_initialize(&ring, samples, SLOTS, SAMPLES_PER_SLOT);
+  ring.written = counters;
+  ring.reading = counters;
+  ring.read = counters;
+}
+
+// Fills every sample of each slot with the slot's number within the stream,
+// so that torn, skipped or repeated slots are all visible to the consumer.
+static void *produce(void *const argument) {
+  (void)argument;
+
+  for (int sequence = 1; sequence <= SLOTS_STREAMED; sequence++) {
+    float *slot;
+
+    while ((slot = audio_ring_begin_write(&ring)) == NULL) {
+      sched_yield();
+    }
+
+    for (int sample = 0; sample < SAMPLES_PER_SLOT; sample++) {
+      slot[sample] = (float)sequence;
+    }
+
+    audio_ring_publish(&ring);
+  }
+
+  return NULL;
+}
+
+static void single_threaded(void) {
+  initialize(UINT32_MAX - 2);
+
+  uint32_t slot;
+  check(!audio_ring_begin_read(&ring, &slot),
+        "A slot was read from an empty ring.");
+  check(audio_ring_low_watermark(&ring) == 0,
+        "The low watermark was %u after finding the ring empty.",
+        audio_ring_low_watermark(&ring));
+
+  for (int index = 0; index < SLOTS; index++) {
+    float *const written = audio_ring_begin_write(&ring);
+    check(written == audio_ring_slot(&ring, (uint32_t)index),
+          "Slot %d was not written in order.", index);
+    audio_ring_publish(&ring);
+  }
+
+  check(audio_ring_begin_write(&ring) == NULL,
+        "A slot was written to a full ring.");
+  check(audio_ring_waiting(&ring) == SLOTS, "%u slots were waiting, not %d.",
+        audio_ring_waiting(&ring), SLOTS);
+  check(audio_ring_high_watermark(&ring) == SLOTS,
+        "The high watermark was %u once full.",
+        audio_ring_high_watermark(&ring));
+
+  // A slot being read is still in use, so does not free space to write.
+  check(audio_ring_begin_read(&ring, &slot) && slot == 0,
+        "The first slot was not read first.");
+  check(audio_ring_waiting(&ring) == SLOTS - 1,
+        "Reading a slot left %u waiting.", audio_ring_waiting(&ring));
+  check(audio_ring_begin_write(&ring) == NULL,
+        "A slot still being read was written to.");
+
+  audio_ring_release(&ring);
+  check(audio_ring_begin_write(&ring) == audio_ring_slot(&ring, 0),
+        "A released slot was not written to next.");
+}
+
+static void two_threads(void) {
+  initialize(UINT32_MAX - SLOTS_STREAMED / 2);
+
+  pthread_t producer;
+
+  if (pthread_create(&producer, NULL, produce, NULL) != 0) {
+    fprintf(stderr, "Failed to start the producer thread.\n");
+    failures++;
+    return;
+  }
+
+  int expected = 1;
+
+  while (expected <= SLOTS_STREAMED) {
+    uint32_t slot;
+
+    if (!audio_ring_begin_read(&ring, &slot)) {
+      sched_yield();
+      continue;
+    }
+
+    const uint32_t waiting = audio_ring_waiting(&ring);
+    check(waiting < SLOTS, "%u slots were waiting while one was read.",
+          waiting);
+
+    const float *const read = audio_ring_slot(&ring, slot);
+
+    // After the first failure, the stream is only drained so that the
+    // producer can finish.
+    for (int sample = 0; failures == 0 && sample < SAMPLES_PER_SLOT;
+         sample++) {
+      if (read[sample] != (float)expected) {
+        check(false, "Read slot %.0f (sample %d) when expecting slot %d.",
+              read[sample], sample, expected);
+        break;
+      }
+    }
+
+    audio_ring_release(&ring);
+    expected++;
+  }
+
+  pthread_join(producer, NULL);
+
+  uint32_t slot;
+  check(!audio_ring_begin_read(&ring, &slot),
+        "Slots remained after the stream ended.");
+  check(ring.read == UINT32_MAX - SLOTS_STREAMED / 2 + SLOTS_STREAMED,
+        "The counters did not wrap with the stream.");
+  check(audio_ring_high_watermark(&ring) >= 1 &&
+            audio_ring_high_watermark(&ring) <= SLOTS,
+        "The high watermark was %u.", audio_ring_high_watermark(&ring));
+  check(audio_ring_low_watermark(&ring) == 0,
+        "The low watermark was %u after the ring was found empty.",
+        audio_ring_low_watermark(&ring));
+}
+
+int main(void) {
+  single_threaded();
+  two_threads();
+  return failures == 0 ? 0 : 1;
+}
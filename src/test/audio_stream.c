@@ -0,0 +1,481 @@
+#include "../library/audio_stream.h"
+#include "../library/file_mapping.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SAMPLES_PER_SECOND 44100
+
+// Audio is mixed on top of this, which should be left wherever a stream has
+// nothing to add.
+#define BACKGROUND 0.25f
+
+#define GAIN 0.5f
+
+#define TOLERANCE 0.000001
+
+// The most samples per channel in any WAV file built below.
+#define MAXIMUM_FRAMES 4096
+
+// IMA ADPCM blocks of 8 groups of 8 samples per channel.
+#define IMA_GROUPS_PER_BLOCK 8
+#define IMA_SAMPLES_PER_BLOCK (IMA_GROUPS_PER_BLOCK * 8 + 1)
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+// The WAV file being built, in memory.
+static uint8_t wav[65536];
+static size_t wav_size;
+
+// What each sample per channel of the WAV file being built should decode to,
+// at a gain of 1.
+static double source[MAXIMUM_FRAMES][2];
+
+static file_mapping mapping;
+static audio_stream stream;
+
+static void put_bytes(const void *const bytes, const size_t size) {
+  memcpy(wav + wav_size, bytes, size);
+  wav_size += size;
+}
+
+static void put_uint16(const uint16_t value) {
+  const uint8_t bytes[] = {value & 255, value >> 8};
+  put_bytes(bytes, sizeof(bytes));
+}
+
+static void put_uint32(const uint32_t value) {
+  const uint8_t bytes[] = {value & 255, (value >> 8) & 255,
+                           (value >> 16) & 255, value >> 24};
+  put_bytes(bytes, sizeof(bytes));
+}
+
+static void set_uint32(const size_t offset, const uint32_t value) {
+  const size_t size = wav_size;
+  wav_size = offset;
+  put_uint32(value);
+  wav_size = size;
+}
+
+static void begin_wav(void) {
+  wav_size = 0;
+  put_bytes("RIFF", 4);
+  put_uint32(0);
+  put_bytes("WAVE", 4);
+}
+
+static void end_wav(void) { set_uint32(4, (uint32_t)(wav_size - 8)); }
+
+// Starts a chunk, returning the offset of its size.
+static size_t begin_chunk(const char *const tag) {
+  put_bytes(tag, 4);
+  put_uint32(0);
+  return wav_size - 4;
+}
+
+// Fills in the size of a chunk, then pads it to an even number of bytes.
+static void end_chunk(const size_t size_offset) {
+  set_uint32(size_offset, (uint32_t)(wav_size - size_offset - 4));
+
+  if (wav_size & 1) {
+    put_bytes("", 1);
+  }
+}
+
+static void put_format(const uint16_t format, const uint16_t channels,
+                       const uint32_t samples_per_second,
+                       const uint16_t block_align,
+                       const uint16_t bits_per_sample) {
+  put_uint16(format);
+  put_uint16(channels);
+  put_uint32(samples_per_second);
+  put_uint32(samples_per_second * block_align);
+  put_uint16(block_align);
+  put_uint16(bits_per_sample);
+}
+
+// A chunk which the audio stream should skip over, of an odd size so that it
+// is followed by a byte of padding.
+static void put_unknown_chunk(void) {
+  const size_t chunk = begin_chunk("LIST");
+  put_bytes("INFOx", 5);
+  end_chunk(chunk);
+}
+
+static int16_t int16_sample(const int frame, const int channel) {
+  return (int16_t)((frame * 2731 + channel * 12345) % 60000 - 30000);
+}
+
+static float float_sample(const int frame, const int channel) {
+  return (float)sin(frame * 0.05 + channel * 2.0) * 0.75f;
+}
+
+// Writes a data chunk of 16-bit samples, which may claim to be longer than it
+// is, as when a file was not finished being written.
+static void put_int16_data(const int channels, const int frames,
+                           const int claimed_frames) {
+  const size_t chunk = begin_chunk("data");
+
+  for (int frame = 0; frame < frames; frame++) {
+    for (int channel = 0; channel < channels; channel++) {
+      const int16_t sample = int16_sample(frame, channel);
+      put_uint16((uint16_t)sample);
+      source[frame][channel] = sample / 32768.0;
+    }
+
+    if (channels == 1) {
+      source[frame][1] = source[frame][0];
+    }
+  }
+
+  end_chunk(chunk);
+
+  if (claimed_frames != frames) {
+    set_uint32(chunk, (uint32_t)(claimed_frames * channels * 2));
+  }
+}
+
+static void put_float_data(const int channels, const int frames) {
+  const size_t chunk = begin_chunk("data");
+
+  for (int frame = 0; frame < frames; frame++) {
+    for (int channel = 0; channel < channels; channel++) {
+      const float sample = float_sample(frame, channel);
+      put_bytes(&sample, sizeof(sample));
+      source[frame][channel] = sample;
+    }
+
+    if (channels == 1) {
+      source[frame][1] = source[frame][0];
+    }
+  }
+
+  end_chunk(chunk);
+}
+
+static const char *open_wav(const uint32_t samples_per_second,
+                            const bool looping) {
+  file_mapping_open_memory(&mapping, wav, wav_size);
+  return audio_stream_open(&stream, &mapping, samples_per_second, looping);
+}
+
+// Mixes on top of the background, checking that samples from a position
+// onwards were added until the stream ended (if expected to), and that the
+// background was left unchanged after that.
+static void mix(const char *const name, const uint32_t samples,
+                const uint64_t from, const uint64_t length,
+                const uint32_t expected_mixed, const bool expected_ended) {
+  static float audio[MAXIMUM_FRAMES * 2];
+
+  for (uint32_t sample = 0; sample < samples * 2; sample++) {
+    audio[sample] = BACKGROUND;
+  }
+
+  bool ended = !expected_ended;
+  const char *const error = audio_stream_mix(&stream, audio, samples, GAIN,
+                                             &ended);
+  check(error == NULL, "%s: Failed to mix: %s", name, error);
+  check(ended == expected_ended, "%s: ended was %s.", name,
+        ended ? "true" : "false");
+
+  for (uint32_t sample = 0; sample < samples; sample++) {
+    for (int channel = 0; channel < 2; channel++) {
+      const double expected =
+          sample < expected_mixed
+              ? BACKGROUND + source[(from + sample) % length][channel] * GAIN
+              : BACKGROUND;
+      const float actual = audio[sample * 2 + channel];
+
+      if (fabs(actual - expected) > TOLERANCE) {
+        check(false, "%s: Sample %u of channel %d was %f, not %f.", name,
+              sample, channel, actual, expected);
+        return;
+      }
+    }
+  }
+}
+
+static void expect_error(const char *const name, const char *const error,
+                         const char *const expected) {
+  check(error != NULL && strcmp(error, expected) == 0,
+        "%s: Opening gave \"%s\", not \"%s\".", name,
+        error == NULL ? "no error" : error, expected);
+}
+
+// The data chunk precedes the format chunk, and both are preceded by a chunk
+// of an odd size which must be skipped over along with its padding.
+static void chunk_order(void) {
+  begin_wav();
+  put_unknown_chunk();
+  put_int16_data(2, 1000, 1000);
+  put_unknown_chunk();
+  const size_t chunk = begin_chunk("fmt ");
+  put_format(1, 2, SAMPLES_PER_SECOND, 4, 16);
+  end_chunk(chunk);
+  end_wav();
+
+  const char *const error = open_wav(SAMPLES_PER_SECOND, false);
+  check(error == NULL, "Chunk order: Failed to open: %s", error);
+  mix("Chunk order", 600, 0, 1000, 600, false);
+  mix("Chunk order end", 600, 600, 1000, 400, true);
+  mix("Chunk order after end", 10, 0, 1000, 0, true);
+}
+
+// A file which was not finished being written claims more data than it holds,
+// and ends part way through a sample.
+static void truncated(void) {
+  begin_wav();
+  const size_t chunk = begin_chunk("fmt ");
+  put_format(1, 1, SAMPLES_PER_SECOND, 2, 16);
+  end_chunk(chunk);
+  put_int16_data(1, 300, 100000);
+  wav_size--;
+  end_wav();
+
+  const char *const error = open_wav(SAMPLES_PER_SECOND, false);
+  check(error == NULL, "Truncated: Failed to open: %s", error);
+  mix("Truncated", 400, 0, 300, 299, true);
+}
+
+// Extensible formats name the sample format in their sub-format, which must
+// be present.
+static void extensible(void) {
+  static const uint8_t float_guid[] = {0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x10, 0x00, 0x80, 0x00, 0x00, 0xAA,
+                                       0x00, 0x38, 0x9B, 0x71};
+
+  begin_wav();
+  size_t chunk = begin_chunk("fmt ");
+  put_format(0xFFFE, 2, SAMPLES_PER_SECOND, 8, 32);
+  put_uint16(22);
+  put_uint16(32);
+  put_uint32(3);
+  put_bytes(float_guid, sizeof(float_guid));
+  end_chunk(chunk);
+  put_float_data(2, 500);
+  end_wav();
+
+  const char *const error = open_wav(SAMPLES_PER_SECOND, false);
+  check(error == NULL, "Extensible: Failed to open: %s", error);
+  mix("Extensible", 500, 0, 500, 500, true);
+
+  begin_wav();
+  chunk = begin_chunk("fmt ");
+  put_format(0xFFFE, 2, SAMPLES_PER_SECOND, 8, 32);
+  put_uint16(0);
+  end_chunk(chunk);
+  put_float_data(2, 500);
+  end_wav();
+
+  expect_error("Extensible without a sub-format",
+               open_wav(SAMPLES_PER_SECOND, false),
+               "The WAV file's format is not supported.");
+}
+
+static void rate_mismatch(void) {
+  begin_wav();
+  const size_t chunk = begin_chunk("fmt ");
+  put_format(3, 1, 48000, 4, 32);
+  end_chunk(chunk);
+  put_float_data(1, 100);
+  end_wav();
+
+  expect_error("Rate mismatch", open_wav(SAMPLES_PER_SECOND, false),
+               "The WAV file's sample rate does not match that of the audio.");
+}
+
+// Mono streams loop and seek, including past their end.
+static void looping_and_seeking(void) {
+  begin_wav();
+  const size_t chunk = begin_chunk("fmt ");
+  put_format(3, 1, SAMPLES_PER_SECOND, 4, 32);
+  end_chunk(chunk);
+  put_float_data(1, 100);
+  end_wav();
+
+  const char *error = open_wav(SAMPLES_PER_SECOND, true);
+  check(error == NULL, "Looping: Failed to open: %s", error);
+  mix("Looping", 250, 0, 100, 250, false);
+  mix("Looping again", 100, 50, 100, 100, false);
+  audio_stream_seek(&stream, 90);
+  mix("Looping after seeking", 20, 90, 100, 20, false);
+  audio_stream_seek(&stream, 1000);
+  mix("Looping after seeking past the end", 10, 0, 100, 10, false);
+
+  error = open_wav(SAMPLES_PER_SECOND, false);
+  check(error == NULL, "Seeking: Failed to open: %s", error);
+  audio_stream_seek(&stream, 40);
+  mix("Seeking", 20, 40, 100, 20, false);
+  audio_stream_seek(&stream, 1000);
+  mix("Seeking past the end", 10, 0, 100, 0, true);
+  audio_stream_seek(&stream, 0);
+  mix("Seeking back", 100, 0, 100, 100, true);
+}
+
+static const int16_t ima_steps[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int ima_index_changes[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+// The state of an IMA ADPCM encoder for one channel, which tracks exactly what
+// a decoder will reconstruct.
+typedef struct {
+  int predictor;
+  int index;
+} ima_encoder;
+
+static uint8_t ima_encode(ima_encoder *const encoder, const int target) {
+  const int step = ima_steps[encoder->index];
+  int difference = target - encoder->predictor;
+  uint8_t code = 0;
+
+  if (difference < 0) {
+    code = 8;
+    difference = -difference;
+  }
+
+  if (difference >= step) {
+    code |= 4;
+    difference -= step;
+  }
+
+  if (difference >= step / 2) {
+    code |= 2;
+    difference -= step / 2;
+  }
+
+  if (difference >= step / 4) {
+    code |= 1;
+  }
+
+  int reconstructed = step >> 3;
+  reconstructed += code & 4 ? step : 0;
+  reconstructed += code & 2 ? step >> 1 : 0;
+  reconstructed += code & 1 ? step >> 2 : 0;
+  encoder->predictor += code & 8 ? -reconstructed : reconstructed;
+  encoder->predictor = encoder->predictor < -32768  ? -32768
+                       : encoder->predictor > 32767 ? 32767
+                                                    : encoder->predictor;
+  encoder->index += ima_index_changes[code & 7];
+  encoder->index = encoder->index < 0    ? 0
+                   : encoder->index > 88 ? 88
+                                         : encoder->index;
+  return code;
+}
+
+// Encodes a loud, sweeping tone as IMA ADPCM, with a final block holding only
+// some of its groups, and a fact chunk trimming off the end of that block.
+static void ima_adpcm(const int channels) {
+  const int full_blocks = 3;
+  const int final_groups = 3;
+  const int encoded_frames = full_blocks * IMA_SAMPLES_PER_BLOCK +
+                             final_groups * 8 + 1;
+  const int frames = encoded_frames - 5;
+  const uint16_t block_align =
+      (uint16_t)(4 * channels * (IMA_GROUPS_PER_BLOCK + 1));
+
+  begin_wav();
+  size_t chunk = begin_chunk("fmt ");
+  put_format(0x11, (uint16_t)channels, SAMPLES_PER_SECOND, block_align, 4);
+  put_uint16(2);
+  put_uint16(IMA_SAMPLES_PER_BLOCK);
+  end_chunk(chunk);
+  chunk = begin_chunk("fact");
+  put_uint32((uint32_t)frames);
+  end_chunk(chunk);
+  chunk = begin_chunk("data");
+
+  ima_encoder encoders[2] = {{0, 0}, {0, 0}};
+
+  for (int first = 0; first < encoded_frames; first += IMA_SAMPLES_PER_BLOCK) {
+    const int groups = first + IMA_SAMPLES_PER_BLOCK <= encoded_frames
+                           ? IMA_GROUPS_PER_BLOCK
+                           : final_groups;
+
+    for (int channel = 0; channel < channels; channel++) {
+      const int target =
+          (int)(sin(first * 0.02 + channel) * 20000.0 * (1 + channel));
+      encoders[channel].predictor =
+          target < -32768 ? -32768 : target > 32767 ? 32767 : target;
+      put_uint16((uint16_t)(int16_t)encoders[channel].predictor);
+      const uint8_t header[] = {(uint8_t)encoders[channel].index, 0};
+      put_bytes(header, sizeof(header));
+      source[first][channel] = encoders[channel].predictor / 32768.0;
+    }
+
+    for (int group = 0; group < groups; group++) {
+      for (int channel = 0; channel < channels; channel++) {
+        uint8_t bytes[4] = {0, 0, 0, 0};
+
+        for (int nibble = 0; nibble < 8; nibble++) {
+          const int frame = first + 1 + group * 8 + nibble;
+          const int target = (int)(sin(frame * (0.02 + frame * 0.0001) +
+                                       channel) *
+                                   20000.0 * (1 + channel));
+          bytes[nibble / 2] |= ima_encode(&encoders[channel], target)
+                               << (nibble % 2 * 4);
+          source[frame][channel] = encoders[channel].predictor / 32768.0;
+        }
+
+        put_bytes(bytes, sizeof(bytes));
+      }
+    }
+  }
+
+  end_chunk(chunk);
+  end_wav();
+
+  for (int frame = 0; frame < encoded_frames; frame++) {
+    if (channels == 1) {
+      source[frame][1] = source[frame][0];
+    }
+  }
+
+  const char *const name = channels == 1 ? "Mono IMA ADPCM" : "IMA ADPCM";
+  const char *const error = open_wav(SAMPLES_PER_SECOND, false);
+  check(error == NULL, "%s: Failed to open: %s", name, error);
+
+  // Runs of samples start and end part way through blocks.
+  mix(name, 50, 0, (uint64_t)frames, 50, false);
+  mix(name, 100, 50, (uint64_t)frames, 100, false);
+  mix(name, 400, 150, (uint64_t)frames, (uint32_t)frames - 150, true);
+
+  audio_stream_seek(&stream, IMA_SAMPLES_PER_BLOCK * 2 + 7);
+  mix(name, 30, IMA_SAMPLES_PER_BLOCK * 2 + 7, (uint64_t)frames, 30, false);
+  audio_stream_seek(&stream, 3);
+  mix(name, 10, 3, (uint64_t)frames, 10, false);
+}
+
+int main(void) {
+  chunk_order();
+  truncated();
+  extensible();
+  rate_mismatch();
+  looping_and_seeking();
+  ima_adpcm(1);
+  ima_adpcm(2);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,425 @@
+#include "../library/audio_backend.h"
+#include "../library/audio_ring.h"
+#include "../library/event_loop_core.h"
+#include "../library/input.h"
+#include "../library/null_audio_backend.h"
+#include "../library/scheduler.h"
+#include "../library/virtual_clock.h"
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TICKS_PER_SECOND 43
+#define SAMPLES_PER_TICK 1024
+#define TICKS_PER_BUFFER 4
+#define SAMPLES_PER_BUFFER (SAMPLES_PER_TICK * TICKS_PER_BUFFER)
+
+// Two buffers of ticks may be executed back-to-back.
+#define MAXIMUM_TICKS_PER_BATCH 8
+
+// The number of samples played between display refreshes, as at 60Hz and
+// 44100Hz.
+#define SAMPLES_PER_REFRESH 735
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+// Each tick marks the first sample of its audio with how many ticks have been
+// executed (including itself), so that silence is zero.
+static uint32_t executed_ticks = 0;
+
+static void tick(const input *const input, float *const audio) {
+  (void)input;
+  executed_ticks++;
+  audio[0] = (float)executed_ticks;
+}
+
+static void video(const input *const input,
+                  const float tick_progress_unit_interval) {
+  (void)input;
+  (void)tick_progress_unit_interval;
+}
+
+static int64_t now(void *const state) {
+  (void)state;
+  return 0;
+}
+
+static const event_loop_timer timer = {.state = NULL, .now = now};
+
+// An event loop core driven by a virtual clock, which publishes its audio to
+// a null audio backend as run_event_loop's audio thread would.
+typedef struct {
+  virtual_clock virtual_clock;
+  float *samples;
+  audio_ring audio_ring;
+  null_audio_backend null_audio_backend;
+  event_loop_core event_loop_core;
+  event_loop_statistics statistics;
+
+  // The state of the audio thread.
+  uint32_t completed_buffers;
+  int queued_buffers;
+  uint32_t underruns;
+  int minimum_slack;
+
+  // What the null audio backend has been given.
+  uint32_t latest_tick;
+  uint64_t silent_ticks;
+  uint64_t repeated_ticks;
+} simulation;
+
+static audio_backend backend(simulation *const simulation) {
+  return null_audio_backend_interface(&simulation->null_audio_backend);
+}
+
+static uint32_t position(simulation *const simulation) {
+  const audio_backend audio_backend = backend(simulation);
+  uint32_t position;
+  const char *const error =
+      audio_backend.get_position(audio_backend.state, &position);
+  check(error == NULL, "Failed to get the position: %s", error);
+  return position;
+}
+
+// Checks that the ticks heard within a buffer continue on from those heard
+// before, with nothing lost or played twice, counting any silence or repeats
+// introduced by the catch up policy.
+static void hear(simulation *const simulation, const float *const buffer) {
+  for (int tick_index = 0; tick_index < TICKS_PER_BUFFER; tick_index++) {
+    const float marker = buffer[tick_index * SAMPLES_PER_TICK * 2];
+
+    if (marker == (float)(simulation->latest_tick + 1)) {
+      simulation->latest_tick++;
+    } else if (marker == 0.0f) {
+      simulation->silent_ticks++;
+    } else if (marker == (float)simulation->latest_tick) {
+      simulation->repeated_ticks++;
+    } else {
+      check(false, "Heard tick %.0f after tick %u.", marker,
+            simulation->latest_tick);
+      simulation->latest_tick = (uint32_t)marker;
+    }
+  }
+}
+
+// Does as run_event_loop's audio thread would each time it wakes: releases
+// the slots which finished playing, noting whether the audio ran dry, then
+// submits every slot waiting in the ring.  Slots are played in the order
+// they are submitted, so each is heard as it is submitted.
+static void service(simulation *const simulation) {
+  const audio_backend audio_backend = backend(simulation);
+  uint32_t completed_buffers;
+  const char *const completed_error =
+      audio_backend.get_completed(audio_backend.state, &completed_buffers);
+  check(completed_error == NULL, "Failed to get the completed buffers: %s",
+        completed_error);
+
+  const uint32_t newly_completed_buffers =
+      completed_buffers - simulation->completed_buffers;
+
+  for (uint32_t index = 0; index < newly_completed_buffers; index++) {
+    audio_ring_release(&simulation->audio_ring);
+  }
+
+  simulation->queued_buffers -= (int)newly_completed_buffers;
+
+  if (newly_completed_buffers > 0) {
+    simulation->completed_buffers = completed_buffers;
+
+    if (simulation->queued_buffers == 0) {
+      simulation->underruns++;
+    }
+
+    const int slack = simulation->queued_buffers +
+                      (int)audio_ring_waiting(&simulation->audio_ring);
+
+    if (slack < simulation->minimum_slack) {
+      simulation->minimum_slack = slack;
+    }
+  }
+
+  uint32_t slot;
+
+  while (simulation->queued_buffers <
+             (int)audio_backend.get_capacity(audio_backend.state) &&
+         audio_ring_begin_read(&simulation->audio_ring, &slot)) {
+    const float *const samples = audio_ring_slot(&simulation->audio_ring, slot);
+    hear(simulation, samples);
+    const char *const submit_error =
+        audio_backend.submit(audio_backend.state, slot, samples);
+    check(submit_error == NULL, "Failed to submit: %s", submit_error);
+    simulation->queued_buffers++;
+  }
+}
+
+static simulation *start(const int minimum_buffers, const int maximum_buffers,
+                         const int catch_up_policy) {
+  simulation *const simulation = calloc(1, sizeof(*simulation));
+
+  if (simulation == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  simulation->virtual_clock.samples_per_refresh = SAMPLES_PER_REFRESH;
+  simulation->minimum_slack = INT_MAX;
+
+  executed_ticks = 0;
+  event_loop_core *const event_loop_core = &simulation->event_loop_core;
+  event_loop_core_initialize(
+      event_loop_core, &timer, TICKS_PER_SECOND, tick, video, SAMPLES_PER_TICK,
+      TICKS_PER_BUFFER, minimum_buffers, maximum_buffers,
+      MAXIMUM_TICKS_PER_BATCH, catch_up_policy, NULL, NULL,
+      &simulation->statistics, 0);
+
+  const int slots = event_loop_core->maximum_buffers;
+  simulation->samples =
+      calloc((size_t)slots * SAMPLES_PER_BUFFER * 2, sizeof(float));
+
+  if (simulation->samples == NULL) {
+    fprintf(stderr, "Failed to allocate memory.\n");
+    exit(1);
+  }
+
+  audio_ring_initialize(&simulation->audio_ring, simulation->samples, slots,
+                        SAMPLES_PER_BUFFER * 2);
+
+  const char *const open_error =
+      null_audio_backend_open(&simulation->null_audio_backend, NULL,
+                              SAMPLES_PER_BUFFER, slots, AUDIO_FORMAT_FLOAT);
+  check(open_error == NULL, "Failed to open: %s", open_error);
+
+  const audio_backend audio_backend = backend(simulation);
+
+  for (int slot = 0; slot < slots; slot++) {
+    const char *const prepare_error = audio_backend.prepare(
+        audio_backend.state, (uint32_t)slot,
+        audio_ring_slot(&simulation->audio_ring, (uint32_t)slot));
+    check(prepare_error == NULL, "Failed to prepare: %s", prepare_error);
+  }
+
+  event_loop_core_prime(event_loop_core, &simulation->audio_ring);
+  check(event_loop_core->error == NULL, "Failed to prime: %s",
+        event_loop_core->error);
+
+  // The audio backend starts playing as soon as it has been primed.
+  service(simulation);
+  const char *const resume_error = audio_backend.resume(audio_backend.state);
+  check(resume_error == NULL, "Failed to resume: %s", resume_error);
+  return simulation;
+}
+
+static void stop(simulation *const simulation) {
+  const audio_backend audio_backend = backend(simulation);
+  const char *const reset_error = audio_backend.reset(audio_backend.state);
+  check(reset_error == NULL, "Failed to reset: %s", reset_error);
+  const char *const close_error = audio_backend.close(audio_backend.state);
+  check(close_error == NULL, "Failed to close: %s", close_error);
+  free(simulation->samples);
+  free(simulation);
+}
+
+// Awaits a display refresh, over which the null audio backend plays as an
+// audio device would, then does as run_event_loop would: replaces the buffers
+// which finished playing and checks the progress given to video.
+static int refresh(simulation *const simulation) {
+  const scheduler_clock scheduler_clock =
+      virtual_clock_interface(&simulation->virtual_clock);
+  const char *const refresh_error =
+      scheduler_clock.wait_for_refresh(scheduler_clock.state);
+  check(refresh_error == NULL, "Failed to await a refresh: %s", refresh_error);
+
+  null_audio_backend_advance(&simulation->null_audio_backend,
+                             simulation->virtual_clock.samples_per_refresh);
+  service(simulation);
+
+  bool adapted;
+  int refills;
+  const char *const refill_error = event_loop_core_refill(
+      &simulation->event_loop_core, &simulation->audio_ring,
+      simulation->completed_buffers, simulation->underruns,
+      simulation->minimum_slack, &adapted, &refills);
+  check(refill_error == NULL, "Failed to refill: %s", refill_error);
+
+  if (adapted) {
+    simulation->minimum_slack = INT_MAX;
+  }
+
+  service(simulation);
+
+  const float progress =
+      event_loop_core_progress(&simulation->event_loop_core,
+                               position(simulation));
+  check(progress >= 0.0f && progress < 1.0f,
+        "Refresh %llu: Progress was %f.",
+        (unsigned long long)simulation->virtual_clock.refreshes, progress);
+
+  return refills;
+}
+
+// Steps a simple linear congruential generator.
+static uint32_t random_next(uint32_t *const state) {
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+// Runs with uneven gaps between refreshes (including the occasional missed
+// refresh) until the position has wrapped past 2^32, at which point nothing
+// may have been lost, repeated or played late.
+static void jitter_and_wraparound(void) {
+  simulation *const simulation = start(0, 0, CATCH_UP_POLICY_DROP);
+  uint32_t random = 1;
+  uint64_t played = 0;
+  bool wrapped = false;
+
+  while (played < ((uint64_t)1 << 32) + SAMPLES_PER_BUFFER * 100) {
+    const uint32_t before = position(simulation);
+    const uint32_t roll = random_next(&random);
+    simulation->virtual_clock.samples_per_refresh =
+        roll % 64 == 0 ? SAMPLES_PER_BUFFER + roll % SAMPLES_PER_BUFFER
+                       : SAMPLES_PER_REFRESH - 400 + roll % 801;
+    played += simulation->virtual_clock.samples_per_refresh;
+    refresh(simulation);
+    wrapped = wrapped || position(simulation) < before;
+
+    if (failures > 0) {
+      break;
+    }
+  }
+
+  check(wrapped, "The position never wrapped.");
+  check(simulation->underruns == 0, "The audio ran dry %u times.",
+        simulation->underruns);
+  check(simulation->silent_ticks == 0 && simulation->repeated_ticks == 0,
+        "Heard %llu silent and %llu repeated ticks.",
+        (unsigned long long)simulation->silent_ticks,
+        (unsigned long long)simulation->repeated_ticks);
+  check(simulation->statistics.discarded_ticks == 0,
+        "Discarded %llu ticks.",
+        (unsigned long long)simulation->statistics.discarded_ticks);
+  check(simulation->statistics.batches > 0,
+        "No missed refresh led to a batch.");
+  check(executed_ticks ==
+            simulation->event_loop_core.submitted_buffers * TICKS_PER_BUFFER,
+        "Executed %u ticks for %u buffers.", executed_ticks,
+        simulation->event_loop_core.submitted_buffers);
+  stop(simulation);
+}
+
+// Lets the number of buffers in flight shrink once stable, then reports the
+// audio output briefly running dry so that it grows again, repeatedly.  The
+// progress given to video must follow the audio throughout.
+static void adaptation(void) {
+  simulation *const simulation = start(2, 6, CATCH_UP_POLICY_DROP);
+  int grew = 0;
+  int shrank = 0;
+
+  for (int refresh_index = 1; refresh_index <= 20000; refresh_index++) {
+    const int before = simulation->event_loop_core.buffers;
+
+    if (refresh_index % 1000 == 0) {
+      simulation->underruns++;
+    }
+
+    refresh(simulation);
+
+    const int after = simulation->event_loop_core.buffers;
+    grew += after > before;
+    shrank += after < before;
+  }
+
+  check(grew > 0 && shrank > 0, "Grew %d and shrank %d times.", grew,
+        shrank);
+  check(simulation->silent_ticks == 0 && simulation->repeated_ticks == 0,
+        "Heard %llu silent and %llu repeated ticks while adapting.",
+        (unsigned long long)simulation->silent_ticks,
+        (unsigned long long)simulation->repeated_ticks);
+  stop(simulation);
+}
+
+// Stalls long enough for every buffer in flight to finish playing at once,
+// checking how the resulting backlog is handled by a catch up policy, and
+// that the event loop then recovers.
+static void catch_up(const int catch_up_policy, const int expected_refills,
+                     const uint64_t expected_silent_ticks,
+                     const uint64_t expected_repeated_ticks) {
+  simulation *const simulation = start(0, 0, catch_up_policy);
+  const int buffers = simulation->event_loop_core.buffers;
+
+  for (int refresh_index = 0; refresh_index < 100; refresh_index++) {
+    refresh(simulation);
+  }
+
+  const uint32_t ticks_before = executed_ticks;
+  const uint32_t in_flight = simulation->event_loop_core.submitted_buffers -
+                             simulation->completed_buffers;
+  null_audio_backend_advance(
+      &simulation->null_audio_backend,
+      in_flight * SAMPLES_PER_BUFFER -
+          (position(simulation) -
+           simulation->completed_buffers * SAMPLES_PER_BUFFER) -
+          SAMPLES_PER_REFRESH);
+
+  const int refills = refresh(simulation);
+
+  check(refills == expected_refills,
+        "Policy %d: Refilled %d buffers after a stall of %d, not %d.",
+        catch_up_policy, refills, buffers, expected_refills);
+  check(executed_ticks - ticks_before ==
+            MAXIMUM_TICKS_PER_BATCH / TICKS_PER_BUFFER * TICKS_PER_BUFFER,
+        "Policy %d: Executed %u ticks in a batch.", catch_up_policy,
+        executed_ticks - ticks_before);
+  check(simulation->statistics.batches == 1,
+        "Policy %d: Counted %llu batches.", catch_up_policy,
+        (unsigned long long)simulation->statistics.batches);
+  check(simulation->statistics.discarded_ticks ==
+            (uint64_t)(refills - MAXIMUM_TICKS_PER_BATCH / TICKS_PER_BUFFER) *
+                TICKS_PER_BUFFER,
+        "Policy %d: Counted %llu discarded ticks.", catch_up_policy,
+        (unsigned long long)simulation->statistics.discarded_ticks);
+
+  // Slowing down leaves fewer buffers in flight, to be topped up next time.
+  const int top_up = refresh(simulation);
+  check(top_up == buffers - refills,
+        "Policy %d: Topped up %d buffers after catching up.", catch_up_policy,
+        top_up);
+
+  for (int refresh_index = 0; refresh_index < 100; refresh_index++) {
+    refresh(simulation);
+  }
+
+  check(simulation->silent_ticks == expected_silent_ticks &&
+            simulation->repeated_ticks == expected_repeated_ticks,
+        "Policy %d: Heard %llu silent and %llu repeated ticks.",
+        catch_up_policy, (unsigned long long)simulation->silent_ticks,
+        (unsigned long long)simulation->repeated_ticks);
+  stop(simulation);
+}
+
+int main(void) {
+  jitter_and_wraparound();
+  adaptation();
+
+  // Three buffers are in flight by default, but only two may be executed
+  // back-to-back, leaving one buffer of ticks over.
+  catch_up(CATCH_UP_POLICY_DROP, 3, TICKS_PER_BUFFER, 0);
+  catch_up(CATCH_UP_POLICY_SLOW, 2, 0, 0);
+  catch_up(CATCH_UP_POLICY_EXTEND, 3, 0, TICKS_PER_BUFFER);
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+#include "../library/frame_codec.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEADER_BYTES 14
+#define END_MARKER_BYTES 8
+
+// Long enough for a run to span several of the encoder's scans and to need
+// more than one QOI_OP_RUN.
+#define RUN_PIXELS 200
+
+// The most pixels in any frame below.
+#define MAXIMUM_PIXELS 4096
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+static uint8_t pixels[MAXIMUM_PIXELS * 4];
+static uint8_t decoded[MAXIMUM_PIXELS * 4];
+static uint8_t encoded[HEADER_BYTES + MAXIMUM_PIXELS * 5 + END_MARKER_BYTES +
+                       16];
+
+static void set_pixel(const int pixel, const int channels, const uint8_t blue,
+                      const uint8_t green, const uint8_t red,
+                      const uint8_t opacity) {
+  uint8_t *const bytes = pixels + pixel * channels;
+  bytes[0] = blue;
+  bytes[1] = green;
+  bytes[2] = red;
+
+  if (channels == 4) {
+    bytes[3] = opacity;
+  }
+}
+
+static int hash(const uint8_t blue, const uint8_t green, const uint8_t red,
+                const uint8_t opacity) {
+  return (red * 3 + green * 5 + blue * 7 + opacity * 11) % 64;
+}
+
+// Encodes the frame in pixels, checking that it decodes back exactly, and
+// returns the number of bytes encoded.
+static size_t round_trip(const char *const name, const int rows,
+                         const int columns, const int channels) {
+  const size_t bytes =
+      frame_codec_encode(pixels, rows, columns, channels, encoded);
+
+  check(bytes <= frame_codec_maximum_bytes(rows, columns, channels),
+        "%s (%d channels): encoded %zu bytes, more than the maximum of %zu.",
+        name, channels, bytes,
+        frame_codec_maximum_bytes(rows, columns, channels));
+
+  check(memcmp(encoded, "qoif", 4) == 0 && encoded[12] == channels &&
+            encoded[13] == 0,
+        "%s (%d channels): the header is incorrect.", name, channels);
+
+  static const uint8_t end_marker[END_MARKER_BYTES] = {0, 0, 0, 0,
+                                                       0, 0, 0, 1};
+  check(memcmp(encoded + bytes - END_MARKER_BYTES, end_marker,
+               END_MARKER_BYTES) == 0,
+        "%s (%d channels): the end marker is missing.", name, channels);
+
+  const size_t pixel_bytes = (size_t)rows * columns * channels;
+  memset(decoded, 0xcd, pixel_bytes);
+
+  // Further bytes after the image are allowed, and left unconsumed.
+  encoded[bytes] = 0xff;
+  size_t consumed = 0;
+  const char *const error = frame_codec_decode(
+      encoded, bytes + 1, rows, columns, channels, decoded, &consumed);
+
+  check(error == NULL, "%s (%d channels): decoding failed with \"%s\".", name,
+        channels, error);
+  check(consumed == bytes,
+        "%s (%d channels): decoding consumed %zu bytes, not %zu.", name,
+        channels, consumed, bytes);
+  check(memcmp(decoded, pixels, pixel_bytes) == 0,
+        "%s (%d channels): decoding did not reproduce the frame.", name,
+        channels);
+
+  return bytes;
+}
+
+// Round trips the frame in pixels, checking that the ops between the header
+// and the end marker are exactly those expected.
+static void check_ops(const char *const name, const int columns,
+                      const int channels, const uint8_t *const expected,
+                      const size_t expected_bytes) {
+  const size_t bytes = round_trip(name, 1, columns, channels);
+
+  if (bytes != HEADER_BYTES + expected_bytes + END_MARKER_BYTES) {
+    check(false, "%s (%d channels): encoded %zu bytes of ops, not %zu.", name,
+          channels, bytes - HEADER_BYTES - END_MARKER_BYTES, expected_bytes);
+    return;
+  }
+
+  for (size_t byte = 0; byte < expected_bytes; byte++) {
+    check(encoded[HEADER_BYTES + byte] == expected[byte],
+          "%s (%d channels): op byte %zu is 0x%02x, not 0x%02x.", name,
+          channels, byte, encoded[HEADER_BYTES + byte], expected[byte]);
+  }
+}
+
+static void check_runs(const int channels) {
+  // The previous pixel starts as opaque black, so a frame of it is all runs,
+  // ending at the last pixel.
+  for (int length = 1; length <= RUN_PIXELS; length++) {
+    for (int pixel = 0; pixel < length; pixel++) {
+      set_pixel(pixel, channels, 0, 0, 0, 255);
+    }
+
+    uint8_t expected[4];
+    size_t expected_bytes = 0;
+
+    for (int remaining = length; remaining > 0; remaining -= 62) {
+      const int part = remaining < 62 ? remaining : 62;
+      expected[expected_bytes++] = 0xc0 | (part - 1);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "run of %d", length);
+    check_ops(name, length, channels, expected, expected_bytes);
+  }
+
+  // Runs of other colors, the first following a literal pixel and ending
+  // mid-frame, the second ending at the last pixel.
+  for (int length = 1; length <= RUN_PIXELS; length++) {
+    const int columns = 2 + length * 2;
+
+    for (int pixel = 0; pixel <= length; pixel++) {
+      set_pixel(pixel, channels, 10, 20, 30, 255);
+    }
+
+    for (int pixel = length + 1; pixel < columns; pixel++) {
+      set_pixel(pixel, channels, 200, 100, 50, 128);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "runs of %d", length);
+    round_trip(name, 1, columns, channels);
+  }
+}
+
+static void check_each_op(const int channels) {
+  // QOI_OP_DIFF: red -1, green 0, blue +1, each wrapping.
+  set_pixel(0, channels, 1, 0, 255, 255);
+  const uint8_t diff[] = {0x40 | 1 << 4 | 2 << 2 | 3};
+  check_ops("QOI_OP_DIFF", 1, channels, diff, sizeof(diff));
+
+  // QOI_OP_LUMA: green +10, red 2 more than that and blue 5 less.
+  set_pixel(0, channels, 5, 10, 12, 255);
+  const uint8_t luma[] = {0x80 | (10 + 32), (2 + 8) << 4 | (-5 + 8)};
+  check_ops("QOI_OP_LUMA", 1, channels, luma, sizeof(luma));
+
+  // Just beyond QOI_OP_DIFF's range of -2 to 1.
+  set_pixel(0, channels, 0, 0, 2, 255);
+  const uint8_t beyond_diff[] = {0x80 | 32, (2 + 8) << 4 | 8};
+  check_ops("QOI_OP_LUMA beyond QOI_OP_DIFF", 1, channels, beyond_diff,
+            sizeof(beyond_diff));
+
+  // QOI_OP_RGB: too far for a difference.
+  set_pixel(0, channels, 200, 0, 100, 255);
+  const uint8_t rgb[] = {0xfe, 100, 0, 200};
+  check_ops("QOI_OP_RGB", 1, channels, rgb, sizeof(rgb));
+
+  // QOI_OP_INDEX: returning to a color seen before the previous pixel.
+  set_pixel(0, channels, 200, 0, 100, 255);
+  set_pixel(1, channels, 0, 100, 200, 255);
+  set_pixel(2, channels, 200, 0, 100, 255);
+  const uint8_t index[] = {0xfe, 100, 0,   200, 0xfe, 200, 100, 0,
+                           0x00 | hash(200, 0, 100, 255)};
+  check_ops("QOI_OP_INDEX", 3, channels, index, sizeof(index));
+
+  if (channels == 4) {
+    // QOI_OP_RGBA: any change in opacity, even with the same color.
+    set_pixel(0, channels, 1, 2, 3, 4);
+    set_pixel(1, channels, 1, 2, 3, 5);
+    const uint8_t rgba[] = {0xff, 3, 2, 1, 4, 0xff, 3, 2, 1, 5};
+    check_ops("QOI_OP_RGBA", 2, channels, rgba, sizeof(rgba));
+  }
+}
+
+// Every step from the opaque black which precedes the first pixel, within and
+// just beyond the ranges of QOI_OP_DIFF and QOI_OP_LUMA.
+static void check_differences(const int channels) {
+  for (int green = -34; green <= 33; green++) {
+    for (int red_green = -10; red_green <= 9; red_green++) {
+      for (int blue_green = -10; blue_green <= 9; blue_green++) {
+        set_pixel(0, channels, (uint8_t)(green + blue_green), (uint8_t)green,
+                  (uint8_t)(green + red_green), 255);
+        char name[64];
+        snprintf(name, sizeof(name), "red %+d, green %+d, blue %+d",
+                 green + red_green, green, green + blue_green);
+        round_trip(name, 1, 1, channels);
+      }
+    }
+  }
+}
+
+// A frame mixing every op: runs of random lengths, a small palette to index,
+// small and large steps and, with 4 channels, changes in opacity.
+static void check_mixed(const int rows, const int columns,
+                        const int channels) {
+  static const uint8_t palette[][4] = {
+      {0, 0, 0, 255},     {255, 255, 255, 255}, {10, 200, 30, 255},
+      {64, 64, 64, 128},  {1, 2, 3, 0},         {250, 5, 128, 255},
+      {30, 30, 200, 255}, {99, 98, 97, 200},
+  };
+  uint32_t state = (uint32_t)(rows * 7919 + columns * 104729 + channels);
+  int pixel = 0;
+  uint8_t blue = 0, green = 0, red = 0, opacity = 255;
+
+  while (pixel < rows * columns) {
+    state = state * 1664525u + 1013904223u;
+    const int choice = state >> 28;
+    int length = 1;
+
+    if (choice < 4) {
+      const uint8_t *const color = palette[(state >> 8) & 7];
+      blue = color[0];
+      green = color[1];
+      red = color[2];
+      opacity = color[3];
+    } else if (choice < 8) {
+      blue += (int)((state >> 8) % 5) - 2;
+      green += (int)((state >> 12) % 5) - 2;
+      red += (int)((state >> 16) % 5) - 2;
+    } else if (choice < 11) {
+      const int step = (int)((state >> 8) & 63) - 32;
+      green += step;
+      red += step + (int)((state >> 14) & 15) - 8;
+      blue += step + (int)((state >> 18) & 15) - 8;
+    } else if (choice < 13) {
+      blue = state >> 8;
+      green = state >> 16;
+      red = state >> 20;
+    } else {
+      length = 1 + (int)((state >> 8) % RUN_PIXELS);
+    }
+
+    if (channels == 4 && choice == 15) {
+      opacity = state >> 4;
+    }
+
+    for (; length > 0 && pixel < rows * columns; length--) {
+      set_pixel(pixel++, channels, blue, green, red, opacity);
+    }
+  }
+
+  char name[48];
+  snprintf(name, sizeof(name), "mixed %dx%d", columns, rows);
+  round_trip(name, rows, columns, channels);
+}
+
+static void check_errors(const int channels) {
+  check_mixed(16, 16, channels);
+  const size_t bytes = frame_codec_encode(pixels, 16, 16, channels, encoded);
+
+  // Every truncation, whether within the header, an op or the end marker,
+  // must be noticed rather than read beyond.
+  for (size_t truncated = 0; truncated < bytes; truncated++) {
+    uint8_t *const copy = malloc(truncated == 0 ? 1 : truncated);
+
+    if (copy == NULL) {
+      fprintf(stderr, "Failed to allocate memory.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    memcpy(copy, encoded, truncated);
+    size_t consumed = 12345;
+    check(frame_codec_decode(copy, truncated, 16, 16, channels, decoded,
+                             &consumed) != NULL,
+          "Truncated to %zu of %zu bytes (%d channels): decoding succeeded.",
+          truncated, bytes, channels);
+    check(consumed == 12345,
+          "Truncated to %zu of %zu bytes (%d channels): consumed was written.",
+          truncated, bytes, channels);
+    free(copy);
+  }
+
+  check(frame_codec_decode(encoded, bytes, 16, 17, channels, decoded, NULL) !=
+            NULL,
+        "A frame with too few columns (%d channels) was decoded.", channels);
+  check(frame_codec_decode(encoded, bytes, 15, 16, channels, decoded, NULL) !=
+            NULL,
+        "A frame with too many rows (%d channels) was decoded.", channels);
+
+  encoded[0] = 'Q';
+  check(frame_codec_decode(encoded, bytes, 16, 16, channels, decoded, NULL) !=
+            NULL,
+        "A frame without the QOI magic (%d channels) was decoded.", channels);
+
+  // A run past the last pixel.
+  set_pixel(0, channels, 0, 0, 0, 255);
+  set_pixel(1, channels, 0, 0, 0, 255);
+  const size_t run_bytes =
+      frame_codec_encode(pixels, 1, 2, channels, encoded);
+  encoded[HEADER_BYTES] = 0xc0 | 2;
+  check(frame_codec_decode(encoded, run_bytes, 1, 2, channels, decoded,
+                           NULL) != NULL,
+        "A run past the last pixel (%d channels) was decoded.", channels);
+}
+
+int main(void) {
+  static const int sizes[][2] = {{1, 1}, {1, 63}, {3, 17}, {7, 33},
+                                 {16, 16}, {20, 100}, {64, 64}};
+
+  for (int channels = 3; channels <= 4; channels++) {
+    check_runs(channels);
+    check_each_op(channels);
+    check_differences(channels);
+
+    for (size_t size = 0; size < sizeof(sizes) / sizeof(sizes[0]); size++) {
+      check_mixed(sizes[size][0], sizes[size][1], channels);
+    }
+
+    check_errors(channels);
+  }
+
+  return failures == 0 ? 0 : 1;
+}
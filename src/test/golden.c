@@ -0,0 +1,310 @@
+#include "../library/golden.h"
+#include "../library/input.h"
+#include "../library/input_recording.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define RECORDING_PATH "dist/test/golden.input"
+#define GOLDEN_PATH "dist/test/golden.gold"
+
+// As the example application.
+#define ROWS 192
+#define COLUMNS 256
+#define SAMPLES_PER_TICK 441
+
+// The window which layered frames are scaled for.
+#define WIDTH 1280
+#define HEIGHT 720
+
+#define TICKS 600
+
+// Wide enough for several of golden_compare's 16-byte vectors, and a partial
+// one, with either number of channels.
+#define COMPARE_ROWS 3
+#define COMPARE_COLUMNS 37
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+static float opacities[ROWS * COLUMNS];
+static float reds[ROWS * COLUMNS];
+static float greens[ROWS * COLUMNS];
+static float blues[ROWS * COLUMNS];
+
+static const uint32_t checkpoints[] = {0, 1, 60, 150, 300, 450, 600};
+
+// The state of the application, which follows the pointer.
+static float row;
+static float column;
+static int samples;
+
+// When positive, the tick at which a bug is introduced into the application.
+static int audio_bug;
+static int video_bug;
+static int ticks;
+
+static void tick(const input *const input, float *const audio) {
+  if (input->pointer_state != POINTER_STATE_NONE) {
+    row += (input->pointer_row - row) * 0.1f;
+    column += (input->pointer_column - column) * 0.1f;
+  }
+
+  ticks++;
+
+  const float pitch = audio_bug > 0 && ticks >= audio_bug ? 0.0314f : 0.0313f;
+
+  for (int sample = 0; sample < SAMPLES_PER_TICK; sample++) {
+    const float unmixed = (float)sin(samples * pitch) * 0.25f;
+    audio[sample * 2] = unmixed;
+    audio[sample * 2 + 1] = unmixed;
+    samples++;
+  }
+}
+
+// The bug introduced into the video darkens these pixels.
+#define VIDEO_BUG_TOP 20
+#define VIDEO_BUG_LEFT 30
+#define VIDEO_BUG_BOTTOM 25
+#define VIDEO_BUG_RIGHT 40
+
+static void video(const input *const input,
+                  const float tick_progress_unit_interval) {
+  (void)input;
+  (void)tick_progress_unit_interval;
+
+  for (int pixel_row = 0; pixel_row < ROWS; pixel_row++) {
+    for (int pixel_column = 0; pixel_column < COLUMNS; pixel_column++) {
+      const int index = pixel_row * COLUMNS + pixel_column;
+      const bool inside = fabsf(pixel_row - row) < 8.0f &&
+                          fabsf(pixel_column - column) < 8.0f;
+      opacities[index] = inside ? 1.0f : 0.5f;
+      reds[index] = inside ? 1.0f : 0.1f;
+      greens[index] = inside ? 0.8f : (float)pixel_row / ROWS;
+      blues[index] = inside ? 0.2f : (float)pixel_column / COLUMNS;
+    }
+  }
+
+  if (video_bug > 0 && ticks >= video_bug) {
+    reds[VIDEO_BUG_TOP * COLUMNS + VIDEO_BUG_LEFT] = 0.0f;
+    reds[VIDEO_BUG_BOTTOM * COLUMNS + VIDEO_BUG_RIGHT] = 0.0f;
+  }
+}
+
+static bool write_recording(void) {
+  input_recording recording;
+  const char *error = input_recording_open(&recording, RECORDING_PATH, true);
+
+  if (error != NULL) {
+    check(false, "%s", error);
+    return false;
+  }
+
+  for (int index = 0; index < TICKS && error == NULL; index++) {
+    const input input = {
+        .pointer_state =
+            index < 100 ? POINTER_STATE_NONE : POINTER_STATE_HOVER,
+        .pointer_row = (float)(index % ROWS),
+        .pointer_column = (float)(index * 3 % COLUMNS),
+        .held_keys = {0, 0, 0, 0, 0, 0, 0, 0},
+        .events = NULL,
+        .number_of_events = 0,
+    };
+
+    error = input_recording_write(&recording, &input);
+  }
+
+  const char *const close_error = input_recording_close(&recording);
+
+  check(error == NULL && close_error == NULL, "%s",
+        error != NULL ? error : close_error);
+  return error == NULL && close_error == NULL;
+}
+
+// Replays the recording against the golden file (or records it), checking
+// that any bugs introduced are detected by the first checkpoint after they
+// take effect, and located.
+static void run(const char *const name, const bool layered, const bool record,
+                const int audio_bug_tick, const int video_bug_tick) {
+  row = ROWS / 2;
+  column = COLUMNS / 2;
+  samples = 0;
+  ticks = 0;
+  audio_bug = audio_bug_tick;
+  video_bug = video_bug_tick;
+
+  bool diverged;
+  golden_divergence divergence;
+
+  const char *const error = run_golden(
+      RECORDING_PATH, GOLDEN_PATH, record, tick, ROWS, COLUMNS,
+      layered ? opacities : NULL, reds, greens, blues, video, SAMPLES_PER_TICK,
+      WIDTH, HEIGHT, checkpoints, sizeof(checkpoints) / sizeof(checkpoints[0]),
+      &diverged, &divergence);
+
+  if (error != NULL) {
+    check(false, "%s: %s", name, error);
+    return;
+  }
+
+  const bool expect_divergence = audio_bug_tick > 0 || video_bug_tick > 0;
+
+  check(diverged == expect_divergence, "%s: Expected the run to %s.", name,
+        expect_divergence ? "diverge" : "match");
+
+  if (!diverged || !expect_divergence) {
+    return;
+  }
+
+  // Each bug takes effect from the tick of the given number, counting from
+  // one, so one fewer ticks have been executed before it.
+  const int bug_tick =
+      audio_bug_tick > 0 && (video_bug_tick == 0 ||
+                             audio_bug_tick < video_bug_tick)
+          ? audio_bug_tick
+          : video_bug_tick;
+  uint32_t checkpoint = 0;
+
+  for (size_t index = 0; checkpoint < (uint32_t)bug_tick; index++) {
+    checkpoint = checkpoints[index];
+  }
+
+  check(divergence.tick == checkpoint,
+        "%s: Detected divergence at tick %u rather than %u.", name,
+        divergence.tick, checkpoint);
+
+  check(divergence.audio_diverged == (audio_bug_tick > 0),
+        "%s: Audio was %sreported to diverge.", name,
+        divergence.audio_diverged ? "" : "not ");
+
+  if (audio_bug_tick > 0) {
+    check(divergence.audio_tick == (uint32_t)audio_bug_tick - 1,
+          "%s: Audio was reported to diverge from tick %u rather than %d.",
+          name, divergence.audio_tick, audio_bug_tick - 1);
+  }
+
+  check(divergence.video_diverged == (video_bug_tick > 0),
+        "%s: Video was %sreported to diverge.", name,
+        divergence.video_diverged ? "" : "not ");
+
+  if (video_bug_tick == 0) {
+    return;
+  }
+
+  if (layered) {
+    // Scaled up, each bugged pixel covers a block of the window.
+    check(divergence.differing_pixels >= 2 &&
+              divergence.region.top >= VIDEO_BUG_TOP &&
+              divergence.region.left >= VIDEO_BUG_LEFT &&
+              divergence.region.bottom > divergence.region.top &&
+              divergence.region.right > divergence.region.left,
+          "%s: Video divergence of %llu pixels within rows %d-%d, columns "
+          "%d-%d does not cover the bug.",
+          name, (unsigned long long)divergence.differing_pixels,
+          divergence.region.top, divergence.region.bottom,
+          divergence.region.left, divergence.region.right);
+  } else {
+    check(divergence.differing_pixels == 2 &&
+              divergence.region.top == VIDEO_BUG_TOP &&
+              divergence.region.left == VIDEO_BUG_LEFT &&
+              divergence.region.bottom == VIDEO_BUG_BOTTOM + 1 &&
+              divergence.region.right == VIDEO_BUG_RIGHT + 1,
+          "%s: Video divergence of %llu pixels within rows %d-%d, columns "
+          "%d-%d does not match the bug.",
+          name, (unsigned long long)divergence.differing_pixels,
+          divergence.region.top, divergence.region.bottom,
+          divergence.region.left, divergence.region.right);
+  }
+}
+
+// Checks that golden_compare finds a single differing byte wherever it falls,
+// whether within a vector or the bytes left over after the last.
+static void check_compare(const int channels) {
+  static uint8_t expected[COMPARE_ROWS * COMPARE_COLUMNS * 4];
+  static uint8_t actual[COMPARE_ROWS * COMPARE_COLUMNS * 4];
+  const int bytes = COMPARE_ROWS * COMPARE_COLUMNS * channels;
+
+  for (int byte = 0; byte < bytes; byte++) {
+    expected[byte] = byte * 7;
+  }
+
+  memcpy(actual, expected, bytes);
+  golden_region region;
+  const uint64_t identical = golden_compare(
+      expected, actual, COMPARE_ROWS, COMPARE_COLUMNS, channels, &region);
+
+  check(identical == 0 && region.top == 0 && region.left == 0 &&
+            region.bottom == 0 && region.right == 0,
+        "Identical frames (%d channels): %llu pixels differ within rows "
+        "%d-%d, columns %d-%d.",
+        channels, (unsigned long long)identical, region.top, region.bottom,
+        region.left, region.right);
+
+  for (int byte = 0; byte < bytes; byte++) {
+    actual[byte] ^= 1;
+    const int pixel = byte / channels;
+    const int pixel_row = pixel / COMPARE_COLUMNS;
+    const int pixel_column = pixel % COMPARE_COLUMNS;
+    const uint64_t differing = golden_compare(
+        expected, actual, COMPARE_ROWS, COMPARE_COLUMNS, channels, &region);
+
+    check(differing == 1 && region.top == pixel_row &&
+              region.left == pixel_column &&
+              region.bottom == pixel_row + 1 &&
+              region.right == pixel_column + 1,
+          "Byte %d differing (%d channels): %llu pixels differ within rows "
+          "%d-%d, columns %d-%d.",
+          byte, channels, (unsigned long long)differing, region.top,
+          region.bottom, region.left, region.right);
+
+    actual[byte] ^= 1;
+  }
+
+  // Two pixels in different rows and vectors.
+  actual[(0 * COMPARE_COLUMNS + 30) * channels + 1] ^= 1;
+  actual[(2 * COMPARE_COLUMNS + 4) * channels] ^= 1;
+  const uint64_t differing = golden_compare(
+      expected, actual, COMPARE_ROWS, COMPARE_COLUMNS, channels, &region);
+
+  check(differing == 2 && region.top == 0 && region.left == 4 &&
+            region.bottom == 3 && region.right == 31,
+        "Two pixels differing (%d channels): %llu pixels differ within rows "
+        "%d-%d, columns %d-%d.",
+        channels, (unsigned long long)differing, region.top, region.bottom,
+        region.left, region.right);
+}
+
+int main(void) {
+  check_compare(3);
+  check_compare(4);
+
+  if (write_recording()) {
+    run("Opaque record", false, true, 0, 0);
+    run("Opaque verify", false, false, 0, 0);
+    run("Opaque video bug", false, false, 0, 200);
+    run("Opaque audio bug", false, false, 400, 0);
+    run("Opaque audio and video bugs", false, false, 100, 100);
+    run("Layered record", true, true, 0, 0);
+    run("Layered verify", true, false, 0, 0);
+    run("Layered video bug", true, false, 0, 200);
+  }
+
+  remove(RECORDING_PATH);
+  remove(GOLDEN_PATH);
+
+  return failures == 0 ? 0 : 1;
+}
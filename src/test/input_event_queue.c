@@ -0,0 +1,79 @@
+#include "../library/input.h"
+#include "../library/input_event_queue.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+// Pushes a number of events numbered from a given millisecond onwards.
+static void push(input_event_queue *const input_event_queue, const int from,
+                 const int count) {
+  for (int index = 0; index < count; index++) {
+    const input_event input_event = {
+        .type = INPUT_EVENT_TYPE_KEY_DOWN,
+        .milliseconds = (uint32_t)(from + index),
+        .virtual_key_code = (from + index) % 256,
+    };
+
+    check(input_event_queue_push(input_event_queue, &input_event),
+          "Failed to push event %d.", from + index);
+  }
+}
+
+// Drains the queue, checking that it held a number of events numbered from a
+// given millisecond onwards, in order.
+static void drain(input_event_queue *const input_event_queue, const int from,
+                  const int count) {
+  input_event input_events[INPUT_EVENT_QUEUE_CAPACITY];
+  const int drained = input_event_queue_drain(input_event_queue, input_events);
+
+  check(drained == count, "Drained %d events, not %d.", drained, count);
+
+  for (int index = 0; index < drained && index < count; index++) {
+    check(input_events[index].milliseconds == (uint32_t)(from + index) &&
+              input_events[index].virtual_key_code == (from + index) % 256,
+          "Event %d was drained out of order.", from + index);
+  }
+}
+
+int main(void) {
+  input_event_queue input_event_queue = {.first = 0, .count = 0};
+
+  drain(&input_event_queue, 0, 0);
+
+  push(&input_event_queue, 0, 3);
+  drain(&input_event_queue, 0, 3);
+  drain(&input_event_queue, 0, 0);
+
+  // Fills the queue, which now starts part way through, so that it wraps.
+  push(&input_event_queue, 3, INPUT_EVENT_QUEUE_CAPACITY);
+
+  const input_event dropped = {.type = INPUT_EVENT_TYPE_KEY_UP};
+  check(!input_event_queue_push(&input_event_queue, &dropped),
+        "An event was pushed to a full queue.");
+
+  drain(&input_event_queue, 3, INPUT_EVENT_QUEUE_CAPACITY);
+
+  // Repeatedly part-fills the queue so that its start walks around the ring.
+  for (int round = 0; round < 10; round++) {
+    const int from = 1000 + round * 200;
+    push(&input_event_queue, from, 150);
+    push(&input_event_queue, from + 150, 50);
+    drain(&input_event_queue, from, 200);
+  }
+
+  return failures == 0 ? 0 : 1;
+}
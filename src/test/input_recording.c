@@ -0,0 +1,175 @@
+#include "../library/input.h"
+#include "../library/input_recording.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PATH "dist/test/input_recording.bin"
+
+#define TICKS 1000
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+// Describes the input given to a tick.  Long stretches are left unchanged, and
+// some ticks are given every event which can be queued.
+static void generate(const int tick, input *const input,
+                     input_event *const input_events) {
+  const int stretch = tick / 50;
+  input->pointer_state = stretch % 3;
+  input->pointer_row = stretch * 0.75f - 3.0f;
+  input->pointer_column = stretch * -1.5f + 200.0f;
+  memset(input->held_keys, 0, sizeof(input->held_keys));
+
+  for (int key = stretch % 7; key < 256; key += 5 + stretch % 11) {
+    input->held_keys[key >> 5] |= (uint32_t)1 << (key & 31);
+  }
+
+  input->number_of_events = tick % 97 == 0 ? INPUT_EVENT_QUEUE_CAPACITY
+                            : tick % 50 < 5 ? tick % 4
+                                            : 0;
+  input->events = input_events;
+
+  for (int index = 0; index < input->number_of_events; index++) {
+    input_event *const input_event = &input_events[index];
+    input_event->type = (tick + index) % 3;
+    // The milliseconds wrap part way through the recording.
+    input_event->milliseconds = UINT32_MAX - 20000 + (uint32_t)(tick * 40);
+
+    if (input_event->type == INPUT_EVENT_TYPE_POINTER) {
+      input_event->pointer_state = (tick + index) % 3;
+      input_event->pointer_row = index * 0.25f;
+      input_event->pointer_column = tick * -0.125f;
+    } else {
+      input_event->virtual_key_code = (tick * 13 + index) % 256;
+    }
+  }
+}
+
+static void compare(const int tick, const input *const expected,
+                    const input *const actual) {
+  check(actual->pointer_state == expected->pointer_state &&
+            actual->pointer_row == expected->pointer_row &&
+            actual->pointer_column == expected->pointer_column,
+        "Tick %d: The pointer did not round trip.", tick);
+
+  check(memcmp(actual->held_keys, expected->held_keys,
+               sizeof(expected->held_keys)) == 0,
+        "Tick %d: The held keys did not round trip.", tick);
+
+  check(actual->number_of_events == expected->number_of_events,
+        "Tick %d: Read %d events, not %d.", tick, actual->number_of_events,
+        expected->number_of_events);
+
+  for (int index = 0; index < actual->number_of_events &&
+                      index < expected->number_of_events;
+       index++) {
+    const input_event *const expected_event = &expected->events[index];
+    const input_event *const actual_event = &actual->events[index];
+    bool matched = actual_event->type == expected_event->type &&
+                   actual_event->milliseconds == expected_event->milliseconds;
+
+    if (expected_event->type == INPUT_EVENT_TYPE_POINTER) {
+      matched = matched &&
+                actual_event->pointer_state == expected_event->pointer_state &&
+                actual_event->pointer_row == expected_event->pointer_row &&
+                actual_event->pointer_column == expected_event->pointer_column;
+    } else {
+      matched = matched && actual_event->virtual_key_code ==
+                               expected_event->virtual_key_code;
+    }
+
+    check(matched, "Tick %d: Event %d did not round trip.", tick, index);
+  }
+}
+
+int main(void) {
+  static input_event expected_events[INPUT_EVENT_QUEUE_CAPACITY];
+  static input_event actual_events[INPUT_EVENT_QUEUE_CAPACITY];
+  input_recording input_recording;
+  input expected;
+  input actual;
+  bool ended;
+
+  const char *error = input_recording_open(&input_recording, PATH, true);
+
+  for (int tick = 0; error == NULL && tick < TICKS; tick++) {
+    generate(tick, &expected, expected_events);
+    error = input_recording_write(&input_recording, &expected);
+  }
+
+  if (error == NULL) {
+    error = input_recording_close(&input_recording);
+  }
+
+  if (error == NULL) {
+    error = input_recording_open(&input_recording, PATH, false);
+  }
+
+  for (int tick = 0; error == NULL && tick < TICKS; tick++) {
+    error = input_recording_read(&input_recording, &actual, actual_events,
+                                 &ended);
+
+    if (error == NULL) {
+      check(!ended, "Tick %d: The recording ended early.", tick);
+
+      if (ended) {
+        break;
+      }
+
+      generate(tick, &expected, expected_events);
+      compare(tick, &expected, &actual);
+    }
+  }
+
+  if (error == NULL) {
+    error = input_recording_read(&input_recording, &actual, actual_events,
+                                 &ended);
+    check(error != NULL || ended, "The recording did not end.");
+  }
+
+  if (error == NULL) {
+    error = input_recording_close(&input_recording);
+  }
+
+  if (error != NULL) {
+    fprintf(stderr, "%s\n", error);
+    return 1;
+  }
+
+  // Anything else is rejected rather than misread.
+  FILE *const file = fopen(PATH, "wb");
+
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open \"%s\".\n", PATH);
+    return 1;
+  }
+
+  fputs("not an input recording", file);
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "Failed to write \"%s\".\n", PATH);
+    return 1;
+  }
+
+  error = input_recording_open(&input_recording, PATH, false);
+  check(error != NULL, "A file which is not an input recording was opened.");
+
+  if (error == NULL) {
+    input_recording_close(&input_recording);
+  }
+
+  return failures == 0 ? 0 : 1;
+}
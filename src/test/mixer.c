@@ -0,0 +1,410 @@
+#include "../library/mixer.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The SSE paths step gains and accumulate voices in single precision.
+#define TOLERANCE 0.0001
+
+#define MONO_FRAMES 1000
+#define STEREO_FRAMES 777
+#define SHORT_FRAMES 50
+
+// Long enough for many short sounds to end or loop within it, and not a
+// multiple of any SIMD width.
+#define MAXIMUM_SAMPLES 1023
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+static float mono[MONO_FRAMES];
+static float stereo[STEREO_FRAMES * 2];
+static float short_mono[SHORT_FRAMES];
+static float short_stereo[SHORT_FRAMES * 2];
+
+static void fill(float *const samples, const int count, uint32_t seed) {
+  for (int index = 0; index < count; index++) {
+    seed = seed * 1664525u + 1013904223u;
+    samples[index] = (float)((seed >> 8) / 8388608.0 - 1.0);
+  }
+}
+
+// A scalar, double-precision model of a voice, following what mixer.h
+// documents rather than how mixer.c is vectorised.
+typedef struct {
+  const float *samples;
+  uint32_t frames;
+  uint32_t channels;
+  uint64_t position;
+  uint64_t step;
+  double left_gain;
+  double right_gain;
+  double target_left_gain;
+  double target_right_gain;
+  bool looping;
+  bool stopping;
+  bool active;
+} reference_voice;
+
+// The mixer under test, alongside the reference voices which should sound the
+// same, indexed as the mixer's own.
+typedef struct {
+  mixer mixer;
+  reference_voice voices[MIXER_CAPACITY];
+  const char *name;
+} harness;
+
+static uint64_t step(const float pitch) {
+  return (uint64_t)((double)pitch * 4294967296.0);
+}
+
+static void pan_gains(const float gain, const float pan, double *const left,
+                      double *const right) {
+  const double angle = (pan + 1.0) * 0.78539816339744830962;
+  *left = gain * cos(angle);
+  *right = gain * sin(angle);
+}
+
+static void initialize(harness *const harness, const char *const name) {
+  mixer_initialize(&harness->mixer);
+
+  for (int index = 0; index < MIXER_CAPACITY; index++) {
+    harness->voices[index].active = false;
+  }
+
+  harness->name = name;
+}
+
+static uint32_t play(harness *const harness, const float *const samples,
+                     const uint32_t frames, const uint32_t channels,
+                     const float gain, const float pan, const float pitch,
+                     const bool looping) {
+  const uint32_t voice = mixer_play(&harness->mixer, samples, frames, channels,
+                                    gain, pan, pitch, looping);
+
+  if (voice == MIXER_NO_VOICE) {
+    return voice;
+  }
+
+  reference_voice *const reference = harness->voices + (voice & 0xFFFF);
+  check(!reference->active, "%s: Replaced voice %u while it was playing.",
+        harness->name, voice & 0xFFFF);
+  reference->samples = samples;
+  reference->frames = frames;
+  reference->channels = channels;
+  reference->position = 0;
+  reference->step = step(pitch);
+  pan_gains(gain, pan, &reference->left_gain, &reference->right_gain);
+  reference->target_left_gain = reference->left_gain;
+  reference->target_right_gain = reference->right_gain;
+  reference->looping = looping;
+  reference->stopping = false;
+  reference->active = true;
+  return voice;
+}
+
+static void adjust(harness *const harness, const uint32_t voice,
+                   const float gain, const float pan, const float pitch) {
+  mixer_adjust(&harness->mixer, voice, gain, pan, pitch);
+  reference_voice *const reference = harness->voices + (voice & 0xFFFF);
+
+  if (!reference->active || reference->stopping) {
+    return;
+  }
+
+  pan_gains(gain, pan, &reference->target_left_gain,
+            &reference->target_right_gain);
+  reference->step = step(pitch);
+}
+
+static void stop(harness *const harness, const uint32_t voice) {
+  mixer_stop(&harness->mixer, voice);
+  reference_voice *const reference = harness->voices + (voice & 0xFFFF);
+  reference->target_left_gain = 0.0;
+  reference->target_right_gain = 0.0;
+  reference->stopping = true;
+}
+
+// Reads a channel of a voice at its position, linearly interpolating towards
+// the next frame, which after the last is the first when looping, or silence.
+static double read(const reference_voice *const voice, const uint32_t channel) {
+  const uint32_t index = (uint32_t)(voice->position >> 32);
+  const double progress = (uint32_t)voice->position / 4294967296.0;
+  const double from = voice->samples[index * voice->channels + channel];
+  double to;
+
+  if (index + 1 < voice->frames) {
+    to = voice->samples[(index + 1) * voice->channels + channel];
+  } else {
+    to = voice->looping ? voice->samples[channel] : 0.0;
+  }
+
+  return from + (to - from) * progress;
+}
+
+static void reference_mix(reference_voice *const voice, double *const audio,
+                          const uint32_t samples) {
+  const uint64_t end = (uint64_t)voice->frames << 32;
+
+  for (uint32_t sample = 0; sample < samples; sample++) {
+    const double ramp = sample / (double)samples;
+    const double left_gain =
+        voice->left_gain + (voice->target_left_gain - voice->left_gain) * ramp;
+    const double right_gain =
+        voice->right_gain +
+        (voice->target_right_gain - voice->right_gain) * ramp;
+
+    audio[sample * 2] += read(voice, 0) * left_gain;
+    audio[sample * 2 + 1] +=
+        read(voice, voice->channels == 1 ? 0 : 1) * right_gain;
+    voice->position += voice->step;
+
+    if (voice->position >= end) {
+      if (voice->looping) {
+        voice->position %= end;
+      } else {
+        voice->active = false;
+        return;
+      }
+    }
+  }
+
+  voice->left_gain = voice->target_left_gain;
+  voice->right_gain = voice->target_right_gain;
+
+  if (voice->stopping) {
+    voice->active = false;
+  }
+}
+
+// Mixes both the mixer and the reference, returning the largest absolute
+// sample written by the mixer.
+static float mix(harness *const harness, const uint32_t samples) {
+  float audio[MAXIMUM_SAMPLES * 2];
+  double expected[MAXIMUM_SAMPLES * 2] = {0};
+
+  for (uint32_t sample = 0; sample < samples * 2; sample++) {
+    audio[sample] = 1000.0f;
+  }
+
+  mixer_mix(&harness->mixer, audio, samples);
+
+  for (int index = 0; index < MIXER_CAPACITY; index++) {
+    if (harness->voices[index].active) {
+      reference_mix(harness->voices + index, expected, samples);
+    }
+  }
+
+  float loudest = 0.0f;
+
+  for (uint32_t sample = 0; sample < samples * 2; sample++) {
+    if (fabs(audio[sample] - expected[sample]) > TOLERANCE) {
+      check(false, "%s: Sample %u was %f, not %f.", harness->name, sample,
+            audio[sample], expected[sample]);
+      break;
+    }
+
+    loudest = fabsf(audio[sample]) > loudest ? fabsf(audio[sample]) : loudest;
+  }
+
+  return loudest;
+}
+
+static bool playing(harness *const harness, const uint32_t voice) {
+  const bool mixer_says = mixer_playing(&harness->mixer, voice);
+  check(mixer_says == harness->voices[voice & 0xFFFF].active,
+        "%s: The mixer reported voice %u as %s.", harness->name,
+        voice & 0xFFFF, mixer_says ? "playing" : "stopped");
+  return mixer_says;
+}
+
+// Plays each kind of voice alone, mixing ticks of uneven sizes, so that runs
+// start and end part way through SIMD groups.
+static void single_voices(void) {
+  static const uint32_t ticks[] = {441, 1, 2, 3, 5, 128, 1023, 37, 600};
+
+  static const struct {
+    const char *name;
+    const float *samples;
+    uint32_t frames;
+    uint32_t channels;
+    float pitch;
+  } sounds[] = {
+      {"Mono", mono, MONO_FRAMES, 1, 1.0f},
+      {"Stereo", stereo, STEREO_FRAMES, 2, 1.0f},
+      {"Pitched mono", mono, MONO_FRAMES, 1, 0.7317f},
+      {"Pitched stereo", stereo, STEREO_FRAMES, 2, 1.4142f},
+  };
+
+  for (size_t sound = 0; sound < sizeof(sounds) / sizeof(sounds[0]);
+       sound++) {
+    for (int looping = 0; looping < 2; looping++) {
+      harness harness;
+      initialize(&harness, sounds[sound].name);
+      const uint32_t voice =
+          play(&harness, sounds[sound].samples, sounds[sound].frames,
+               sounds[sound].channels, 0.8f, -0.35f, sounds[sound].pitch,
+               looping);
+
+      for (size_t tick = 0; tick < sizeof(ticks) / sizeof(ticks[0]); tick++) {
+        mix(&harness, ticks[tick]);
+        playing(&harness, voice);
+      }
+
+      check(playing(&harness, voice) == (bool)looping,
+            "%s: A %s sound was %s after playing past its end.",
+            sounds[sound].name, looping ? "looping" : "non-looping",
+            looping ? "stopped" : "still playing");
+    }
+  }
+}
+
+// Sounds shorter than a tick end, or wrap around, part way through it.
+static void ends(void) {
+  harness harness;
+  initialize(&harness, "Ends");
+  const uint32_t once = play(&harness, short_mono, SHORT_FRAMES, 1, 1.0f, 0.0f,
+                             1.0f, false);
+  const uint32_t looped = play(&harness, short_stereo, SHORT_FRAMES, 2, 1.0f,
+                               0.5f, 1.0f, true);
+  const uint32_t pitched = play(&harness, short_mono, SHORT_FRAMES, 1, 1.0f,
+                                -1.0f, 3.3f, true);
+
+  mix(&harness, 200);
+  check(!playing(&harness, once), "Ends: A short sound did not end.");
+  check(playing(&harness, looped) && playing(&harness, pitched),
+        "Ends: A looping sound ended.");
+
+  for (int tick = 0; tick < 20; tick++) {
+    mix(&harness, 1 + tick * 37 % 300);
+  }
+}
+
+// Changes in gain and pan, and pitch, take effect over the next mix.
+static void ramps(void) {
+  harness harness;
+  initialize(&harness, "Ramps");
+  const uint32_t mono_voice =
+      play(&harness, mono, MONO_FRAMES, 1, 1.0f, -1.0f, 1.0f, true);
+  const uint32_t stereo_voice =
+      play(&harness, stereo, STEREO_FRAMES, 2, 0.2f, 1.0f, 0.5f, true);
+
+  mix(&harness, 100);
+  adjust(&harness, mono_voice, 0.1f, 1.0f, 1.0f);
+  adjust(&harness, stereo_voice, 0.9f, -0.5f, 1.25f);
+  mix(&harness, 441);
+  adjust(&harness, mono_voice, 0.6f, 0.0f, 0.9f);
+  mix(&harness, 7);
+  mix(&harness, 300);
+}
+
+// Stopping fades a voice out over the next mix, after which it is silent and
+// its reference is stale.
+static void stopping(void) {
+  harness harness;
+  initialize(&harness, "Stopping");
+  const uint32_t voice =
+      play(&harness, mono, MONO_FRAMES, 1, 1.0f, 0.0f, 1.0f, true);
+
+  mix(&harness, 64);
+  stop(&harness, voice);
+  check(playing(&harness, voice), "Stopping: A voice stopped before fading.");
+
+  // Further adjustments must not interrupt the fade.
+  mixer_adjust(&harness.mixer, voice, 1.0f, 0.0f, 1.0f);
+  mix(&harness, 64);
+  check(!playing(&harness, voice), "Stopping: A voice did not stop.");
+  check(mix(&harness, 64) == 0.0f, "Stopping: A stopped voice was heard.");
+}
+
+// References to voices which have stopped must not affect whichever sound
+// next plays through the same voice.
+static void stale_references(void) {
+  harness harness;
+  initialize(&harness, "Stale references");
+  check(!mixer_playing(&harness.mixer, MIXER_NO_VOICE),
+        "Stale references: MIXER_NO_VOICE was playing.");
+
+  const uint32_t first = play(&harness, short_mono, SHORT_FRAMES, 1, 1.0f, 0.0f,
+                              1.0f, false);
+  mix(&harness, 100);
+
+  const uint32_t second =
+      play(&harness, mono, MONO_FRAMES, 1, 1.0f, 0.0f, 1.0f, true);
+  check((second & 0xFFFF) == (first & 0xFFFF) && second != first,
+        "Stale references: Voice %08x was reused as %08x.", first, second);
+
+  mixer_stop(&harness.mixer, first);
+  mixer_adjust(&harness.mixer, first, 0.0f, 0.0f, 2.0f);
+  check(!mixer_playing(&harness.mixer, first),
+        "Stale references: A stale reference was playing.");
+  check(playing(&harness, second),
+        "Stale references: A stale reference stopped a new voice.");
+  mix(&harness, 441);
+}
+
+// Every voice can play at once, after which further sounds are refused until
+// one stops.
+static void exhaustion(void) {
+  harness harness;
+  initialize(&harness, "Exhaustion");
+  uint32_t voices[MIXER_CAPACITY];
+
+  for (int index = 0; index < MIXER_CAPACITY; index++) {
+    voices[index] =
+        play(&harness, index % 2 ? stereo : mono,
+             index % 2 ? STEREO_FRAMES : MONO_FRAMES, index % 2 ? 2 : 1,
+             1.0f / MIXER_CAPACITY, index / (MIXER_CAPACITY / 2.0f) - 1.0f,
+             0.5f + index / 32.0f, true);
+    check(voices[index] != MIXER_NO_VOICE,
+          "Exhaustion: Voice %d was refused.", index);
+
+    for (int other = 0; other < index; other++) {
+      check(voices[other] != voices[index],
+            "Exhaustion: Voices %d and %d shared a reference.", other, index);
+    }
+  }
+
+  check(play(&harness, mono, MONO_FRAMES, 1, 1.0f, 0.0f, 1.0f, false) ==
+            MIXER_NO_VOICE,
+        "Exhaustion: More voices played than the mixer's capacity.");
+
+  mix(&harness, 441);
+  stop(&harness, voices[17]);
+  check(play(&harness, mono, MONO_FRAMES, 1, 1.0f, 0.0f, 1.0f, false) ==
+            MIXER_NO_VOICE,
+        "Exhaustion: A fading voice was replaced.");
+  mix(&harness, 441);
+  check(play(&harness, mono, MONO_FRAMES, 1, 1.0f, 0.0f, 1.0f, false) ==
+            (((voices[17] >> 16) + 1) << 16 | 17),
+        "Exhaustion: The stopped voice was not reused.");
+  mix(&harness, 441);
+}
+
+int main(void) {
+  fill(mono, MONO_FRAMES, 1);
+  fill(stereo, STEREO_FRAMES * 2, 2);
+  fill(short_mono, SHORT_FRAMES, 3);
+  fill(short_stereo, SHORT_FRAMES * 2, 4);
+
+  single_voices();
+  ends();
+  ramps();
+  stopping();
+  stale_references();
+  exhaustion();
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include "../library/scheduler.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(const bool passed, const char *const format, ...) {
+  if (!passed) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fprintf(stderr, "\n");
+    failures++;
+  }
+}
+
+static void check_plan(const int due, const int maximum_ticks_per_batch,
+                       const int catch_up_policy, const int expected_ticks,
+                       const int expected_refills) {
+  int ticks = -1;
+  int refills = -1;
+  scheduler_plan(due, maximum_ticks_per_batch, catch_up_policy, &ticks,
+                 &refills);
+  check(ticks == expected_ticks && refills == expected_refills,
+        "scheduler_plan(%d, %d, %d) planned %d ticks and %d refills, not %d "
+        "and %d.",
+        due, maximum_ticks_per_batch, catch_up_policy, ticks, refills,
+        expected_ticks, expected_refills);
+}
+
+int main(void) {
+  check(scheduler_progress(1000, 1000, 400) == 0.0f,
+        "Progress did not start at zero.");
+  check(scheduler_progress(1000, 1100, 400) == 0.25f,
+        "Progress was not proportional to the position.");
+  check(scheduler_progress(1000, 5000, 400) == 1.0f,
+        "Progress was not limited to one.");
+
+  // The position wraps past zero before the minimum position does.
+  check(scheduler_progress(UINT32_MAX - 99, 100, 400) == 0.5f,
+        "Progress did not hold across the position wrapping.");
+
+  check_plan(0, 3, CATCH_UP_POLICY_DROP, 0, 0);
+  check_plan(3, 3, CATCH_UP_POLICY_SLOW, 3, 3);
+
+  for (int policy = CATCH_UP_POLICY_DROP; policy <= CATCH_UP_POLICY_EXTEND;
+       policy++) {
+    check_plan(2, 3, policy, 2, 2);
+  }
+
+  check_plan(7, 3, CATCH_UP_POLICY_DROP, 3, 7);
+  check_plan(7, 3, CATCH_UP_POLICY_SLOW, 3, 3);
+  check_plan(7, 3, CATCH_UP_POLICY_EXTEND, 3, 7);
+
+  check(scheduler_adapt(3, 2, 8, true, 0, 100, 50) == 4,
+        "Running dry did not grow the buffers.");
+  check(scheduler_adapt(8, 2, 8, true, 0, 100, 50) == 8,
+        "Running dry grew the buffers beyond the maximum.");
+  check(scheduler_adapt(4, 2, 8, false, 2, 50, 50) == 3,
+        "A stable window with a tick to spare did not shrink the buffers.");
+  check(scheduler_adapt(4, 2, 8, false, 2, 49, 50) == 4,
+        "The buffers shrank before the window was long enough.");
+  check(scheduler_adapt(4, 2, 8, false, 1, 100, 50) == 4,
+        "The buffers shrank without a tick to spare.");
+  check(scheduler_adapt(2, 2, 8, false, 2, 100, 50) == 2,
+        "The buffers shrank below the minimum.");
+
+  return failures == 0 ? 0 : 1;
+}